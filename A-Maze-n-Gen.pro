@@ -2,35 +2,93 @@ QT       += core gui
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
-CONFIG += c++11
+CONFIG += c++11 thread
 
 INCLUDEPATH += include \
                src
 
 SOURCES += \
     src/main.cpp \
+    src/algorithmrace.cpp \
     src/cell.cpp \
     src/maze.cpp \
     src/coordinate.cpp \
+    src/compactmazeformat.cpp \
+    src/cyclepoppinggenerator.cpp \
+    src/frametelemetry.cpp \
+    src/infinitemaze.cpp \
+    src/mazecache.cpp \
+    src/mazeconnectivity.cpp \
+    src/mazegenerator.cpp \
+    src/mazejunctiongraph.cpp \
+    src/mazepool.cpp \
+    src/mazerandom.cpp \
+    src/mazeregionregenerator.cpp \
+    src/mazestepgenerator.cpp \
+    src/mazetilepyramid.cpp \
+    src/mazevectorexporter.cpp \
+    src/packedmazegrid.cpp \
+    src/rowwisegenerator.cpp \
+    src/sharedmazesegment.cpp \
+    src/uniformtreegenerator.cpp \
+    src/visitheatmap.cpp \
+    src/gui/algorithmracewindow.cpp \
     src/gui/mazesizeradiobutton.cpp \
     src/gui/startstoppushbutton.cpp \
     src/gui/mainwindow.cpp \
     src/gui/basewidgetmenu.cpp \
     src/gui/algorithmgeneratormenu.cpp \
     src/gui/fieldsizemenu.cpp \
-    src/gui/mazearea.cpp
+    src/gui/mazearea.cpp \
+    src/gui/infinitemazeview.cpp \
+    src/gui/mazegraphicsview.cpp \
+    src/gui/mazetileview.cpp
 
 HEADERS += \
+    include/algorithmrace.h \
     include/cell.h \
     include/maze.h \
     include/coordinate.h \
+    include/compactmazeformat.h \
+    include/cyclepoppinggenerator.h \
+    include/frametelemetry.h \
+    include/infinitemaze.h \
+    include/mazecache.h \
+    include/mazeconnectivity.h \
+    include/mazegenerator.h \
+    include/mazejunctiongraph.h \
+    include/mazepool.h \
+    include/mazerandom.h \
+    include/mazeregionregenerator.h \
+    include/mazestepgenerator.h \
+    include/mazetilepyramid.h \
+    include/mazevectorexporter.h \
+    include/packedmazegrid.h \
+    include/rowwisegenerator.h \
+    include/sharedmazesegment.h \
+    include/tracezones.h \
+    include/uniformtreegenerator.h \
+    include/visitheatmap.h \
+    include/gui/algorithmracewindow.h \
     include/gui/mazesizeradiobutton.h \
     include/gui/startstoppushbutton.h \
     include/gui/algorithmgeneratormenu.h \
     include/gui/basewidgetmenu.h \
     include/gui/fieldsizemenu.h \
     include/gui/mainwindow.h \
-    include/gui/mazearea.h
+    include/gui/mazearea.h \
+    include/gui/infinitemazeview.h \
+    include/gui/mazegraphicsview.h \
+    include/gui/mazetileview.h
+
+# qmake CONFIG+=tracing: зоны профилирования и запись трассы amaze-trace.json при выходе
+tracing {
+    DEFINES += MAZE_TRACING
+    SOURCES += src/tracezones.cpp
+}
+
+# shm_open на Linux со старой glibc живет в librt
+linux: LIBS += -lrt
 
 RC_FILE = resources/resources.rc
 
@@ -0,0 +1,9 @@
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    cyclepopping \
+    uniformity \
+    junctiongraph \
+    connectivity \
+    stepgenerator \
+    sharedmemory
@@ -0,0 +1,32 @@
+TEMPLATE = app
+TARGET = connectivitybenchmark
+
+QT -= core gui
+
+CONFIG += console c++11 thread
+CONFIG -= app_bundle
+
+INCLUDEPATH += ../../include
+
+SOURCES += \
+    connectivitybenchmark.cpp \
+    ../../src/cyclepoppinggenerator.cpp \
+    ../../src/mazeanalyzer.cpp \
+    ../../src/mazeconnectivity.cpp \
+    ../../src/mazegenerator.cpp \
+    ../../src/mazerandom.cpp \
+    ../../src/packedmazegrid.cpp \
+    ../../src/rowwisegenerator.cpp \
+    ../../src/uniformtreegenerator.cpp \
+    ../../src/visitheatmap.cpp
+
+HEADERS += \
+    ../../include/cyclepoppinggenerator.h \
+    ../../include/mazeanalyzer.h \
+    ../../include/mazeconnectivity.h \
+    ../../include/mazegenerator.h \
+    ../../include/mazerandom.h \
+    ../../include/packedmazegrid.h \
+    ../../include/rowwisegenerator.h \
+    ../../include/uniformtreegenerator.h \
+    ../../include/visitheatmap.h
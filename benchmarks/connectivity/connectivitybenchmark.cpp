@@ -0,0 +1,210 @@
+#include "mazeanalyzer.h"
+#include "mazeconnectivity.h"
+#include "mazegenerator.h"
+#include "mazerandom.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace
+{
+// Путь из fromCell в toCell, в котором соседние клетки соединены проходом
+bool isValidPath(const PackedMazeGrid &grid, const std::vector<std::uint32_t> &path, std::size_t fromCell,
+                 std::size_t toCell)
+{
+    if (path.empty() || path.front() != fromCell || path.back() != toCell)
+        return false;
+    const std::size_t width = grid.getWidth();
+    for (std::size_t index = 1; index < path.size(); ++index)
+    {
+        const std::size_t cell = path[index - 1];
+        const std::size_t next = path[index];
+        int direction {-1};
+        if (next + width == cell)
+            direction = PackedMazeGrid::Direction::Top;
+        else if (next == cell + 1 && next % width != 0)
+            direction = PackedMazeGrid::Direction::Right;
+        else if (next == cell + width)
+            direction = PackedMazeGrid::Direction::Bot;
+        else if (next + 1 == cell && cell % width != 0)
+            direction = PackedMazeGrid::Direction::Left;
+        if (direction < 0 || !grid.hasPassage(cell % width, cell / width, direction))
+            return false;
+    }
+    return true;
+}
+
+// Номер компонента каждой клетки обходом в ширину по всей сетке; возвращает число компонентов
+std::size_t labelComponents(const PackedMazeGrid &grid, std::vector<std::uint32_t> &labels)
+{
+    const std::size_t width = grid.getWidth();
+    const std::uint32_t unlabeled {0xFFFFFFFF};
+    labels.assign(grid.getCellCount(), unlabeled);
+    std::vector<std::uint32_t> queue;
+    queue.reserve(grid.getCellCount());
+    std::uint32_t componentCount {0};
+    for (std::size_t root = 0; root < labels.size(); ++root)
+    {
+        if (labels[root] != unlabeled)
+            continue;
+        labels[root] = componentCount;
+        queue.assign(1, static_cast<std::uint32_t>(root));
+        for (std::size_t head = 0; head < queue.size(); ++head)
+        {
+            const std::size_t cell = queue[head];
+            const std::size_t neighbors[PackedMazeGrid::Direction::Count] {cell - width, cell + 1, cell + width, cell - 1};
+            for (int direction = 0; direction < PackedMazeGrid::Direction::Count; ++direction)
+            {
+                if (grid.hasPassage(cell % width, cell / width, direction) && labels[neighbors[direction]] == unlabeled)
+                {
+                    labels[neighbors[direction]] = componentCount;
+                    queue.push_back(static_cast<std::uint32_t>(neighbors[direction]));
+                }
+            }
+        }
+        ++componentCount;
+    }
+    return componentCount;
+}
+
+/* editCount случайных правок внутренних стен лабиринта. После каждой правки MazeConnectivity
+ * сравнивается с обходом в ширину по всей сетке: число компонентов и циклов, флаги правки
+ * (цикл при открытии, разделение при закрытии) и queryCount случайных пар клеток - связность,
+ * корректность пути и его длина. Пока циклов нет, путь единственный и совпадает с путем
+ * MazeAnalyzer. Возвращает true, если расхождений нет */
+bool checkEdits(const char *name, int algorithm, std::size_t width, std::size_t height, std::size_t editCount,
+                std::size_t queryCount, std::uint64_t seed)
+{
+    PackedMazeGrid grid;
+    MazeGenerator::generate(GenerationParameters(algorithm, width, height, seed), grid);
+    MazeConnectivity connectivity;
+    if (!connectivity.build(grid))
+    {
+        std::printf("%-24s build failed  FAIL\n", name);
+        return false;
+    }
+
+    std::vector<std::uint32_t> labels;
+    std::vector<std::uint32_t> previousLabels;
+    labelComponents(grid, labels);
+    // Идеальный лабиринт: проходов на один меньше, чем клеток
+    std::size_t openPassages = grid.getCellCount() - 1;
+    MazeRandom random(seed + 1);
+    std::size_t mismatches {0};
+    std::size_t disconnections {0};
+    std::size_t maxLoops {0};
+    std::chrono::duration<double> connectivityTime {0.0};
+    std::chrono::duration<double> scanTime {0.0};
+    const auto reportMismatch = [&](std::size_t edit, const char *what) {
+        if (mismatches++ == 0)
+            std::printf("  mismatch after edit %zu: %s\n", edit, what);
+    };
+
+    for (std::size_t edit = 0; edit < editCount; ++edit)
+    {
+        // Внутренняя стена справа или снизу от случайной клетки
+        std::size_t x {};
+        std::size_t y {};
+        int direction {};
+        do
+        {
+            x = random.bounded(static_cast<std::uint32_t>(width));
+            y = random.bounded(static_cast<std::uint32_t>(height));
+            direction = random.bounded(2) == 0 ? PackedMazeGrid::Direction::Right : PackedMazeGrid::Direction::Bot;
+        } while ((direction == PackedMazeGrid::Direction::Right && x + 1 == width) ||
+                 (direction == PackedMazeGrid::Direction::Bot && y + 1 == height));
+        const std::size_t firstCell = y * width + x;
+        const std::size_t secondCell = direction == PackedMazeGrid::Direction::Right ? firstCell + 1 : firstCell + width;
+        const bool isOpen = !grid.hasPassage(x, y, direction);
+        grid.setPassage(x, y, direction, isOpen);
+        openPassages = isOpen ? openPassages + 1 : openPassages - 1;
+
+        auto start = std::chrono::steady_clock::now();
+        const MazeConnectivity::EditResult result = connectivity.setPassage(x, y, direction, isOpen);
+        connectivityTime += std::chrono::steady_clock::now() - start;
+
+        labels.swap(previousLabels);
+        start = std::chrono::steady_clock::now();
+        const std::size_t componentCount = labelComponents(grid, labels);
+        scanTime += std::chrono::steady_clock::now() - start;
+
+        const std::size_t loopCount = openPassages + componentCount - grid.getCellCount();
+        maxLoops = std::max(maxLoops, loopCount);
+        const bool isSplit = labels[firstCell] != labels[secondCell];
+        disconnections += isSplit;
+        if (!result.isChanged)
+            reportMismatch(edit, "edit not applied");
+        if (result.isLoopCreated != (isOpen && previousLabels[firstCell] == previousLabels[secondCell]))
+            reportMismatch(edit, "loop flag");
+        if (result.isDisconnected != (!isOpen && isSplit))
+            reportMismatch(edit, "disconnect flag");
+        if (connectivity.getComponentCount() != componentCount || connectivity.getLoopCount() != loopCount ||
+                connectivity.isPerfect() != (componentCount == 1 && loopCount == 0))
+            reportMismatch(edit, "component or loop count");
+
+        for (std::size_t query = 0; query < queryCount; ++query)
+        {
+            const std::size_t fromCell = static_cast<std::size_t>(random.generate64() % grid.getCellCount());
+            const std::size_t toCell = static_cast<std::size_t>(random.generate64() % grid.getCellCount());
+            const bool isExpectedConnected = labels[fromCell] == labels[toCell];
+            start = std::chrono::steady_clock::now();
+            const bool isConnected = connectivity.isConnected(fromCell, toCell);
+            const std::uint64_t pathLength = connectivity.getPathLength(fromCell, toCell);
+            const std::vector<std::uint32_t> path = connectivity.getPath(fromCell, toCell);
+            connectivityTime += std::chrono::steady_clock::now() - start;
+
+            if (isConnected != isExpectedConnected)
+                reportMismatch(edit, "isConnected");
+            else if (!isExpectedConnected && (pathLength != MazeConnectivity::NO_PATH || !path.empty()))
+                reportMismatch(edit, "path between disconnected cells");
+            else if (isExpectedConnected && (!isValidPath(grid, path, fromCell, toCell) || path.size() != pathLength + 1))
+                reportMismatch(edit, "invalid path");
+            else if (isExpectedConnected && loopCount == 0 && MazeAnalyzer::findPath(grid, fromCell, toCell) != path)
+                reportMismatch(edit, "path differs from BFS without loops");
+        }
+    }
+    if (connectivity.getGrid().computeChecksum() != grid.computeChecksum())
+        reportMismatch(editCount, "grid");
+
+    std::printf("%-24s %9zu %7zu %10zu %9zu %8zu %12.2f %11.2f %6zu  %s\n", name, grid.getCellCount(), editCount,
+                disconnections, maxLoops, connectivity.getComponentCount(),
+                connectivityTime.count() * 1e6 / editCount, scanTime.count() * 1e6 / editCount, mismatches,
+                mismatches == 0 ? "ok" : "FAIL");
+    return mismatches == 0;
+}
+}
+
+/* Проверка и замер связности при правке стен (MazeConnectivity): случайные правки готового
+ * лабиринта, после каждой ответы link-cut дерева сверяются с обходом в ширину по всей сетке.
+ * Столбцы времени - на одну правку вместе с её запросами и на один обход всей сетки.
+ * Использование: connectivitybenchmark [размер, по умолчанию 64] [правок, по умолчанию 5000]
+ *                                      [запросов на правку, по умолчанию 4] */
+int main(int argc, char *argv[])
+{
+    const std::size_t mazeSize = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 64;
+    const std::size_t editCount = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 5000;
+    const std::size_t queryCount = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 4;
+    if (mazeSize < 2 || editCount == 0)
+    {
+        std::fprintf(stderr, "Usage: %s [SIZE >= 2] [EDITS >= 1] [QUERIES_PER_EDIT]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::printf("%-24s %9s %7s %10s %9s %8s %12s %11s %6s  %s\n", "maze", "cells", "edits", "splits", "max loops",
+                "parts", "link-cut us", "BFS us", "errors", "verdict");
+    bool isPassed {true};
+    isPassed = checkEdits("Recursive Backtracker", MazeGenerator::Algorithm::RecursiveBacktracker, mazeSize, mazeSize,
+                          editCount, queryCount, 1) && isPassed;
+    isPassed = checkEdits("Wilson", MazeGenerator::Algorithm::Wilson, mazeSize, mazeSize, editCount, queryCount, 2) &&
+            isPassed;
+    // Узкая полоса: почти каждое закрытие режет лабиринт, и замена ищется среди немногих циклов
+    isPassed = checkEdits("Wilson 2 x N", MazeGenerator::Algorithm::Wilson, 2, mazeSize * 4, editCount, queryCount, 3) &&
+            isPassed;
+    // Несколько правок: циклов мало, пути сверяются с MazeAnalyzer
+    isPassed = checkEdits("Aldous-Broder, few edits", MazeGenerator::Algorithm::AldousBroder, mazeSize, mazeSize, 8,
+                          queryCount * 50, 4) && isPassed;
+    return isPassed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
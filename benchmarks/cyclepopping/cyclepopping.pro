@@ -0,0 +1,24 @@
+TEMPLATE = app
+TARGET = cyclepoppingbenchmark
+
+QT -= core gui
+
+CONFIG += console c++11 thread
+CONFIG -= app_bundle
+
+INCLUDEPATH += ../../include
+
+SOURCES += \
+    cyclepoppingbenchmark.cpp \
+    ../../src/cyclepoppinggenerator.cpp \
+    ../../src/mazerandom.cpp \
+    ../../src/packedmazegrid.cpp \
+    ../../src/uniformtreegenerator.cpp \
+    ../../src/visitheatmap.cpp
+
+HEADERS += \
+    ../../include/cyclepoppinggenerator.h \
+    ../../include/mazerandom.h \
+    ../../include/packedmazegrid.h \
+    ../../include/uniformtreegenerator.h \
+    ../../include/visitheatmap.h
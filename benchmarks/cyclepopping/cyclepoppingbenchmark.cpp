@@ -0,0 +1,33 @@
+#include "cyclepoppinggenerator.h"
+#include "uniformtreegenerator.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+/* Масштабирование многопоточного выталкивания циклов по числу потоков в сравнении с
+ * однопоточным Уилсоном. Результат при одном seed не зависит от числа потоков.
+ * Использование: cyclepoppingbenchmark [размер], по умолчанию 3163 (~10^7 клеток) */
+int main(int argc, char *argv[])
+{
+    const std::size_t mazeSize = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 3163;
+    const unsigned int maxThreads = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1;
+    PackedMazeGrid grid;
+
+    auto start = std::chrono::steady_clock::now();
+    UniformTreeGenerator wilsonGenerator(mazeSize, mazeSize, 1);
+    wilsonGenerator.generate(UniformTreeGenerator::Algorithm::Wilson, grid);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::printf("%zux%zu Wilson: %.3f s\n", mazeSize, mazeSize, elapsed.count());
+
+    for (unsigned int threadCount = 1; threadCount <= maxThreads; threadCount *= 2)
+    {
+        start = std::chrono::steady_clock::now();
+        CyclePoppingGenerator generator(mazeSize, mazeSize, 1, threadCount);
+        generator.generate(grid);
+        elapsed = std::chrono::steady_clock::now() - start;
+        std::printf("%zux%zu cycle popping, %2u threads: %.3f s\n", mazeSize, mazeSize, threadCount, elapsed.count());
+    }
+    return 0;
+}
@@ -0,0 +1,297 @@
+#include "mazeanalyzer.h"
+#include "mazegenerator.h"
+#include "mazejunctiongraph.h"
+#include "mazerandom.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <queue>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+// Путь из fromCell в toCell, в котором соседние клетки соединены проходом
+bool isValidPath(const PackedMazeGrid &grid, const std::vector<std::uint32_t> &path, std::size_t fromCell,
+                 std::size_t toCell)
+{
+    if (path.empty() || path.front() != fromCell || path.back() != toCell)
+        return false;
+    const std::size_t width = grid.getWidth();
+    for (std::size_t index = 1; index < path.size(); ++index)
+    {
+        const std::size_t cell = path[index - 1];
+        const std::size_t next = path[index];
+        int direction {-1};
+        if (next + width == cell)
+            direction = PackedMazeGrid::Direction::Top;
+        else if (next == cell + 1 && next % width != 0)
+            direction = PackedMazeGrid::Direction::Right;
+        else if (next == cell + width)
+            direction = PackedMazeGrid::Direction::Bot;
+        else if (next + 1 == cell && cell % width != 0)
+            direction = PackedMazeGrid::Direction::Left;
+        if (direction < 0 || !grid.hasPassage(cell % width, cell / width, direction))
+            return false;
+    }
+    return true;
+}
+
+// Соседняя клетка в направлении direction; проход туда должен быть
+std::size_t getNeighborCell(const PackedMazeGrid &grid, std::size_t cell, int direction)
+{
+    const std::size_t width = grid.getWidth();
+    const std::size_t steps[PackedMazeGrid::Direction::Count] {std::size_t(0) - width, 1, width, std::size_t(0) - 1};
+    return cell + steps[direction];
+}
+
+int getPassageCount(const PackedMazeGrid &grid, std::size_t cell)
+{
+    int passageCount {0};
+    for (int direction = 0; direction < PackedMazeGrid::Direction::Count; ++direction)
+        passageCount += grid.hasPassage(cell % grid.getWidth(), cell / grid.getWidth(), direction);
+    return passageCount;
+}
+
+/* Граф против самой сетки. Узлы - ровно клетки без двух проходов (и по клетке на цикл без
+ * развилок), степень узла - число его проходов. Каждое ребро проходится по сетке от fromNode в
+ * fromDirection: клетки коридора, длина, конечный узел и направление входа в него должны совпасть,
+ * а все клетки коридоров - покрыться ребрами ровно один раз. Возвращает число расхождений */
+std::size_t checkEdges(const PackedMazeGrid &grid, const MazeJunctionGraph &graph)
+{
+    std::size_t errors {0};
+    std::size_t corridorCellCount {0};
+    for (std::size_t cell = 0; cell < grid.getCellCount(); ++cell)
+    {
+        const int passageCount = getPassageCount(grid, cell);
+        const std::uint32_t node = graph.getCellNode(cell);
+        if (node == MazeJunctionGraph::NO_NODE)
+        {
+            ++corridorCellCount;
+            errors += passageCount != 2 || graph.getCellEdge(cell) == MazeJunctionGraph::NO_NODE;
+        }
+        else
+        {
+            errors += graph.getNodeCell(node) != cell || graph.getNodeDegree(node) != std::size_t(passageCount);
+        }
+    }
+
+    std::size_t walkedCellCount {0};
+    for (std::uint32_t edgeIndex = 0; edgeIndex < graph.getEdgeCount(); ++edgeIndex)
+    {
+        const MazeJunctionGraph::Edge &edge = graph.getEdge(edgeIndex);
+        const std::uint32_t *corridorCells = graph.getCorridorCells(edgeIndex);
+        std::size_t cell = graph.getNodeCell(edge.fromNode);
+        int direction = edge.fromDirection;
+        std::uint32_t length {0};
+        bool isBroken = !grid.hasPassage(cell % grid.getWidth(), cell / grid.getWidth(), direction);
+        while (!isBroken)
+        {
+            cell = getNeighborCell(grid, cell, direction);
+            ++length;
+            if (graph.getCellNode(cell) != MazeJunctionGraph::NO_NODE)
+                break;
+            isBroken = length >= edge.length || corridorCells[length - 1] != cell || graph.getCellEdge(cell) != edgeIndex;
+            // Коридор продолжается вторым проходом клетки, не тем, которым в неё вошли
+            const int entryDirection = (direction + 2) % PackedMazeGrid::Direction::Count;
+            for (direction = 0; direction == entryDirection ||
+                 !grid.hasPassage(cell % grid.getWidth(), cell / grid.getWidth(), direction); ++direction)
+            {
+            }
+            ++walkedCellCount;
+        }
+        const int entryDirection = (direction + 2) % PackedMazeGrid::Direction::Count;
+        errors += isBroken || length != edge.length || cell != graph.getNodeCell(edge.toNode) ||
+                entryDirection != edge.toDirection;
+    }
+    return errors + (walkedCellCount != corridorCellCount);
+}
+
+/* Длины ребер против обхода в ширину по всей сетке: расстояния Дейкстры по графу от узла до всех
+ * узлов должны совпасть с числом шагов по клеткам. Возвращает число расхождений */
+std::size_t checkEdgeLengths(const PackedMazeGrid &grid, const MazeJunctionGraph &graph, std::uint32_t sourceNode)
+{
+    const std::uint64_t unreached {~std::uint64_t(0)};
+    std::vector<std::uint64_t> cellDistances(grid.getCellCount(), unreached);
+    std::vector<std::uint32_t> queue(1, graph.getNodeCell(sourceNode));
+    cellDistances[queue.front()] = 0;
+    for (std::size_t head = 0; head < queue.size(); ++head)
+    {
+        const std::size_t cell = queue[head];
+        for (int direction = 0; direction < PackedMazeGrid::Direction::Count; ++direction)
+        {
+            if (!grid.hasPassage(cell % grid.getWidth(), cell / grid.getWidth(), direction))
+                continue;
+            const std::size_t neighbor = getNeighborCell(grid, cell, direction);
+            if (cellDistances[neighbor] == unreached)
+            {
+                cellDistances[neighbor] = cellDistances[cell] + 1;
+                queue.push_back(static_cast<std::uint32_t>(neighbor));
+            }
+        }
+    }
+
+    using QueueEntry = std::pair<std::uint64_t, std::uint32_t>;
+    std::vector<std::uint64_t> nodeDistances(graph.getNodeCount(), unreached);
+    std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> nodeQueue;
+    nodeDistances[sourceNode] = 0;
+    nodeQueue.push(QueueEntry(0, sourceNode));
+    while (!nodeQueue.empty())
+    {
+        const QueueEntry entry = nodeQueue.top();
+        nodeQueue.pop();
+        if (entry.first != nodeDistances[entry.second])
+            continue;
+        for (std::size_t index = 0; index < graph.getNodeDegree(entry.second); ++index)
+        {
+            const MazeJunctionGraph::Edge &edge = graph.getEdge(graph.getNodeEdge(entry.second, index));
+            const std::uint32_t neighbor = edge.fromNode == entry.second ? edge.toNode : edge.fromNode;
+            if (entry.first + edge.length < nodeDistances[neighbor])
+            {
+                nodeDistances[neighbor] = entry.first + edge.length;
+                nodeQueue.push(QueueEntry(nodeDistances[neighbor], neighbor));
+            }
+        }
+    }
+
+    std::size_t errors {0};
+    for (std::uint32_t node = 0; node < graph.getNodeCount(); ++node)
+        errors += nodeDistances[node] != cellDistances[graph.getNodeCell(node)];
+    return errors;
+}
+
+// Открывает каждую закрытую внутреннюю стену с вероятностью 1 / period, добавляя циклы
+void openRandomWalls(PackedMazeGrid &grid, std::uint32_t period, MazeRandom &random)
+{
+    for (std::size_t y = 0; y < grid.getHeight(); ++y)
+    {
+        for (std::size_t x = 0; x < grid.getWidth(); ++x)
+        {
+            if (x + 1 < grid.getWidth() && random.bounded(period) == 0)
+                grid.setPassage(x, y, PackedMazeGrid::Direction::Right, true);
+            if (y + 1 < grid.getHeight() && random.bounded(period) == 0)
+                grid.setPassage(x, y, PackedMazeGrid::Direction::Bot, true);
+        }
+    }
+}
+
+/* Сравнение MazeJunctionGraph::findPath с MazeAnalyzer::findPath на queryCount случайных парах
+ * клеток: путь должен существовать в тех же случаях, быть корректным и той же длины (в дереве
+ * путь единственный, с циклами оба пути кратчайшие). Ребра графа сверяются с сеткой, а их длины -
+ * с обходом в ширину из нескольких узлов. Возвращает true, если расхождений нет */
+bool checkGrid(const char *name, const PackedMazeGrid &grid, std::size_t queryCount, std::uint64_t seed)
+{
+    MazeJunctionGraph graph;
+    auto start = std::chrono::steady_clock::now();
+    if (!graph.build(grid))
+    {
+        std::printf("%-28s build failed  FAIL\n", name);
+        return false;
+    }
+    const std::chrono::duration<double> buildTime = std::chrono::steady_clock::now() - start;
+
+    MazeRandom random(seed);
+    std::size_t edgeErrors = checkEdges(grid, graph);
+    const std::size_t sourceCount = std::min<std::size_t>(graph.getNodeCount(), 3);
+    for (std::size_t source = 0; source < sourceCount; ++source)
+        edgeErrors += checkEdgeLengths(grid, graph, random.bounded(static_cast<std::uint32_t>(graph.getNodeCount())));
+
+    std::vector<std::size_t> queries(queryCount * 2);
+    for (std::size_t &cell : queries)
+        cell = static_cast<std::size_t>(random.generate64() % grid.getCellCount());
+
+    std::vector<std::vector<std::uint32_t>> graphPaths(queryCount);
+    start = std::chrono::steady_clock::now();
+    for (std::size_t query = 0; query < queryCount; ++query)
+        graphPaths[query] = graph.findPath(queries[query * 2], queries[query * 2 + 1]);
+    const std::chrono::duration<double> graphTime = std::chrono::steady_clock::now() - start;
+
+    std::size_t mismatches {0};
+    std::chrono::duration<double> analyzerTime {0.0};
+    for (std::size_t query = 0; query < queryCount; ++query)
+    {
+        const std::size_t fromCell = queries[query * 2];
+        const std::size_t toCell = queries[query * 2 + 1];
+        start = std::chrono::steady_clock::now();
+        const std::vector<std::uint32_t> analyzerPath = MazeAnalyzer::findPath(grid, fromCell, toCell);
+        analyzerTime += std::chrono::steady_clock::now() - start;
+
+        const std::vector<std::uint32_t> &graphPath = graphPaths[query];
+        const bool isMatch = analyzerPath.empty() ? graphPath.empty() :
+                                                    graphPath.size() == analyzerPath.size() &&
+                                                    isValidPath(grid, graphPath, fromCell, toCell) &&
+                                                    (graph.hasCycles() || graphPath == analyzerPath);
+        if (!isMatch && mismatches++ == 0)
+            std::printf("  mismatch %zu -> %zu: analyzer %zu cells, graph %zu cells\n", fromCell, toCell,
+                        analyzerPath.size(), graphPath.size());
+    }
+
+    const bool isPassed = mismatches == 0 && edgeErrors == 0;
+    std::printf("%-28s %9zu %9zu %6s %9.3f %10.3f %10.3f %6zu %6zu  %s\n", name, grid.getCellCount(),
+                graph.getNodeCount(), graph.hasCycles() ? "yes" : "no", buildTime.count() * 1000,
+                analyzerTime.count() * 1000, graphTime.count() * 1000, edgeErrors, mismatches, isPassed ? "ok" : "FAIL");
+    return isPassed;
+}
+}
+
+/* Проверка и замер графа развилок: пути по графу сравниваются с обходом в ширину по клеткам на
+ * готовых лабиринтах, на лабиринтах с добавленными циклами (как после правок стен в Maze) и на
+ * сетках, где циклы без развилок и тупиков (кольца 2x2, открытая сетка 2x2) не дают ни одного узла.
+ * Использование: junctiongraphbenchmark [размер, по умолчанию 1000] [запросов, по умолчанию 200] */
+int main(int argc, char *argv[])
+{
+    const std::size_t mazeSize = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000;
+    const std::size_t queryCount = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 200;
+    MazeRandom random(1);
+    bool isPassed {true};
+    PackedMazeGrid grid;
+
+    std::printf("%-28s %9s %9s %6s %9s %10s %10s %6s %6s  %s\n", "grid", "cells", "nodes", "cycles", "build ms",
+                "cells ms", "graph ms", "edges", "paths", "verdict");
+    const struct
+    {
+        const char *name;
+        int algorithm;
+    } algorithms[] {{"Recursive Backtracker", MazeGenerator::Algorithm::RecursiveBacktracker},
+                    {"Wilson", MazeGenerator::Algorithm::Wilson}};
+    for (const auto &algorithm : algorithms)
+    {
+        MazeGenerator::generate(GenerationParameters(algorithm.algorithm, mazeSize, mazeSize, 1), grid);
+        isPassed = checkGrid(algorithm.name, grid, queryCount, 2) && isPassed;
+
+        openRandomWalls(grid, 20, random);
+        const std::string loopedName = std::string(algorithm.name) + " + loops";
+        isPassed = checkGrid(loopedName.c_str(), grid, queryCount, 3) && isPassed;
+    }
+
+    // Сетка из отдельных колец 2x2: ни одной развилки и ни одного тупика
+    grid.resize(mazeSize / 2 * 2, mazeSize / 2 * 2);
+    for (std::size_t y = 0; y < grid.getHeight(); y += 2)
+    {
+        for (std::size_t x = 0; x < grid.getWidth(); x += 2)
+        {
+            grid.setPassage(x, y, PackedMazeGrid::Direction::Right, true);
+            grid.setPassage(x, y, PackedMazeGrid::Direction::Bot, true);
+            grid.setPassage(x + 1, y + 1, PackedMazeGrid::Direction::Top, true);
+            grid.setPassage(x + 1, y + 1, PackedMazeGrid::Direction::Left, true);
+        }
+    }
+    isPassed = checkGrid("2x2 rings", grid, queryCount, 4) && isPassed;
+
+    // Сетки без стен: 2x2 - одно кольцо без узлов, 8x8 - сплошные развилки
+    grid.resize(2, 2);
+    grid.setPassage(0, 0, PackedMazeGrid::Direction::Right, true);
+    grid.setPassage(0, 0, PackedMazeGrid::Direction::Bot, true);
+    grid.setPassage(1, 1, PackedMazeGrid::Direction::Top, true);
+    grid.setPassage(1, 1, PackedMazeGrid::Direction::Left, true);
+    isPassed = checkGrid("open 2x2", grid, 64, 5) && isPassed;
+    grid.resize(8, 8);
+    openRandomWalls(grid, 1, random);
+    isPassed = checkGrid("open 8x8", grid, 1000, 6) && isPassed;
+
+    return isPassed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,37 @@
+TEMPLATE = app
+TARGET = sharedmemorybenchmark
+
+QT -= core gui
+
+CONFIG += console c++11 thread
+CONFIG -= app_bundle
+
+win32: error("sharedmemorybenchmark requires a POSIX system")
+
+INCLUDEPATH += ../../include
+
+SOURCES += \
+    sharedmemorybenchmark.cpp \
+    ../../src/compactmazeformat.cpp \
+    ../../src/cyclepoppinggenerator.cpp \
+    ../../src/mazegenerator.cpp \
+    ../../src/mazerandom.cpp \
+    ../../src/packedmazegrid.cpp \
+    ../../src/rowwisegenerator.cpp \
+    ../../src/sharedmazesegment.cpp \
+    ../../src/uniformtreegenerator.cpp \
+    ../../src/visitheatmap.cpp
+
+HEADERS += \
+    ../../include/compactmazeformat.h \
+    ../../include/cyclepoppinggenerator.h \
+    ../../include/mazegenerator.h \
+    ../../include/mazerandom.h \
+    ../../include/packedmazegrid.h \
+    ../../include/rowwisegenerator.h \
+    ../../include/sharedmazesegment.h \
+    ../../include/uniformtreegenerator.h \
+    ../../include/visitheatmap.h
+
+# shm_open на Linux со старой glibc живет в librt
+linux: LIBS += -lrt
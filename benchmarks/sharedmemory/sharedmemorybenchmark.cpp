@@ -0,0 +1,227 @@
+#include "compactmazeformat.h"
+#include "mazegenerator.h"
+#include "sharedmazesegment.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace
+{
+using MazeKey = std::tuple<std::size_t, std::size_t, std::uint64_t>;
+
+const int PUBLISHED_ALGORITHM {MazeGenerator::Algorithm::Wilson};
+
+struct MazeSize
+{
+    std::size_t width;
+    std::size_t height;
+};
+
+// Размеры растут, поэтому сегмент увеличивается посреди прогона и читатель должен его переотобразить
+const MazeSize PUBLISHED_SIZES[] {{16, 16}, {64, 48}, {200, 150}, {640, 480}};
+
+// Согласованный снимок сегмента копируется в grid; false, если издатель все попытки писал
+bool readPublishedMaze(SharedMazeReader &reader, PackedMazeGrid &grid, int &algorithm)
+{
+    return reader.readSnapshot([&](const SharedMazeReader::Snapshot &snapshot) {
+        grid.resize(snapshot.width, snapshot.height);
+        const std::size_t planeWords = snapshot.wordsPerRow * snapshot.height;
+        if (planeWords != 0 && snapshot.wordsPerRow == grid.getWordsPerRow())
+        {
+            std::memcpy(grid.getRightRow(0), snapshot.rightPlane, planeWords * sizeof(std::uint64_t));
+            std::memcpy(grid.getBotRow(0), snapshot.botPlane, planeWords * sizeof(std::uint64_t));
+        }
+        algorithm = snapshot.algorithm;
+    });
+}
+
+/* Издатель в дочернем процессе: roundCount раз подряд публикует все лабиринты, каждый - одной
+ * записью seqlock. Лабиринты готовы заранее, запись - только копирование. Уступая процессор
+ * посреди записи и после нее, издатель и на одном ядре дает читателю попасть и на запись, и между
+ * записями */
+int runPublisher(const std::string &name, const std::vector<PackedMazeGrid> &mazes, unsigned int roundCount)
+{
+    SharedMazePublisher publisher(name);
+    PackedMazeGrid grid;
+    if (!publisher.open() || !publisher.attach(grid))
+        return EXIT_FAILURE;
+    for (unsigned int round = 0; round < roundCount; ++round)
+    {
+        for (std::size_t index = 0; index < mazes.size(); ++index)
+        {
+            publisher.beginWrite();
+            // Копия получает свою память, endWrite переносит ее в сегмент
+            grid = mazes[index];
+            if (index % 2 != 0)
+                std::this_thread::yield();
+            publisher.endWrite(PUBLISHED_ALGORITHM, grid);
+            std::this_thread::yield();
+        }
+    }
+    return EXIT_SUCCESS;
+}
+
+/* Чтение сегмента, пока издатель в другом процессе пишет в него лабиринт за лабиринтом. Каждый
+ * снимок, который readSnapshot признал согласованным, обязан совпасть с одним из опубликованных
+ * лабиринтов: разорванное чтение дает сетку, которой нет в наборе */
+int runRoundTrip(std::uint64_t seedCount, unsigned int roundCount)
+{
+    char name[64] {};
+    std::snprintf(name, sizeof(name), "/a-maze-n-gen-check-%ld", static_cast<long>(getpid()));
+
+    std::vector<PackedMazeGrid> mazes;
+    std::set<MazeKey> publishedMazes;
+    for (const MazeSize &size : PUBLISHED_SIZES)
+    {
+        for (std::uint64_t seed = 1; seed <= seedCount; ++seed)
+        {
+            mazes.emplace_back();
+            MazeGenerator::generate(GenerationParameters(PUBLISHED_ALGORITHM, size.width, size.height, seed), mazes.back());
+            publishedMazes.insert(MazeKey(size.width, size.height, mazes.back().computeChecksum()));
+        }
+    }
+    const MazeKey lastMaze(mazes.back().getWidth(), mazes.back().getHeight(), mazes.back().computeChecksum());
+    PackedMazeGrid grid;
+
+    shm_unlink(name);
+    const pid_t publisherPid = fork();
+    if (publisherPid < 0)
+    {
+        std::perror("fork");
+        return EXIT_FAILURE;
+    }
+    if (publisherPid == 0)
+        _exit(runPublisher(name, mazes, roundCount));
+
+    std::unique_ptr<SharedMazeReader> reader;
+    for (unsigned int attempt = 0; attempt < 1000 && !reader; ++attempt)
+    {
+        reader.reset(new SharedMazeReader);
+        if (!reader->open(name))
+        {
+            reader.reset();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    std::uint64_t snapshots {0};
+    std::uint64_t busyReads {0};
+    std::uint64_t mismatches {0};
+    std::set<MazeKey> seenMazes;
+    const auto checkSnapshot = [&](bool isRead, int algorithm) {
+        if (!isRead)
+        {
+            ++busyReads;
+            return;
+        }
+        // До первой записи сегмент пустой
+        if (grid.getCellCount() == 0)
+            return;
+        ++snapshots;
+        const MazeKey key(grid.getWidth(), grid.getHeight(), grid.computeChecksum());
+        if (algorithm != PUBLISHED_ALGORITHM || publishedMazes.count(key) == 0)
+            ++mismatches;
+        else
+            seenMazes.insert(key);
+    };
+
+    int publisherStatus {0};
+    const auto start = std::chrono::steady_clock::now();
+    while (reader && waitpid(publisherPid, &publisherStatus, WNOHANG) == 0)
+    {
+        int algorithm {};
+        const bool isRead = readPublishedMaze(*reader, grid, algorithm);
+        checkSnapshot(isRead, algorithm);
+    }
+    if (!reader)
+        waitpid(publisherPid, &publisherStatus, 0);
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    // После выхода издателя сегмент остается у читателя и хранит последний лабиринт
+    int algorithm {};
+    const bool isLastRead = reader && readPublishedMaze(*reader, grid, algorithm);
+    checkSnapshot(isLastRead, algorithm);
+    const bool isLastMatched = isLastRead && MazeKey(grid.getWidth(), grid.getHeight(), grid.computeChecksum()) == lastMaze;
+    shm_unlink(name);
+
+    const bool isPublisherOk = WIFEXITED(publisherStatus) && WEXITSTATUS(publisherStatus) == EXIT_SUCCESS;
+    const bool isPassed = reader && isPublisherOk && mismatches == 0 && isLastMatched;
+    std::printf("%-12s %10s %10s %10s %10s %10s  %s\n", "published", "snapshots", "distinct", "busy", "mismatch",
+                "reads/s", "verdict");
+    std::printf("%-12llu %10llu %10zu %10llu %10llu %10.0f  %s\n",
+                static_cast<unsigned long long>(mazes.size()) * roundCount,
+                static_cast<unsigned long long>(snapshots), seenMazes.size(), static_cast<unsigned long long>(busyReads),
+                static_cast<unsigned long long>(mismatches), snapshots / elapsed.count(), isPassed ? "ok" : "FAIL");
+    if (!reader || !isPublisherOk || !isLastMatched)
+        std::fprintf(stderr, "%s\n", !reader ? "segment was never opened" :
+                                     !isPublisherOk ? "publisher failed" : "last maze not visible after publisher exit");
+    return isPassed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// Сегмент, оставленный mazegen --shared-memory, должен совпасть с лабиринтом из --output
+int checkPublishedFile(const std::string &name, const std::string &filePath)
+{
+    std::ifstream file(filePath, std::ios::binary);
+    GenerationParameters parameters;
+    PackedMazeGrid expectedGrid;
+    if (!file || !CompactMazeFormat::read(file, parameters, expectedGrid))
+    {
+        std::fprintf(stderr, "Unable to read %s\n", filePath.c_str());
+        return EXIT_FAILURE;
+    }
+    SharedMazeReader reader;
+    PackedMazeGrid grid;
+    int algorithm {};
+    if (!reader.open(name) || !readPublishedMaze(reader, grid, algorithm))
+    {
+        std::fprintf(stderr, "Unable to read shared memory %s\n", name.c_str());
+        return EXIT_FAILURE;
+    }
+    const bool isSame = algorithm == parameters.algorithm && grid.getWidth() == expectedGrid.getWidth() &&
+            grid.getHeight() == expectedGrid.getHeight() && grid.computeChecksum() == expectedGrid.computeChecksum();
+    std::printf("%s %zux%zu algorithm %d: %s\n", name.c_str(), grid.getWidth(), grid.getHeight(), algorithm,
+                isSame ? "matches" : "DIFFERS");
+    return isSame ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+}
+
+/* Проверка публикации через разделяемую память. Без --check издатель в дочернем процессе пишет
+ * лабиринты растущих размеров, а этот процесс одновременно читает снимки и сверяет каждый с
+ * опубликованными: seqlock не должен пропустить ни одного разорванного чтения, а после выхода
+ * издателя у читателя должен остаться последний лабиринт. С --check сегмент NAME сравнивается с
+ * файлом, записанным тем же запуском mazegen.
+ * Использование: sharedmemorybenchmark [seed'ов на размер, по умолчанию 20] [кругов, по умолчанию 50]
+ *                sharedmemorybenchmark --check /NAME FILE.amz */
+int main(int argc, char *argv[])
+{
+    if (argc > 1 && std::strcmp(argv[1], "--check") == 0)
+    {
+        if (argc != 4)
+        {
+            std::fprintf(stderr, "Usage: %s --check /NAME FILE.amz\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+        return checkPublishedFile(argv[2], argv[3]);
+    }
+    const std::uint64_t seedCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 20;
+    const unsigned int roundCount = argc > 2 ? static_cast<unsigned int>(std::strtoul(argv[2], nullptr, 10)) : 50;
+    if (seedCount == 0 || roundCount == 0)
+    {
+        std::fprintf(stderr, "Usage: %s [SEEDS_PER_SIZE] [ROUNDS]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    return runRoundTrip(seedCount, roundCount);
+}
@@ -0,0 +1,30 @@
+TEMPLATE = app
+TARGET = stepgeneratorbenchmark
+
+QT -= core gui
+
+CONFIG += console c++11 thread
+CONFIG -= app_bundle
+
+INCLUDEPATH += ../../include
+
+SOURCES += \
+    stepgeneratorbenchmark.cpp \
+    ../../src/cyclepoppinggenerator.cpp \
+    ../../src/mazegenerator.cpp \
+    ../../src/mazerandom.cpp \
+    ../../src/mazestepgenerator.cpp \
+    ../../src/packedmazegrid.cpp \
+    ../../src/rowwisegenerator.cpp \
+    ../../src/uniformtreegenerator.cpp \
+    ../../src/visitheatmap.cpp
+
+HEADERS += \
+    ../../include/cyclepoppinggenerator.h \
+    ../../include/mazegenerator.h \
+    ../../include/mazerandom.h \
+    ../../include/mazestepgenerator.h \
+    ../../include/packedmazegrid.h \
+    ../../include/rowwisegenerator.h \
+    ../../include/uniformtreegenerator.h \
+    ../../include/visitheatmap.h
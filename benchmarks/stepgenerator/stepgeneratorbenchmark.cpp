@@ -0,0 +1,105 @@
+#include "mazegenerator.h"
+#include "mazestepgenerator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+namespace
+{
+bool isSameGrid(const PackedMazeGrid &first, const PackedMazeGrid &second)
+{
+    if (first.getWidth() != second.getWidth() || first.getHeight() != second.getHeight())
+        return false;
+    for (std::size_t row = 0; row < first.getHeight(); ++row)
+    {
+        if (!std::equal(first.getRightRow(row), first.getRightRow(row) + first.getWordsPerRow(), second.getRightRow(row)) ||
+                !std::equal(first.getBotRow(row), first.getBotRow(row) + first.getWordsPerRow(), second.getBotRow(row)))
+            return false;
+    }
+    return true;
+}
+
+// Лабиринт по шагам next(); возвращает число шагов
+std::size_t generateBySteps(const GenerationParameters &parameters, PackedMazeGrid &grid)
+{
+    grid.resize(parameters.width, parameters.height);
+    MazeStepGenerator generator(parameters.algorithm, parameters.width, parameters.height, parameters.seed);
+    MazeStepGenerator::Step step;
+    std::size_t stepCount {0};
+    while (generator.next(step))
+    {
+        MazeStepGenerator::applyStep(step, grid);
+        ++stepCount;
+    }
+    return stepCount;
+}
+}
+
+/* Проверка и замер MazeStepGenerator: шаги next() при том же seed должны строить тот же лабиринт,
+ * что MazeGenerator, - на вырожденных сетках в одну клетку или строку и на seedCount seed'ах
+ * нескольких размеров. Затем на лабиринте size x size сравнивается время генерации по шагам,
+ * через run() и через MazeGenerator: run() должен идти со скоростью MazeGenerator.
+ * Использование: stepgeneratorbenchmark [размер, по умолчанию 1000] [seed'ов, по умолчанию 200] */
+int main(int argc, char *argv[])
+{
+    const std::size_t mazeSize = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000;
+    const std::uint64_t seedCount = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 200;
+    const struct
+    {
+        const char *name;
+        int algorithm;
+    } algorithms[] {{"Aldous-Broder", MazeGenerator::Algorithm::AldousBroder},
+                    {"Recursive Backtracker", MazeGenerator::Algorithm::RecursiveBacktracker},
+                    {"Wilson", MazeGenerator::Algorithm::Wilson}};
+    const struct
+    {
+        std::size_t width;
+        std::size_t height;
+    } checkedSizes[] {{1, 1}, {1, 9}, {9, 1}, {2, 2}, {7, 5}, {64, 64}, {65, 3}, {130, 70}};
+
+    bool isPassed {true};
+    std::printf("%-22s %8s %12s %10s %10s %10s %8s  %s\n", "algorithm", "mismatch", "steps", "steps ms",
+                "run ms", "batch ms", "speedup", "verdict");
+    for (const auto &algorithm : algorithms)
+    {
+        PackedMazeGrid steppedGrid;
+        PackedMazeGrid batchGrid;
+        std::size_t mismatches {0};
+        for (const auto &size : checkedSizes)
+        {
+            for (std::uint64_t seed = 1; seed <= seedCount; ++seed)
+            {
+                const GenerationParameters parameters(algorithm.algorithm, size.width, size.height, seed);
+                generateBySteps(parameters, steppedGrid);
+                MazeGenerator::generate(parameters, batchGrid);
+                if (!isSameGrid(steppedGrid, batchGrid) && mismatches++ == 0)
+                    std::printf("  mismatch %zux%zu seed %llu\n", size.width, size.height,
+                                static_cast<unsigned long long>(seed));
+            }
+        }
+
+        const GenerationParameters parameters(algorithm.algorithm, mazeSize, mazeSize, 1);
+        auto start = std::chrono::steady_clock::now();
+        const std::size_t stepCount = generateBySteps(parameters, steppedGrid);
+        const std::chrono::duration<double, std::milli> stepsTime = std::chrono::steady_clock::now() - start;
+
+        PackedMazeGrid runGrid;
+        start = std::chrono::steady_clock::now();
+        MazeStepGenerator(algorithm.algorithm, mazeSize, mazeSize, 1).run(runGrid);
+        const std::chrono::duration<double, std::milli> runTime = std::chrono::steady_clock::now() - start;
+
+        start = std::chrono::steady_clock::now();
+        MazeGenerator::generate(parameters, batchGrid);
+        const std::chrono::duration<double, std::milli> batchTime = std::chrono::steady_clock::now() - start;
+
+        if (!isSameGrid(steppedGrid, batchGrid) || !isSameGrid(runGrid, batchGrid))
+            ++mismatches;
+        std::printf("%-22s %8zu %12zu %10.1f %10.1f %10.1f %7.2fx  %s\n", algorithm.name, mismatches, stepCount,
+                    stepsTime.count(), runTime.count(), batchTime.count(), stepsTime.count() / runTime.count(),
+                    mismatches == 0 ? "ok" : "FAIL");
+        isPassed = mismatches == 0 && isPassed;
+    }
+    return isPassed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
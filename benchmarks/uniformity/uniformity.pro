@@ -0,0 +1,34 @@
+TEMPLATE = app
+TARGET = uniformitybenchmark
+
+QT -= core gui
+
+CONFIG += console c++11 thread
+CONFIG -= app_bundle
+
+INCLUDEPATH += ../../include
+
+SOURCES += \
+    uniformitybenchmark.cpp \
+    ../../src/cyclepoppinggenerator.cpp \
+    ../../src/maskedmazegenerator.cpp \
+    ../../src/mazegenerator.cpp \
+    ../../src/mazemask.cpp \
+    ../../src/mazerandom.cpp \
+    ../../src/mazestepgenerator.cpp \
+    ../../src/packedmazegrid.cpp \
+    ../../src/rowwisegenerator.cpp \
+    ../../src/uniformtreegenerator.cpp \
+    ../../src/visitheatmap.cpp
+
+HEADERS += \
+    ../../include/cyclepoppinggenerator.h \
+    ../../include/maskedmazegenerator.h \
+    ../../include/mazegenerator.h \
+    ../../include/mazemask.h \
+    ../../include/mazerandom.h \
+    ../../include/mazestepgenerator.h \
+    ../../include/packedmazegrid.h \
+    ../../include/rowwisegenerator.h \
+    ../../include/uniformtreegenerator.h \
+    ../../include/visitheatmap.h
@@ -0,0 +1,348 @@
+#include "cyclepoppinggenerator.h"
+#include "maskedmazegenerator.h"
+#include "mazegenerator.h"
+#include "mazerandom.h"
+#include "mazestepgenerator.h"
+#include "uniformtreegenerator.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace
+{
+// Порог p-value, ниже которого генератор считается неравномерным
+const double SIGNIFICANCE_LEVEL {1e-3};
+
+unsigned int countTrailingZeros(std::uint32_t word)
+{
+#if defined(__GNUC__)
+    return static_cast<unsigned int>(__builtin_ctz(word));
+#else
+    unsigned int count {0};
+    for (; !(word & 1); word >>= 1)
+        ++count;
+    return count;
+#endif
+}
+
+// Лабиринт по шагам next(), а не через run(), который отдает генерацию MazeGenerator
+void generateBySteps(int algorithm, std::size_t width, std::size_t height, std::uint64_t seed, PackedMazeGrid &grid)
+{
+    grid.resize(width, height);
+    MazeStepGenerator generator(algorithm, width, height, seed);
+    MazeStepGenerator::Step step;
+    while (generator.next(step))
+        MazeStepGenerator::applyStep(step, grid);
+}
+
+// Соседняя клетка в направлении direction или false, если там край сетки
+bool findNeighbor(std::size_t cell, std::size_t width, std::size_t height, int direction, std::size_t &neighbor)
+{
+    const std::size_t x = cell % width;
+    const std::size_t y = cell / width;
+    switch (direction)
+    {
+    case PackedMazeGrid::Direction::Top :
+        neighbor = cell - width;
+        return y > 0;
+    case PackedMazeGrid::Direction::Right :
+        neighbor = cell + 1;
+        return x + 1 < width;
+    case PackedMazeGrid::Direction::Bot :
+        neighbor = cell + width;
+        return y + 1 < height;
+    case PackedMazeGrid::Direction::Left :
+        neighbor = cell - 1;
+        return x > 0;
+    }
+    return false;
+}
+
+/* Контрольный неравномерный генератор: Aldous-Broder, пока не посещена доля switchShare клеток,
+ * затем блуждания Уилсона с корнем во всем построенном дереве. Продолжение Aldous-Broder зависит
+ * от того, где стоит блуждающий, а Уилсон это положение не учитывает, поэтому распределение
+ * деревьев смещено. Тест, который этот генератор проходит, слишком слаб */
+void generateAldousBroderWilson(std::size_t width, std::size_t height, std::uint64_t seed, double switchShare,
+                                PackedMazeGrid &grid)
+{
+    const std::size_t cellCount = width * height;
+    grid.resize(width, height);
+    MazeRandom random(seed);
+    std::vector<std::uint8_t> isInTree(cellCount, 0);
+    // Направление последнего выхода из клетки при блуждании Уилсона; перезапись стирает петли
+    std::vector<int> exitDirections(cellCount, 0);
+    const auto walk = [&](std::size_t cell, int &direction) {
+        std::size_t neighbor {};
+        do
+            direction = static_cast<int>(random.bounded(PackedMazeGrid::Direction::Count));
+        while (!findNeighbor(cell, width, height, direction, neighbor));
+        return neighbor;
+    };
+
+    std::size_t cell = static_cast<std::size_t>(random.generate64() % cellCount);
+    isInTree[cell] = 1;
+    const std::size_t switchCells = static_cast<std::size_t>(switchShare * cellCount);
+    for (std::size_t visitedCells = 1; visitedCells < switchCells;)
+    {
+        int direction {};
+        const std::size_t nextCell = walk(cell, direction);
+        if (!isInTree[nextCell])
+        {
+            grid.setPassage(cell % width, cell / width, direction, true);
+            isInTree[nextCell] = 1;
+            ++visitedCells;
+        }
+        cell = nextCell;
+    }
+
+    for (std::size_t startCell = 0; startCell < cellCount; ++startCell)
+    {
+        for (cell = startCell; !isInTree[cell];)
+            cell = walk(cell, exitDirections[cell]);
+        for (cell = startCell; !isInTree[cell];)
+        {
+            isInTree[cell] = 1;
+            grid.setPassage(cell % width, cell / width, exitDirections[cell], true);
+            findNeighbor(cell, width, height, exitDirections[cell], cell);
+        }
+    }
+}
+
+struct GeneratorCase
+{
+    const char *name;
+    // Гибрид Aldous-Broder/Wilson равномерным быть не обязан и служит проверкой чувствительности теста
+    bool isExactlyUniform;
+    std::function<void(std::size_t width, std::size_t height, std::uint64_t seed, PackedMazeGrid &grid)> generate;
+};
+
+/* Все остовные деревья решетки width x height и таблица "набор проходов -> номер дерева".
+ * Проход - бит маски: сначала горизонтальные (x, y)-(x + 1, y) по строкам, затем вертикальные
+ * (x, y)-(x, y + 1). Деревья перебираются как наборы из cells - 1 проходов без циклов */
+class SpanningTreeIndex
+{
+private:
+    std::size_t width_ {};
+    std::size_t height_ {};
+    std::size_t treeCount_ {};
+    std::vector<std::uint32_t> slotKeys_;
+    std::vector<std::uint32_t> slotTrees_;
+    std::uint32_t slotMask_ {};
+
+    std::size_t findSlot(std::uint32_t edges) const
+    {
+        std::size_t slot = static_cast<std::uint32_t>(edges * 0x9E3779B1u) & slotMask_;
+        while (slotKeys_[slot] != 0 && slotKeys_[slot] != edges)
+            slot = (slot + 1) & slotMask_;
+        return slot;
+    }
+
+    bool isTree(std::uint32_t edges, std::vector<std::size_t> &parents) const
+    {
+        for (std::size_t cell = 0; cell < parents.size(); ++cell)
+            parents[cell] = cell;
+        auto findRoot = [&parents](std::size_t cell) {
+            while (parents[cell] != cell)
+                cell = parents[cell] = parents[parents[cell]];
+            return cell;
+        };
+        const std::size_t horizontalEdges = height_ * (width_ - 1);
+        for (; edges != 0; edges &= edges - 1)
+        {
+            const std::size_t edge = countTrailingZeros(edges);
+            const std::size_t from = edge < horizontalEdges ? edge / (width_ - 1) * width_ + edge % (width_ - 1) :
+                                                              edge - horizontalEdges;
+            const std::size_t to = edge < horizontalEdges ? from + 1 : from + width_;
+            const std::size_t fromRoot = findRoot(from);
+            const std::size_t toRoot = findRoot(to);
+            if (fromRoot == toRoot)
+                return false;
+            parents[fromRoot] = toRoot;
+        }
+        return true;
+    }
+
+public:
+    SpanningTreeIndex(std::size_t width, std::size_t height)
+        : width_(width),
+          height_(height)
+    {
+        const std::size_t cellCount = width * height;
+        const unsigned int edgeCount = static_cast<unsigned int>(height * (width - 1) + (height - 1) * width);
+        const unsigned int treeEdges = static_cast<unsigned int>(cellCount - 1);
+        std::vector<std::uint32_t> trees;
+        std::vector<std::size_t> parents(cellCount);
+        // Все маски из treeEdges бит по возрастанию (Gosper's hack)
+        for (std::uint32_t edges = (std::uint32_t(1) << treeEdges) - 1; edges < (std::uint32_t(1) << edgeCount);)
+        {
+            if (isTree(edges, parents))
+                trees.push_back(edges);
+            const std::uint32_t lowest = edges & (0u - edges);
+            const std::uint32_t ripple = edges + lowest;
+            edges = ripple | (((edges ^ ripple) >> 2) / lowest);
+        }
+
+        treeCount_ = trees.size();
+        std::size_t slotCount {1};
+        while (slotCount < treeCount_ * 2)
+            slotCount *= 2;
+        slotMask_ = static_cast<std::uint32_t>(slotCount - 1);
+        slotKeys_.assign(slotCount, 0);
+        slotTrees_.assign(slotCount, 0);
+        for (std::size_t tree = 0; tree < treeCount_; ++tree)
+        {
+            const std::size_t slot = findSlot(trees[tree]);
+            slotKeys_[slot] = trees[tree];
+            slotTrees_[slot] = static_cast<std::uint32_t>(tree);
+        }
+    }
+
+    std::size_t getTreeCount() const
+    {
+        return treeCount_;
+    }
+
+    // Номер дерева или getTreeCount(), если проходы лабиринта не образуют остовное дерево
+    std::size_t findTree(const PackedMazeGrid &grid) const
+    {
+        std::uint32_t edges {0};
+        const std::uint64_t rightMask = (std::uint64_t(1) << (width_ - 1)) - 1;
+        const std::uint64_t botMask = (std::uint64_t(1) << width_) - 1;
+        const std::size_t horizontalEdges = height_ * (width_ - 1);
+        for (std::size_t y = 0; y < height_; ++y)
+        {
+            edges |= static_cast<std::uint32_t>((grid.getRightRow(y)[0] & rightMask) << (y * (width_ - 1)));
+            if (y + 1 < height_)
+                edges |= static_cast<std::uint32_t>((grid.getBotRow(y)[0] & botMask) << (horizontalEdges + y * width_));
+        }
+        const std::size_t slot = findSlot(edges);
+        return slotKeys_[slot] == edges && edges != 0 ? slotTrees_[slot] : treeCount_;
+    }
+};
+
+// P(X >= chiSquare) для хи-квадрат с degrees степенями свободы; приближение Уилсона-Хилферти
+double computePValue(double chiSquare, double degrees)
+{
+    const double variance = 2.0 / (9.0 * degrees);
+    const double z = (std::cbrt(chiSquare / degrees) - (1.0 - variance)) / std::sqrt(variance);
+    return 0.5 * std::erfc(z / std::sqrt(2.0));
+}
+
+/* Прогон одного генератора: sampleCount лабиринтов с seed baseSeed, baseSeed + 1, ... делятся
+ * между потоками подряд идущими блоками. Каждый поток считает частоты деревьев в своей
+ * гистограмме без синхронизации, после join гистограммы складываются. Возвращает true, если
+ * генератор прошел проверку */
+bool checkGenerator(const GeneratorCase &generatorCase, const SpanningTreeIndex &treeIndex, std::size_t size,
+                    std::uint64_t sampleCount, std::uint64_t baseSeed, unsigned int threadCount)
+{
+    const std::size_t treeCount = treeIndex.getTreeCount();
+    // Последний элемент гистограммы - лабиринты, которые не являются остовным деревом
+    std::vector<std::vector<std::uint64_t>> histograms(threadCount, std::vector<std::uint64_t>(treeCount + 1, 0));
+
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (unsigned int worker = 0; worker < threadCount; ++worker)
+    {
+        workers.emplace_back([&, worker] {
+            const std::uint64_t firstSample = sampleCount * worker / threadCount;
+            const std::uint64_t lastSample = sampleCount * (worker + 1) / threadCount;
+            std::vector<std::uint64_t> &histogram = histograms[worker];
+            PackedMazeGrid grid;
+            for (std::uint64_t sample = firstSample; sample < lastSample; ++sample)
+            {
+                generatorCase.generate(size, size, baseSeed + sample, grid);
+                ++histogram[treeIndex.findTree(grid)];
+            }
+        });
+    }
+    for (std::thread &worker : workers)
+        worker.join();
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::vector<std::uint64_t> counts(treeCount + 1, 0);
+    for (const std::vector<std::uint64_t> &histogram : histograms)
+    {
+        for (std::size_t tree = 0; tree <= treeCount; ++tree)
+            counts[tree] += histogram[tree];
+    }
+
+    const double expected = static_cast<double>(sampleCount) / treeCount;
+    double chiSquare {0.0};
+    std::uint64_t unseenTrees {0};
+    for (std::size_t tree = 0; tree < treeCount; ++tree)
+    {
+        const double deviation = static_cast<double>(counts[tree]) - expected;
+        chiSquare += deviation * deviation / expected;
+        if (counts[tree] == 0)
+            ++unseenTrees;
+    }
+    const double pValue = computePValue(chiSquare, static_cast<double>(treeCount - 1));
+    const std::uint64_t invalidMazes = counts[treeCount];
+    const bool isUniform = invalidMazes == 0 && pValue >= SIGNIFICANCE_LEVEL;
+
+    std::printf("%-26s %zux%zu %10llu %12.0f %14.1f %10.2e %8llu %8llu  %s\n", generatorCase.name, size, size,
+                static_cast<unsigned long long>(sampleCount), sampleCount / elapsed.count(), chiSquare, pValue,
+                static_cast<unsigned long long>(unseenTrees), static_cast<unsigned long long>(invalidMazes),
+                isUniform ? "ok" : generatorCase.isExactlyUniform ? "FAIL" : "non-uniform (expected)");
+    return isUniform || !generatorCase.isExactlyUniform;
+}
+}
+
+/* Проверка равномерности генераторов остовных деревьев: на решетках 3x3 (192 дерева) и 4x4
+ * (100 352 дерева) каждый генератор строит sampleCount лабиринтов во всех потоках, частоты
+ * деревьев сравниваются с равномерными по хи-квадрат. Ошибка в ГСЧ или в стирании петель
+ * проявляется как маленькое p-value или как лабиринт, не являющийся деревом. Для 4x4 нужно
+ * хотя бы 10^6 лабиринтов, чтобы на дерево приходилось не меньше 5-10 ожидаемых попаданий.
+ * Использование: uniformitybenchmark [лабиринтов на генератор и размер, по умолчанию 10^6] [seed] */
+int main(int argc, char *argv[])
+{
+    const std::uint64_t sampleCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    const std::uint64_t baseSeed = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1;
+    const unsigned int threadCount = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1;
+
+    const std::vector<GeneratorCase> generatorCases {
+        {"Aldous-Broder", true, [](std::size_t width, std::size_t height, std::uint64_t seed, PackedMazeGrid &grid) {
+            UniformTreeGenerator(width, height, seed).generate(UniformTreeGenerator::Algorithm::AldousBroder, grid);
+        }},
+        {"Wilson", true, [](std::size_t width, std::size_t height, std::uint64_t seed, PackedMazeGrid &grid) {
+            UniformTreeGenerator(width, height, seed).generate(UniformTreeGenerator::Algorithm::Wilson, grid);
+        }},
+        // Пошаговые версии - то, что анимирует Maze в интерфейсе
+        {"Aldous-Broder (steps)", true, [](std::size_t width, std::size_t height, std::uint64_t seed, PackedMazeGrid &grid) {
+            generateBySteps(MazeGenerator::Algorithm::AldousBroder, width, height, seed, grid);
+        }},
+        {"Wilson (steps)", true, [](std::size_t width, std::size_t height, std::uint64_t seed, PackedMazeGrid &grid) {
+            generateBySteps(MazeGenerator::Algorithm::Wilson, width, height, seed, grid);
+        }},
+        {"Wilson (full mask)", true, [](std::size_t width, std::size_t height, std::uint64_t seed, PackedMazeGrid &grid) {
+            MazeMask mask(width, height);
+            mask.fill(true);
+            mask.buildIndex();
+            MaskedMazeGenerator(mask, seed).generate(MazeGenerator::Algorithm::Wilson, grid);
+        }},
+        {"Cycle popping", true, [](std::size_t width, std::size_t height, std::uint64_t seed, PackedMazeGrid &grid) {
+            CyclePoppingGenerator(width, height, seed, 1).generate(grid);
+        }},
+        // При переключении на половине клеток перекос на 3x3 виден уже на 10^5 лабиринтах
+        {"Aldous-Broder + Wilson 0.5", false, [](std::size_t width, std::size_t height, std::uint64_t seed, PackedMazeGrid &grid) {
+            generateAldousBroderWilson(width, height, seed, 0.5, grid);
+        }}};
+
+    std::printf("%u threads, p-value threshold %.0e\n", threadCount, SIGNIFICANCE_LEVEL);
+    std::printf("%-26s %4s %10s %12s %14s %10s %8s %8s  %s\n", "generator", "size", "samples", "samples/s",
+                "chi-square", "p-value", "unseen", "invalid", "verdict");
+    bool isPassed {true};
+    for (std::size_t size : {3, 4})
+    {
+        const SpanningTreeIndex treeIndex(size, size);
+        std::printf("%zux%zu: %zu spanning trees\n", size, size, treeIndex.getTreeCount());
+        for (const GeneratorCase &generatorCase : generatorCases)
+            isPassed = checkGenerator(generatorCase, treeIndex, size, sampleCount, baseSeed, threadCount) && isPassed;
+    }
+    return isPassed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,61 @@
+TEMPLATE = app
+TARGET = mazegen
+
+QT -= core gui
+
+CONFIG += console c++11 thread
+CONFIG -= app_bundle
+
+INCLUDEPATH += ../include
+
+SOURCES += \
+    main.cpp \
+    ../src/algorithmrace.cpp \
+    ../src/compactmazeformat.cpp \
+    ../src/cyclepoppinggenerator.cpp \
+    ../src/generationcheckpoint.cpp \
+    ../src/maskedmazegenerator.cpp \
+    ../src/mazeadjacency.cpp \
+    ../src/mazeanimationexporter.cpp \
+    ../src/mazearchive.cpp \
+    ../src/mazecache.cpp \
+    ../src/mazecanonicalhash.cpp \
+    ../src/mazeentropycoder.cpp \
+    ../src/mazegenerator.cpp \
+    ../src/mazehashset.cpp \
+    ../src/mazemask.cpp \
+    ../src/mazerandom.cpp \
+    ../src/mazestepgenerator.cpp \
+    ../src/mazevectorexporter.cpp \
+    ../src/packedmazegrid.cpp \
+    ../src/rowwisegenerator.cpp \
+    ../src/sharedmazesegment.cpp \
+    ../src/uniformtreegenerator.cpp \
+    ../src/visitheatmap.cpp
+
+HEADERS += \
+    ../include/algorithmrace.h \
+    ../include/compactmazeformat.h \
+    ../include/cyclepoppinggenerator.h \
+    ../include/generationcheckpoint.h \
+    ../include/maskedmazegenerator.h \
+    ../include/mazeadjacency.h \
+    ../include/mazeanimationexporter.h \
+    ../include/mazearchive.h \
+    ../include/mazecache.h \
+    ../include/mazecanonicalhash.h \
+    ../include/mazeentropycoder.h \
+    ../include/mazegenerator.h \
+    ../include/mazehashset.h \
+    ../include/mazemask.h \
+    ../include/mazerandom.h \
+    ../include/mazestepgenerator.h \
+    ../include/mazevectorexporter.h \
+    ../include/packedmazegrid.h \
+    ../include/rowwisegenerator.h \
+    ../include/sharedmazesegment.h \
+    ../include/uniformtreegenerator.h \
+    ../include/visitheatmap.h
+
+# shm_open на Linux со старой glibc живет в librt
+linux: LIBS += -lrt
@@ -0,0 +1,691 @@
+#include "algorithmrace.h"
+#include "compactmazeformat.h"
+#include "maskedmazegenerator.h"
+#include "generationcheckpoint.h"
+#include "mazeadjacency.h"
+#include "mazeanimationexporter.h"
+#include "mazearchive.h"
+#include "mazecache.h"
+#include "mazeentropycoder.h"
+#include "mazecanonicalhash.h"
+#include "mazegenerator.h"
+#include "mazehashset.h"
+#include "mazevectorexporter.h"
+#include "sharedmazesegment.h"
+#include "uniformtreegenerator.h"
+#include "visitheatmap.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+// Начальная емкость множества для --dedupe (32 МиБ), дальше оно удваивается по мере надобности
+const std::uint64_t INITIAL_DEDUPE_CAPACITY {std::uint64_t(1) << 20};
+
+std::atomic<bool> isStopRequested {false};
+
+void handleStopSignal(int)
+{
+    isStopRequested = true;
+}
+
+enum DedupeMode {NoDedupe, ExactDedupe, SymmetricDedupe};
+
+struct Options
+{
+    int algorithm {MazeGenerator::Algorithm::Wilson};
+    std::size_t width {};
+    std::size_t height {};
+    std::uint64_t seed {};
+    bool isSeedSet {false};
+    std::string outputPath;
+    std::string checkpointPath;
+    unsigned int checkpointIntervalSeconds {300};
+    std::string resumePath;
+    std::string archivePath;
+    std::uint64_t count {1};
+    int dedupeMode {NoDedupe};
+    std::string extractPath;
+    std::uint64_t index {};
+    std::string heatmapPath;
+    std::string adjacencyPath;
+    std::string vectorPath;
+    std::vector<int> raceAlgorithms;
+    std::string animationPath;
+    std::size_t frameSteps {10};
+    std::string maskPath;
+    std::string cacheDirectory;
+    std::uint64_t cacheSizeBytes {std::uint64_t(1) << 30};
+    std::string sharedMemoryName;
+};
+
+void printUsage(const char *programName)
+{
+    std::fprintf(stderr,
+                 "Usage: %s --width W --height H --output FILE [--algorithm N] [--seed S]\n"
+                 "          [--checkpoint FILE] [--checkpoint-interval SECONDS] [--heatmap FILE.csv]\n"
+                 "          [--adjacency FILE] [--vector FILE.svg|FILE.pdf] [--cache-dir DIR] [--cache-size BYTES]\n"
+                 "          [--shared-memory /NAME]\n"
+                 "       %s --mask FILE.pbm --output FILE [--algorithm 1|2] [--seed S] [--adjacency FILE] [--vector FILE]\n"
+                 "       %s --resume CHECKPOINT --output FILE [--checkpoint FILE]\n"
+                 "       %s --width W --height H --archive FILE [--count N] [--algorithm N] [--seed S]\n"
+                 "          [--dedupe exact|symmetric]\n"
+                 "       %s --extract ARCHIVE [--index I] --output FILE [--adjacency FILE] [--vector FILE]\n"
+                 "       %s --width W --height H --race all|N,N,... [--seed S]\n"
+                 "       %s --width W --height H --animate FILE.gif|PREFIX [--frame-steps N] [--algorithm N] [--seed S]\n"
+                 "Algorithms: 0 Aldous-Broder, 1 Recursive Backtracker, 2 Wilson, 3 Binary Tree,\n"
+                 "            4 Sidewinder, 5 Cycle Popping\n"
+                 "Checkpoints and visit heatmaps are supported for 0 and 2.\n"
+                 "Archive mazes get seeds S, S + 1, ..., S + N - 1 and are appended to an existing archive.\n"
+                 "--dedupe skips mazes equal to an earlier one of the run, exactly or up to rotation and mirroring.\n"
+                 "--adjacency also writes the maze graph in CSR form (see MazeAdjacency) for mmap.\n"
+                 "--vector also draws the maze as SVG or PDF (by extension) with merged wall runs.\n"
+                 "--cache-dir takes a maze with an explicit --seed from a cache directory shared with the GUI\n"
+                 "and the daemon, or stores it there; without checkpoints and heatmaps only.\n"
+                 "--mask shapes the maze by a PBM image: black pixels are cells, the rest stays solid.\n"
+                 "--shared-memory generates straight into a POSIX shared memory segment (see SharedMazeReader)\n"
+                 "and leaves it there after exit; the next run with the same name replaces it.\n"
+                 "A race generates the same size and seed with every listed algorithm in parallel threads.\n"
+                 "--animate records generation (0, 1 and 2) as a GIF or as PREFIX_00000.png, ..., N steps per frame.\n",
+                 programName, programName, programName, programName, programName, programName, programName);
+}
+
+// "all" или номера алгоритмов через запятую
+bool parseRaceAlgorithms(const char *value, std::vector<int> &algorithms)
+{
+    algorithms.clear();
+    if (std::strcmp(value, "all") == 0)
+    {
+        for (int algorithm = 0; algorithm < MazeGenerator::Algorithm::Count; ++algorithm)
+        {
+            if (MazeGenerator::isSupported(algorithm))
+                algorithms.push_back(algorithm);
+        }
+        return true;
+    }
+    for (;;)
+    {
+        char *end {nullptr};
+        const long algorithm = std::strtol(value, &end, 10);
+        if (end == value || !MazeGenerator::isSupported(static_cast<int>(algorithm)))
+            return false;
+        algorithms.push_back(static_cast<int>(algorithm));
+        if (*end == '\0')
+            return true;
+        if (*end != ',')
+            return false;
+        value = end + 1;
+    }
+}
+
+bool parseOptions(int argc, char *argv[], Options &options)
+{
+    for (int argument = 1; argument + 1 < argc; argument += 2)
+    {
+        const char *name = argv[argument];
+        const char *value = argv[argument + 1];
+        if (std::strcmp(name, "--algorithm") == 0)
+            options.algorithm = std::atoi(value);
+        else if (std::strcmp(name, "--width") == 0)
+            options.width = std::strtoull(value, nullptr, 10);
+        else if (std::strcmp(name, "--height") == 0)
+            options.height = std::strtoull(value, nullptr, 10);
+        else if (std::strcmp(name, "--seed") == 0)
+        {
+            options.seed = std::strtoull(value, nullptr, 10);
+            options.isSeedSet = true;
+        }
+        else if (std::strcmp(name, "--output") == 0)
+            options.outputPath = value;
+        else if (std::strcmp(name, "--checkpoint") == 0)
+            options.checkpointPath = value;
+        else if (std::strcmp(name, "--checkpoint-interval") == 0)
+            options.checkpointIntervalSeconds = static_cast<unsigned int>(std::strtoul(value, nullptr, 10));
+        else if (std::strcmp(name, "--resume") == 0)
+            options.resumePath = value;
+        else if (std::strcmp(name, "--archive") == 0)
+            options.archivePath = value;
+        else if (std::strcmp(name, "--count") == 0)
+            options.count = std::strtoull(value, nullptr, 10);
+        else if (std::strcmp(name, "--dedupe") == 0)
+        {
+            if (std::strcmp(value, "exact") == 0)
+                options.dedupeMode = ExactDedupe;
+            else if (std::strcmp(value, "symmetric") == 0)
+                options.dedupeMode = SymmetricDedupe;
+            else
+                return false;
+        }
+        else if (std::strcmp(name, "--extract") == 0)
+            options.extractPath = value;
+        else if (std::strcmp(name, "--index") == 0)
+            options.index = std::strtoull(value, nullptr, 10);
+        else if (std::strcmp(name, "--heatmap") == 0)
+            options.heatmapPath = value;
+        else if (std::strcmp(name, "--adjacency") == 0)
+            options.adjacencyPath = value;
+        else if (std::strcmp(name, "--vector") == 0)
+            options.vectorPath = value;
+        else if (std::strcmp(name, "--animate") == 0)
+            options.animationPath = value;
+        else if (std::strcmp(name, "--frame-steps") == 0)
+            options.frameSteps = std::strtoull(value, nullptr, 10);
+        else if (std::strcmp(name, "--mask") == 0)
+            options.maskPath = value;
+        else if (std::strcmp(name, "--cache-dir") == 0)
+            options.cacheDirectory = value;
+        else if (std::strcmp(name, "--cache-size") == 0)
+            options.cacheSizeBytes = std::strtoull(value, nullptr, 10);
+        else if (std::strcmp(name, "--shared-memory") == 0)
+            options.sharedMemoryName = value;
+        else if (std::strcmp(name, "--race") == 0)
+        {
+            if (!parseRaceAlgorithms(value, options.raceAlgorithms))
+                return false;
+        }
+        else
+            return false;
+    }
+    const bool hasSize = options.width > 0 && options.height > 0;
+    if (argc % 2 == 0)
+        return false;
+    // Разделяемая память - только для генерации одного лабиринта по размеру или из контрольной точки
+    if (!options.sharedMemoryName.empty() && (!options.maskPath.empty() || !options.extractPath.empty()))
+        return false;
+    // Размер лабиринта по маске задает сама маска
+    if (!options.maskPath.empty())
+        return !options.outputPath.empty() && options.archivePath.empty() && options.raceAlgorithms.empty() &&
+                options.animationPath.empty() && options.resumePath.empty() && options.extractPath.empty();
+    if (!options.archivePath.empty() || !options.raceAlgorithms.empty() || !options.animationPath.empty())
+        return hasSize && options.sharedMemoryName.empty();
+    return !options.outputPath.empty() && (!options.extractPath.empty() || !options.resumePath.empty() || hasSize);
+}
+
+// Номер алгоритма UniformTreeGenerator или -1, если контрольные точки для алгоритма не поддерживаются
+int toUniformTreeAlgorithm(int algorithm)
+{
+    switch (algorithm)
+    {
+    case MazeGenerator::Algorithm::AldousBroder :
+        return UniformTreeGenerator::Algorithm::AldousBroder;
+    case MazeGenerator::Algorithm::Wilson :
+        return UniformTreeGenerator::Algorithm::Wilson;
+    }
+    return -1;
+}
+
+// Номер алгоритма MazeGenerator или -1, если в контрольной точке неизвестный алгоритм
+int toMazeGeneratorAlgorithm(int uniformTreeAlgorithm)
+{
+    switch (uniformTreeAlgorithm)
+    {
+    case UniformTreeGenerator::Algorithm::AldousBroder :
+        return MazeGenerator::Algorithm::AldousBroder;
+    case UniformTreeGenerator::Algorithm::Wilson :
+        return MazeGenerator::Algorithm::Wilson;
+    }
+    return -1;
+}
+
+bool writeCompactMaze(const std::string &outputPath, const GenerationParameters &parameters, const PackedMazeGrid &grid)
+{
+    std::ofstream output(outputPath, std::ios::binary | std::ios::trunc);
+    CompactMazeFormat::write(output, parameters, grid);
+    if (!output.flush())
+    {
+        std::fprintf(stderr, "Unable to write %s\n", outputPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool writeAdjacency(const std::string &adjacencyPath, const PackedMazeGrid &grid)
+{
+    MazeAdjacency adjacency;
+    if (!adjacency.build(grid))
+    {
+        std::fprintf(stderr, "The maze is too large for a 32-bit adjacency file\n");
+        return false;
+    }
+    if (!adjacency.writeToFile(adjacencyPath))
+    {
+        std::fprintf(stderr, "Unable to write %s\n", adjacencyPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool writeVectorImage(const std::string &vectorPath, const PackedMazeGrid &grid)
+{
+    if (!MazeVectorExporter::writeToFile(vectorPath, grid))
+    {
+        std::fprintf(stderr, "Unable to write %s\n", vectorPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+/* Пакетная генерация в архив. Лабиринты генерируются и сжимаются пачками во всех потоках, а
+ * в архив пишутся одним потоком по порядку, так что номер в архиве совпадает с номером seed.
+ * С --dedupe потоки сразу кладут хеш лабиринта (контрольную сумму или канонический хеш) в общее
+ * множество, и из повторов пишется только лабиринт с наименьшим seed; номера в архиве тогда идут
+ * с пропусками, но seed хранится в каждой записи. По SIGINT или SIGTERM дописывается текущая
+ * пачка, и архив закрывается целым */
+int generateArchive(const Options &options)
+{
+    MazeArchiveWriter archive;
+    if (!archive.open(options.archivePath))
+    {
+        std::fprintf(stderr, "Unable to open archive %s\n", options.archivePath.c_str());
+        return EXIT_FAILURE;
+    }
+
+    const unsigned int threadCount = std::max(1u, std::thread::hardware_concurrency());
+    const std::uint64_t batchSize = std::uint64_t(threadCount) * 64;
+    std::vector<std::vector<std::uint8_t>> encodedMazes(batchSize);
+    std::vector<std::uint64_t> checksums(batchSize);
+    std::unique_ptr<MazeHashSet> seenMazes;
+    std::vector<std::uint64_t> dedupeHashes;
+    std::atomic<bool> isSeenMazesFull {false};
+    if (options.dedupeMode != NoDedupe)
+    {
+        // Множество растет вместе с числом различных лабиринтов, а не выделяется сразу под --count
+        seenMazes.reset(new MazeHashSet(static_cast<std::size_t>(std::min(options.count, INITIAL_DEDUPE_CAPACITY))));
+        dedupeHashes.resize(batchSize);
+    }
+
+    std::uint64_t generatedCount {0};
+    std::uint64_t duplicateCount {0};
+    while (generatedCount < options.count && !isStopRequested)
+    {
+        const std::uint64_t currentBatchSize = std::min(batchSize, options.count - generatedCount);
+        if (seenMazes && seenMazes->getSize() + currentBatchSize > seenMazes->getCapacity())
+        {
+            const std::uint64_t capacity = std::max<std::uint64_t>(std::uint64_t(seenMazes->getCapacity()) * 2,
+                                                                   seenMazes->getSize() + currentBatchSize);
+            try
+            {
+                seenMazes->reserve(static_cast<std::size_t>(capacity));
+            }
+            catch (const std::bad_alloc&)
+            {
+                std::fprintf(stderr, "Not enough memory to track %llu distinct mazes for --dedupe, stopping\n",
+                             static_cast<unsigned long long>(capacity));
+                archive.close();
+                return EXIT_FAILURE;
+            }
+        }
+        std::vector<std::thread> workers;
+        for (unsigned int worker = 0; worker < threadCount; ++worker)
+        {
+            workers.emplace_back([&, worker] {
+                PackedMazeGrid grid;
+                MazeCanonicalHash canonicalHash;
+                for (std::uint64_t maze = worker; maze < currentBatchSize; maze += threadCount)
+                {
+                    const GenerationParameters parameters(options.algorithm, options.width, options.height,
+                                                          options.seed + generatedCount + maze);
+                    MazeGenerator::generate(parameters, grid);
+                    encodedMazes[maze].clear();
+                    MazeEntropyCoder::encode(grid, encodedMazes[maze]);
+                    checksums[maze] = grid.computeChecksum();
+                    if (seenMazes)
+                    {
+                        dedupeHashes[maze] = options.dedupeMode == SymmetricDedupe ? canonicalHash.compute(grid) :
+                                                                                   checksums[maze];
+                        if (seenMazes->insert(dedupeHashes[maze], generatedCount + maze) == MazeHashSet::Full)
+                            isSeenMazesFull = true;
+                    }
+                }
+            });
+        }
+        for (std::thread &worker : workers)
+            worker.join();
+        // Без места в множестве повтор не отличить от нового лабиринта: пачка не пишется совсем
+        if (isSeenMazesFull)
+        {
+            std::fprintf(stderr, "Duplicate filter is full after %llu mazes, stopping\n",
+                         static_cast<unsigned long long>(generatedCount));
+            archive.close();
+            return EXIT_FAILURE;
+        }
+
+        for (std::uint64_t maze = 0; maze < currentBatchSize; ++maze)
+        {
+            if (seenMazes && !seenMazes->isFirst(dedupeHashes[maze], generatedCount + maze))
+            {
+                ++duplicateCount;
+                continue;
+            }
+            const GenerationParameters parameters(options.algorithm, options.width, options.height,
+                                                  options.seed + generatedCount + maze);
+            if (!archive.appendEncoded(parameters, checksums[maze], encodedMazes[maze]))
+            {
+                std::fprintf(stderr, "Unable to write archive %s\n", options.archivePath.c_str());
+                return EXIT_FAILURE;
+            }
+        }
+        generatedCount += currentBatchSize;
+    }
+
+    if (!archive.close())
+    {
+        std::fprintf(stderr, "Unable to write archive %s\n", options.archivePath.c_str());
+        return EXIT_FAILURE;
+    }
+    std::fprintf(stderr, "Appended %llu mazes, skipped %llu duplicates, archive holds %llu\n",
+                 static_cast<unsigned long long>(generatedCount - duplicateCount),
+                 static_cast<unsigned long long>(duplicateCount), static_cast<unsigned long long>(archive.getEntryCount()));
+    return generatedCount == options.count ? EXIT_SUCCESS : 3;
+}
+
+/* Гонка алгоритмов: все перечисленные алгоритмы генерируют лабиринт одного размера с одним seed
+ * одновременно, каждый в своем потоке. По SIGINT или SIGTERM пошаговые дорожки останавливаются */
+int runRace(const Options &options)
+{
+    static const char *const ALGORITHM_NAMES[MazeGenerator::Algorithm::Count] {
+        "Aldous-Broder", "Recursive Backtracker", "Wilson", "Binary Tree", "Sidewinder", "Cycle Popping"};
+
+    AlgorithmRace race(options.raceAlgorithms, options.width, options.height, options.seed);
+    race.start();
+    while (!race.isFinished() && !isStopRequested)
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    race.stop();
+
+    std::printf("%-24s %14s %12s %14s\n", "algorithm", "steps", "elapsed_ms", "steps_per_s");
+    for (std::size_t lane = 0; lane < race.getLaneCount(); ++lane)
+    {
+        const AlgorithmRace::LaneStatus status = race.getLaneStatus(lane);
+        const double stepsPerSecond = status.elapsedNs > 0 ? status.steps * 1e9 / status.elapsedNs : 0.0;
+        std::printf("%-24s %14llu %12.1f %14.0f%s\n", ALGORITHM_NAMES[status.algorithm],
+                    static_cast<unsigned long long>(status.steps), status.elapsedNs / 1e6, stepsPerSecond,
+                    status.isFinished ? "" : " (stopped)");
+    }
+    return race.isFinished() ? EXIT_SUCCESS : 3;
+}
+
+/* Анимация генерации в GIF (по расширению .gif) или в последовательность PNG с префиксом пути.
+ * Кадры рисуются в памяти, поэтому запись идет не в реальном времени, а так быстро, как сжимается */
+int writeAnimation(const Options &options)
+{
+    if (!MazeAnimationExporter::isSupported(options.algorithm))
+    {
+        std::fprintf(stderr, "Animation is supported for algorithms 0, 1 and 2\n");
+        return EXIT_FAILURE;
+    }
+    MazeAnimationExporter::Settings settings;
+    settings.algorithm = options.algorithm;
+    settings.width = options.width;
+    settings.height = options.height;
+    settings.seed = options.seed;
+    settings.stepsPerFrame = options.frameSteps;
+    MazeAnimationExporter exporter(settings);
+
+    const std::string &path = options.animationPath;
+    const std::string extension = path.size() >= 4 ? path.substr(path.size() - 4) : std::string();
+    const bool isGif = extension == ".gif" || extension == ".GIF";
+    if (!(isGif ? exporter.writeGif(path) : exporter.writePngSequence(path)))
+    {
+        std::fprintf(stderr, "Unable to write animation %s\n", path.c_str());
+        return EXIT_FAILURE;
+    }
+    const MazeAnimationExporter::Statistics statistics = exporter.getStatistics();
+    std::fprintf(stderr, "%llu steps in %llu frames, %llu bytes\n", static_cast<unsigned long long>(statistics.steps),
+                 static_cast<unsigned long long>(statistics.frames),
+                 static_cast<unsigned long long>(statistics.bytesWritten));
+    return EXIT_SUCCESS;
+}
+
+/* Лабиринт по маске из PBM: размер сетки - размер картинки, клетки вне маски остаются сплошными.
+ * Параметры в файле описывают только алгоритм, размер и seed, так что повторить такой лабиринт
+ * можно только с той же маской */
+int generateMaskedMaze(const Options &options)
+{
+    if (!MaskedMazeGenerator::isSupported(options.algorithm))
+    {
+        std::fprintf(stderr, "Masks are supported for algorithms 1 and 2\n");
+        return EXIT_FAILURE;
+    }
+    std::ifstream input(options.maskPath, std::ios::binary);
+    MazeMask mask;
+    if (!input || !MazeMask::readPbm(input, mask))
+    {
+        std::fprintf(stderr, "Unable to read PBM mask %s\n", options.maskPath.c_str());
+        return EXIT_FAILURE;
+    }
+
+    PackedMazeGrid grid;
+    MaskedMazeGenerator(mask, options.seed).generate(options.algorithm, grid);
+    std::fprintf(stderr, "%llu of %llu cells are in the maze\n", static_cast<unsigned long long>(mask.getActiveCount()),
+                 static_cast<unsigned long long>(grid.getCellCount()));
+
+    const GenerationParameters parameters(options.algorithm, mask.getWidth(), mask.getHeight(), options.seed);
+    if (!writeCompactMaze(options.outputPath, parameters, grid))
+        return EXIT_FAILURE;
+    if (!options.adjacencyPath.empty() && !writeAdjacency(options.adjacencyPath, grid))
+        return EXIT_FAILURE;
+    if (!options.vectorPath.empty() && !writeVectorImage(options.vectorPath, grid))
+        return EXIT_FAILURE;
+    return EXIT_SUCCESS;
+}
+
+int extractFromArchive(const Options &options)
+{
+    MazeArchiveReader archive;
+    if (!archive.open(options.extractPath))
+    {
+        std::fprintf(stderr, "Unable to read archive %s\n", options.extractPath.c_str());
+        return EXIT_FAILURE;
+    }
+    GenerationParameters parameters;
+    PackedMazeGrid grid;
+    if (!archive.read(options.index, parameters, grid))
+    {
+        std::fprintf(stderr, "Maze %llu is missing or corrupted (archive holds %llu)\n",
+                     static_cast<unsigned long long>(options.index),
+                     static_cast<unsigned long long>(archive.getEntryCount()));
+        return EXIT_FAILURE;
+    }
+    if (!writeCompactMaze(options.outputPath, parameters, grid))
+        return EXIT_FAILURE;
+    if (!options.adjacencyPath.empty() && !writeAdjacency(options.adjacencyPath, grid))
+        return EXIT_FAILURE;
+    if (!options.vectorPath.empty() && !writeVectorImage(options.vectorPath, grid))
+        return EXIT_FAILURE;
+    return EXIT_SUCCESS;
+}
+}
+
+/* Генерация без графики: одного лабиринта в файл CompactMazeFormat или пачки лабиринтов в архив.
+ * Для долгих алгоритмов блуждания периодически пишутся контрольные точки (в фоне, генерация не
+ * ждет диска); по SIGINT или SIGTERM записывается последняя точка, и генерацию можно продолжить
+ * через --resume */
+int main(int argc, char *argv[])
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    std::signal(SIGINT, handleStopSignal);
+    std::signal(SIGTERM, handleStopSignal);
+
+    if (!options.extractPath.empty())
+        return extractFromArchive(options);
+
+    std::unique_ptr<GenerationCheckpoint> resumedCheckpoint;
+    if (!options.resumePath.empty())
+    {
+        resumedCheckpoint.reset(new GenerationCheckpoint);
+        if (!resumedCheckpoint->readFromFile(options.resumePath))
+        {
+            std::fprintf(stderr, "Unable to read checkpoint %s\n", options.resumePath.c_str());
+            return EXIT_FAILURE;
+        }
+        options.algorithm = toMazeGeneratorAlgorithm(resumedCheckpoint->algorithm);
+        if (options.algorithm < 0)
+        {
+            std::fprintf(stderr, "Checkpoint %s has an unsupported algorithm\n", options.resumePath.c_str());
+            return EXIT_FAILURE;
+        }
+        options.width = resumedCheckpoint->grid.getWidth();
+        options.height = resumedCheckpoint->grid.getHeight();
+        options.seed = resumedCheckpoint->seed;
+        if (options.checkpointPath.empty())
+            options.checkpointPath = options.resumePath;
+    }
+    else if (!options.isSeedSet)
+    {
+        options.seed = (std::uint64_t(std::random_device()()) << 32) | std::random_device()();
+        std::fprintf(stderr, "Seed: %llu\n", static_cast<unsigned long long>(options.seed));
+    }
+
+    for (int algorithm : options.raceAlgorithms)
+    {
+        if (!MazeGenerator::isSupported(GenerationParameters(algorithm, options.width, options.height, options.seed)))
+        {
+            std::fprintf(stderr, "Algorithm %d does not support %zux%zu mazes\n", algorithm, options.width, options.height);
+            return EXIT_FAILURE;
+        }
+    }
+    if (!options.raceAlgorithms.empty())
+        return runRace(options);
+    if (!MazeGenerator::isSupported(options.algorithm))
+    {
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (!MazeGenerator::isSupported(GenerationParameters(options.algorithm, options.width, options.height, options.seed)))
+    {
+        std::fprintf(stderr, "Algorithm %d does not support %zux%zu mazes\n", options.algorithm, options.width,
+                     options.height);
+        return EXIT_FAILURE;
+    }
+    if (!options.maskPath.empty())
+        return generateMaskedMaze(options);
+    if (!options.archivePath.empty())
+        return generateArchive(options);
+    if (!options.animationPath.empty())
+        return writeAnimation(options);
+
+    const GenerationParameters parameters(options.algorithm, options.width, options.height, options.seed);
+    PackedMazeGrid grid;
+    /* Сетка заранее переезжает в сегмент нужного размера, и генераторы пишут прямо в него. Пока
+     * идет генерация, sequence нечетный и читатели ждут; прерванная генерация сегмент удаляет */
+    std::unique_ptr<SharedMazePublisher> sharedMazePublisher;
+    if (!options.sharedMemoryName.empty())
+    {
+        sharedMazePublisher.reset(new SharedMazePublisher(options.sharedMemoryName));
+        grid.resize(options.width, options.height);
+        if (!sharedMazePublisher->open() || !sharedMazePublisher->attach(grid))
+        {
+            std::fprintf(stderr, "Unable to publish the maze in shared memory %s\n", options.sharedMemoryName.c_str());
+            return EXIT_FAILURE;
+        }
+        sharedMazePublisher->beginWrite();
+    }
+    const int uniformTreeAlgorithm = toUniformTreeAlgorithm(options.algorithm);
+    // Лабиринт определяется параметрами, но контрольные точки и карта заходов требуют самой генерации
+    const bool isCacheUsed = !options.cacheDirectory.empty() && options.isSeedSet && options.resumePath.empty() &&
+            options.checkpointPath.empty() && options.heatmapPath.empty();
+    if (isCacheUsed)
+    {
+        MazeCache cache(options.cacheDirectory, options.cacheSizeBytes);
+        cache.generate(parameters, grid);
+        std::fprintf(stderr, "Cache %s: %s\n", options.cacheDirectory.c_str(),
+                     cache.getStatistics().hits != 0 ? "hit" : "miss");
+    }
+    else if (uniformTreeAlgorithm < 0)
+    {
+        if (!options.checkpointPath.empty())
+            std::fprintf(stderr, "Checkpoints are not supported for this algorithm, generating without them\n");
+        if (!options.heatmapPath.empty())
+            std::fprintf(stderr, "Visit heatmaps are only collected by random-walk algorithms\n");
+        MazeGenerator::generate(parameters, grid);
+    }
+    else
+    {
+        UniformTreeGenerator generator(options.width, options.height, options.seed);
+        VisitHeatmap heatmap;
+        if (!options.heatmapPath.empty())
+            generator.setVisitHeatmap(&heatmap);
+        std::unique_ptr<CheckpointWriter> checkpointWriter;
+        if (!options.checkpointPath.empty())
+            checkpointWriter.reset(new CheckpointWriter(options.checkpointPath));
+
+        auto lastCheckpointTime = std::chrono::steady_clock::now();
+        generator.setProgressHandler([&](const UniformTreeGenerator &currentGenerator, const PackedMazeGrid &currentGrid) {
+            const bool isStopping = isStopRequested;
+            const auto now = std::chrono::steady_clock::now();
+            if (checkpointWriter && (isStopping ||
+                                     now - lastCheckpointTime >= std::chrono::seconds(options.checkpointIntervalSeconds)))
+            {
+                currentGenerator.saveCheckpoint(currentGrid, checkpointWriter->acquireBuffer());
+                checkpointWriter->submit();
+                lastCheckpointTime = now;
+            }
+            return !isStopping;
+        });
+
+        bool isFinished {false};
+        if (resumedCheckpoint)
+        {
+            if (!generator.restoreCheckpoint(*resumedCheckpoint, grid))
+            {
+                std::fprintf(stderr, "Checkpoint %s is inconsistent\n", options.resumePath.c_str());
+                return EXIT_FAILURE;
+            }
+            resumedCheckpoint.reset();
+            isFinished = generator.resume(grid);
+        }
+        else
+        {
+            isFinished = generator.generate(uniformTreeAlgorithm, grid);
+        }
+
+        if (checkpointWriter)
+        {
+            checkpointWriter->flush();
+            if (checkpointWriter->hasWriteFailed())
+                std::fprintf(stderr, "Some checkpoints could not be written to %s\n", options.checkpointPath.c_str());
+        }
+        if (!isFinished)
+        {
+            if (checkpointWriter)
+                std::fprintf(stderr, "Interrupted, continue with --resume %s\n", options.checkpointPath.c_str());
+            return 3;
+        }
+        if (!options.heatmapPath.empty() && !heatmap.writeCsv(options.heatmapPath))
+            std::fprintf(stderr, "Cannot write visit heatmap to %s\n", options.heatmapPath.c_str());
+    }
+
+    if (sharedMazePublisher)
+    {
+        sharedMazePublisher->endWrite(options.algorithm, grid);
+        sharedMazePublisher->keepAfterExit();
+    }
+    if (!writeCompactMaze(options.outputPath, parameters, grid))
+        return EXIT_FAILURE;
+    if (!options.adjacencyPath.empty() && !writeAdjacency(options.adjacencyPath, grid))
+        return EXIT_FAILURE;
+    if (!options.vectorPath.empty() && !writeVectorImage(options.vectorPath, grid))
+        return EXIT_FAILURE;
+    // Лабиринт готов, контрольная точка больше не нужна
+    if (!options.checkpointPath.empty() && uniformTreeAlgorithm >= 0)
+        std::remove(options.checkpointPath.c_str());
+    return EXIT_SUCCESS;
+}
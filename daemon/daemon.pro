@@ -0,0 +1,41 @@
+TEMPLATE = app
+TARGET = mazedaemon
+
+QT -= core gui
+
+CONFIG += console c++11 thread
+CONFIG -= app_bundle
+
+# Unix-сокеты и poll(), на Windows демон не собирается
+win32: error("mazedaemon requires a POSIX system")
+
+INCLUDEPATH += ../include
+
+SOURCES += \
+    main.cpp \
+    mazedaemon.cpp \
+    mazeprotocol.cpp \
+    ../src/compactmazeformat.cpp \
+    ../src/cyclepoppinggenerator.cpp \
+    ../src/mazeanalyzer.cpp \
+    ../src/mazecache.cpp \
+    ../src/mazegenerator.cpp \
+    ../src/mazerandom.cpp \
+    ../src/packedmazegrid.cpp \
+    ../src/rowwisegenerator.cpp \
+    ../src/uniformtreegenerator.cpp \
+    ../src/visitheatmap.cpp
+
+HEADERS += \
+    mazedaemon.h \
+    mazeprotocol.h \
+    ../include/compactmazeformat.h \
+    ../include/cyclepoppinggenerator.h \
+    ../include/mazeanalyzer.h \
+    ../include/mazecache.h \
+    ../include/mazegenerator.h \
+    ../include/mazerandom.h \
+    ../include/packedmazegrid.h \
+    ../include/rowwisegenerator.h \
+    ../include/uniformtreegenerator.h \
+    ../include/visitheatmap.h
@@ -0,0 +1,81 @@
+#include "mazedaemon.h"
+
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+MazeDaemon *runningDaemon {nullptr};
+
+void handleStopSignal(int)
+{
+    if (runningDaemon)
+        runningDaemon->stop();
+}
+
+void printUsage(const char *programName)
+{
+    std::fprintf(stderr,
+                 "Usage: %s --socket PATH [--workers N] [--cache-dir DIR] [--cache-size BYTES]\n"
+                 "          [--max-cells N] [--max-batch N] [--max-in-flight BYTES] [--stats-interval SECONDS]\n"
+                 "--max-in-flight caps buffered bytes per connection (default 64 MiB);\n"
+                 "--stats-interval 0 prints statistics only on shutdown\n", programName);
+}
+}
+
+/* Демон без графики, раздающий лабиринты по Unix-сокету (протокол описан в mazeprotocol.h).
+ * Завершается по SIGINT или SIGTERM, удаляя файл сокета */
+int main(int argc, char *argv[])
+{
+    MazeDaemon::Options options;
+    for (int argument = 1; argument < argc; ++argument)
+    {
+        const char *name = argv[argument];
+        const char *value = argument + 1 < argc ? argv[argument + 1] : nullptr;
+        if (!value)
+        {
+            printUsage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        ++argument;
+
+        if (std::strcmp(name, "--socket") == 0)
+            options.socketPath = value;
+        else if (std::strcmp(name, "--workers") == 0)
+            options.workerCount = static_cast<unsigned int>(std::strtoul(value, nullptr, 10));
+        else if (std::strcmp(name, "--cache-dir") == 0)
+            options.cacheDirectory = value;
+        else if (std::strcmp(name, "--cache-size") == 0)
+            options.cacheSizeBytes = std::strtoull(value, nullptr, 10);
+        else if (std::strcmp(name, "--max-cells") == 0)
+            options.maxCellsPerRequest = std::strtoull(value, nullptr, 10);
+        else if (std::strcmp(name, "--max-batch") == 0)
+            options.maxRequestsPerBatch = std::strtoull(value, nullptr, 10);
+        else if (std::strcmp(name, "--max-in-flight") == 0)
+            options.maxBytesInFlight = std::strtoull(value, nullptr, 10);
+        else if (std::strcmp(name, "--stats-interval") == 0)
+            options.statisticsIntervalSeconds = static_cast<unsigned int>(std::strtoul(value, nullptr, 10));
+        else
+        {
+            printUsage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (options.socketPath.empty() || options.maxBytesInFlight == 0)
+    {
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    MazeDaemon daemon(options);
+    runningDaemon = &daemon;
+    std::signal(SIGINT, handleStopSignal);
+    std::signal(SIGTERM, handleStopSignal);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    const bool isStopped = daemon.run();
+    runningDaemon = nullptr;
+    return isStopped ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,283 @@
+#include "compactmazeformat.h"
+#include "mazeanalyzer.h"
+#include "mazeprotocol.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// На macOS флага нет, там SIGPIPE игнорируется в main
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+namespace
+{
+struct Options
+{
+    std::string socketPath;
+    GenerationParameters parameters {MazeGenerator::Algorithm::RecursiveBacktracker, 64, 64, 1};
+    std::uint32_t flags {};
+    std::size_t requestsPerBatch {1};
+    std::size_t batchCount {1};
+    std::uint64_t maxCellsPerRequest {std::uint64_t(1) << 26};
+};
+
+void printUsage(const char *programName)
+{
+    std::fprintf(stderr,
+                 "Usage: %s --socket PATH [--algorithm N] [--width W] [--height H] [--seed S]\n"
+                 "          [--requests N] [--batches N] [--solve] [--statistics] [--max-cells N]\n"
+                 "Sends N batches at once, request i of the run uses seed S + i. Every maze in the\n"
+                 "responses is rebuilt locally and compared; --max-cells must match the daemon\n", programName);
+}
+
+bool readExactly(int socket, unsigned char *buffer, std::size_t size)
+{
+    while (size > 0)
+    {
+        const ssize_t readBytes = read(socket, buffer, size);
+        if (readBytes < 0 && errno == EINTR)
+            continue;
+        if (readBytes <= 0)
+            return false;
+        buffer += readBytes;
+        size -= static_cast<std::size_t>(readBytes);
+    }
+    return true;
+}
+
+bool writeExactly(int socket, const unsigned char *buffer, std::size_t size)
+{
+    while (size > 0)
+    {
+        const ssize_t writtenBytes = send(socket, buffer, size, MSG_NOSIGNAL);
+        if (writtenBytes < 0 && errno == EINTR)
+            continue;
+        if (writtenBytes <= 0)
+            return false;
+        buffer += writtenBytes;
+        size -= static_cast<std::size_t>(writtenBytes);
+    }
+    return true;
+}
+
+bool isSameGrid(const PackedMazeGrid &first, const PackedMazeGrid &second)
+{
+    if (first.getWidth() != second.getWidth() || first.getHeight() != second.getHeight())
+        return false;
+    for (std::size_t row = 0; row < first.getHeight(); ++row)
+    {
+        if (!std::equal(first.getRightRow(row), first.getRightRow(row) + first.getWordsPerRow(), second.getRightRow(row)) ||
+                !std::equal(first.getBotRow(row), first.getBotRow(row) + first.getWordsPerRow(), second.getBotRow(row)))
+            return false;
+    }
+    return true;
+}
+
+// Ответ, который демон должен был прислать на запрос, собирается заново и сравнивается с полученным
+bool checkResponse(const Options &options, const MazeProtocol::Request &request, std::uint32_t status,
+                   std::uint32_t flags, const std::vector<unsigned char> &body)
+{
+    const GenerationParameters &parameters = request.parameters;
+    if (flags != request.flags)
+        return false;
+    if (!MazeGenerator::isSupported(parameters.algorithm))
+        return status == MazeProtocol::Status::UnknownAlgorithm && body.empty();
+    if (parameters.width == 0 || parameters.height == 0 || parameters.width > options.maxCellsPerRequest ||
+            parameters.height > options.maxCellsPerRequest / parameters.width || !MazeGenerator::isSupported(parameters))
+        return status == MazeProtocol::Status::TooLarge && body.empty();
+    if (status != MazeProtocol::Status::Ok)
+        return false;
+
+    std::istringstream mazeStream(std::string(body.begin(), body.end()));
+    GenerationParameters receivedParameters;
+    PackedMazeGrid receivedGrid;
+    if (!CompactMazeFormat::read(mazeStream, receivedParameters, receivedGrid) || receivedParameters != parameters)
+        return false;
+    PackedMazeGrid grid;
+    MazeGenerator::generate(parameters, grid);
+    if (!isSameGrid(grid, receivedGrid))
+        return false;
+
+    std::vector<unsigned char> expectedTail;
+    if (request.flags & MazeProtocol::Flag::Solve)
+    {
+        const std::vector<std::uint32_t> path = MazeAnalyzer::findPath(grid, 0, grid.getCellCount() - 1);
+        MazeProtocol::putUint(expectedTail, path.size(), 8);
+        for (std::uint32_t cell : path)
+            MazeProtocol::putUint(expectedTail, cell, 4);
+    }
+    if (request.flags & MazeProtocol::Flag::Statistics)
+    {
+        const MazeAnalyzer::Statistics statistics = MazeAnalyzer::computeStatistics(grid);
+        MazeProtocol::putUint(expectedTail, statistics.deadEnds, 8);
+        MazeProtocol::putUint(expectedTail, statistics.corridors, 8);
+        MazeProtocol::putUint(expectedTail, statistics.junctions, 8);
+    }
+    const std::size_t mazeSize = CompactMazeFormat::getEncodedSize(grid);
+    return body.size() == mazeSize + expectedTail.size() &&
+            std::equal(expectedTail.begin(), expectedTail.end(), body.begin() + mazeSize);
+}
+
+bool parseOptions(int argc, char *argv[], Options &options)
+{
+    for (int argument = 1; argument < argc; ++argument)
+    {
+        const char *name = argv[argument];
+        if (std::strcmp(name, "--solve") == 0)
+        {
+            options.flags |= MazeProtocol::Flag::Solve;
+            continue;
+        }
+        if (std::strcmp(name, "--statistics") == 0)
+        {
+            options.flags |= MazeProtocol::Flag::Statistics;
+            continue;
+        }
+
+        const char *value = argument + 1 < argc ? argv[argument + 1] : nullptr;
+        if (!value)
+            return false;
+        ++argument;
+        if (std::strcmp(name, "--socket") == 0)
+            options.socketPath = value;
+        else if (std::strcmp(name, "--algorithm") == 0)
+            options.parameters.algorithm = std::atoi(value);
+        else if (std::strcmp(name, "--width") == 0)
+            options.parameters.width = std::strtoull(value, nullptr, 10);
+        else if (std::strcmp(name, "--height") == 0)
+            options.parameters.height = std::strtoull(value, nullptr, 10);
+        else if (std::strcmp(name, "--seed") == 0)
+            options.parameters.seed = std::strtoull(value, nullptr, 10);
+        else if (std::strcmp(name, "--requests") == 0)
+            options.requestsPerBatch = std::strtoull(value, nullptr, 10);
+        else if (std::strcmp(name, "--batches") == 0)
+            options.batchCount = std::strtoull(value, nullptr, 10);
+        else if (std::strcmp(name, "--max-cells") == 0)
+            options.maxCellsPerRequest = std::strtoull(value, nullptr, 10);
+        else
+            return false;
+    }
+    return !options.socketPath.empty();
+}
+}
+
+/* Клиент демона для проверки и замеров: отправляет пакеты запросов, читает ответы и сверяет каждый
+ * с лабиринтом, построенным локально по тем же параметрам. Пакеты пишет отдельный поток, не
+ * дожидаясь ответов, поэтому заодно проверяется, что демон не копит их без предела и не
+ * взаимоблокируется с клиентом. Код возврата ненулевой при любом расхождении */
+int main(int argc, char *argv[])
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    std::signal(SIGPIPE, SIG_IGN);
+
+    sockaddr_un address {};
+    address.sun_family = AF_UNIX;
+    if (options.socketPath.size() >= sizeof(address.sun_path))
+    {
+        std::fprintf(stderr, "Invalid socket path: %s\n", options.socketPath.c_str());
+        return EXIT_FAILURE;
+    }
+    std::strcpy(address.sun_path, options.socketPath.c_str());
+    const int socket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (socket < 0 || connect(socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+    {
+        std::fprintf(stderr, "Unable to connect to %s: %s\n", options.socketPath.c_str(), std::strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    std::vector<std::vector<MazeProtocol::Request>> batches(options.batchCount);
+    std::uint64_t seed = options.parameters.seed;
+    for (std::vector<MazeProtocol::Request> &batch : batches)
+    {
+        batch.resize(options.requestsPerBatch);
+        for (MazeProtocol::Request &request : batch)
+        {
+            request.parameters = options.parameters;
+            request.parameters.seed = seed++;
+            request.flags = options.flags;
+        }
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    bool isWritten {false};
+    std::thread writer([&]() {
+        std::vector<unsigned char> buffer;
+        for (const std::vector<MazeProtocol::Request> &batch : batches)
+            MazeProtocol::encodeRequestBatch(batch, buffer);
+        isWritten = writeExactly(socket, buffer.data(), buffer.size());
+        shutdown(socket, SHUT_WR);
+    });
+
+    std::size_t responseCount {0};
+    std::size_t mismatchCount {0};
+    std::uint64_t receivedBytes {0};
+    bool isReceived {true};
+    for (const std::vector<MazeProtocol::Request> &batch : batches)
+    {
+        unsigned char batchHeader[MazeProtocol::BATCH_HEADER_SIZE];
+        std::vector<unsigned char> expectedHeader;
+        MazeProtocol::encodeResponseBatchHeader(batch.size(), expectedHeader);
+        if (!readExactly(socket, batchHeader, sizeof(batchHeader)) ||
+                !std::equal(expectedHeader.begin(), expectedHeader.end(), batchHeader))
+        {
+            isReceived = false;
+            break;
+        }
+        for (const MazeProtocol::Request &request : batch)
+        {
+            unsigned char responseHeader[MazeProtocol::RESPONSE_HEADER_SIZE];
+            if (!readExactly(socket, responseHeader, sizeof(responseHeader)))
+            {
+                isReceived = false;
+                break;
+            }
+            std::vector<unsigned char> body(static_cast<std::size_t>(MazeProtocol::getUint(responseHeader + 8, 8)));
+            if (!readExactly(socket, body.data(), body.size()))
+            {
+                isReceived = false;
+                break;
+            }
+            receivedBytes += sizeof(responseHeader) + body.size();
+            ++responseCount;
+            if (!checkResponse(options, request, static_cast<std::uint32_t>(MazeProtocol::getUint(responseHeader, 4)),
+                               static_cast<std::uint32_t>(MazeProtocol::getUint(responseHeader + 4, 4)), body) &&
+                    mismatchCount++ == 0)
+                std::fprintf(stderr, "Mismatch in response %zu (seed %llu)\n", responseCount - 1,
+                             static_cast<unsigned long long>(request.parameters.seed));
+        }
+        if (!isReceived)
+            break;
+    }
+    // После всех ответов демон закрывает соединение со своей стороны
+    unsigned char extraByte {};
+    const bool isClosedByDaemon = isReceived && read(socket, &extraByte, 1) == 0;
+    writer.join();
+    close(socket);
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::printf("%zu responses, %llu bytes, %zu mismatches, %.1f ms\n", responseCount,
+                static_cast<unsigned long long>(receivedBytes), mismatchCount, elapsed.count() * 1000);
+    if (!isWritten || !isReceived || !isClosedByDaemon)
+        std::fprintf(stderr, "Connection failed: %s\n", !isWritten ? "requests not sent" :
+                                                        !isReceived ? "responses truncated" : "not closed by daemon");
+    return isWritten && isReceived && isClosedByDaemon && mismatchCount == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
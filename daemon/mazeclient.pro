@@ -0,0 +1,37 @@
+TEMPLATE = app
+TARGET = mazeclient
+
+QT -= core gui
+
+CONFIG += console c++11 thread
+CONFIG -= app_bundle
+
+# Клиент для проверки демона и smoketest.sh, как и демон - только POSIX
+win32: error("mazeclient requires a POSIX system")
+
+INCLUDEPATH += ../include
+
+SOURCES += \
+    mazeclient.cpp \
+    mazeprotocol.cpp \
+    ../src/compactmazeformat.cpp \
+    ../src/cyclepoppinggenerator.cpp \
+    ../src/mazeanalyzer.cpp \
+    ../src/mazegenerator.cpp \
+    ../src/mazerandom.cpp \
+    ../src/packedmazegrid.cpp \
+    ../src/rowwisegenerator.cpp \
+    ../src/uniformtreegenerator.cpp \
+    ../src/visitheatmap.cpp
+
+HEADERS += \
+    mazeprotocol.h \
+    ../include/compactmazeformat.h \
+    ../include/cyclepoppinggenerator.h \
+    ../include/mazeanalyzer.h \
+    ../include/mazegenerator.h \
+    ../include/mazerandom.h \
+    ../include/packedmazegrid.h \
+    ../include/rowwisegenerator.h \
+    ../include/uniformtreegenerator.h \
+    ../include/visitheatmap.h
@@ -0,0 +1,537 @@
+#include "mazedaemon.h"
+#include "compactmazeformat.h"
+#include "mazeanalyzer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// На macOS флага нет, там SIGPIPE игнорируется в main
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+namespace
+{
+void makeNonBlocking(int fileDescriptor)
+{
+    fcntl(fileDescriptor, F_SETFL, fcntl(fileDescriptor, F_GETFL, 0) | O_NONBLOCK);
+    fcntl(fileDescriptor, F_SETFD, FD_CLOEXEC);
+}
+}
+
+MazeDaemon::MazeDaemon(const Options &options)
+    : options_(options)
+{
+    if (options_.workerCount == 0)
+        options_.workerCount = std::max(1u, std::thread::hardware_concurrency());
+    if (!options_.cacheDirectory.empty())
+        mazeCache_.reset(new MazeCache(options_.cacheDirectory, options_.cacheSizeBytes));
+    latenciesUs_.reserve(LATENCY_WINDOW);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+MazeDaemon::~MazeDaemon()
+{
+    {
+        std::lock_guard<std::mutex> lock(jobMutex_);
+        isStopping_ = true;
+    }
+    jobCondition_.notify_all();
+    for (std::thread &worker : workers_)
+        worker.join();
+
+    for (auto &connection : connections_)
+        close(connection.second.socket);
+    if (listenSocket_ >= 0)
+    {
+        close(listenSocket_);
+        unlink(options_.socketPath.c_str());
+    }
+    for (int fileDescriptor : wakePipe_)
+    {
+        if (fileDescriptor >= 0)
+            close(fileDescriptor);
+    }
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeDaemon::stop()
+{
+    isStopRequested_ = true;
+    const char wakeByte {0};
+    if (write(wakePipe_[1], &wakeByte, 1) < 0)
+        return;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool MazeDaemon::run()
+{
+    if (pipe(wakePipe_) != 0 || !openListenSocket())
+        return false;
+    makeNonBlocking(wakePipe_[0]);
+    makeNonBlocking(wakePipe_[1]);
+
+    for (unsigned int worker = 0; worker < options_.workerCount; ++worker)
+        workers_.emplace_back(&MazeDaemon::runWorker, this);
+    lastReportTime_ = Clock::now();
+
+    std::vector<pollfd> pollDescriptors;
+    std::vector<std::uint64_t> polledConnections;
+    while (!isStopRequested_)
+    {
+        pollDescriptors.assign({pollfd {listenSocket_, POLLIN, 0}, pollfd {wakePipe_[0], POLLIN, 0}});
+        polledConnections.clear();
+        for (auto &connection : connections_)
+        {
+            short events = isReadAllowed(connection.second) ? POLLIN : 0;
+            if (connection.second.outputOffset < connection.second.output.size())
+                events |= POLLOUT;
+            pollDescriptors.push_back(pollfd {connection.second.socket, events, 0});
+            polledConnections.push_back(connection.first);
+        }
+
+        // Без периодических отчетов цикл спит до события, иначе poll с нулевым ожиданием крутился бы вхолостую
+        const bool isReportingPeriodically = options_.statisticsIntervalSeconds != 0;
+        const auto nextReport = lastReportTime_ + std::chrono::seconds(options_.statisticsIntervalSeconds);
+        const auto timeout = std::chrono::duration_cast<std::chrono::milliseconds>(nextReport - Clock::now());
+        if (poll(pollDescriptors.data(), pollDescriptors.size(),
+                 isReportingPeriodically ? std::max<int>(0, timeout.count()) : -1) < 0 && errno != EINTR)
+            return false;
+
+        if (pollDescriptors[1].revents & POLLIN)
+        {
+            drainWakePipe();
+            collectCompletedJobs();
+        }
+        if (pollDescriptors[0].revents & POLLIN)
+            acceptConnections();
+
+        for (std::size_t index = 0; index < polledConnections.size(); ++index)
+        {
+            auto connection = connections_.find(polledConnections[index]);
+            const short revents = pollDescriptors[index + 2].revents;
+            if (connection == connections_.end() || revents == 0)
+                continue;
+            if ((revents & POLLIN) || ((revents & (POLLHUP | POLLERR)) && isReadAllowed(connection->second)))
+                readFromConnection(connection->first, connection->second);
+            else if (revents & (POLLHUP | POLLERR))
+                abandonConnection(connection->second);
+            if (revents & POLLOUT)
+            {
+                writeToConnection(connection->second);
+                // Освободилось место под ответы следующей порции
+                dispatchBatches(connection->first, connection->second);
+            }
+        }
+
+        // Соединение закрывается, когда ответы на все принятые пакеты отправлены
+        for (auto connection = connections_.begin(); connection != connections_.end();)
+        {
+            const Connection &state = connection->second;
+            if (state.isClosing && !state.isBatchInFlight && state.pendingRequests.empty() &&
+                    state.outputOffset == state.output.size())
+            {
+                close(state.socket);
+                connection = connections_.erase(connection);
+            }
+            else
+            {
+                ++connection;
+            }
+        }
+
+        if (isReportingPeriodically && Clock::now() >= nextReport)
+            reportStatistics();
+    }
+    reportStatistics();
+    return true;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool MazeDaemon::openListenSocket()
+{
+    sockaddr_un address {};
+    address.sun_family = AF_UNIX;
+    if (options_.socketPath.empty() || options_.socketPath.size() >= sizeof(address.sun_path))
+    {
+        std::fprintf(stderr, "Invalid socket path: %s\n", options_.socketPath.c_str());
+        return false;
+    }
+    std::strcpy(address.sun_path, options_.socketPath.c_str());
+
+    listenSocket_ = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenSocket_ < 0)
+        return false;
+    makeNonBlocking(listenSocket_);
+
+    // Файл сокета от предыдущего, аварийно завершенного запуска мешает bind
+    unlink(options_.socketPath.c_str());
+    if (bind(listenSocket_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+            listen(listenSocket_, SOMAXCONN) != 0)
+    {
+        std::fprintf(stderr, "Unable to listen on %s: %s\n", options_.socketPath.c_str(), std::strerror(errno));
+        close(listenSocket_);
+        listenSocket_ = -1;
+        return false;
+    }
+    return true;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeDaemon::acceptConnections()
+{
+    for (;;)
+    {
+        const int socket = accept(listenSocket_, nullptr, nullptr);
+        if (socket < 0)
+            return;
+        makeNonBlocking(socket);
+        connections_[nextConnectionId_++].socket = socket;
+    }
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeDaemon::readFromConnection(std::uint64_t connectionId, Connection &connection)
+{
+    unsigned char chunk[READ_CHUNK_SIZE];
+    while (isReadAllowed(connection))
+    {
+        const ssize_t readBytes = read(connection.socket, chunk, sizeof(chunk));
+        if (readBytes > 0)
+        {
+            connection.input.insert(connection.input.end(), chunk, chunk + readBytes);
+            continue;
+        }
+        if (readBytes == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+            connection.isClosing = true;
+        break;
+    }
+    dispatchBatches(connectionId, connection);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeDaemon::writeToConnection(Connection &connection)
+{
+    while (connection.outputOffset < connection.output.size())
+    {
+        const ssize_t writtenBytes = send(connection.socket, connection.output.data() + connection.outputOffset,
+                                          connection.output.size() - connection.outputOffset, MSG_NOSIGNAL);
+        if (writtenBytes < 0)
+        {
+            // Клиент ушел, не дождавшись ответа - отправлять больше некому
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+                abandonConnection(connection);
+            return;
+        }
+        connection.outputOffset += static_cast<std::size_t>(writtenBytes);
+    }
+    connection.output.clear();
+    connection.outputOffset = 0;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeDaemon::abandonConnection(Connection &connection)
+{
+    connection.isClosing = true;
+    connection.input.clear();
+    connection.pendingRequests.clear();
+    connection.output.clear();
+    connection.outputOffset = 0;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool MazeDaemon::isTooLarge(const GenerationParameters &parameters) const
+{
+    // Проверка по отдельности защищает от переполнения произведения; у генератора может быть свой предел
+    return parameters.width == 0 || parameters.height == 0 || parameters.width > options_.maxCellsPerRequest ||
+            parameters.height > options_.maxCellsPerRequest / parameters.width || !MazeGenerator::isSupported(parameters);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::uint64_t MazeDaemon::estimateResponseSize(const MazeProtocol::Request &request) const
+{
+    const GenerationParameters &parameters = request.parameters;
+    std::uint64_t size = MazeProtocol::RESPONSE_HEADER_SIZE;
+    if (!MazeGenerator::isSupported(parameters.algorithm) || isTooLarge(parameters))
+        return size;
+
+    const std::uint64_t wordsPerRow = (parameters.width + PackedMazeGrid::BITS_PER_WORD - 1) /
+            PackedMazeGrid::BITS_PER_WORD;
+    size += CompactMazeFormat::HEADER_SIZE + 2 * wordsPerRow * parameters.height * sizeof(std::uint64_t);
+    // Путь решения не длиннее числа клеток
+    if (request.flags & MazeProtocol::Flag::Solve)
+        size += 8 + 4 * std::uint64_t(parameters.width) * parameters.height;
+    if (request.flags & MazeProtocol::Flag::Statistics)
+        size += 3 * 8;
+    return size;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::uint64_t MazeDaemon::getBytesInFlight(const Connection &connection) const
+{
+    return connection.input.size() + (connection.output.size() - connection.outputOffset) +
+            connection.inFlightResponseBytes;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool MazeDaemon::isReadAllowed(const Connection &connection) const
+{
+    if (connection.isClosing)
+        return false;
+    if (getBytesInFlight(connection) < options_.maxBytesInFlight)
+        return true;
+    // Пакет длиннее предела все равно дочитывается, когда больше ждать нечего, иначе он бы не пришел никогда
+    const std::uint64_t maxBatchSize = MazeProtocol::BATCH_HEADER_SIZE +
+            std::uint64_t(options_.maxRequestsPerBatch) * MazeProtocol::REQUEST_SIZE;
+    return !connection.isBatchInFlight && connection.pendingRequests.empty() &&
+            connection.outputOffset == connection.output.size() && connection.input.size() < maxBatchSize;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeDaemon::dispatchBatches(std::uint64_t connectionId, Connection &connection)
+{
+    if (connection.isBatchInFlight)
+        return;
+
+    while (connection.pendingRequests.empty())
+    {
+        std::vector<MazeProtocol::Request> requests;
+        std::size_t consumedBytes {};
+        switch (MazeProtocol::decodeRequestBatch(connection.input, options_.maxRequestsPerBatch,
+                                                 requests, consumedBytes))
+        {
+        case MazeProtocol::DecodeResult::Incomplete :
+            return;
+        case MazeProtocol::DecodeResult::Malformed :
+            connection.isClosing = true;
+            connection.input.clear();
+            return;
+        case MazeProtocol::DecodeResult::Complete :
+            break;
+        }
+
+        connection.input.erase(connection.input.begin(), connection.input.begin() + consumedBytes);
+        // Заголовок пакета ответов пишет сам цикл, рабочие потоки дописывают за ним ответы порций
+        MazeProtocol::encodeResponseBatchHeader(requests.size(), connection.output);
+        connection.pendingRequests.assign(requests.begin(), requests.end());
+        connection.batchReceivedTime = Clock::now();
+    }
+
+    // Ответы порции собираются в памяти целиком, поэтому порция набирается под свободную часть предела
+    const std::uint64_t unsentBytes = connection.output.size() - connection.outputOffset;
+    if (unsentBytes >= options_.maxBytesInFlight)
+        return;
+    const std::uint64_t budgetBytes = options_.maxBytesInFlight - unsentBytes;
+
+    Job job;
+    std::uint64_t responseBytes {0};
+    while (!connection.pendingRequests.empty())
+    {
+        const std::uint64_t requestResponseBytes = estimateResponseSize(connection.pendingRequests.front());
+        // Запрос с ответом больше предела уходит один: разделить его нельзя
+        if (!job.requests.empty() && responseBytes + requestResponseBytes > budgetBytes)
+            break;
+        responseBytes += requestResponseBytes;
+        job.requests.push_back(connection.pendingRequests.front());
+        connection.pendingRequests.pop_front();
+    }
+
+    connection.isBatchInFlight = true;
+    connection.inFlightResponseBytes = responseBytes;
+    job.connectionId = connectionId;
+    job.receivedTime = connection.batchReceivedTime;
+    job.isLastInBatch = connection.pendingRequests.empty();
+    {
+        std::lock_guard<std::mutex> lock(jobMutex_);
+        jobs_.push_back(std::move(job));
+    }
+    jobCondition_.notify_one();
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeDaemon::collectCompletedJobs()
+{
+    std::deque<CompletedJob> completedJobs;
+    {
+        std::lock_guard<std::mutex> lock(jobMutex_);
+        completedJobs.swap(completedJobs_);
+    }
+
+    for (CompletedJob &completedJob : completedJobs)
+    {
+        auto connection = connections_.find(completedJob.connectionId);
+        if (connection == connections_.end())
+            continue;
+
+        Connection &state = connection->second;
+        state.isBatchInFlight = false;
+        state.inFlightResponseBytes = 0;
+        state.output.insert(state.output.end(), completedJob.response.begin(), completedJob.response.end());
+        writeToConnection(state);
+        // Следующая порция или пакет могли ждать, пока обрабатывалась предыдущая
+        dispatchBatches(connection->first, state);
+    }
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeDaemon::drainWakePipe()
+{
+    char buffer[256];
+    while (read(wakePipe_[0], buffer, sizeof(buffer)) > 0)
+        continue;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeDaemon::runWorker()
+{
+    std::unique_lock<std::mutex> lock(jobMutex_);
+    while (!isStopping_)
+    {
+        if (jobs_.empty())
+        {
+            jobCondition_.wait(lock);
+            continue;
+        }
+        Job job = std::move(jobs_.front());
+        jobs_.pop_front();
+        lock.unlock();
+
+        CompletedJob completedJob;
+        completedJob.connectionId = job.connectionId;
+        std::size_t failedCount {0};
+        for (const MazeProtocol::Request &request : job.requests)
+        {
+            const std::size_t responseStart = completedJob.response.size();
+            processRequest(request, completedJob.response);
+            if (MazeProtocol::getUint(&completedJob.response[responseStart], 4) != MazeProtocol::Status::Ok)
+                ++failedCount;
+        }
+
+        const auto latency = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - job.receivedTime);
+        recordLatency(job.requests.size(), static_cast<std::uint32_t>(std::min<long long>(latency.count(), 0xFFFFFFFF)),
+                      failedCount, job.isLastInBatch);
+
+        lock.lock();
+        completedJobs_.push_back(std::move(completedJob));
+        const char wakeByte {0};
+        if (write(wakePipe_[1], &wakeByte, 1) < 0 && errno != EAGAIN)
+            std::fprintf(stderr, "Unable to wake event loop: %s\n", std::strerror(errno));
+    }
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeDaemon::processRequest(const MazeProtocol::Request &request, std::vector<unsigned char> &response)
+{
+    const GenerationParameters &parameters = request.parameters;
+    std::vector<unsigned char> body;
+    if (!MazeGenerator::isSupported(parameters.algorithm))
+    {
+        MazeProtocol::encodeResponse(MazeProtocol::Status::UnknownAlgorithm, request.flags, body, response);
+        return;
+    }
+    if (isTooLarge(parameters))
+    {
+        MazeProtocol::encodeResponse(MazeProtocol::Status::TooLarge, request.flags, body, response);
+        return;
+    }
+
+    PackedMazeGrid grid;
+    if (mazeCache_)
+        mazeCache_->generate(parameters, grid);
+    else
+        MazeGenerator::generate(parameters, grid);
+
+    std::ostringstream mazeStream;
+    CompactMazeFormat::write(mazeStream, parameters, grid);
+    const std::string encodedMaze = mazeStream.str();
+    body.assign(encodedMaze.begin(), encodedMaze.end());
+
+    if (request.flags & MazeProtocol::Flag::Solve)
+    {
+        const std::vector<std::uint32_t> path = MazeAnalyzer::findPath(grid, 0, grid.getCellCount() - 1);
+        MazeProtocol::putUint(body, path.size(), 8);
+        for (std::uint32_t cell : path)
+            MazeProtocol::putUint(body, cell, 4);
+    }
+    if (request.flags & MazeProtocol::Flag::Statistics)
+    {
+        const MazeAnalyzer::Statistics statistics = MazeAnalyzer::computeStatistics(grid);
+        MazeProtocol::putUint(body, statistics.deadEnds, 8);
+        MazeProtocol::putUint(body, statistics.corridors, 8);
+        MazeProtocol::putUint(body, statistics.junctions, 8);
+    }
+    MazeProtocol::encodeResponse(MazeProtocol::Status::Ok, request.flags, body, response);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeDaemon::recordLatency(std::size_t requestCount, std::uint32_t latencyUs, std::size_t failedCount,
+                               bool isLastInBatch)
+{
+    // Все запросы порции готовы одновременно, поэтому и задержка у них одна
+    std::lock_guard<std::mutex> lock(statisticsMutex_);
+    for (std::size_t request = 0; request < requestCount; ++request)
+    {
+        if (latenciesUs_.size() < LATENCY_WINDOW)
+            latenciesUs_.push_back(latencyUs);
+        else
+            latenciesUs_[latencyCursor_] = latencyUs;
+        latencyCursor_ = (latencyCursor_ + 1) % LATENCY_WINDOW;
+    }
+    requestCount_ += requestCount;
+    failedRequestCount_ += failedCount;
+    if (isLastInBatch)
+        ++batchCount_;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeDaemon::reportStatistics()
+{
+    const Clock::time_point now = Clock::now();
+    const double elapsedSeconds = std::chrono::duration<double>(now - lastReportTime_).count();
+    lastReportTime_ = now;
+
+    std::vector<std::uint32_t> latencies;
+    std::uint64_t requestCount {};
+    std::uint64_t batchCount {};
+    std::uint64_t failedRequestCount {};
+    {
+        std::lock_guard<std::mutex> lock(statisticsMutex_);
+        latencies = latenciesUs_;
+        requestCount = requestCount_;
+        batchCount = batchCount_;
+        failedRequestCount = failedRequestCount_;
+    }
+    if (requestCount == requestCountAtLastReport_)
+        return;
+
+    const auto percentile = [&latencies](double share) -> std::uint32_t {
+        const std::size_t index = std::min(latencies.size() - 1, static_cast<std::size_t>(share * latencies.size()));
+        std::nth_element(latencies.begin(), latencies.begin() + index, latencies.end());
+        return latencies[index];
+    };
+    const double requestRate = elapsedSeconds > 0 ? (requestCount - requestCountAtLastReport_) / elapsedSeconds : 0;
+    requestCountAtLastReport_ = requestCount;
+
+    char cacheText[160] {};
+    if (mazeCache_)
+    {
+        const MazeCache::Statistics cacheStatistics = mazeCache_->getStatistics();
+        std::snprintf(cacheText, sizeof(cacheText), " | cache hits %llu, misses %llu, evictions %llu, %llu entries",
+                      static_cast<unsigned long long>(cacheStatistics.hits),
+                      static_cast<unsigned long long>(cacheStatistics.misses),
+                      static_cast<unsigned long long>(cacheStatistics.evictions),
+                      static_cast<unsigned long long>(cacheStatistics.entryCount));
+    }
+    std::fprintf(stderr, "requests %llu (failed %llu) batches %llu | %.1f req/s | latency p50 %u us, p99 %u us%s\n",
+                 static_cast<unsigned long long>(requestCount), static_cast<unsigned long long>(failedRequestCount),
+                 static_cast<unsigned long long>(batchCount), requestRate, percentile(0.5), percentile(0.99), cacheText);
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "mazecache.h"
+#include "mazeprotocol.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/* Демон, раздающий лабиринты по Unix-сокету. Однопоточный цикл событий на poll() принимает
+ * соединения и собирает пакеты запросов, запросы пакета уходят в пул рабочих потоков, готовые
+ * ответы возвращаются в цикл через pipe пробуждения. На соединение обрабатывается не больше одной
+ * порции запросов за раз, поэтому ответы приходят в порядке запросов.
+ *
+ * Байты соединения в пути (непрочитанный ввод, неотправленный вывод и оценка ответа порции в
+ * работе) ограничены maxBytesInFlight: сверх него сокет не читается, а большой пакет делится на
+ * порции по оценке размера ответов. Клиент, который не читает ответы, упирается в свой сокет, а не
+ * в память демона.
+ *
+ * Задержка считается от получения пакета до готовности ответа; p50/p99 по последним
+ * LATENCY_WINDOW запросам и частота запросов пишутся в stderr раз в statisticsIntervalSeconds
+ * (0 - только при остановке) */
+class MazeDaemon
+{
+public:
+    struct Options
+    {
+        std::string socketPath;
+        unsigned int workerCount {};
+        std::uint64_t maxCellsPerRequest {std::uint64_t(1) << 26};
+        std::size_t maxRequestsPerBatch {1024};
+        std::uint64_t maxBytesInFlight {std::uint64_t(1) << 26};
+        std::string cacheDirectory;
+        std::uint64_t cacheSizeBytes {std::uint64_t(1) << 30};
+        unsigned int statisticsIntervalSeconds {10};
+    };
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    static const std::size_t LATENCY_WINDOW {4096};
+    static const std::size_t READ_CHUNK_SIZE {64 * 1024};
+
+    struct Connection
+    {
+        int socket {-1};
+        std::vector<unsigned char> input;
+        std::vector<unsigned char> output;
+        std::size_t outputOffset {};
+        // Разобранные запросы текущего пакета, еще не отданные рабочим потокам
+        std::deque<MazeProtocol::Request> pendingRequests;
+        Clock::time_point batchReceivedTime;
+        std::uint64_t inFlightResponseBytes {};
+        bool isBatchInFlight {false};
+        bool isClosing {false};
+    };
+
+    struct Job
+    {
+        std::uint64_t connectionId {};
+        std::vector<MazeProtocol::Request> requests;
+        Clock::time_point receivedTime;
+        bool isLastInBatch {false};
+    };
+
+    struct CompletedJob
+    {
+        std::uint64_t connectionId {};
+        std::vector<unsigned char> response;
+    };
+
+    Options options_;
+    int listenSocket_ {-1};
+    int wakePipe_[2] {-1, -1};
+    std::atomic<bool> isStopRequested_ {false};
+
+    std::map<std::uint64_t, Connection> connections_;
+    std::uint64_t nextConnectionId_ {1};
+
+    std::unique_ptr<MazeCache> mazeCache_;
+    std::vector<std::thread> workers_;
+    std::mutex jobMutex_;
+    std::condition_variable jobCondition_;
+    std::deque<Job> jobs_;
+    std::deque<CompletedJob> completedJobs_;
+    bool isStopping_ {false};
+
+    std::mutex statisticsMutex_;
+    std::vector<std::uint32_t> latenciesUs_;
+    std::size_t latencyCursor_ {};
+    std::uint64_t requestCount_ {};
+    std::uint64_t batchCount_ {};
+    std::uint64_t failedRequestCount_ {};
+    std::uint64_t requestCountAtLastReport_ {};
+    Clock::time_point lastReportTime_;
+
+    bool openListenSocket();
+    void acceptConnections();
+    std::uint64_t estimateResponseSize(const MazeProtocol::Request &request) const;
+    bool isTooLarge(const GenerationParameters &parameters) const;
+    std::uint64_t getBytesInFlight(const Connection &connection) const;
+    bool isReadAllowed(const Connection &connection) const;
+    void readFromConnection(std::uint64_t connectionId, Connection &connection);
+    void writeToConnection(Connection &connection);
+    void abandonConnection(Connection &connection);
+    void dispatchBatches(std::uint64_t connectionId, Connection &connection);
+    void collectCompletedJobs();
+    void drainWakePipe();
+
+    void runWorker();
+    void processRequest(const MazeProtocol::Request &request, std::vector<unsigned char> &response);
+    void recordLatency(std::size_t requestCount, std::uint32_t latencyUs, std::size_t failedCount, bool isLastInBatch);
+    void reportStatistics();
+
+public:
+    explicit MazeDaemon(const Options &options);
+    ~MazeDaemon();
+
+    MazeDaemon(const MazeDaemon&) = delete;
+    MazeDaemon& operator=(const MazeDaemon&) = delete;
+
+    // Блокирует до вызова stop(); false, если не удалось открыть сокет
+    bool run();
+    // Безопасно вызывать из обработчика сигнала
+    void stop();
+};
@@ -0,0 +1,92 @@
+#include "mazeprotocol.h"
+
+#include <cstring>
+
+namespace
+{
+const char REQUEST_MAGIC[4] {'A', 'M', 'Z', 'Q'};
+const char RESPONSE_MAGIC[4] {'A', 'M', 'Z', 'P'};
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeProtocol::putUint(std::vector<unsigned char> &buffer, std::uint64_t value, std::size_t byteCount)
+{
+    for (std::size_t byte = 0; byte < byteCount; ++byte)
+        buffer.push_back(static_cast<unsigned char>(value >> (byte * 8)));
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::uint64_t MazeProtocol::getUint(const unsigned char *source, std::size_t byteCount)
+{
+    std::uint64_t value {0};
+    for (std::size_t byte = 0; byte < byteCount; ++byte)
+        value |= std::uint64_t(source[byte]) << (byte * 8);
+    return value;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeProtocol::encodeRequestBatch(const std::vector<Request> &requests, std::vector<unsigned char> &buffer)
+{
+    buffer.insert(buffer.end(), REQUEST_MAGIC, REQUEST_MAGIC + sizeof(REQUEST_MAGIC));
+    putUint(buffer, VERSION, 4);
+    putUint(buffer, requests.size(), 4);
+    for (const Request &request : requests)
+    {
+        putUint(buffer, static_cast<std::uint32_t>(request.parameters.algorithm), 4);
+        putUint(buffer, request.flags, 4);
+        putUint(buffer, request.parameters.width, 8);
+        putUint(buffer, request.parameters.height, 8);
+        putUint(buffer, request.parameters.seed, 8);
+    }
+}
+
+/*------------------------------------------------------------------------------------------------*/
+MazeProtocol::DecodeResult MazeProtocol::decodeRequestBatch(const std::vector<unsigned char> &buffer,
+                                                            std::size_t maxRequests,
+                                                            std::vector<Request> &requests,
+                                                            std::size_t &consumedBytes)
+{
+    if (buffer.size() < BATCH_HEADER_SIZE)
+        return DecodeResult::Incomplete;
+    if (std::memcmp(buffer.data(), REQUEST_MAGIC, sizeof(REQUEST_MAGIC)) != 0 || getUint(&buffer[4], 4) != VERSION)
+        return DecodeResult::Malformed;
+
+    const std::size_t requestCount = static_cast<std::size_t>(getUint(&buffer[8], 4));
+    if (requestCount > maxRequests)
+        return DecodeResult::Malformed;
+    const std::size_t batchSize = BATCH_HEADER_SIZE + requestCount * REQUEST_SIZE;
+    if (buffer.size() < batchSize)
+        return DecodeResult::Incomplete;
+
+    requests.resize(requestCount);
+    const unsigned char *record = &buffer[BATCH_HEADER_SIZE];
+    for (Request &request : requests)
+    {
+        request.parameters.algorithm = static_cast<int>(getUint(record, 4));
+        request.flags = static_cast<std::uint32_t>(getUint(record + 4, 4));
+        request.parameters.width = static_cast<std::size_t>(getUint(record + 8, 8));
+        request.parameters.height = static_cast<std::size_t>(getUint(record + 16, 8));
+        request.parameters.seed = getUint(record + 24, 8);
+        record += REQUEST_SIZE;
+    }
+    consumedBytes = batchSize;
+    return DecodeResult::Complete;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeProtocol::encodeResponseBatchHeader(std::size_t responseCount, std::vector<unsigned char> &buffer)
+{
+    buffer.insert(buffer.end(), RESPONSE_MAGIC, RESPONSE_MAGIC + sizeof(RESPONSE_MAGIC));
+    putUint(buffer, VERSION, 4);
+    putUint(buffer, responseCount, 4);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeProtocol::encodeResponse(std::uint32_t status, std::uint32_t flags, const std::vector<unsigned char> &body,
+                                  std::vector<unsigned char> &buffer)
+{
+    putUint(buffer, status, 4);
+    putUint(buffer, flags, 4);
+    putUint(buffer, body.size(), 8);
+    buffer.insert(buffer.end(), body.begin(), body.end());
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "mazegenerator.h"
+
+#include <cstdint>
+#include <vector>
+
+/* Двоичный протокол демона, все поля little-endian.
+ *
+ * Пакет запросов:  magic "AMZQ" | version u32 | requestCount u32 | запросы
+ *   запрос:        algorithm u32 | flags u32 | width u64 | height u64 | seed u64
+ * Пакет ответов:   magic "AMZP" | version u32 | responseCount u32 | ответы в порядке запросов
+ *   ответ:         status u32 | flags u32 | bodyLength u64 | тело
+ *   тело:          лабиринт в CompactMazeFormat,
+ *                  при Solve - pathLength u64 и индексы клеток пути u32 от (0, 0) до правого нижнего угла,
+ *                  при Statistics - deadEnds u64 | corridors u64 | junctions u64 */
+class MazeProtocol
+{
+public:
+    enum Flag : std::uint32_t {Solve = 0x01, Statistics = 0x02};
+    enum Status : std::uint32_t {Ok, UnknownAlgorithm, TooLarge};
+    enum DecodeResult {Complete, Incomplete, Malformed};
+
+    struct Request
+    {
+        GenerationParameters parameters;
+        std::uint32_t flags {};
+    };
+
+    static const std::uint32_t VERSION {1};
+    static const std::size_t BATCH_HEADER_SIZE {12};
+    static const std::size_t REQUEST_SIZE {32};
+    static const std::size_t RESPONSE_HEADER_SIZE {16};
+
+    static void putUint(std::vector<unsigned char> &buffer, std::uint64_t value, std::size_t byteCount);
+    static std::uint64_t getUint(const unsigned char *source, std::size_t byteCount);
+
+    static void encodeRequestBatch(const std::vector<Request> &requests, std::vector<unsigned char> &buffer);
+    // При Complete в consumedBytes - длина разобранного пакета, остаток буфера - следующий пакет
+    static DecodeResult decodeRequestBatch(const std::vector<unsigned char> &buffer, std::size_t maxRequests,
+                                           std::vector<Request> &requests, std::size_t &consumedBytes);
+
+    static void encodeResponseBatchHeader(std::size_t responseCount, std::vector<unsigned char> &buffer);
+    static void encodeResponse(std::uint32_t status, std::uint32_t flags, const std::vector<unsigned char> &body,
+                               std::vector<unsigned char> &buffer);
+};
@@ -0,0 +1,85 @@
+#!/bin/sh
+# Сквозная проверка демона: запуск на временном сокете, несколько прогонов mazeclient, остановка по SIGTERM.
+# Использование: smoketest.sh [путь к mazedaemon] [путь к mazeclient]
+set -u
+
+DAEMON=${1:-./mazedaemon}
+CLIENT=${2:-./mazeclient}
+WORK_DIR=$(mktemp -d)
+SOCKET=$WORK_DIR/mazes.sock
+FAILURES=0
+
+# Маленький предел байтов в пути, чтобы пакеты делились на порции, а чтение приостанавливалось
+"$DAEMON" --socket "$SOCKET" --workers 2 --max-in-flight 65536 --stats-interval 0 \
+          --cache-dir "$WORK_DIR" 2> "$WORK_DIR/daemon.log" &
+DAEMON_PID=$!
+trap 'kill "$DAEMON_PID" 2> /dev/null; rm -rf "$WORK_DIR"' EXIT
+
+for attempt in 1 2 3 4 5 6 7 8 9 10; do
+    [ -S "$SOCKET" ] && break
+    sleep 0.1
+done
+if [ ! -S "$SOCKET" ]; then
+    echo "FAIL: daemon did not create $SOCKET"
+    cat "$WORK_DIR/daemon.log"
+# Прогон "cache hits" повторяет запросы "solve and statistics", и итоговая строка должна это показать
+if ! grep -q "cache hits [1-9]" "$WORK_DIR/daemon.log"; then
+    echo "FAIL  cache hits not reported"
+    FAILURES=$((FAILURES + 1))
+fi
+    exit 1
+fi
+
+run_client() {
+    description=$1
+    shift
+    if output=$("$CLIENT" --socket "$SOCKET" "$@" 2>&1); then
+        echo "ok    $description: $output"
+    else
+        echo "FAIL  $description: $output"
+        FAILURES=$((FAILURES + 1))
+    fi
+}
+
+run_client "one request" --width 32 --height 24
+run_client "solve and statistics" --algorithm 2 --width 64 --height 48 --requests 8 --batches 3 --solve --statistics
+run_client "every algorithm number" --algorithm 5 --width 40 --height 40 --requests 4 --statistics
+run_client "unsupported algorithm" --algorithm 6 --requests 2
+run_client "too large" --width 0 --height 10
+run_client "cache hits" --algorithm 2 --width 64 --height 48 --requests 8 --batches 3 --solve --statistics
+run_client "larger than in-flight cap" --width 256 --height 256 --requests 32 --batches 4 --solve
+for algorithm in 0 1 3 4; do
+    run_client "algorithm $algorithm" --algorithm $algorithm --width 50 --height 30 --requests 16 --solve
+done
+
+# Параллельные клиенты на одном демоне
+PIDS=""
+for client in 1 2 3 4; do
+    "$CLIENT" --socket "$SOCKET" --width 128 --height 128 --seed $((client * 1000)) --requests 32 --batches 2 \
+              > "$WORK_DIR/client$client.log" 2>&1 &
+    PIDS="$PIDS $!"
+done
+for pid in $PIDS; do
+    if ! wait "$pid"; then
+        echo "FAIL  parallel client: $(cat "$WORK_DIR"/client*.log)"
+        FAILURES=$((FAILURES + 1))
+    fi
+done
+[ "$FAILURES" -eq 0 ] && echo "ok    parallel clients"
+
+kill -TERM "$DAEMON_PID"
+if ! wait "$DAEMON_PID"; then
+    echo "FAIL  daemon exit status"
+    FAILURES=$((FAILURES + 1))
+fi
+if [ -e "$SOCKET" ]; then
+    echo "FAIL  socket file left behind"
+    FAILURES=$((FAILURES + 1))
+fi
+cat "$WORK_DIR/daemon.log"
+
+if [ "$FAILURES" -ne 0 ]; then
+    echo "$FAILURES check(s) failed"
+    exit 1
+fi
+echo "all checks passed"
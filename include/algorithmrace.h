@@ -0,0 +1,72 @@
+#pragma once
+
+#include "mazestepgenerator.h"
+#include "packedmazegrid.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* Гонка алгоритмов: несколько генераций одного размера с одним seed, каждая в своем потоке и со
+ * своим генератором случайных чисел. Общего состояния у дорожек нет, поэтому результат каждой
+ * совпадает с генерацией той же пары (алгоритм, seed) в одиночку.
+ *
+ * Алгоритмы с пошаговой генерацией идут через MazeStepGenerator, и прогресс виден по ходу; для
+ * остальных (Binary Tree, Sidewinder, Cycle Popping) шагом считается клетка, а сетка появляется
+ * целиком в конце. Время - настенное: при дорожках больше, чем ядер, оно растет у всех */
+class AlgorithmRace
+{
+public:
+    struct LaneStatus
+    {
+        int algorithm;
+        std::uint64_t steps;
+        std::uint64_t elapsedNs;
+        bool isFinished;
+    };
+
+    // Шагов между публикациями прогресса и сетки
+    static const std::size_t STEPS_PER_BATCH {4096};
+
+private:
+    struct Lane
+    {
+        int algorithm {};
+        PackedMazeGrid grid;
+        // Поток дорожки держит его на время пачки шагов, читатели - на время копирования сетки
+        mutable std::mutex gridMutex;
+        std::atomic<std::uint64_t> steps {0};
+        std::atomic<std::uint64_t> elapsedNs {0};
+        std::atomic<bool> isFinished {false};
+        std::thread thread;
+    };
+
+    const std::size_t width_ {};
+    const std::size_t height_ {};
+    const std::uint64_t seed_ {};
+    std::vector<std::unique_ptr<Lane>> lanes_;
+    std::atomic<bool> isStopRequested_ {false};
+
+    void runLane(Lane &lane);
+
+public:
+    explicit AlgorithmRace(const std::vector<int> &algorithms, std::size_t width, std::size_t height, std::uint64_t seed);
+    ~AlgorithmRace();
+
+    AlgorithmRace(const AlgorithmRace&) = delete;
+    AlgorithmRace& operator=(const AlgorithmRace&) = delete;
+
+    // Гонка запускается один раз, для новой создается новый объект
+    void start();
+    // Останавливает пошаговые дорожки и дожидается всех потоков
+    void stop();
+    void wait();
+
+    std::size_t getLaneCount() const;
+    LaneStatus getLaneStatus(std::size_t lane) const;
+    bool isFinished() const;
+    // Копия текущего состояния сетки дорожки
+    void copyLaneGrid(std::size_t lane, PackedMazeGrid &grid) const;
+};
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "mazegenerator.h"
+#include "packedmazegrid.h"
+
+#include <iosfwd>
+
+/* Компактный двоичный формат лабиринта: заголовок фиксированной длины и следом обе битовые
+ * плоскости PackedMazeGrid как есть, слово в слово. Заголовок хранит параметры генерации и
+ * контрольную сумму плоскостей, поэтому испорченный или обрезанный файл распознается при чтении.
+ *
+ * Заголовок (все поля little-endian):
+ *   magic "AMZG" | version u32 | algorithm u32 | width u64 | height u64 | seed u64 | checksum u64 |
+ *   reserved u32
+ * Плоскости пишутся в порядке байтов машины; все целевые платформы little-endian */
+class CompactMazeFormat
+{
+private:
+    static const char MAGIC[4];
+
+public:
+    static const std::uint32_t VERSION {1};
+    static const std::size_t HEADER_SIZE {48};
+
+    static std::size_t getEncodedSize(const PackedMazeGrid &grid);
+
+    static void write(std::ostream &stream, const GenerationParameters &parameters, const PackedMazeGrid &grid);
+    /* false, если данные не в этом формате, обрезаны или не сходится контрольная сумма. Поток
+     * должен позволять seekg (файл): размер сетки сверяется с остатком до выделения памяти */
+    static bool read(std::istream &stream, GenerationParameters &parameters, PackedMazeGrid &grid);
+};
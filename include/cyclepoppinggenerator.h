@@ -0,0 +1,94 @@
+#pragma once
+
+#include "packedmazegrid.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+/* Многопоточный генератор равномерного остовного дерева методом выталкивания циклов
+ * (Propp-Wilson). У каждой клетки свой бесконечный стек случайных стрелок к соседям, стрелка
+ * с номером depth получается хешированием (seed, клетка, depth), поэтому сами стеки не хранятся,
+ * а только их текущая глубина. Дерево получается, когда в графе текущих стрелок не остается
+ * циклов; результат не зависит от порядка выталкивания, поэтому циклы можно выталкивать из
+ * нескольких потоков одновременно, и распределение остается точно равномерным.
+ *
+ * Каждый поток идет по стрелкам от своих клеток, захватывая клетки CAS-ом в cellClaims_, и сам
+ * выталкивает циклы, замкнувшиеся на собственном пути. Путь, дошедший до корневого дерева, сразу
+ * помечается ROOTED и больше не меняется. Путь, упершийся в клетку чужого пути, запоминается как
+ * сегмент; после того как все потоки закончили, сегменты однопоточно разрешаются по цепочкам:
+ * цепочка либо приходит в корень, либо замыкается (цикл из путей разных потоков - он здесь же
+ * выталкивается), либо обрывается на освобожденной клетке. Не дошедшие до корня клетки
+ * освобождаются и проходятся в следующем раунде */
+class CyclePoppingGenerator
+{
+private:
+    using CellIndex = std::uint32_t;
+    using SegmentId = std::uint32_t;
+
+    static const SegmentId UNCLAIMED {0};
+    static const SegmentId ROOTED {0xFFFFFFFF};
+
+    enum ResolveState {Unresolved, Resolving, Resolved};
+
+    struct Segment
+    {
+        std::size_t pathBegin {};
+        std::size_t pathEnd {};
+        // Клетка чужого пути, в которую уперся сегмент
+        CellIndex stopCell {};
+        int resolveState {ResolveState::Unresolved};
+        bool isRooted {false};
+    };
+
+    struct Worker
+    {
+        std::vector<CellIndex> activeCells;
+        std::vector<CellIndex> pathCells;
+        std::vector<Segment> segments;
+    };
+
+    std::size_t width_ {};
+    std::size_t height_ {};
+    std::uint64_t seed_ {};
+    unsigned int threadCount_ {};
+    std::uint64_t seedKey_ {};
+    CellIndex rootCell_ {};
+    CellIndex lastRowStart_ {};
+
+    std::vector<std::uint32_t> stackDepths_;
+    std::unique_ptr<std::atomic<SegmentId>[]> cellClaims_;
+    std::vector<Worker> workers_;
+
+    int arrowDirection(CellIndex cell) const;
+    CellIndex arrowTarget(CellIndex cell) const;
+
+    SegmentId makeSegmentId(unsigned int workerIndex, std::size_t segmentIndex) const;
+    Segment& segmentById(SegmentId segmentId);
+
+    std::size_t walkActiveCells(unsigned int workerIndex);
+    void walkFromCell(unsigned int workerIndex, CellIndex startCell);
+    void resolveSegments();
+    void popCycle(CellIndex cycleCell);
+    void applyRound(unsigned int workerIndex);
+    void carvePassages(unsigned int workerIndex, PackedMazeGrid &grid) const;
+
+    template <typename Function>
+    void runOnWorkers(Function function);
+
+public:
+    /* Клетки и сегменты нумеруются 32-битными числами ниже ROOTED; номер сегмента может
+     * превышать номер клетки на число потоков, поэтому потоков не больше MAX_THREAD_COUNT */
+    static const unsigned int MAX_THREAD_COUNT {256};
+    static const std::uint64_t MAX_CELL_COUNT {ROOTED - MAX_THREAD_COUNT};
+
+    // threadCount 0 - по числу ядер, больше MAX_THREAD_COUNT не берется
+    explicit CyclePoppingGenerator(std::size_t width, std::size_t height, std::uint64_t seed,
+                                   unsigned int threadCount = 0) noexcept;
+    ~CyclePoppingGenerator() {};
+
+    // В сетке не больше MAX_CELL_COUNT клеток
+    static bool isSupported(std::size_t width, std::size_t height);
+    // false, если сетка не поддерживается (isSupported); grid тогда не меняется
+    bool generate(PackedMazeGrid &grid);
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/* Телеметрия кадров отрисовки: кольцевой буфер последних кадров со временем отрисовки, временем
+ * обновления сцены между кадрами и числом шагов генерации, показанных в кадре. По нему
+ * считаются FPS, перцентили времени кадра и скорость генерации, а весь буфер выгружается в CSV,
+ * чтобы подтверждать улучшения анимации и отрисовки цифрами */
+class FrameTelemetry
+{
+public:
+    struct Frame
+    {
+        // Момент окончания отрисовки кадра
+        std::uint64_t timestampNs;
+        std::uint64_t paintNs;
+        // Работа генерации со сценой с прошлого кадра
+        std::uint64_t sceneUpdateNs;
+        std::uint64_t appliedSteps;
+    };
+
+    struct Summary
+    {
+        std::size_t frameCount;
+        double framesPerSecond;
+        // Время кадра - промежуток между концами соседних кадров
+        double p50FrameMs;
+        double p99FrameMs;
+        double p99PaintMs;
+        double stepsPerSecond;
+    };
+
+    static const std::size_t DEFAULT_CAPACITY {4096};
+
+private:
+    std::vector<Frame> frames_;
+    std::size_t nextFrame_ {};
+    std::size_t frameCount_ {};
+
+    // index-й по старшинству кадр в буфере
+    const Frame& getFrame(std::size_t index) const;
+
+public:
+    explicit FrameTelemetry(std::size_t capacity = DEFAULT_CAPACITY);
+    ~FrameTelemetry() {};
+
+    void addFrame(const Frame &frame);
+    void clear();
+    std::size_t getFrameCount() const;
+
+    // Сводка по кадрам за последние windowNs наносекунд
+    Summary getSummary(std::uint64_t windowNs) const;
+    bool writeCsv(const std::string &filePath) const;
+};
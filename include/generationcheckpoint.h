@@ -0,0 +1,77 @@
+#pragma once
+
+#include "mazerandom.h"
+#include "packedmazegrid.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/* Полное состояние прерванной генерации UniformTreeGenerator: сетка, состояние клеток (в нем же
+ * хранится путь блуждания Уилсона), состояние генератора случайных чисел и позиция блуждания.
+ * Из такой точки генерация продолжается байт в байт так же, как шла бы без остановки */
+struct GenerationCheckpoint
+{
+    int algorithm {};
+    std::uint64_t seed {};
+    MazeRandom::State randomState {};
+    std::uint64_t directionBits {};
+    std::uint32_t directionBitsLeft {};
+
+    int phase {};
+    std::uint64_t x {};
+    std::uint64_t y {};
+    std::uint64_t visitedCells {};
+    std::uint64_t cellsToVisit {};
+    std::uint64_t wilsonStartCell {};
+
+    std::vector<std::uint8_t> cellStates;
+    PackedMazeGrid grid;
+
+    /* Запись во временный файл, fsync и атомарный rename поверх старой точки, поэтому на диске
+     * всегда остается целая контрольная точка, даже после сбоя питания */
+    bool writeToFile(const std::string &filePath) const;
+    /* false, если файла нет, он не контрольная точка, не сходится контрольная сумма или размер,
+     * позиция и счетчики не согласуются с сеткой. Алгоритм и фазу проверяет restoreCheckpoint */
+    bool readFromFile(const std::string &filePath);
+};
+
+/* Фоновая запись контрольных точек. Буферов два: пока один пишется на диск, генератор заполняет
+ * другой. Если прошлая точка еще не начала писаться, новая просто заменяет её */
+class CheckpointWriter
+{
+private:
+    std::string filePath_;
+    GenerationCheckpoint buffers_[2];
+
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    std::thread writerThread_;
+    int writingBuffer_ {-1};
+    int pendingBuffer_ {-1};
+    int fillingBuffer_ {-1};
+    std::uint64_t writtenCount_ {};
+    bool hasWriteFailed_ {false};
+    bool isStopping_ {false};
+
+    void runWriter();
+
+public:
+    explicit CheckpointWriter(const std::string &filePath);
+    // Дописывает ожидающую точку и останавливает поток
+    ~CheckpointWriter();
+
+    CheckpointWriter(const CheckpointWriter&) = delete;
+    CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+    // Свободный буфер для заполнения; после заполнения нужно вызвать submit()
+    GenerationCheckpoint& acquireBuffer();
+    void submit();
+    // Ждет, пока все отправленные точки будут записаны
+    void flush();
+
+    std::uint64_t getWrittenCount();
+    bool hasWriteFailed();
+};
@@ -14,6 +14,9 @@ private:
     QRadioButton *algorithmAldousBroderRadio_ {nullptr};
     QRadioButton *algorithmRecursiveBacktrackerRadio_ {nullptr};
     QRadioButton *algorithmWilsonRadio_ {nullptr};
+    QRadioButton *algorithmBinaryTreeRadio_ {nullptr};
+    QRadioButton *algorithmSidewinderRadio_ {nullptr};
+    QRadioButton *algorithmCyclePoppingRadio_ {nullptr};
 
     QPushButton *test_ {nullptr};
     StartStopPushButton *startGenerationButton_ {nullptr};
@@ -29,7 +32,7 @@ public:
 
     void initializeMenu();
     void setDisabledButtons(bool makeButtonsDisabled);
-    enum Algorithm {AldousBroder, RecursiveBacktracker, Wilson};
+    enum Algorithm {AldousBroder, RecursiveBacktracker, Wilson, BinaryTree, Sidewinder, CyclePopping};
 
 signals:
     void algorithmReadyToGenerate();
@@ -44,6 +47,9 @@ private slots:
     void slotAldousBroderRadio();
     void slotRecursiveBacktrackerRadio();
     void slotWilsonRadio();
+    void slotBinaryTreeRadio();
+    void slotSidewinderRadio();
+    void slotCyclePoppingRadio();
     void slotStartGenerationButton();
     void loadMaze();
 
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "algorithmrace.h"
+
+#include <QWidget>
+#include <QCloseEvent>
+#include <QHBoxLayout>
+#include <QVBoxLayout>
+#include <QImage>
+#include <QLabel>
+#include <QPushButton>
+#include <QSpinBox>
+#include <QTimer>
+
+#include <memory>
+#include <vector>
+
+/* Окно гонки алгоритмов: все алгоритмы строят лабиринт одного размера с одним seed одновременно,
+ * каждый в своем потоке (см. AlgorithmRace). Рядом показываются текущие сетки, скорость в шагах
+ * в секунду и прошедшее время, чтобы выбирать алгоритм под нужный размер */
+class AlgorithmRaceWindow : public QWidget
+{
+    Q_OBJECT
+
+private:
+    const int LANE_IMAGE_SIZE {200};
+    const int REFRESH_MS {100};
+    const int MIN_MAZE_SIZE {2};
+    const int MAX_MAZE_SIZE {1000};
+    const int DEFAULT_MAZE_SIZE {100};
+
+    struct LaneWidgets
+    {
+        QLabel *titleLabel;
+        QLabel *imageLabel;
+        QLabel *statisticsLabel;
+    };
+
+    QVBoxLayout *windowLayout_ {nullptr};
+    QHBoxLayout *controlsLayout_ {nullptr};
+    QHBoxLayout *lanesLayout_ {nullptr};
+    QSpinBox *mazeSizeSpinBox_ {nullptr};
+    QSpinBox *seedSpinBox_ {nullptr};
+    QPushButton *startStopButton_ {nullptr};
+    QTimer *refreshTimer_ {nullptr};
+
+    std::vector<int> algorithms_;
+    std::vector<LaneWidgets> laneWidgets_;
+    // Шаги, с которыми сетка дорожки была нарисована в последний раз
+    std::vector<std::uint64_t> drawnSteps_;
+    std::unique_ptr<AlgorithmRace> race_;
+
+    void initializeWindow();
+    void stopRace();
+    static QString getAlgorithmName(int algorithm);
+    static QImage makeMazeImage(const PackedMazeGrid &grid);
+
+protected:
+    void closeEvent(QCloseEvent *event) override;
+
+public:
+    explicit AlgorithmRaceWindow(QWidget *parent = nullptr) noexcept;
+    ~AlgorithmRaceWindow() {};
+
+public slots:
+    void startOrStopRace();
+    void refreshLanes();
+};
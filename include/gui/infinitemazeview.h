@@ -0,0 +1,54 @@
+#pragma once
+
+#include "infinitemaze.h"
+
+#include <QWidget>
+#include <QKeyEvent>
+#include <QMouseEvent>
+#include <QPaintEvent>
+#include <QPainter>
+#include <QPoint>
+#include <QResizeEvent>
+#include <QSize>
+
+/* Окно в бесконечный лабиринт (InfiniteMaze). Сдвигается перетаскиванием мышью и стрелками;
+ * при каждой отрисовке строятся только блоки, попавшие в окно, а построенные хранятся в LRU-кэше
+ * ограниченного размера, поэтому память не растет при сколь угодно долгом перемещении. Емкость
+ * кэша следует за размером окна: все видимые блоки и CACHE_MARGIN_CHUNKS блоков вокруг */
+class InfiniteMazeView : public QWidget
+{
+    Q_OBJECT
+
+private:
+    static const int CELL_SIZE_PX {10};
+    static const int KEY_SCROLL_CELLS {4};
+    static const std::size_t CHUNK_SIZE {16};
+    // Запас блоков с каждой стороны окна: соседи для стен на краю и возврат назад без перестройки
+    static const std::size_t CACHE_MARGIN_CHUNKS {2};
+    const QColor BACKGROUND_COLOR {Qt::white};
+    const QColor WALL_COLOR {Qt::black};
+
+    InfiniteMazeCache cache_;
+    // Точка лабиринта в пикселях, попадающая в левый верхний угол окна
+    std::int64_t originX_ {};
+    std::int64_t originY_ {};
+    QPoint dragPosition_;
+    bool isDragging_ {false};
+
+    static std::size_t computeCacheCapacity(const QSize &viewSize);
+    void scrollBy(std::int64_t dx, std::int64_t dy);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+    void keyPressEvent(QKeyEvent *event) override;
+
+public:
+    explicit InfiniteMazeView(std::uint64_t seed, int algorithm, QWidget *parent = nullptr);
+    ~InfiniteMazeView() {};
+
+    const InfiniteMazeCache& getCache() const;
+};
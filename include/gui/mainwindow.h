@@ -1,12 +1,14 @@
 #pragma once
 
 #include "algorithmgeneratormenu.h"
+#include "algorithmracewindow.h"
 #include "fieldsizemenu.h"
 #include "mazearea.h"
 
 
 #include <QWidget>
 #include <QLayout>
+#include <QPushButton>
 
 class MainWindow : public QWidget
 {
@@ -16,6 +18,8 @@ private:
     FieldSizeMenu *fieldSizeWidget_ {nullptr};
     AlgorithmGeneratorMenu *algorithmGeneratorWidget_ {nullptr};
     QVBoxLayout *sidebarLayout_ {nullptr};
+    QPushButton *algorithmRaceButton_ {nullptr};
+    AlgorithmRaceWindow *algorithmRaceWindow_ {nullptr};
 
     MazeArea *mazeGrid_ {nullptr};
 
@@ -29,8 +33,10 @@ public:
     void initializeMazeSettingsMenu();
     void initializeMazeArea();
     void initializeMainWindow();
+    MazeArea* getMazeArea() const;
 
 public slots:
     void setDisabledAllButtons();
+    void showAlgorithmRace();
 
 };
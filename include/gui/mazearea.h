@@ -1,12 +1,23 @@
 #pragma once
 
 #include "algorithmgeneratormenu.h"
+#include "frametelemetry.h"
+#include "infinitemazeview.h"
+#include "mazegraphicsview.h"
+#include "mazetileview.h"
 #include "maze.h"
 
-#include <QGraphicsView>
 #include <QGraphicsScene>
+#include <QGraphicsPathItem>
+#include <QGraphicsPixmapItem>
+#include <QImage>
 #include <QVBoxLayout>
 #include <QGroupBox>
+#include <QCheckBox>
+#include <QLabel>
+#include <QPushButton>
+#include <QElapsedTimer>
+#include <QTimer>
 
 class MazeArea : public QWidget
 {
@@ -16,23 +27,73 @@ private:
     const unsigned int MAZE_AREA_SIZE {300};
     const unsigned int GRAPHIC_AREA_BORDER_SIZE {7};
     const unsigned int GRAPHIC_VIEW_SIZE {MAZE_AREA_SIZE + GRAPHIC_AREA_BORDER_SIZE};
+    const std::size_t MAZE_POOL_SIZE_PER_KEY {2};
+    const quint64 MAZE_POOL_MAX_SIZE_BYTES {64 * 1024 * 1024};
+    const int TELEMETRY_OVERLAY_REFRESH_MS {500};
+    const quint64 TELEMETRY_WINDOW_NS {2000000000};
+    const int HEATMAP_REFRESH_MS {100};
+    // Над подсветкой текущей клетки (-1), но под стенами (0)
+    const qreal HEATMAP_Z_VALUE {-0.5};
+    // Над стенами
+    const qreal SOLUTION_Z_VALUE {1};
+    const QColor SOLUTION_COLOR {220, 40, 40};
     const QString MAZE_AREA_STYLE_SHEET {"QGroupBox {border-style: double;"
                                          "border-width: 3px;}"};
 
     Maze *maze_ {nullptr};
 
     QGraphicsScene *mazeScene_ {nullptr};
-    QGraphicsView *mazeView_ {nullptr};
+    MazeGraphicsView *mazeView_ {nullptr};
 
     QVBoxLayout *mazeAreaLayout_ {nullptr};
     QGroupBox *mazeAreaGroupBox_ {nullptr};
 
+    FrameTelemetry frameTelemetry_;
+    QElapsedTimer frameClock_;
+    QHBoxLayout *telemetryLayout_ {nullptr};
+    QCheckBox *telemetryOverlayCheckBox_ {nullptr};
+    QPushButton *exportTelemetryButton_ {nullptr};
+    QTimer *telemetryOverlayTimer_ {nullptr};
+
+    QHBoxLayout *heatmapLayout_ {nullptr};
+    QCheckBox *heatmapCheckBox_ {nullptr};
+    QPushButton *exportHeatmapButton_ {nullptr};
+    QTimer *heatmapRefreshTimer_ {nullptr};
+    QGraphicsPixmapItem *heatmapItem_ {nullptr};
+
+    // Выделение рамкой области для перестройки; последняя непустая рамка в координатах сцены
+    QPushButton *regenerateRegionButton_ {nullptr};
+    QRectF selectedRegion_;
+    QPushButton *exportVectorButton_ {nullptr};
+    // Ctrl+щелчок по стене готового лабиринта ломает или ставит её, связность обновляется по правке
+    QLabel *connectivityLabel_ {nullptr};
+    // Путь из левого верхнего угла в правый нижний по графу развилок, с учетом правок стен
+    QCheckBox *solutionCheckBox_ {nullptr};
+    QGraphicsPathItem *solutionItem_ {nullptr};
+    // Генерация закончена: можно править стены и искать путь
+    bool isMazeReady_ {false};
+
+    // Бесконечный лабиринт показывается вместо сцены и создается заново при каждом включении
+    QPushButton *infiniteMazeButton_ {nullptr};
+    InfiniteMazeView *infiniteMazeView_ {nullptr};
+    // Большой лабиринт из файла компактного формата, тоже вместо сцены; не вместе с бесконечным
+    QPushButton *tileViewButton_ {nullptr};
+    MazeTileView *tileView_ {nullptr};
+
+    void recordFrame(qint64 paintNs);
+    QImage makeHeatmapImage() const;
+    void toggleWallAt(QPointF scenePosition);
+    void showConnectivity(const QString &editText);
+    void refreshSolution();
+
 public:
     MazeArea(QWidget *parent) noexcept;
     ~MazeArea() {};
 
     void initializeMenu();
     void addCellOnScene(Cell& cell);
+    // Настройки генерации из командной строки приложения задаются прямо лабиринту
+    Maze* getMaze() const;
 
 signals:
     void fieldReadyToGenerate();
@@ -43,4 +104,16 @@ public slots:
     void startGenerateMazeGrid(unsigned int mazeSize);
     void startGenerationMaze(int whichAlgorithmWasChosen);
     void interruptGenerationHandling();
+    void setTelemetryOverlayVisible(bool isVisible);
+    void refreshTelemetryOverlay();
+    void exportTelemetry();
+    void setHeatmapVisible(bool isVisible);
+    void setSolutionVisible(bool isVisible);
+    void refreshHeatmap();
+    void exportHeatmap();
+    void setRegionSelectionEnabled(bool isEnabled);
+    void trackRegionSelection(QRect viewportRect, QPointF fromScenePoint, QPointF toScenePoint);
+    void setInfiniteMazeVisible(bool isVisible);
+    void setTileViewVisible(bool isVisible);
+    void exportVectorImage();
 };
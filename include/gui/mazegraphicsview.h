@@ -0,0 +1,43 @@
+#pragma once
+
+#include <QGraphicsView>
+#include <QMouseEvent>
+#include <QPaintEvent>
+#include <QPainter>
+#include <QString>
+
+#include <functional>
+
+/* Вид сцены лабиринта. Замеряет время отрисовки каждого кадра (для телеметрии и трассы
+ * профилирования), поверх сцены может показывать текстовую панель телеметрии и передает
+ * щелчок с Ctrl обработчику правки стен */
+class MazeGraphicsView : public QGraphicsView
+{
+public:
+    using FrameHandler = std::function<void(qint64 paintNs)>;
+    using WallEditHandler = std::function<void(QPointF scenePosition)>;
+
+private:
+    const QRect OVERLAY_RECT {0, 0, 190, 78};
+    const QColor OVERLAY_BACKGROUND_COLOR {0, 0, 0, 160};
+
+    FrameHandler frameHandler_;
+    WallEditHandler wallEditHandler_;
+    QString overlayText_;
+
+public:
+    explicit MazeGraphicsView(QWidget *parent = nullptr) noexcept;
+    ~MazeGraphicsView() {};
+
+    // Вызывается после отрисовки каждого кадра с её длительностью
+    void setFrameHandler(const FrameHandler &frameHandler);
+    // Без обработчика щелчок с Ctrl обрабатывается как обычно
+    void setWallEditHandler(const WallEditHandler &wallEditHandler);
+    // Пустой текст скрывает панель
+    void setOverlayText(const QString &overlayText);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void drawForeground(QPainter *painter, const QRectF &rect) override;
+};
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "mazetilepyramid.h"
+
+#include <QWidget>
+#include <QKeyEvent>
+#include <QMouseEvent>
+#include <QPaintEvent>
+#include <QPainter>
+#include <QPoint>
+#include <QWheelEvent>
+
+/* Просмотр лабиринта любого размера через пирамиду плиток (MazeTilePyramid). Масштаб плавный,
+ * уровень пирамиды выбирается так, чтобы пиксель плитки был не меньше пикселя экрана. Отрисовка
+ * окна только берет готовые плитки из кэша и ставит недостающие в очередь от грубого уровня к
+ * подробному, а пока подробных нет, видны растянутые грубые - поэтому перемещение и масштаб не
+ * ждут рисования плиток.
+ *
+ * Перетаскивание и стрелки сдвигают окно, колесо и +/- меняют масштаб вокруг курсора и центра,
+ * Ctrl+щелчок при крупных клетках открывает или закрывает ближайшую стену */
+class MazeTileView : public QWidget
+{
+    Q_OBJECT
+
+private:
+    // Окно 300 x 300 видит до 4 плиток на уровне и держит в запасе еще несколько экранов
+    const std::size_t CACHE_CAPACITY_TILES {256};
+    const int KEY_SCROLL_PX {40};
+    const double ZOOM_STEP {1.25};
+    const double MAX_SCALE {4.0};
+    // Стены правятся, только когда клетка на экране не меньше этого
+    const double MIN_EDIT_CELL_PX {4.0};
+    const QColor BACKGROUND_COLOR {Qt::lightGray};
+
+    MazeTilePyramid pyramid_;
+    // Масштаб - пикселей экрана на пиксель уровня 0; начало - точка уровня 0 в левом верхнем углу
+    double scale_ {1.0};
+    double originX_ {};
+    double originY_ {};
+    QPoint dragPosition_;
+    bool isDragging_ {false};
+
+    double getMinScale() const;
+    unsigned int getVisibleLevel() const;
+    void scrollBy(double dx, double dy);
+    void zoomAt(QPointF position, double factor);
+    void toggleWallAt(QPointF position);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+    void wheelEvent(QWheelEvent *event) override;
+    void keyPressEvent(QKeyEvent *event) override;
+
+public:
+    explicit MazeTileView(PackedMazeGrid &&grid, QWidget *parent = nullptr);
+    ~MazeTileView() {};
+
+    // Весь лабиринт в окне и по центру; вызывается после задания размера окна
+    void fitMaze();
+    const MazeTilePyramid& getPyramid() const;
+};
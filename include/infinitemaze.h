@@ -0,0 +1,124 @@
+#pragma once
+
+#include "mazegenerator.h"
+#include "packedmazegrid.h"
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/* Лабиринт без границ из квадратных блоков chunkSize x chunkSize. Блок - чистая функция
+ * (seed, chunkX, chunkY): внутри обычный идеальный лабиринт MazeGenerator с seed из хеша
+ * координат, а проходы через стороны тоже выводятся из хешей, поэтому блоки строятся
+ * независимо, в любом порядке и параллельно, и любой блок можно построить заново.
+ *
+ * Каждый блок открыт ровно одним проходом к своему "родителю" - верхнему или левому соседу
+ * (выбор и место прохода на стороне по хешу), как Binary Tree на уровне блоков. Цепочки
+ * родителей только убывают по chunkX + chunkY, поэтому циклов нет, а две цепочки ведут себя как
+ * встречные случайные блуждания на прямой и с вероятностью 1 сливаются: весь бесконечный
+ * лабиринт - одно дерево. Цена локальности - крупный уклон путей вверх и влево: путь между
+ * соседними блоками может уходить далеко.
+ *
+ * Координаты клеток и блоков знаковые, блок (chunkX, chunkY) занимает клетки
+ * [chunkX * chunkSize, (chunkX + 1) * chunkSize) по x и так же по y */
+class InfiniteMaze
+{
+public:
+    struct Chunk
+    {
+        std::int64_t chunkX {};
+        std::int64_t chunkY {};
+        PackedMazeGrid grid;
+        // Положение прохода через каждую сторону (PackedMazeGrid::Direction) вдоль стороны или NO_OPENING
+        std::uint32_t openings[PackedMazeGrid::Direction::Count] {};
+    };
+    using ChunkKey = std::pair<std::int64_t, std::int64_t>;
+
+    static const std::uint32_t NO_OPENING {0xFFFFFFFF};
+    static const std::size_t DEFAULT_CHUNK_SIZE {64};
+
+private:
+    std::uint64_t seed_ {};
+    int algorithm_ {MazeGenerator::Algorithm::RecursiveBacktracker};
+    std::size_t chunkSize_ {DEFAULT_CHUNK_SIZE};
+
+    std::uint64_t hashChunk(std::int64_t chunkX, std::int64_t chunkY, std::uint64_t salt) const;
+    // Блок связан с верхним соседом, иначе - с левым
+    bool isParentAbove(std::int64_t chunkX, std::int64_t chunkY) const;
+    std::uint32_t getParentOpening(std::int64_t chunkX, std::int64_t chunkY) const;
+
+public:
+    // Алгоритм - номер MazeGenerator::Algorithm; неподдерживаемый заменяется Recursive Backtracker
+    explicit InfiniteMaze(std::uint64_t seed, int algorithm = MazeGenerator::Algorithm::RecursiveBacktracker,
+                          std::size_t chunkSize = DEFAULT_CHUNK_SIZE) noexcept;
+    ~InfiniteMaze() {};
+
+    std::uint64_t getSeed() const;
+    int getAlgorithm() const;
+    std::size_t getChunkSize() const;
+    // Блок, в котором лежит клетка, с округлением вниз и для отрицательных координат
+    std::int64_t getChunkCoordinate(std::int64_t cellCoordinate) const;
+
+    // Потокобезопасен: не меняет объект
+    void generateChunk(std::int64_t chunkX, std::int64_t chunkY, Chunk &chunk) const;
+    // chunks[i] - блок keys[i]; threadCount 0 - по числу ядер
+    void generateChunks(const std::vector<ChunkKey> &keys, std::vector<Chunk> &chunks,
+                        unsigned int threadCount = 0) const;
+};
+
+/* Блоки бесконечного лабиринта по запросу с вытеснением давно не использованных (LRU), так что
+ * память ограничена capacity блоками при любом долгом перемещении. Возвращаемые блоки
+ * разделяемые: вытеснение не портит блок, который еще держит вызывающий. Не потокобезопасен */
+class InfiniteMazeCache
+{
+public:
+    struct Statistics
+    {
+        std::uint64_t hits {};
+        std::uint64_t misses {};
+        std::uint64_t evictions {};
+    };
+
+private:
+    struct ChunkKeyHash
+    {
+        std::size_t operator()(const InfiniteMaze::ChunkKey &key) const;
+    };
+
+    struct Entry
+    {
+        std::shared_ptr<const InfiniteMaze::Chunk> chunk;
+        std::list<InfiniteMaze::ChunkKey>::iterator lruPosition;
+    };
+
+    InfiniteMaze maze_;
+    std::size_t capacity_ {};
+    // В начале списка - последний использованный блок
+    std::list<InfiniteMaze::ChunkKey> lruKeys_;
+    std::unordered_map<InfiniteMaze::ChunkKey, Entry, ChunkKeyHash> entries_;
+    Statistics statistics_;
+
+    void evictToFit(std::size_t chunkCount);
+    void insert(InfiniteMaze::Chunk &&chunk);
+
+public:
+    explicit InfiniteMazeCache(const InfiniteMaze &maze, std::size_t capacity);
+    ~InfiniteMazeCache() {};
+
+    // Меньшая емкость сразу вытесняет лишние блоки, начиная с давно не использованных
+    void setCapacity(std::size_t capacity);
+    std::size_t getCapacity() const;
+    const InfiniteMaze& getMaze() const;
+    std::size_t getChunkCount() const;
+    Statistics getStatistics() const;
+
+    std::shared_ptr<const InfiniteMaze::Chunk> getChunk(std::int64_t chunkX, std::int64_t chunkY);
+    /* Строит недостающие блоки прямоугольника [firstChunkX, lastChunkX] x [firstChunkY, lastChunkY]
+     * параллельно. Прямоугольник больше capacity вытеснит собственное начало */
+    void prefetch(std::int64_t firstChunkX, std::int64_t firstChunkY, std::int64_t lastChunkX, std::int64_t lastChunkY);
+    // Проход из клетки (x, y) в направлении PackedMazeGrid::Direction, в том числе через сторону блока
+    bool hasPassage(std::int64_t x, std::int64_t y, int direction);
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "mazemask.h"
+#include "mazerandom.h"
+#include "packedmazegrid.h"
+
+#include <vector>
+
+/* Генерация лабиринта произвольной формы по MazeMask. Неактивные клетки не посещаются вовсе и
+ * остаются со всеми стенами; в лабиринт превращается каждая связная часть маски (у несвязной
+ * маски получается лес, по дереву на часть).
+ *
+ * Состояние клеток лежит в массиве по плотным номерам маски, а случайная стартовая клетка
+ * берется через select от случайного номера, поэтому память и выбор клеток зависят от площади
+ * фигуры, а не описанного прямоугольника. Сама сетка результата - прямоугольник маски */
+class MaskedMazeGenerator
+{
+private:
+    enum CellState : std::uint8_t {DirectionMask = 0x03, InTree = 0x04, Reached = 0x08};
+
+    const MazeMask &mask_;
+    MazeRandom random_;
+    std::vector<std::uint8_t> cellStates_;
+    std::uint64_t directionBits_ {};
+    unsigned int directionBitsLeft_ {};
+
+    // Активные соседи клетки; возвращает их число
+    unsigned int findNeighbors(std::size_t x, std::size_t y, int directions[PackedMazeGrid::Direction::Count]) const;
+    // Сосед по направлению и его плотный номер
+    void moveToNeighbor(std::size_t &x, std::size_t &y, std::size_t &index, int direction) const;
+    // Равновероятно один из активных соседей; у клетки должен быть хотя бы один
+    int chooseRandomDirection(std::size_t x, std::size_t y);
+    std::size_t chooseRandomActiveCell();
+
+    void generateRecursiveBacktracker(PackedMazeGrid &grid);
+    void generateWilson(PackedMazeGrid &grid);
+    // Первая по номеру клетка каждой связной части становится корнем дерева
+    void markComponentRoots();
+
+public:
+    explicit MaskedMazeGenerator(const MazeMask &mask, std::uint64_t seed) noexcept;
+    ~MaskedMazeGenerator() {};
+
+    // MazeGenerator::Algorithm; поддерживаются RecursiveBacktracker и Wilson
+    static bool isSupported(int algorithm);
+    void generate(int algorithm, PackedMazeGrid &grid);
+};
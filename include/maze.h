@@ -2,14 +2,24 @@
 
 #include "cell.h"
 #include "coordinate.h"
+#include "mazecache.h"
+#include "mazeconnectivity.h"
+#include "mazejunctiongraph.h"
+#include "mazepool.h"
+#include "mazeregionregenerator.h"
+#include "mazestepgenerator.h"
+#include "packedmazegrid.h"
+#include "sharedmazesegment.h"
+#include "visitheatmap.h"
 #include "gui/algorithmgeneratormenu.h"
 
 #include <QVector>
-#include <QStack>
 #include <QRandomGenerator>
 #include <QEventLoop>
 #include <QTimer>
-#include <QBitArray>
+#include <QElapsedTimer>
+
+#include <memory>
 
 struct Coordinate;
 
@@ -22,8 +32,32 @@ private:
     unsigned int mazeSize_ {};
 
     QVector<QVector<Cell>> cellGrid_;
+    PackedMazeGrid packedGrid_;
     bool interruptFlag_ {false};
 
+    // Без заданного seed каждый запуск дает новый лабиринт, и кэш не используется
+    quint64 generationSeed_ {};
+    bool isGenerationSeedSet_ {false};
+    // Перегенераций областей с начала генерации: с заданным seed каждая получает свой seed
+    quint64 regionRegenerationCount_ {};
+    std::unique_ptr<MazeCache> mazeCache_;
+    std::unique_ptr<MazePool> mazePool_;
+    std::unique_ptr<SharedMazePublisher> sharedMazePublisher_;
+
+    // Работа генерации со сценой между кадрами для телеметрии: шаги и время вне delay()
+    quint64 appliedSteps_ {};
+    qint64 sceneUpdateNs_ {};
+    QElapsedTimer sceneUpdateTimer_;
+
+    VisitHeatmap visitHeatmap_;
+    bool isVisitHeatmapEnabled_ {false};
+    // Перестраивается целиком за O(N), поэтому только при первом запросе после изменения сетки
+    MazeJunctionGraph junctionGraph_;
+    bool isJunctionGraphStale_ {true};
+    // Строится при первой правке стен или запросе после генерации, дальше обновляется по правкам
+    MazeConnectivity connectivity_;
+    bool isConnectivityStale_ {true};
+
     enum Direction {Forbidden = -1, Top, Right, Bot, Left, Count};
     const int DELAY_MS_IN_GENERATION_CYCLE {1};
 
@@ -32,30 +66,44 @@ public:
     ~Maze() {};
 
     QVector<QVector<Cell>>& getCellGrid();
+    const PackedMazeGrid& getPackedGrid() const;
+
+    void setGenerationSeed(quint64 seed);
+    void enableCache(const QString &directoryPath, quint64 maxSizeBytes);
+    MazeCache::Statistics getCacheStatistics() const;
+    void enableMazePool(std::size_t mazesPerKey, quint64 maxSizeBytes);
+    MazePool::Statistics getMazePoolStatistics() const;
+    bool enableSharedMemoryPublication(const QString &segmentName);
+    // Шаги и время работы со сценой, накопленные с прошлого вызова
+    void takeFrameWork(quint64 &appliedSteps, qint64 &sceneUpdateNs);
+    // Счет заходов в клетки при анимированной генерации; карта обнуляется в начале каждой генерации
+    void setVisitHeatmapEnabled(bool isEnabled);
+    const VisitHeatmap& getVisitHeatmap() const;
+    // Граф развилок текущей сетки с учетом правок стен
+    const MazeJunctionGraph& getJunctionGraph();
+    // Связность, циклы и пути с учетом правок стен
+    MazeConnectivity& getConnectivity();
 
     void generateMazeGrid(unsigned int mazeSize);
     void resetGrid();
 
     void interruptReceived();
-    bool generationLoopExitCondition(unsigned int &visitedCells);
 
     void generateMaze(int whichAlgorithmWasChosen);
-    void generateAldousBroder(unsigned int &visitedCells, Coordinate &currentCoordinates);
-    void generateRecursiveBacktracker(unsigned int &visitedCells, Coordinate &currentCoordinates);
-    void generateWilson(unsigned int &visitedCells, Coordinate &currentCoordinates);
-
-    int checkNeighborsAndDecideWhichWayToGo(Coordinate currentCoordinates);
-    void chooseRandomNonAddedCoordinates(Coordinate &currentCoordinates, QVector<Coordinate> &cellsAlreadyInMaze);
-    void makeStepBack(Coordinate currentCoordinates, Coordinate previousCoordinates, bool isWallsNeedToRebuild);
-
-    bool isLegitimateStep(Coordinate coordinate, int stepDirection);
-    void makeStep(Coordinate &currentCoordinates, int stepDirection, unsigned int &visitedCellsCounter);
-    void markCellAfterStep(Coordinate currentCoordinates, Coordinate newCoordinates);
-
-    void goTop(Coordinate &currentCoordinates, Coordinate &newCoordinates, bool &cellWasVisitedOnThisStep);
-    void goRight(Coordinate &currentCoordinates, Coordinate &newCoordinates, bool &cellWasVisitedOnThisStep);
-    void goBot(Coordinate &currentCoordinates, Coordinate &newCoordinates, bool &cellWasVisitedOnThisStep);
-    void goLeft(Coordinate &currentCoordinates, Coordinate &newCoordinates, bool &cellWasVisitedOnThisStep);
+    // Анимированная генерация Aldous-Broder, Recursive Backtracker и Wilson по шагам MazeStepGenerator
+    void generateStepByStep(int whichAlgorithmWasChosen, Coordinate &currentCoordinates);
+    void applyGenerationStep(const MazeStepGenerator::Step &step, Coordinate &currentCoordinates);
+    void generatePackedMaze(int whichAlgorithmWasChosen);
+    void applyPackedGridToCells();
+
+    void setPassageInCells(Coordinate coordinates, int direction, bool isOpen);
+    // Ломает стену между клеткой и соседом или ставит её на месте прохода
+    MazeConnectivity::EditResult toggleWall(Coordinate coordinates, int direction);
+    /* Перестраивает прямоугольник width x height с углом в corner, не трогая остальной лабиринт и
+     * сохраняя его идеальным (MazeRegionRegenerator). false, если область пуста или выходит за лабиринт */
+    bool regenerateRegion(Coordinate corner, int width, int height);
+    static Coordinate getNeighborCoordinates(Coordinate coordinates, int direction);
+
     void loadMazeFromFile(const std::string& filePath);
     void loadFromFile();
     void saveToFile();
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "packedmazegrid.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/* Лабиринт как граф в формате CSR (compressed sparse row) для библиотек поиска пути и графов:
+ * вершина (x, y) имеет номер y * width + x, её соседи - neighbors[offsets[v]] ...
+ * neighbors[offsets[v + 1] - 1] по возрастанию номера. Объектов на вершину не создается, строится
+ * за один параллельный проход по словам упакованной сетки: сначала по строке считается только
+ * число записей (popcount), затем каждый поток заполняет свои строки.
+ *
+ * Файл-спутник (little-endian, под mmap без разбора):
+ *   заголовок: magic "AMZJ" | version u32 | width u32 | height u32 | nodeCount u64 | entryCount u64
+ *   offsets:   nodeCount + 1 значений u64 сразу после заголовка
+ *   neighbors: entryCount значений u32 сразу после offsets
+ * Номера соседей 32-битные, поэтому лабиринт должен быть меньше 2^32 клеток */
+class MazeAdjacency
+{
+public:
+    static const char MAGIC[4];
+    static const std::uint32_t VERSION {1};
+    static const std::size_t HEADER_SIZE {32};
+
+private:
+    // Меньшие сетки быстрее построить в одном потоке, чем запускать остальные
+    static const std::size_t MIN_CELLS_PER_THREAD {1 << 16};
+
+    std::size_t width_ {};
+    std::size_t height_ {};
+    std::vector<std::uint64_t> offsets_;
+    std::vector<std::uint32_t> neighbors_;
+
+    void countRowEntries(const PackedMazeGrid &grid, std::size_t firstRow, std::size_t endRow,
+                         std::vector<std::uint64_t> &rowEntries) const;
+    void fillRows(const PackedMazeGrid &grid, std::size_t firstRow, std::size_t endRow,
+                  const std::vector<std::uint64_t> &rowEntries);
+
+public:
+    MazeAdjacency() noexcept {};
+    ~MazeAdjacency() {};
+
+    // threadCount 0 - по числу ядер. false, если в сетке 2^32 клеток или больше
+    bool build(const PackedMazeGrid &grid, unsigned int threadCount = 0);
+
+    std::size_t getWidth() const;
+    std::size_t getHeight() const;
+    std::size_t getNodeCount() const;
+    // Число записей в neighbors: каждый проход записан дважды, по разу у каждого конца
+    std::size_t getEntryCount() const;
+    const std::uint64_t* getOffsets() const;
+    const std::uint32_t* getNeighbors() const;
+
+    bool writeToFile(const std::string &filePath) const;
+};
+
+/* Файл-спутник MazeAdjacency, отображенный в память только для чтения: offsets и neighbors
+ * указывают прямо в отображение, так что граф на миллионы вершин открывается без чтения и
+ * копирования. Без mmap (не POSIX) файл читается в память целиком */
+class MazeAdjacencyView
+{
+private:
+    const std::uint8_t *data_ {nullptr};
+    std::size_t size_ {};
+    void *mapping_ {nullptr};
+    std::vector<std::uint64_t> fileData_;
+
+    std::size_t width_ {};
+    std::size_t height_ {};
+    std::size_t nodeCount_ {};
+    std::size_t entryCount_ {};
+
+public:
+    MazeAdjacencyView() noexcept {};
+    ~MazeAdjacencyView();
+
+    MazeAdjacencyView(const MazeAdjacencyView&) = delete;
+    MazeAdjacencyView& operator=(const MazeAdjacencyView&) = delete;
+
+    // false, если файла нет, он не спутник MazeAdjacency или обрезан
+    bool open(const std::string &filePath);
+    void close();
+
+    std::size_t getWidth() const;
+    std::size_t getHeight() const;
+    std::size_t getNodeCount() const;
+    std::size_t getEntryCount() const;
+    const std::uint64_t* getOffsets() const;
+    const std::uint32_t* getNeighbors() const;
+};
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "packedmazegrid.h"
+
+#include <cstdint>
+#include <vector>
+
+// Разбор готового лабиринта без графики: поиск пути и подсчет клеток по числу проходов
+class MazeAnalyzer
+{
+public:
+    struct Statistics
+    {
+        std::uint64_t deadEnds {};
+        std::uint64_t corridors {};
+        std::uint64_t junctions {};
+    };
+
+    // Путь из клетки fromCell в toCell (индекс клетки - y * width + x) включительно; пустой, если пути нет
+    static std::vector<std::uint32_t> findPath(const PackedMazeGrid &grid, std::size_t fromCell, std::size_t toCell);
+    static Statistics computeStatistics(const PackedMazeGrid &grid);
+};
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "mazestepgenerator.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/* Анимация генерации без окна: MazeStepGenerator с заданным seed рисует в растр в памяти, и каждые
+ * stepsPerFrame шагов получается кадр. Растр похож на сцену Maze: белые клетки, черные стены в
+ * пиксель, серая текущая клетка. В кадр попадает только прямоугольник, измененный с прошлого кадра,
+ * а кодирование (GIF или последовательность PNG) идет в отдельном потоке через очередь
+ * ограниченной длины, так что генерация и сжатие работают одновременно.
+ *
+ * Кодеры свои и без зависимостей: GIF - LZW по 2-битной палитре, кадры с прозрачным фоном
+ * накладываются на предыдущие; PNG - палитра, фильтр Up и deflate с фиксированным Хаффманом и
+ * повторами на расстоянии 1, чего для строк, почти не меняющихся между кадрами, хватает */
+class MazeAnimationExporter
+{
+public:
+    struct Settings
+    {
+        // MazeGenerator::Algorithm; поддерживаются только пошаговые (MazeStepGenerator::isSupported)
+        int algorithm {};
+        std::size_t width {};
+        std::size_t height {};
+        std::uint64_t seed {};
+        std::size_t stepsPerFrame {10};
+        // Сторона клетки вместе с одной из её стен
+        unsigned int cellPixels {6};
+        unsigned int frameDelayMs {20};
+        // Последний кадр с готовым лабиринтом держится дольше
+        unsigned int finalFrameDelayMs {2000};
+    };
+
+    struct Statistics
+    {
+        std::uint64_t steps {};
+        std::uint64_t frames {};
+        std::uint64_t bytesWritten {};
+    };
+
+private:
+    enum Color : std::uint8_t {Background, Wall, CurrentCell, Transparent};
+    static const std::size_t MAX_QUEUED_FRAMES {16};
+
+    // Измененная часть растра в пикселях; у полного кадра - весь растр
+    struct Frame
+    {
+        std::size_t left {};
+        std::size_t top {};
+        std::size_t width {};
+        std::size_t height {};
+        unsigned int delayMs {};
+        std::vector<std::uint8_t> pixels;
+    };
+
+    Settings settings_;
+    Statistics statistics_;
+    std::size_t imageWidth_ {};
+    std::size_t imageHeight_ {};
+
+    // Текущий растр, растр последнего кадра и прямоугольник изменений между ними
+    std::vector<std::uint8_t> image_;
+    std::vector<std::uint8_t> previousImage_;
+    std::size_t dirtyLeft_ {};
+    std::size_t dirtyTop_ {};
+    std::size_t dirtyRight_ {};
+    std::size_t dirtyBottom_ {};
+    bool isDirty_ {false};
+    bool hasCurrentCell_ {false};
+    std::size_t currentX_ {};
+    std::size_t currentY_ {};
+
+    std::mutex queueMutex_;
+    std::condition_variable queueCondition_;
+    std::deque<Frame> frameQueue_;
+    bool isProducerFinished_ {false};
+
+    void fillRect(std::size_t left, std::size_t top, std::size_t width, std::size_t height, std::uint8_t color);
+    void setPassage(std::size_t x, std::size_t y, int direction, bool isOpen);
+    void setCurrentCell(std::size_t x, std::size_t y);
+    void clearCurrentCell();
+    void applyStep(const MazeStepGenerator::Step &step);
+
+    Frame takeFrame(bool isFullFrame, bool isTransparent, unsigned int delayMs);
+    void pushFrame(Frame &&frame);
+    bool popFrame(Frame &frame);
+    // Генерация в вызывающем потоке, кодирование - в encode
+    bool run(bool isGif, const std::function<bool(const Frame&)> &encode);
+
+public:
+    explicit MazeAnimationExporter(const Settings &settings) noexcept;
+    ~MazeAnimationExporter() {};
+
+    static bool isSupported(int algorithm);
+
+    // Один файл GIF с бесконечным повтором
+    bool writeGif(const std::string &filePath);
+    // Кадры pathPrefix_00000.png, pathPrefix_00001.png, ... - каждый целиком
+    bool writePngSequence(const std::string &pathPrefix);
+    Statistics getStatistics() const;
+};
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "mazegenerator.h"
+#include "packedmazegrid.h"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+/* Архив из множества лабиринтов в одном файле: пакетная генерация дает миллионы маленьких
+ * лабиринтов, и файл на каждый из них слишком дорог для файловой системы.
+ *
+ * Формат (все поля little-endian):
+ *   заголовок:  magic "AMZA" | version u32 | entryCount u64 | indexOffset u64 | flags u64
+ *   тела:       лабиринты, сжатые MazeEntropyCoder, подряд
+ *   индекс:     entryCount записей фиксированной длины по адресу indexOffset:
+ *               offset u64 | size u64 | seed u64 | checksum u64 | width u32 | height u32 |
+ *               algorithm u32 | reserved u32
+ * Индекс лежит в конце файла. Дописывание не трогает ни старые тела, ни старый индекс: новые тела
+ * пишутся за ним, при закрытии за ними - полный новый индекс, и только после этого заголовок
+ * переключается на новый индекс. Если процесс упадет раньше, заголовок указывает на старый индекс
+ * и архив читается в прежнем виде. Цена - мертвый старый индекс в файле после каждого дописывания.
+ * Любой лабиринт находится за O(1): запись индекса с номером i лежит по адресу
+ * indexOffset + i * INDEX_ENTRY_SIZE */
+class MazeArchive
+{
+public:
+    static const char MAGIC[4];
+    static const std::uint32_t VERSION {1};
+    static const std::size_t HEADER_SIZE {32};
+    static const std::size_t INDEX_ENTRY_SIZE {48};
+    /* Так первые версии помечали архив на время дописывания поверх индекса; после сбоя такой
+     * архив поврежден и не читается. Сейчас флаг не ставится */
+    static const std::uint64_t FLAG_WRITE_IN_PROGRESS {1};
+
+    struct Entry
+    {
+        GenerationParameters parameters;
+        std::uint64_t checksum;
+        std::uint64_t offset;
+        std::uint64_t size;
+    };
+};
+
+/* Запись архива. Сжатие можно выполнить заранее в других потоках (MazeEntropyCoder::encode) и
+ * передать готовые данные в appendEncoded, тогда запись сводится к последовательному write */
+class MazeArchiveWriter
+{
+private:
+    std::string filePath_;
+    std::fstream file_;
+    std::vector<std::uint8_t> index_;
+    std::vector<std::uint8_t> encodedBuffer_;
+    std::uint64_t entryCount_ {};
+    // Где лежит индекс, на который указывает заголовок в файле
+    std::uint64_t indexOffset_ {};
+    // Куда пишется следующее тело, а при закрытии - новый индекс
+    std::uint64_t dataEnd_ {};
+    bool isOpen_ {false};
+    bool hasWriteFailed_ {false};
+
+    bool writeHeader();
+    // Дожидается записи файла на диск, чтобы заголовок не опередил индекс
+    bool syncFile();
+
+public:
+    MazeArchiveWriter() noexcept {};
+    // Закрывает архив, если его не закрыли явно
+    ~MazeArchiveWriter();
+
+    MazeArchiveWriter(const MazeArchiveWriter&) = delete;
+    MazeArchiveWriter& operator=(const MazeArchiveWriter&) = delete;
+
+    // Создает новый архив или открывает существующий для дописывания в конец
+    bool open(const std::string &filePath);
+    bool append(const GenerationParameters &parameters, const PackedMazeGrid &grid);
+    bool appendEncoded(const GenerationParameters &parameters, std::uint64_t checksum,
+                       const std::vector<std::uint8_t> &encoded);
+    /* Пишет новый индекс и переключает на него заголовок; до этого читатели видят архив без новых
+     * лабиринтов. false, если какая-то запись не удалась */
+    bool close();
+
+    std::uint64_t getEntryCount() const;
+};
+
+/* Чтение архива через mmap: открытие не читает файл целиком, а каждый лабиринт распаковывается
+ * прямо из отображенной памяти. read не меняет состояние читателя, поэтому один открытый архив
+ * можно читать из нескольких потоков */
+class MazeArchiveReader
+{
+private:
+    const std::uint8_t *data_ {nullptr};
+    std::size_t size_ {};
+    void *mapping_ {nullptr};
+    // Без mmap (не POSIX) файл читается в память целиком
+    std::vector<std::uint8_t> fileData_;
+    std::uint64_t entryCount_ {};
+    std::uint64_t indexOffset_ {};
+
+public:
+    MazeArchiveReader() noexcept {};
+    ~MazeArchiveReader();
+
+    MazeArchiveReader(const MazeArchiveReader&) = delete;
+    MazeArchiveReader& operator=(const MazeArchiveReader&) = delete;
+
+    // false, если файла нет, он не архив или поврежден; незавершенное дописывание архив не портит
+    bool open(const std::string &filePath);
+    void close();
+
+    std::uint64_t getEntryCount() const;
+    bool getEntry(std::uint64_t entryIndex, MazeArchive::Entry &entry) const;
+    // false, если номер вне архива или данные лабиринта повреждены
+    bool read(std::uint64_t entryIndex, GenerationParameters &parameters, PackedMazeGrid &grid) const;
+};
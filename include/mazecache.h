@@ -0,0 +1,88 @@
+#pragma once
+
+#include "mazegenerator.h"
+#include "packedmazegrid.h"
+
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/* Дисковый кэш готовых лабиринтов. Лабиринт полностью определяется параметрами генерации,
+ * поэтому ключом служит хеш (алгоритм, размер, seed), а файл записи назван этим ключом.
+ * Записи хранятся в CompactMazeFormat, их целостность проверяется контрольной суммой при каждом
+ * чтении; испорченная запись удаляется и считается промахом.
+ *
+ * Папку могут делить несколько процессов (GUI, mazegen, демон), поэтому общего индекса нет:
+ * список записей и их размеры берутся из самой папки, а порядок использования (LRU) - из времени
+ * изменения файлов, которое обновляется при каждом попадании. Запись пишется во временный файл с
+ * уникальным для процесса и потока именем и переименовывается в готовую, поэтому читатель видит
+ * либо целую запись, либо никакой. Когда суммарный размер превышает лимит, папка просматривается
+ * заново и удаляются давно не использованные записи, в том числе сохраненные другими процессами.
+ * Без POSIX папку просмотреть нельзя, и учитываются только записи этого процесса.
+ * Папка должна существовать. Все методы потокобезопасны */
+class MazeCache
+{
+public:
+    struct Statistics
+    {
+        std::uint64_t hits {};
+        std::uint64_t misses {};
+        std::uint64_t stores {};
+        std::uint64_t evictions {};
+        std::uint64_t corruptedEntries {};
+        std::uint64_t entryCount {};
+        std::uint64_t sizeBytes {};
+    };
+
+private:
+    using Key = std::uint64_t;
+
+    struct Entry
+    {
+        std::uint64_t sizeBytes;
+        std::list<Key>::iterator lruPosition;
+    };
+
+    // После переполнения записи удаляются с запасом, чтобы папку не просматривать на каждой записи
+    static constexpr double EVICTION_TARGET_SHARE {0.9};
+
+    std::string directoryPath_;
+    std::uint64_t maxSizeBytes_ {};
+    std::atomic<std::uint64_t> temporaryFileCount_ {0};
+
+    mutable std::mutex mutex_;
+    // В начале списка - последняя использованная запись
+    std::list<Key> lruKeys_;
+    std::unordered_map<Key, Entry> entries_;
+    Statistics statistics_;
+
+    static Key makeKey(const GenerationParameters &parameters);
+    std::string makeEntryPath(Key key) const;
+    std::string makeTemporaryPath(const std::string &entryPath);
+
+    // Заново строит список записей по файлам папки, от последней использованной к самой старой
+    void scanDirectory();
+    // Новая запись в начале списка; ключа в списке быть не должно
+    void addEntry(Key key, std::uint64_t sizeBytes);
+    // Удаляет файл записи и убирает её из списка
+    void removeEntry(Key key);
+    // Только убирает запись из списка, файл остается
+    void forgetEntry(Key key);
+    void evictToFit(std::uint64_t incomingBytes);
+
+public:
+    explicit MazeCache(const std::string &directoryPath, std::uint64_t maxSizeBytes);
+    ~MazeCache() {};
+
+    MazeCache(const MazeCache&) = delete;
+    MazeCache& operator=(const MazeCache&) = delete;
+
+    bool load(const GenerationParameters &parameters, PackedMazeGrid &grid);
+    void store(const GenerationParameters &parameters, const PackedMazeGrid &grid);
+    // Берет лабиринт из кэша, а при промахе генерирует его и сохраняет
+    void generate(const GenerationParameters &parameters, PackedMazeGrid &grid);
+
+    Statistics getStatistics() const;
+};
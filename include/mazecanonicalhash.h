@@ -0,0 +1,50 @@
+#pragma once
+
+#include "packedmazegrid.h"
+
+#include <cstdint>
+#include <vector>
+
+/* Хеш лабиринта, не зависящий от поворотов и отражений: минимум хешей по всем восьми
+ * преобразованиям квадрата (четыре отражения по осям для исходной и для транспонированной сетки).
+ * Транспонирование плоскостей идет блоками 64 x 64 бит, отражение строки - разворотом битов слов,
+ * отражение столбцов - обходом строк с конца, так что сетка ни разу не разбирается по клеткам.
+ * Размеры входят в хеш, поэтому лабиринты W x H и H x W, совпадающие после поворота, тоже равны.
+ *
+ * Объект держит буферы между вызовами, чтобы хеширование миллионов маленьких лабиринтов не
+ * выделяло память; на поток нужен свой объект */
+class MazeCanonicalHash
+{
+private:
+    // Плоскости одной ориентации сетки и они же с развернутыми строками; биты за краем сетки нулевые
+    struct Planes
+    {
+        std::size_t width {};
+        std::size_t height {};
+        std::size_t wordsPerRow {};
+        std::vector<std::uint64_t> right;
+        std::vector<std::uint64_t> bot;
+        std::vector<std::uint64_t> reversedRight;
+        std::vector<std::uint64_t> reversedBot;
+    };
+
+    Planes original_;
+    Planes transposed_;
+
+    static void resizePlanes(Planes &planes, std::size_t width, std::size_t height);
+    static void transposePlane(const std::vector<std::uint64_t> &source, std::size_t sourceWordsPerRow,
+                               std::size_t sourceRows, std::vector<std::uint64_t> &target,
+                               std::size_t targetWordsPerRow, std::size_t targetRows);
+    // bitCount битов строки в обратном порядке
+    static void reverseRow(const std::uint64_t *row, std::size_t wordsPerRow, std::size_t bitCount,
+                           std::uint64_t *reversedRow);
+    static void reversePlanes(Planes &planes);
+    // Минимум хешей четырех отражений одной ориентации
+    static std::uint64_t hashReflections(const Planes &planes);
+
+public:
+    MazeCanonicalHash() noexcept {};
+    ~MazeCanonicalHash() {};
+
+    std::uint64_t compute(const PackedMazeGrid &grid);
+};
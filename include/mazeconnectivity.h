@@ -0,0 +1,89 @@
+#pragma once
+
+#include "packedmazegrid.h"
+
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+
+/* Связность лабиринта при правке стен без перегенерации и повторного поиска пути. Остовный лес
+ * проходов хранится в link-cut дереве (splay-деревья по путям), остальные проходы - рёбра циклов.
+ *
+ * Открытие стены связывает два дерева (O(log N) амортизированно) или, если клетки уже связаны,
+ * добавляет цикл. Закрытие прохода цикла только убирает его; закрытие прохода дерева режет дерево
+ * и ищет среди проходов циклов замену, которая снова соединит части: O(log N) без циклов и
+ * O(k log N) при k циклах. Идеальный лабиринт - один компонент без циклов.
+ *
+ * Номер клетки - y * width + x, как в MazeAnalyzer. Запросы перестраивают splay-деревья, поэтому
+ * они не const */
+class MazeConnectivity
+{
+public:
+    struct EditResult
+    {
+        // false, если проход уже был в нужном состоянии или стена на краю лабиринта
+        bool isChanged;
+        // Открытая стена соединила уже связанные клетки
+        bool isLoopCreated;
+        // Закрытая стена разделила компонент, и замены среди циклов не нашлось
+        bool isDisconnected;
+    };
+
+    static const std::uint64_t NO_PATH {0xFFFFFFFFFFFFFFFF};
+
+private:
+    static const std::uint32_t NONE {0xFFFFFFFF};
+
+    struct Node
+    {
+        std::uint32_t parent;
+        std::uint32_t children[2];
+        // Вершин в splay-поддереве, то есть на участке пути
+        std::uint32_t size;
+    };
+
+    PackedMazeGrid grid_;
+    std::vector<Node> nodes_;
+    // Отложенный разворот splay-поддерева (смена корня дерева)
+    std::vector<std::uint8_t> isReversed_;
+    // Проходы вне остовного леса
+    std::unordered_set<std::uint64_t> loopPassages_;
+    std::size_t componentCount_ {};
+    std::vector<std::uint32_t> splayPath_;
+
+    bool isSplayRoot(std::uint32_t node) const;
+    void pushReverse(std::uint32_t node);
+    void updateSize(std::uint32_t node);
+    void rotate(std::uint32_t node);
+    void splay(std::uint32_t node);
+    void access(std::uint32_t node);
+    void makeRoot(std::uint32_t node);
+    std::uint32_t findRoot(std::uint32_t node);
+    void link(std::uint32_t first, std::uint32_t second);
+    void cut(std::uint32_t first, std::uint32_t second);
+    void collectPath(std::uint32_t node, std::vector<std::uint32_t> &path);
+
+    bool getPassageCells(std::size_t x, std::size_t y, int direction, std::uint32_t &first, std::uint32_t &second) const;
+
+public:
+    MazeConnectivity() noexcept {};
+    ~MazeConnectivity() {};
+
+    // O(N): остовный лес обходом в ширину. false, если в сетке 2^32 - 1 клеток или больше
+    bool build(const PackedMazeGrid &grid);
+    EditResult setPassage(std::size_t x, std::size_t y, int direction, bool isOpen);
+
+    // Сетка со всеми правками
+    const PackedMazeGrid& getGrid() const;
+    std::size_t getComponentCount() const;
+    // Число независимых циклов: проходов сверх остовного леса
+    std::size_t getLoopCount() const;
+    bool isPerfect() const;
+
+    bool isConnected(std::size_t firstCell, std::size_t secondCell);
+    /* Путь по остовному лесу. Без циклов он единственный; с циклами - один из путей, не обязательно
+     * кратчайший. Длина - число шагов, NO_PATH для несвязанных клеток */
+    std::uint64_t getPathLength(std::size_t fromCell, std::size_t toCell);
+    // Клетки пути из fromCell в toCell включительно, пустой, если пути нет; O(log N + длина пути)
+    std::vector<std::uint32_t> getPath(std::size_t fromCell, std::size_t toCell);
+};
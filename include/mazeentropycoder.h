@@ -0,0 +1,28 @@
+#pragma once
+
+#include "packedmazegrid.h"
+
+#include <cstdint>
+#include <vector>
+
+/* Сжатие стен лабиринта адаптивным двоичным арифметическим кодером (range coder в духе LZMA).
+ * Каждая клетка - это два бита (проход вправо и вниз), и кодируются они с контекстом из уже
+ * закодированных соседей и связности клеток текущей строки: в лабиринте без циклов проход между
+ * уже связанными клетками невозможен, а часть проходов вниз обязательна. Для равномерных остовных
+ * деревьев выходит около 1.73 бита на клетку (предел - около 1.68), для Binary Tree - около 1.03.
+ * Биты у правого и нижнего края всегда закрыты и не кодируются вовсе.
+ *
+ * Размер сетки в сжатые данные не пишется - его хранит тот, кто хранит сами данные */
+class MazeEntropyCoder
+{
+public:
+    /* Больше клеток на байт сжатых данных не бывает: каждая клетка, кроме одной, кодирует хотя бы
+     * один бит, а бит стоит не меньше log2(2048 / 2017) ~ 0.022 бита - вероятность не уходит за 31/2048.
+     * По этой границе читатели отбрасывают поврежденный размер сетки до выделения памяти */
+    static const std::uint64_t MAX_CELLS_PER_BYTE {512};
+
+    // Дописывает сжатые плоскости grid в конец encoded
+    static void encode(const PackedMazeGrid &grid, std::vector<std::uint8_t> &encoded);
+    // grid должна быть уже нужного размера; false, если данные обрываются раньше времени
+    static bool decode(const std::uint8_t *encoded, std::size_t encodedSize, PackedMazeGrid &grid);
+};
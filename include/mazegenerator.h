@@ -0,0 +1,35 @@
+#pragma once
+
+#include "packedmazegrid.h"
+
+#include <cstdint>
+
+// Все, от чего зависит результат генерации: при одинаковых параметрах лабиринт одинаковый
+struct GenerationParameters
+{
+    int algorithm;
+    std::size_t width;
+    std::size_t height;
+    std::uint64_t seed;
+    GenerationParameters();
+    GenerationParameters(int algorithm, std::size_t width, std::size_t height, std::uint64_t seed);
+    bool operator==(const GenerationParameters &other) const;
+    bool operator!=(const GenerationParameters &other) const;
+};
+
+/* Единая точка входа для генерации без графики: по номеру алгоритма выбирает нужный генератор и
+ * строит лабиринт в PackedMazeGrid. Номера алгоритмов совпадают с AlgorithmGeneratorMenu::Algorithm */
+class MazeGenerator
+{
+private:
+    static void generateRecursiveBacktracker(const GenerationParameters &parameters, PackedMazeGrid &grid);
+
+public:
+    enum Algorithm {AldousBroder, RecursiveBacktracker, Wilson, BinaryTree, Sidewinder, CyclePopping, Count};
+
+    static bool isSupported(int algorithm);
+    // Алгоритм поддерживается и справляется с сеткой такого размера
+    static bool isSupported(const GenerationParameters &parameters);
+    // Неподдерживаемые параметры (isSupported) оставляют grid без изменений
+    static void generate(const GenerationParameters &parameters, PackedMazeGrid &grid);
+};
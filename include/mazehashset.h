@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+/* Множество 64-битных хешей лабиринтов для отсева повторов при пакетной генерации. Таблица с
+ * открытой адресацией без блокировок: вставка - это compare-and-swap пустой ячейки, поэтому все
+ * потоки генерации пишут в нее одновременно. Во время вставок емкость не меняется; между пачками,
+ * когда вставок нет, reserve увеличивает ее, так что память идет только на различные лабиринты.
+ *
+ * Вместе с хешем хранится наименьший порядковый номер лабиринта с этим хешем. Какой поток
+ * вставит хеш первым, зависит от планировщика, а наименьший номер - нет: после вставки всех
+ * лабиринтов isFirst одинаково отвечает при любом числе потоков.
+ *
+ * Хеш 0 обозначает пустую ячейку и хранится как 1 */
+class MazeHashSet
+{
+public:
+    enum InsertResult {Inserted, Duplicate, Full};
+
+private:
+    static const std::uint64_t EMPTY_KEY {0};
+
+    std::size_t capacity_ {};
+    std::size_t slotMask_ {};
+    std::unique_ptr<std::atomic<std::uint64_t>[]> keys_;
+    std::unique_ptr<std::atomic<std::uint64_t>[]> firstOrdinals_;
+    std::atomic<std::size_t> size_ {0};
+
+    static std::uint64_t toKey(std::uint64_t hash);
+    std::size_t getFirstSlot(std::uint64_t key) const;
+
+public:
+    // Вмещает capacity хешей; ячеек вдвое больше, чтобы цепочки проб оставались короткими
+    explicit MazeHashSet(std::size_t capacity);
+    ~MazeHashSet() {};
+
+    /* Увеличивает емкость до capacity с переносом хешей и номеров. Не потокобезопасна: вызывать,
+     * когда вставок и запросов нет. При нехватке памяти бросает std::bad_alloc, множество не меняется */
+    void reserve(std::size_t capacity);
+
+    // Full, если хешей уже capacity: повтор тогда не распознать, вызывающему нужно остановиться
+    InsertResult insert(std::uint64_t hash, std::uint64_t ordinal);
+    bool contains(std::uint64_t hash) const;
+    // Лабиринт ordinal - самый ранний с таким хешем (вызывать после вставок)
+    bool isFirst(std::uint64_t hash, std::uint64_t ordinal) const;
+    std::size_t getSize() const;
+    std::size_t getCapacity() const;
+};
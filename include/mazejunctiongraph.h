@@ -0,0 +1,124 @@
+#pragma once
+
+#include "packedmazegrid.h"
+
+#include <cstdint>
+#include <vector>
+
+/* Граф развилок готового лабиринта: коридоры (клетки ровно с двумя проходами) сжаты во взвешенные
+ * ребра между узлами - развилками и тупиками. Поиск пути обходит только узлы, а клетки коридора
+ * восстанавливаются по ребру. Узлов меньше, чем клеток, примерно в 5 раз у Recursive Backtracker
+ * с его длинными коридорами и примерно в 1.8 раза у равномерных алгоритмов, так что граф окупается
+ * при многих поисках по одному лабиринту.
+ *
+ * Строится по сетке, оставленной генерацией (Maze::getPackedGrid или MazeGenerator), параллельно
+ * по полосам строк: каждая полоса находит свои узлы и проходит коридоры из них. Номер клетки, как
+ * и в MazeAnalyzer, - y * width + x; узлы пронумерованы в порядке клеток.
+ *
+ * После правок стен в сетке бывают циклы. Цикл из одних клеток коридора узлов не имеет, поэтому
+ * одна его клетка становится узлом с ребром-петлей; такие узлы идут после остальных. Поиск пути
+ * в сетке с циклами идет по длинам ребер и дает кратчайший путь, как MazeAnalyzer::findPath */
+class MazeJunctionGraph
+{
+public:
+    struct Edge
+    {
+        std::uint32_t fromNode;
+        std::uint32_t toNode;
+        // Шагов от узла до узла, то есть клеток коридора плюс один
+        std::uint32_t length;
+        // Направления (PackedMazeGrid::Direction), которыми ребро выходит из fromNode и из toNode
+        std::uint8_t fromDirection;
+        std::uint8_t toDirection;
+        // Клетки коридора от fromNode к toNode - corridorCells[firstCell] ... [firstCell + length - 2]
+        std::uint64_t firstCell;
+    };
+
+    static const std::uint32_t NO_NODE {0xFFFFFFFF};
+
+private:
+    // Старший бит в cellLocations_ отличает клетку коридора (номер ребра) от узла
+    static const std::uint32_t CORRIDOR_FLAG {0x80000000};
+    static const std::size_t MIN_CELLS_PER_THREAD {1 << 16};
+
+    // Состояние одной полосы строк между проходами построения
+    struct Band
+    {
+        std::size_t firstRow {};
+        std::size_t endRow {};
+        std::uint32_t firstNode {};
+        std::uint32_t nodeCount {};
+        std::uint64_t firstSlot {};
+        std::uint64_t slotCount {};
+        std::uint32_t firstEdge {};
+        std::uint64_t firstCorridorCell {};
+        std::vector<Edge> edges;
+        std::vector<std::uint32_t> corridorCells;
+    };
+
+    std::size_t width_ {};
+    std::size_t height_ {};
+    std::vector<std::uint32_t> nodeCells_;
+    // Ребра узла - nodeEdges_[nodeEdgeOffsets_[node]] ... по порядку направлений
+    std::vector<std::uint64_t> nodeEdgeOffsets_;
+    std::vector<std::uint32_t> nodeEdges_;
+    std::vector<Edge> edges_;
+    std::vector<std::uint32_t> corridorCells_;
+    std::vector<std::uint32_t> cellLocations_;
+    std::uint32_t maxEdgeLength_ {};
+    bool hasCycles_ {};
+
+    // Проходы клетки по битам направлений, нужны только на время построения
+    std::vector<std::uint8_t> openings_;
+
+    void findOpenings(const PackedMazeGrid &grid, Band &band);
+    void numberNodes(Band &band);
+    void traceCorridors(Band &band) const;
+    void publishEdges(Band &band);
+    // Узлы для циклов без развилок и тупиков, которые не прошел ни один коридор
+    void addCycleNodes();
+    bool findCycles() const;
+
+    std::size_t getCorridorPosition(std::uint32_t edge, std::uint32_t cell) const;
+    void appendCorridor(std::uint32_t edge, std::size_t first, std::size_t last, std::vector<std::uint32_t> &path) const;
+    // Шагов от клетки коридора до узла на его конце; у петли - до ближнего конца
+    std::uint64_t getExitLength(std::uint32_t edge, std::size_t position, std::uint32_t node) const;
+    bool isExitAtEnd(std::uint32_t edge, std::size_t position, std::uint32_t node) const;
+    /* Поиск от toCell до узла, через который путь выходит из fromCell; ссылки на родителя - номера
+     * ребер в parentEdges. Возвращает этот узел или NO_NODE, если пути нет. Обход в ширину годится
+     * только для дерева, в сетке с циклами - Дейкстра по длинам ребер, и тогда учитываются лишь пути
+     * короче maxLength */
+    std::uint32_t searchTree(std::size_t fromCell, std::size_t toCell, std::vector<std::uint32_t> &parentEdges) const;
+    std::uint32_t searchShortest(std::size_t fromCell, std::size_t toCell, std::uint64_t maxLength,
+                                 std::vector<std::uint32_t> &parentEdges) const;
+
+public:
+    MazeJunctionGraph() noexcept {};
+    ~MazeJunctionGraph() {};
+
+    // threadCount 0 - по числу ядер. false, если в сетке 2^31 клеток или больше
+    bool build(const PackedMazeGrid &grid, unsigned int threadCount = 0);
+
+    std::size_t getWidth() const;
+    std::size_t getHeight() const;
+    std::size_t getNodeCount() const;
+    // Есть ли в сетке циклы, то есть не лес ли это
+    bool hasCycles() const;
+    std::size_t getEdgeCount() const;
+    std::uint32_t getNodeCell(std::uint32_t node) const;
+    std::size_t getNodeDegree(std::uint32_t node) const;
+    // Номер ребра из узла по порядку 0 ... getNodeDegree(node) - 1
+    std::uint32_t getNodeEdge(std::uint32_t node, std::size_t index) const;
+    const Edge& getEdge(std::uint32_t edge) const;
+    const std::uint32_t* getCorridorCells(std::uint32_t edge) const;
+
+    // Узел клетки или NO_NODE, если клетка лежит в коридоре
+    std::uint32_t getCellNode(std::size_t cell) const;
+    // Ребро, в коридоре которого лежит клетка, или NO_NODE для узлов
+    std::uint32_t getCellEdge(std::size_t cell) const;
+
+    /* Путь по клеткам из fromCell в toCell включительно, как MazeAnalyzer::findPath, но обход идет
+     * по узлам, а коридоры разворачиваются только на найденном пути. В дереве путь единственный и
+     * веса для его поиска не нужны; с циклами путь кратчайший */
+    std::vector<std::uint32_t> findPath(std::size_t fromCell, std::size_t toCell) const;
+};
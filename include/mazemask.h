@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <vector>
+
+/* Маска формы лабиринта: какие клетки прямоугольника width x height входят в лабиринт.
+ * Биты хранятся строками по 64-битным словам, как в PackedMazeGrid, а для каждого слова
+ * запоминается число активных клеток до него. Этого хватает, чтобы за O(1) получить плотный
+ * номер активной клетки (rank: 0, 1, ... в порядке строк) и за O(log) - клетку по номеру
+ * (select). Генераторы по маске держат свое состояние в массивах по плотным номерам, поэтому
+ * их память растет с площадью фигуры, а не описанного прямоугольника.
+ *
+ * После setActive индекс нужно построить заново через buildIndex; readPbm строит его сам */
+class MazeMask
+{
+private:
+    static const std::size_t BITS_PER_WORD {64};
+
+    std::size_t width_ {};
+    std::size_t height_ {};
+    std::size_t wordsPerRow_ {};
+    std::vector<std::uint64_t> words_;
+    // Активных клеток до начала слова; последний элемент - всего активных клеток
+    std::vector<std::uint64_t> wordRanks_;
+
+public:
+    MazeMask() noexcept {};
+    explicit MazeMask(std::size_t width, std::size_t height);
+    ~MazeMask() {};
+
+    // Все клетки становятся неактивными
+    void resize(std::size_t width, std::size_t height);
+    void fill(bool isActive);
+
+    std::size_t getWidth() const;
+    std::size_t getHeight() const;
+
+    bool isActive(std::size_t x, std::size_t y) const;
+    void setActive(std::size_t x, std::size_t y, bool isActive);
+
+    void buildIndex();
+    std::size_t getActiveCount() const;
+    // Плотный номер активной клетки (x, y); isActive и rank - на каждом шаге генераторов, поэтому inline
+    std::size_t rank(std::size_t x, std::size_t y) const;
+    // Клетка с плотным номером index < getActiveCount()
+    void select(std::size_t index, std::size_t &x, std::size_t &y) const;
+
+    /* Маска из PBM (P1 или P4): черный пиксель - активная клетка, так что логотип, нарисованный
+     * черным по белому, и становится лабиринтом. false, если файл не PBM или обрезан */
+    static bool readPbm(std::istream &stream, MazeMask &mask);
+};
+
+/*------------------------------------------------------------------------------------------------*/
+inline bool MazeMask::isActive(std::size_t x, std::size_t y) const
+{
+    return (words_[y * wordsPerRow_ + x / BITS_PER_WORD] >> (x % BITS_PER_WORD)) & 1;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+inline std::size_t MazeMask::rank(std::size_t x, std::size_t y) const
+{
+    const std::size_t word = y * wordsPerRow_ + x / BITS_PER_WORD;
+    const std::uint64_t lowerBits = (std::uint64_t(1) << (x % BITS_PER_WORD)) - 1;
+#if defined(__GNUC__)
+    const unsigned int lowerCount = static_cast<unsigned int>(__builtin_popcountll(words_[word] & lowerBits));
+#else
+    unsigned int lowerCount {0};
+    for (std::uint64_t bits = words_[word] & lowerBits; bits != 0; bits &= bits - 1)
+        ++lowerCount;
+#endif
+    return static_cast<std::size_t>(wordRanks_[word] + lowerCount);
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "mazegenerator.h"
+#include "mazerandom.h"
+#include "packedmazegrid.h"
+
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+/* Пул заранее сгенерированных лабиринтов. Для каждой запрошенной пары (алгоритм, размер) держит
+ * до mazesPerKey готовых лабиринтов со случайными seed; take() отдает готовый лабиринт обменом
+ * за O(1), а фоновые потоки с пониженным приоритетом сразу начинают генерировать замену.
+ *
+ * Суммарный объем готовых лабиринтов ограничен maxSizeBytes: если новый не помещается, место
+ * освобождается за счет давно не запрашивавшихся размеров. Пока система загружена (средняя
+ * загрузка выше числа ядер без учета самого пула), пополнение приостанавливается */
+class MazePool
+{
+public:
+    struct Statistics
+    {
+        std::uint64_t hits {};
+        std::uint64_t misses {};
+        std::uint64_t readyMazes {};
+        std::uint64_t sizeBytes {};
+    };
+
+private:
+    using Key = std::tuple<int, std::size_t, std::size_t>;
+
+    struct Slot
+    {
+        std::deque<PackedMazeGrid> readyMazes;
+        std::size_t pendingMazes {};
+        std::uint64_t lastUsedTick {};
+    };
+
+    const std::size_t mazesPerKey_ {};
+    const std::uint64_t maxSizeBytes_ {};
+
+    mutable std::mutex mutex_;
+    std::condition_variable refillCondition_;
+    std::vector<std::thread> workers_;
+    bool isStopping_ {false};
+
+    std::map<Key, Slot> slots_;
+    std::uint64_t tick_ {};
+    // Память готовых лабиринтов и лабиринтов, которые сейчас генерируются
+    std::uint64_t sizeBytes_ {};
+    unsigned int busyWorkers_ {};
+    MazeRandom seedSource_;
+    Statistics statistics_;
+
+    static std::uint64_t estimateSizeBytes(const Key &key);
+    static bool isCpuUnderPressure(unsigned int busyWorkers);
+    static void lowerCurrentThreadPriority();
+
+    bool findSlotToRefill(Key &key);
+    bool freeMemoryFor(const Key &key, std::uint64_t sizeBytes);
+    void runWorker();
+
+public:
+    explicit MazePool(std::size_t mazesPerKey, std::uint64_t maxSizeBytes, unsigned int threadCount = 1);
+    ~MazePool();
+
+    MazePool(const MazePool&) = delete;
+    MazePool& operator=(const MazePool&) = delete;
+
+    /* Забирает готовый лабиринт в grid. Пара (алгоритм, размер) с этого момента пополняется в фоне,
+     * поэтому при первом запросе вернется false и лабиринт нужно построить самостоятельно */
+    bool take(int algorithm, std::size_t width, std::size_t height, PackedMazeGrid &grid);
+
+    Statistics getStatistics() const;
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+/* Сидируемый генератор xoshiro256**. QRandomGenerator::global() не даёт ни повторяемости по
+ * seed, ни доступа к состоянию, а генераторам, работающим словами по 64 клетки, нужны дешёвые
+ * 64-битные случайные маски */
+class MazeRandom
+{
+public:
+    using State = std::array<std::uint64_t, 4>;
+
+private:
+    std::uint64_t state_[4] {};
+
+public:
+    explicit MazeRandom(std::uint64_t seed = 0) noexcept;
+    ~MazeRandom() {};
+
+    void seed(std::uint64_t seed);
+    // Состояние нужно для контрольных точек: восстановленный генератор продолжает ту же серию
+    State getState() const;
+    void setState(const State &state);
+
+    std::uint64_t generate64();
+    std::uint32_t generate();
+    std::uint32_t bounded(std::uint32_t highest);
+};
+
+/*------------------------------------------------------------------------------------------------*/
+inline std::uint64_t MazeRandom::generate64()
+{
+    const std::uint64_t result = ((state_[1] * 5) << 7 | (state_[1] * 5) >> 57) * 9;
+    const std::uint64_t t = state_[1] << 17;
+
+    state_[2] ^= state_[0];
+    state_[3] ^= state_[1];
+    state_[1] ^= state_[2];
+    state_[0] ^= state_[3];
+    state_[2] ^= t;
+    state_[3] = (state_[3] << 45) | (state_[3] >> 19);
+
+    return result;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+inline std::uint32_t MazeRandom::generate()
+{
+    return static_cast<std::uint32_t>(generate64() >> 32);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+inline std::uint32_t MazeRandom::bounded(std::uint32_t highest)
+{
+    // Умножение со сдвигом вместо остатка от деления (Lemire), смещение пренебрежимо мало
+    return static_cast<std::uint32_t>((static_cast<std::uint64_t>(generate()) * highest) >> 32);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "packedmazegrid.h"
+
+#include <cstdint>
+#include <vector>
+
+/* Перегенерация прямоугольной области готового лабиринта на месте. Проходы внутри области
+ * удаляются, проходы через её границу остаются, а внутри заново строятся равномерные остовные
+ * деревья (алгоритм Уилсона) - по одному на каждый компонент, на которые область была разбита
+ * своими внутренними проходами. Каждый компонент сохраняет свои клетки и выходы наружу, поэтому
+ * связность через границу не меняется, и идеальный лабиринт остается идеальным.
+ *
+ * Чаще всего область связна, и перестраивается целиком; если лабиринт входит и выходит из
+ * области несколько раз, части не сливаются: для этого нужна связность снаружи, а работа
+ * пропорциональна только размеру области */
+class MazeRegionRegenerator
+{
+public:
+    struct Region
+    {
+        std::size_t x;
+        std::size_t y;
+        std::size_t width;
+        std::size_t height;
+    };
+
+private:
+    static const std::uint32_t NO_COMPONENT {0xFFFFFFFF};
+
+    enum CellState : std::uint8_t {DirectionMask = 0x03, InTree = 0x04};
+
+    static bool getNeighbor(const Region &region, std::size_t cell, int direction, std::size_t &neighbor);
+    static std::uint32_t labelComponents(const PackedMazeGrid &grid, const Region &region,
+                                         std::vector<std::uint32_t> &components);
+    static void clearInteriorPassages(PackedMazeGrid &grid, const Region &region);
+    static void runWilson(PackedMazeGrid &grid, const Region &region, const std::vector<std::uint32_t> &components,
+                          std::uint32_t componentCount, std::uint64_t seed);
+
+public:
+    // false, если область пуста или выходит за сетку
+    static bool regenerate(PackedMazeGrid &grid, const Region &region, std::uint64_t seed);
+};
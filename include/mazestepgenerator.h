@@ -0,0 +1,116 @@
+#pragma once
+
+#include "mazerandom.h"
+#include "packedmazegrid.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/* Пошаговые генераторы Aldous-Broder, Recursive Backtracker и Wilson. Генератор не
+ * рисует и не ждет: каждый вызов next выдает один шаг (прорубить проход, пройти, стереть петлю,
+ * вернуться), а что с ним делать, решает вызывающий - анимация, воспроизведение или проверка.
+ *
+ * Все состояние лежит в членах класса, как у UniformTreeGenerator, так что генерацию можно
+ * тянуть по одному шагу, по N шагов или сразу до конца. Номера алгоритмов - MazeGenerator::Algorithm.
+ * Случайные числа расходуются в том же порядке, что у MazeGenerator (для блужданий - у
+ * UniformTreeGenerator), поэтому при том же seed шаги строят тот же лабиринт: стертые петли
+ * Уилсона дают тот же путь, что направления последнего выхода. Это проверяет
+ * benchmarks/stepgenerator */
+class MazeStepGenerator
+{
+public:
+    enum StepType
+    {
+        // Блуждающий ставится в клетку (x, y) без прохода: начало генерации или новой ветки Уилсона
+        Start,
+        // Проход из (x, y) в сторону direction открыт, блуждающий перешел в соседа
+        Carve,
+        // Блуждающий перешел из (x, y) в сторону direction по уже построенной части
+        Move,
+        // Петля Уилсона: клетка (x, y) убрана из пути, проход из нее в сторону direction закрыт
+        Erase,
+        // Recursive Backtracker: тупик, возврат из (x, y) в сторону direction
+        Retreat
+    };
+
+    struct Step
+    {
+        int type;
+        std::uint32_t x;
+        std::uint32_t y;
+        int direction;
+    };
+
+private:
+    enum CellState : std::uint8_t {InMaze = 0x01, OnPath = 0x02};
+    enum Phase {AldousBroderWalk, BacktrackerWalk, WilsonSeek, WilsonWalk, WilsonErase, Finished};
+
+    std::size_t width_ {};
+    std::size_t height_ {};
+    std::uint64_t seed_ {};
+    MazeRandom random_;
+    int algorithm_ {};
+    int phase_ {Phase::Finished};
+    bool isStarted_ {false};
+
+    // Клетка блуждающего: и координаты, и номер, чтобы на шаге не делить
+    std::size_t x_ {};
+    std::size_t y_ {};
+    std::size_t cell_ {};
+    std::size_t cellsInMaze_ {};
+    std::vector<std::uint8_t> cellStates_;
+    // Стек Recursive Backtracker или текущий путь блуждания Уилсона
+    std::vector<std::size_t> path_;
+    std::size_t eraseTargetCell_ {};
+    // Все клетки до неё уже в лабиринте
+    std::size_t firstFreeCell_ {};
+
+    std::uint64_t directionBits_ {};
+    unsigned int directionBitsLeft_ {};
+
+    int chooseRandomDirection(std::size_t x, std::size_t y);
+    std::size_t getNeighbor(std::size_t cell, int direction) const;
+    void moveToNeighbor(int direction);
+    static int getDirectionBetween(std::size_t fromCell, std::size_t toCell, std::size_t width);
+
+    void makeAldousBroderStep(Step &step);
+    void makeBacktrackerStep(Step &step);
+    void makeWilsonSeekStep(Step &step);
+    void makeWilsonWalkStep(Step &step);
+    void makeWilsonEraseStep(Step &step);
+    void setStep(Step &step, int type, int direction) const;
+
+public:
+    explicit MazeStepGenerator(int algorithm, std::size_t width, std::size_t height, std::uint64_t seed) noexcept;
+    ~MazeStepGenerator() {};
+
+    static bool isSupported(int algorithm);
+    // Открывает или закрывает проход шага в сетке; Start, Move и Retreat сетку не меняют
+    static void applyStep(const Step &step, PackedMazeGrid &grid);
+
+    // false, когда лабиринт готов и шагов больше нет
+    bool next(Step &step);
+    bool isFinished() const;
+
+    // До maxSteps шагов, каждый передается в stepHandler; возвращает число сделанных шагов
+    template <typename StepHandler>
+    std::size_t advance(std::size_t maxSteps, StepHandler &&stepHandler);
+    /* Генерация до конца без обработчиков. Если шагов еще не было, лабиринт строит MazeGenerator
+     * без выдачи шагов (в 1.5-3 раза быстрее), иначе оставшиеся шаги применяются к сетке */
+    void run(PackedMazeGrid &grid);
+};
+
+/*------------------------------------------------------------------------------------------------*/
+template <typename StepHandler>
+std::size_t MazeStepGenerator::advance(std::size_t maxSteps, StepHandler &&stepHandler)
+{
+    std::size_t stepCount {0};
+    Step step;
+    while (stepCount < maxSteps && next(step))
+    {
+        stepHandler(static_cast<const Step&>(step));
+        ++stepCount;
+    }
+    return stepCount;
+}
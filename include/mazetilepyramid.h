@@ -0,0 +1,122 @@
+#pragma once
+
+#include "packedmazegrid.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/* Пирамида плиток для просмотра лабиринтов, которые не помещаются ни на сцену, ни в одно
+ * изображение (50 000 x 50 000 и больше). Плитка - квадрат TILE_SIZE x TILE_SIZE пикселей яркости;
+ * на уровне level она покрывает 32 * 2^level клеток по каждой стороне, верхний уровень - одна
+ * плитка на весь лабиринт. На уровнях 0-2 клетка занимает 8, 4 и 2 пикселя и стены рисуются как
+ * есть, выше пиксель покрывает 2^(level - 3) клеток, и его яркость - доля открытых проходов в них
+ * (считается popcount по словам плоскостей).
+ *
+ * Плитки рисуются пулом потоков в порядке запроса и хранятся в LRU-кэше ограниченного размера.
+ * Правка стены задевает ровно одну плитку на каждом уровне: такие плитки в кэше помечаются
+ * устаревшими и перерисовываются, а до этого отдаются старые, чтобы изображение не мигало.
+ * Потоки читают сетку без копирования, поэтому правка ждет окончания начатых плиток, а новые
+ * плитки ждут правку.
+ *
+ * Все методы потокобезопасны; обработчик готовности вызывается из рабочего потока */
+class MazeTilePyramid
+{
+public:
+    static const unsigned int TILE_SIZE {256};
+    // Сторона клетки вместе с одной из её стен на уровне 0
+    static const unsigned int FINEST_CELL_PIXELS {8};
+
+    struct Tile
+    {
+        unsigned int level {};
+        std::uint32_t tileX {};
+        std::uint32_t tileY {};
+        // TILE_SIZE строк по TILE_SIZE байт
+        std::vector<std::uint8_t> pixels;
+    };
+
+    struct Statistics
+    {
+        std::uint64_t hits {};
+        std::uint64_t misses {};
+        std::uint64_t rendered {};
+        std::uint64_t evictions {};
+        std::uint64_t invalidations {};
+    };
+
+    using ReadyHandler = std::function<void()>;
+
+private:
+    using Key = std::uint64_t;
+
+    struct Entry
+    {
+        std::shared_ptr<const Tile> tile;
+        // Стены под плиткой менялись; плитка уже стоит в очереди на перерисовку
+        bool isStale {false};
+        std::list<Key>::iterator lruPosition;
+    };
+
+    PackedMazeGrid grid_;
+    unsigned int levelCount_ {};
+    std::size_t capacity_ {};
+
+    mutable std::mutex mutex_;
+    std::condition_variable workCondition_;
+    std::condition_variable gridCondition_;
+    ReadyHandler readyHandler_;
+    // В начале списка - последняя использованная плитка
+    std::list<Key> lruKeys_;
+    std::unordered_map<Key, Entry> entries_;
+    std::deque<Key> pendingKeys_;
+    // Ждущие в очереди и рисующиеся сейчас
+    std::unordered_set<Key> queuedKeys_;
+    Statistics statistics_;
+    unsigned int activeRenders_ {};
+    bool isGridWriteWaiting_ {false};
+    bool isStopping_ {false};
+    std::vector<std::thread> workers_;
+
+    static Key makeKey(unsigned int level, std::uint32_t tileX, std::uint32_t tileY);
+    void enqueue(Key key);
+    void insertTile(Key key, std::shared_ptr<const Tile> &&tile);
+    void invalidateTile(unsigned int level, std::size_t tileX, std::size_t tileY);
+    void runWorker();
+
+    void renderTile(Tile &tile) const;
+    void renderWalls(Tile &tile, unsigned int cellPixels) const;
+    void renderDensity(Tile &tile, std::size_t cellsPerPixel) const;
+
+public:
+    // threadCount 0 - по числу ядер без одного, чтобы не мешать интерфейсу
+    explicit MazeTilePyramid(PackedMazeGrid &&grid, std::size_t capacity, unsigned int threadCount = 0);
+    ~MazeTilePyramid();
+
+    // Сетку меняет только setPassage; читать её можно из потока, который его вызывает
+    const PackedMazeGrid& getGrid() const;
+    unsigned int getLevelCount() const;
+    std::size_t getTileCells(unsigned int level) const;
+    std::uint32_t getTileColumns(unsigned int level) const;
+    std::uint32_t getTileRows(unsigned int level) const;
+    Statistics getStatistics() const;
+
+    void setReadyHandler(const ReadyHandler &readyHandler);
+    /* Плитка из кэша, возможно устаревшая, или nullptr. Отсутствующая или устаревшая плитка
+     * ставится в конец очереди, поэтому запросы от грубого уровня к подробному так и рисуются */
+    std::shared_ptr<const Tile> requestTile(unsigned int level, std::uint32_t tileX, std::uint32_t tileY);
+    // Только из кэша, без очереди и без влияния на LRU
+    std::shared_ptr<const Tile> findTile(unsigned int level, std::uint32_t tileX, std::uint32_t tileY) const;
+    // Снимает с очереди еще не начатые плитки, например ушедшие из окна
+    void cancelPending();
+
+    void setPassage(std::size_t x, std::size_t y, int direction, bool isOpen);
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/* Компактное хранение стен лабиринта: по два бита на клетку в двух битовых плоскостях.
+ * Бит в плоскости right означает проход из (x, y) в (x + 1, y), бит в плоскости bot - проход
+ * из (x, y) в (x, y + 1). Каждая строка выровнена на 64-битные слова, поэтому генераторы и
+ * экспорт могут работать сразу с 64 клетками за операцию.
+ *
+ * Плоскости могут лежать во внешней памяти (например, в разделяемой памяти другого процесса):
+ * пока размер помещается в эту память, resize и генераторы пишут прямо в неё */
+class PackedMazeGrid
+{
+private:
+    std::size_t width_ {};
+    std::size_t height_ {};
+    std::size_t wordsPerRow_ {};
+
+    std::vector<std::uint64_t> rightPassages_;
+    std::vector<std::uint64_t> botPassages_;
+
+    // Указывают либо в векторы выше, либо во внешнюю память
+    std::uint64_t *rightPlane_ {nullptr};
+    std::uint64_t *botPlane_ {nullptr};
+    std::size_t externalCapacityWords_ {};
+    bool isExternalStorage_ {false};
+
+    std::size_t getPlaneWords() const;
+
+public:
+    // Порядок совпадает с Maze::Direction
+    enum Direction {Top, Right, Bot, Left, Count};
+    static const std::size_t BITS_PER_WORD {64};
+
+    PackedMazeGrid() noexcept {};
+    explicit PackedMazeGrid(std::size_t width, std::size_t height);
+    // Копия всегда хранит плоскости в собственной памяти
+    PackedMazeGrid(const PackedMazeGrid &other);
+    PackedMazeGrid& operator=(const PackedMazeGrid &other);
+    ~PackedMazeGrid() {};
+
+    void resize(std::size_t width, std::size_t height);
+    void clear();
+    // Обмен содержимым за O(1), без копирования плоскостей
+    void swap(PackedMazeGrid &other) noexcept;
+
+    /* Переносит текущие плоскости во внешнюю память, по planeCapacityWords слов на каждую плоскость.
+     * Память должна вмещать текущий размер; при resize сверх нее сетка возвращается в свою память */
+    void moveToExternalStorage(std::uint64_t *rightPlane, std::uint64_t *botPlane, std::size_t planeCapacityWords);
+    bool usesStorage(const std::uint64_t *rightPlane) const;
+
+    std::size_t getWidth() const;
+    std::size_t getHeight() const;
+    std::size_t getCellCount() const;
+    std::size_t getWordsPerRow() const;
+    std::size_t getSizeBytes() const;
+
+    std::uint64_t getRowMask(std::size_t wordIndex) const;
+    std::uint64_t getRightRowMask(std::size_t wordIndex) const;
+
+    std::uint64_t* getRightRow(std::size_t row);
+    std::uint64_t* getBotRow(std::size_t row);
+    const std::uint64_t* getRightRow(std::size_t row) const;
+    const std::uint64_t* getBotRow(std::size_t row) const;
+
+    bool hasPassage(std::size_t x, std::size_t y, int direction) const;
+    void setPassage(std::size_t x, std::size_t y, int direction, bool isOpen);
+
+    // Контрольная сумма обеих плоскостей для проверки целостности сохраненных лабиринтов
+    std::uint64_t computeChecksum() const;
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "mazerandom.h"
+#include "packedmazegrid.h"
+
+#include <functional>
+#include <vector>
+
+/* Генераторы Binary Tree и Sidewinder, которые строят лабиринт строка за строкой, обрабатывая
+ * по 64 клетки за операцию. Каждой строке нужна только она сама, поэтому строки можно как
+ * писать в PackedMazeGrid, так и отдавать наружу по одной, не храня весь лабиринт */
+class RowWiseGenerator
+{
+public:
+    enum Algorithm {BinaryTree, Sidewinder};
+    using RowSink = std::function<void(std::size_t row,
+                                       const std::uint64_t *rightPassages,
+                                       const std::uint64_t *botPassages)>;
+
+private:
+    std::size_t height_ {};
+    PackedMazeGrid rowLayout_;
+    MazeRandom random_;
+
+    std::vector<std::uint64_t> rightRow_;
+    std::vector<std::uint64_t> botRow_;
+
+    void generateRow(int algorithm, std::size_t row, std::uint64_t *rightPassages, std::uint64_t *botPassages);
+    void generateBinaryTreeRow(std::uint64_t *rightPassages, std::uint64_t *botPassages);
+    void generateSidewinderRow(std::uint64_t *rightPassages, std::uint64_t *botPassages);
+    void generateLastRow(std::uint64_t *rightPassages, std::uint64_t *botPassages);
+
+public:
+    explicit RowWiseGenerator(std::size_t width, std::size_t height, std::uint64_t seed) noexcept;
+    ~RowWiseGenerator() {};
+
+    void generate(int algorithm, PackedMazeGrid &grid);
+    void stream(int algorithm, const RowSink &rowSink);
+};
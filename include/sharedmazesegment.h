@@ -0,0 +1,102 @@
+#pragma once
+
+#include "packedmazegrid.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+/* Публикация PackedMazeGrid в именованной разделяемой памяти POSIX без копирования.
+ *
+ * Сегмент: заголовок SharedMazeHeader (64 байта), затем плоскость right и плоскость bot по
+ * planeCapacityWords слов каждая. Издатель переносит плоскости сетки прямо в сегмент, поэтому
+ * генератор пишет в память, которую видят читатели. Согласованность обеспечивает seqlock:
+ * на время записи sequence нечетный, читатель сверяет sequence до и после чтения. Сегмент
+ * только растет, поэтому отображение читателя никогда не выходит за его конец.
+ * На платформах без POSIX shm открытие сегмента просто не удается */
+struct SharedMazeHeader
+{
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::atomic<std::uint64_t> sequence;
+    std::uint64_t width;
+    std::uint64_t height;
+    std::uint64_t wordsPerRow;
+    std::uint64_t planeCapacityWords;
+    std::int32_t algorithm;
+    std::uint32_t reserved;
+};
+
+class SharedMazePublisher
+{
+private:
+    std::string name_;
+    int segmentDescriptor_ {-1};
+    void *mapping_ {nullptr};
+    std::size_t mappingSize_ {};
+    bool isKeptAfterExit_ {false};
+
+    SharedMazeHeader* getHeader() const;
+    std::uint64_t* getRightPlane() const;
+    std::uint64_t* getBotPlane() const;
+    bool ensureCapacity(std::size_t planeWords);
+    bool isNameOwner() const;
+
+public:
+    explicit SharedMazePublisher(const std::string &name) noexcept;
+    ~SharedMazePublisher();
+
+    SharedMazePublisher(const SharedMazePublisher&) = delete;
+    SharedMazePublisher& operator=(const SharedMazePublisher&) = delete;
+
+    /* Имя в стиле shm_open: "/a-maze-n-gen". Всегда создает новый сегмент, прежний сегмент с
+     * тем же именем отвязывается, но у читателей, которые его уже отобразили, остается целым */
+    bool open();
+    /* Имя не отвязывается и после завершения издателя: так процесс может опубликовать лабиринт
+     * и выйти. Сегмент живет, пока его не заменит следующий open() с тем же именем или shm_unlink */
+    void keepAfterExit();
+
+    /* Переносит плоскости сетки в сегмент. Дальнейшие изменения сетки сразу попадают в сегмент,
+     * пока её размер помещается в него */
+    bool attach(PackedMazeGrid &grid);
+    // Повторный вызов до endWrite ничего не делает
+    void beginWrite();
+    void endWrite(int algorithm, PackedMazeGrid &grid);
+};
+
+class SharedMazeReader
+{
+public:
+    struct Snapshot
+    {
+        std::uint64_t sequence {};
+        std::size_t width {};
+        std::size_t height {};
+        std::size_t wordsPerRow {};
+        int algorithm {};
+        const std::uint64_t *rightPlane {nullptr};
+        const std::uint64_t *botPlane {nullptr};
+    };
+
+private:
+    int segmentDescriptor_ {-1};
+    const void *mapping_ {nullptr};
+    std::size_t mappingSize_ {};
+
+    bool remap();
+
+public:
+    SharedMazeReader() noexcept {};
+    ~SharedMazeReader();
+
+    SharedMazeReader(const SharedMazeReader&) = delete;
+    SharedMazeReader& operator=(const SharedMazeReader&) = delete;
+
+    bool open(const std::string &name);
+
+    /* Передает consumer снимок прямо из сегмента, без копирования. consumer может увидеть
+     * данные посреди записи, поэтому его результату можно верить, только если метод вернул true.
+     * Пока идет запись, попытка повторяется до maxAttempts раз */
+    bool readSnapshot(const std::function<void(const Snapshot&)> &consumer, unsigned int maxAttempts = 1000);
+};
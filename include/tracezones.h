@@ -0,0 +1,78 @@
+#pragma once
+
+/* Зоны трассировки для профилирования генерации, отрисовки и работы с файлами.
+ *
+ * MAZE_TRACE_ZONE("имя") в начале блока отмечает время от этой строки до выхода из блока,
+ * MAZE_TRACE_ZONE_ARG добавляет к зоне одно числовое значение (например, номер алгоритма).
+ * Имена зон и аргументов - строковые литералы: они не копируются, а хранятся указателем.
+ *
+ * Трассировка включается сборкой с CONFIG+=tracing (define MAZE_TRACING). Без неё все макросы
+ * раскрываются в пустые операторы и не оставляют в коде ничего. С ней каждый поток пишет
+ * события в свой буфер без блокировок, а TraceRecorder::writeChromeTrace сохраняет их в JSON
+ * формата Chrome trace, который открывается в ui.perfetto.dev и chrome://tracing */
+
+#ifdef MAZE_TRACING
+
+#include <cstdint>
+#include <string>
+
+struct TraceEvent
+{
+    const char *name;
+    const char *argumentName;
+    std::int64_t argument;
+    std::uint64_t startNs;
+    std::uint64_t durationNs;
+};
+
+class TraceRecorder
+{
+public:
+    // Наносекунды от запуска процесса по монотонным часам
+    static std::uint64_t now();
+    static void record(const TraceEvent &event);
+    // Имя текущего потока в трассе; вызывается один раз в начале потока
+    static void setThreadName(const char *threadName);
+    // Сохраняет все записанные к этому моменту события; потоки при этом продолжают писать
+    static bool writeChromeTrace(const std::string &filePath);
+};
+
+class TraceZone
+{
+private:
+    const char *name_;
+    const char *argumentName_;
+    std::int64_t argument_;
+    std::uint64_t startNs_;
+
+public:
+    explicit TraceZone(const char *name, const char *argumentName = nullptr, std::int64_t argument = 0)
+        : name_(name), argumentName_(argumentName), argument_(argument), startNs_(TraceRecorder::now())
+    {
+    }
+
+    ~TraceZone()
+    {
+        TraceRecorder::record(TraceEvent {name_, argumentName_, argument_, startNs_, TraceRecorder::now() - startNs_});
+    }
+
+    TraceZone(const TraceZone&) = delete;
+    TraceZone& operator=(const TraceZone&) = delete;
+};
+
+#define MAZE_TRACE_CONCAT_IMPL(first, second) first##second
+#define MAZE_TRACE_CONCAT(first, second) MAZE_TRACE_CONCAT_IMPL(first, second)
+#define MAZE_TRACE_ZONE(name) TraceZone MAZE_TRACE_CONCAT(traceZone, __LINE__)(name)
+#define MAZE_TRACE_ZONE_ARG(name, argumentName, argument) \
+    TraceZone MAZE_TRACE_CONCAT(traceZone, __LINE__)(name, argumentName, static_cast<std::int64_t>(argument))
+#define MAZE_TRACE_THREAD_NAME(threadName) TraceRecorder::setThreadName(threadName)
+#define MAZE_TRACE_WRITE(filePath) TraceRecorder::writeChromeTrace(filePath)
+
+#else
+
+#define MAZE_TRACE_ZONE(name) static_cast<void>(0)
+#define MAZE_TRACE_ZONE_ARG(name, argumentName, argument) static_cast<void>(0)
+#define MAZE_TRACE_THREAD_NAME(threadName) static_cast<void>(0)
+#define MAZE_TRACE_WRITE(filePath) static_cast<void>(0)
+
+#endif
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "generationcheckpoint.h"
+#include "mazerandom.h"
+#include "packedmazegrid.h"
+#include "visitheatmap.h"
+
+#include <functional>
+#include <vector>
+
+/* Генераторы равномерного остовного дерева на основе случайного блуждания (Aldous-Broder и Wilson)
+ * без привязки к графике: работают прямо с PackedMazeGrid и сидируемым MazeRandom.
+ *
+ * Все состояние блуждания хранится в членах класса, поэтому генерацию можно остановить между
+ * шагами, сохранить в GenerationCheckpoint и продолжить с того же места с тем же результатом */
+class UniformTreeGenerator
+{
+public:
+    enum Algorithm {AldousBroder, Wilson};
+
+    // Как часто (в шагах блуждания) вызывается обработчик прогресса
+    static const std::uint64_t PROGRESS_INTERVAL_STEPS {1 << 16};
+
+    // Вызывается между шагами; false останавливает генерацию в точке, из которой её можно продолжить
+    using ProgressHandler = std::function<bool(const UniformTreeGenerator &generator, const PackedMazeGrid &grid)>;
+
+private:
+    enum CellState : std::uint8_t {DirectionMask = 0x03, InTree = 0x04};
+    enum Phase {AldousBroderWalk, WilsonSeek, WilsonWalk, WilsonCarve, Finished};
+
+    std::size_t width_ {};
+    std::size_t height_ {};
+    std::uint64_t seed_ {};
+    MazeRandom random_;
+
+    int algorithm_ {};
+    int phase_ {Phase::Finished};
+    std::size_t x_ {};
+    std::size_t y_ {};
+    std::size_t visitedCells_ {};
+    std::size_t cellsToVisit_ {};
+    std::size_t wilsonStartCell_ {};
+
+    ProgressHandler progressHandler_;
+    VisitHeatmap *visitHeatmap_ {nullptr};
+    std::uint64_t stepsUntilProgress_ {PROGRESS_INTERVAL_STEPS};
+
+    // Младшие два бита - направление последнего выхода из клетки при блуждании Уилсона
+    std::vector<std::uint8_t> cellStates_;
+    std::uint64_t directionBits_ {};
+    unsigned int directionBitsLeft_ {};
+
+    int chooseRandomDirection(std::size_t x, std::size_t y);
+    void moveToNeighbor(std::size_t &x, std::size_t &y, int direction) const;
+
+    bool reportProgress(const PackedMazeGrid &grid);
+    bool run(PackedMazeGrid &grid);
+    bool runAldousBroder(PackedMazeGrid &grid);
+    bool runWilson(PackedMazeGrid &grid);
+
+public:
+    explicit UniformTreeGenerator(std::size_t width, std::size_t height, std::uint64_t seed) noexcept;
+    ~UniformTreeGenerator() {};
+
+    void setProgressHandler(const ProgressHandler &progressHandler);
+    /* Карта заходов блуждания; generate задает ей размер сетки и обнуляет. В контрольную точку
+     * карта не входит, после resume она продолжает считать с того, что в ней есть. nullptr выключает */
+    void setVisitHeatmap(VisitHeatmap *visitHeatmap);
+
+    // false, если генерацию остановил обработчик прогресса
+    bool generate(int algorithm, PackedMazeGrid &grid);
+
+    void saveCheckpoint(const PackedMazeGrid &grid, GenerationCheckpoint &checkpoint) const;
+    /* Генератор должен быть создан с размером и seed из контрольной точки. false, если алгоритм,
+     * фаза или состояния клеток в точке недопустимы или размер не совпадает; генератор не меняется */
+    bool restoreCheckpoint(const GenerationCheckpoint &checkpoint, PackedMazeGrid &grid);
+    bool resume(PackedMazeGrid &grid);
+};
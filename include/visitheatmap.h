@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/* Счетчики заходов случайного блуждания в каждую клетку: 16 бит на клетку в отдельном от сетки
+ * массиве, при переполнении счетчик останавливается на максимуме. По ним видно, где блуждание
+ * Олдоса-Бродера и Уилсона тратит время. Генераторы пишут в карту, только если её им передали,
+ * поэтому без карты стоимость - одна предсказуемая проверка указателя на шаг */
+class VisitHeatmap
+{
+private:
+    std::size_t width_ {};
+    std::size_t height_ {};
+    std::vector<std::uint16_t> visitCounts_;
+
+public:
+    static const std::uint16_t MAX_VISIT_COUNT {0xFFFF};
+
+    VisitHeatmap() noexcept {};
+    ~VisitHeatmap() {};
+
+    // Меняет размер и обнуляет счетчики
+    void resize(std::size_t width, std::size_t height);
+    void clear();
+
+    // Вызывается на каждом шаге блуждания, поэтому определена прямо здесь
+    void recordVisit(std::size_t x, std::size_t y)
+    {
+        std::uint16_t &visitCount = visitCounts_[y * width_ + x];
+        visitCount += visitCount != MAX_VISIT_COUNT;
+    }
+
+    std::size_t getWidth() const;
+    std::size_t getHeight() const;
+    std::uint16_t getVisitCount(std::size_t x, std::size_t y) const;
+    std::uint16_t getMaxVisitCount() const;
+
+    // Цвет ARGB в логарифмической шкале от прозрачного (нет заходов) через синий к красному
+    static std::uint32_t getHeatColor(std::uint16_t visitCount, std::uint16_t maxVisitCount);
+    // Счетчики построчно через запятую
+    bool writeCsv(const std::string &filePath) const;
+};
@@ -0,0 +1,126 @@
+#include "algorithmrace.h"
+#include "mazegenerator.h"
+#include "tracezones.h"
+
+#include <chrono>
+#include <functional>
+
+AlgorithmRace::AlgorithmRace(const std::vector<int> &algorithms, std::size_t width, std::size_t height,
+                             std::uint64_t seed)
+    : width_(width),
+      height_(height),
+      seed_(seed)
+{
+    for (int algorithm : algorithms)
+    {
+        std::unique_ptr<Lane> lane(new Lane);
+        lane->algorithm = algorithm;
+        lane->grid.resize(width_, height_);
+        lanes_.push_back(std::move(lane));
+    }
+}
+
+/*------------------------------------------------------------------------------------------------*/
+AlgorithmRace::~AlgorithmRace()
+{
+    stop();
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void AlgorithmRace::start()
+{
+    for (std::unique_ptr<Lane> &lane : lanes_)
+        lane->thread = std::thread(&AlgorithmRace::runLane, this, std::ref(*lane));
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void AlgorithmRace::stop()
+{
+    isStopRequested_ = true;
+    wait();
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void AlgorithmRace::wait()
+{
+    for (std::unique_ptr<Lane> &lane : lanes_)
+    {
+        if (lane->thread.joinable())
+            lane->thread.join();
+    }
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::size_t AlgorithmRace::getLaneCount() const
+{
+    return lanes_.size();
+}
+
+/*------------------------------------------------------------------------------------------------*/
+AlgorithmRace::LaneStatus AlgorithmRace::getLaneStatus(std::size_t lane) const
+{
+    const Lane &current = *lanes_[lane];
+    // isFinished читается первым: после него счетчики уже окончательные
+    const bool isLaneFinished = current.isFinished.load(std::memory_order_acquire);
+    return LaneStatus {current.algorithm, current.steps.load(std::memory_order_relaxed),
+                       current.elapsedNs.load(std::memory_order_relaxed), isLaneFinished};
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool AlgorithmRace::isFinished() const
+{
+    for (const std::unique_ptr<Lane> &lane : lanes_)
+    {
+        if (!lane->isFinished.load(std::memory_order_acquire))
+            return false;
+    }
+    return true;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void AlgorithmRace::copyLaneGrid(std::size_t lane, PackedMazeGrid &grid) const
+{
+    std::lock_guard<std::mutex> lock(lanes_[lane]->gridMutex);
+    grid = lanes_[lane]->grid;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void AlgorithmRace::runLane(Lane &lane)
+{
+    MAZE_TRACE_THREAD_NAME("AlgorithmRace lane");
+    MAZE_TRACE_ZONE_ARG("AlgorithmRace::runLane", "algorithm", lane.algorithm);
+    const auto startTime = std::chrono::steady_clock::now();
+    const auto getElapsedNs = [&startTime]() {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                              std::chrono::steady_clock::now() - startTime).count());
+    };
+
+    if (!MazeStepGenerator::isSupported(lane.algorithm))
+    {
+        PackedMazeGrid grid;
+        MazeGenerator::generate(GenerationParameters(lane.algorithm, width_, height_, seed_), grid);
+        {
+            std::lock_guard<std::mutex> lock(lane.gridMutex);
+            lane.grid.swap(grid);
+        }
+        lane.steps.store(width_ * height_, std::memory_order_relaxed);
+        lane.elapsedNs.store(getElapsedNs(), std::memory_order_relaxed);
+        lane.isFinished.store(true, std::memory_order_release);
+        return;
+    }
+
+    MazeStepGenerator generator(lane.algorithm, width_, height_, seed_);
+    std::size_t batchSteps {STEPS_PER_BATCH};
+    while (batchSteps == STEPS_PER_BATCH && !isStopRequested_.load(std::memory_order_relaxed))
+    {
+        {
+            std::lock_guard<std::mutex> lock(lane.gridMutex);
+            batchSteps = generator.advance(STEPS_PER_BATCH, [&lane](const MazeStepGenerator::Step &step) {
+                MazeStepGenerator::applyStep(step, lane.grid);
+            });
+        }
+        lane.steps.fetch_add(batchSteps, std::memory_order_relaxed);
+        lane.elapsedNs.store(getElapsedNs(), std::memory_order_relaxed);
+    }
+    lane.isFinished.store(generator.isFinished(), std::memory_order_release);
+}
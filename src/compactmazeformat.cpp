@@ -0,0 +1,91 @@
+#include "compactmazeformat.h"
+
+#include <cstring>
+#include <istream>
+#include <ostream>
+
+const char CompactMazeFormat::MAGIC[4] {'A', 'M', 'Z', 'G'};
+
+namespace
+{
+void putUint(unsigned char *destination, std::uint64_t value, std::size_t byteCount)
+{
+    for (std::size_t byte = 0; byte < byteCount; ++byte)
+        destination[byte] = static_cast<unsigned char>(value >> (byte * 8));
+}
+
+std::uint64_t getUint(const unsigned char *source, std::size_t byteCount)
+{
+    std::uint64_t value {0};
+    for (std::size_t byte = 0; byte < byteCount; ++byte)
+        value |= std::uint64_t(source[byte]) << (byte * 8);
+    return value;
+}
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::size_t CompactMazeFormat::getEncodedSize(const PackedMazeGrid &grid)
+{
+    return HEADER_SIZE + 2 * grid.getWordsPerRow() * grid.getHeight() * sizeof(std::uint64_t);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void CompactMazeFormat::write(std::ostream &stream, const GenerationParameters &parameters, const PackedMazeGrid &grid)
+{
+    unsigned char header[HEADER_SIZE] {};
+    std::memcpy(header, MAGIC, sizeof(MAGIC));
+    putUint(header + 4, VERSION, 4);
+    putUint(header + 8, static_cast<std::uint32_t>(parameters.algorithm), 4);
+    putUint(header + 12, grid.getWidth(), 8);
+    putUint(header + 20, grid.getHeight(), 8);
+    putUint(header + 28, parameters.seed, 8);
+    putUint(header + 36, grid.computeChecksum(), 8);
+    stream.write(reinterpret_cast<const char*>(header), HEADER_SIZE);
+
+    const std::streamsize planeBytes = grid.getWordsPerRow() * grid.getHeight() * sizeof(std::uint64_t);
+    if (planeBytes == 0)
+        return;
+    stream.write(reinterpret_cast<const char*>(grid.getRightRow(0)), planeBytes);
+    stream.write(reinterpret_cast<const char*>(grid.getBotRow(0)), planeBytes);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool CompactMazeFormat::read(std::istream &stream, GenerationParameters &parameters, PackedMazeGrid &grid)
+{
+    unsigned char header[HEADER_SIZE] {};
+    if (!stream.read(reinterpret_cast<char*>(header), HEADER_SIZE) ||
+            std::memcmp(header, MAGIC, sizeof(MAGIC)) != 0 || getUint(header + 4, 4) != VERSION)
+        return false;
+
+    const std::uint64_t width = getUint(header + 12, 8);
+    const std::uint64_t height = getUint(header + 20, 8);
+    // Защита от мусора в заголовке: не выделяем память под заведомо невозможную сетку
+    if (width > (std::uint64_t(1) << 32) || height > (std::uint64_t(1) << 32))
+        return false;
+    // Плоскости должны уместиться в остаток файла, иначе запись испорчена и память не нужна
+    const std::streampos dataStart = stream.tellg();
+    stream.seekg(0, std::ios::end);
+    const std::streampos streamEnd = stream.tellg();
+    stream.seekg(dataStart);
+    if (!stream || dataStart == std::streampos(-1) || streamEnd < dataStart)
+        return false;
+    const std::uint64_t wordsPerRow = (width + PackedMazeGrid::BITS_PER_WORD - 1) / PackedMazeGrid::BITS_PER_WORD;
+    const std::uint64_t remainingWords = static_cast<std::uint64_t>(streamEnd - dataStart) / sizeof(std::uint64_t);
+    if (wordsPerRow != 0 && height > remainingWords / 2 / wordsPerRow)
+        return false;
+
+    parameters.algorithm = static_cast<int>(getUint(header + 8, 4));
+    parameters.width = static_cast<std::size_t>(width);
+    parameters.height = static_cast<std::size_t>(height);
+    parameters.seed = getUint(header + 28, 8);
+
+    // Плоскости читаются прямо в память сетки, без промежуточного буфера
+    grid.resize(parameters.width, parameters.height);
+    const std::streamsize planeBytes = grid.getWordsPerRow() * grid.getHeight() * sizeof(std::uint64_t);
+    if (planeBytes != 0 &&
+            (!stream.read(reinterpret_cast<char*>(grid.getRightRow(0)), planeBytes) ||
+             !stream.read(reinterpret_cast<char*>(grid.getBotRow(0)), planeBytes)))
+        return false;
+
+    return grid.computeChecksum() == getUint(header + 36, 8);
+}
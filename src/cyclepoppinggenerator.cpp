@@ -0,0 +1,348 @@
+#include "cyclepoppinggenerator.h"
+#include "tracezones.h"
+
+#include <algorithm>
+#include <thread>
+
+const unsigned int CyclePoppingGenerator::MAX_THREAD_COUNT;
+const std::uint64_t CyclePoppingGenerator::MAX_CELL_COUNT;
+
+/*------------------------------------------------------------------------------------------------*/
+static std::uint64_t mixBits(std::uint64_t value)
+{
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+    return value ^ (value >> 31);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+CyclePoppingGenerator::CyclePoppingGenerator(std::size_t width, std::size_t height, std::uint64_t seed,
+                                             unsigned int threadCount) noexcept
+    : width_(width),
+      height_(height),
+      seed_(seed),
+      threadCount_(threadCount)
+{
+    if (threadCount_ == 0)
+        threadCount_ = std::thread::hardware_concurrency();
+    if (threadCount_ == 0)
+        threadCount_ = 1;
+    threadCount_ = std::min(threadCount_, MAX_THREAD_COUNT);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool CyclePoppingGenerator::isSupported(std::size_t width, std::size_t height)
+{
+    // Проверка по отдельности защищает от переполнения произведения
+    return width == 0 || height <= MAX_CELL_COUNT / width;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool CyclePoppingGenerator::generate(PackedMazeGrid &grid)
+{
+    if (!isSupported(width_, height_))
+        return false;
+    const std::size_t cellCount = width_ * height_;
+    grid.resize(width_, height_);
+    if (cellCount == 0)
+        return true;
+
+    stackDepths_.assign(cellCount, 0);
+    cellClaims_.reset(new std::atomic<SegmentId>[cellCount]);
+    for (std::size_t cell = 0; cell < cellCount; ++cell)
+        cellClaims_[cell].store(UNCLAIMED, std::memory_order_relaxed);
+
+    seedKey_ = mixBits(seed_);
+    rootCell_ = static_cast<CellIndex>(seedKey_ % cellCount);
+    lastRowStart_ = static_cast<CellIndex>(cellCount - width_);
+    cellClaims_[rootCell_].store(ROOTED, std::memory_order_relaxed);
+
+    workers_.assign(threadCount_, Worker());
+    for (unsigned int workerIndex = 0; workerIndex < threadCount_; ++workerIndex)
+    {
+        Worker &worker = workers_[workerIndex];
+        const std::size_t firstCell = cellCount * workerIndex / threadCount_;
+        const std::size_t lastCell = cellCount * (workerIndex + 1) / threadCount_;
+        for (std::size_t cell = firstCell; cell < lastCell; ++cell)
+        {
+            if (cell != rootCell_)
+                worker.activeCells.push_back(static_cast<CellIndex>(cell));
+        }
+    }
+
+    for (;;)
+    {
+        std::atomic<std::size_t> activeCells {0};
+        runOnWorkers([&](unsigned int workerIndex) { activeCells += walkActiveCells(workerIndex); });
+        if (activeCells == 0)
+            break;
+
+        resolveSegments();
+        runOnWorkers([&](unsigned int workerIndex) { applyRound(workerIndex); });
+    }
+
+    runOnWorkers([&](unsigned int workerIndex) { carvePassages(workerIndex, grid); });
+
+    workers_.clear();
+    cellClaims_.reset();
+    std::vector<std::uint32_t>().swap(stackDepths_);
+    return true;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::size_t CyclePoppingGenerator::walkActiveCells(unsigned int workerIndex)
+{
+    MAZE_TRACE_ZONE("CyclePoppingGenerator::walkActiveCells");
+    Worker &worker = workers_[workerIndex];
+    worker.pathCells.clear();
+    worker.segments.clear();
+
+    std::size_t keptCells {0};
+    for (CellIndex startCell : worker.activeCells)
+    {
+        if (cellClaims_[startCell].load(std::memory_order_acquire) == ROOTED)
+            continue;
+        worker.activeCells[keptCells++] = startCell;
+        walkFromCell(workerIndex, startCell);
+    }
+    worker.activeCells.resize(keptCells);
+
+    return keptCells;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void CyclePoppingGenerator::walkFromCell(unsigned int workerIndex, CellIndex startCell)
+{
+    Worker &worker = workers_[workerIndex];
+    const std::size_t pathBegin = worker.pathCells.size();
+    const SegmentId segmentId = makeSegmentId(workerIndex, worker.segments.size());
+
+    CellIndex cell = startCell;
+    for (;;)
+    {
+        SegmentId expected = UNCLAIMED;
+        if (cellClaims_[cell].compare_exchange_strong(expected, segmentId, std::memory_order_acq_rel))
+        {
+            worker.pathCells.push_back(cell);
+            cell = arrowTarget(cell);
+            continue;
+        }
+
+        if (expected == segmentId)
+        {
+            /* Путь замкнулся сам на себя: выталкиваем цикл (хвост пути начиная с cell) и идем
+             * дальше по новой стрелке cell. Все клетки цикла наши, их стрелки никто не читает */
+            CellIndex cycleCell {};
+            do
+            {
+                cycleCell = worker.pathCells.back();
+                worker.pathCells.pop_back();
+                ++stackDepths_[cycleCell];
+                cellClaims_[cycleCell].store(UNCLAIMED, std::memory_order_release);
+            }
+            while (cycleCell != cell);
+            continue;
+        }
+
+        if (expected == ROOTED)
+        {
+            for (std::size_t i = pathBegin; i < worker.pathCells.size(); ++i)
+                cellClaims_[worker.pathCells[i]].store(ROOTED, std::memory_order_release);
+            worker.pathCells.resize(pathBegin);
+            return;
+        }
+
+        // Уперлись в чужой путь (или стартовую клетку перехватили) - судьбу решим после раунда
+        if (worker.pathCells.size() != pathBegin)
+        {
+            Segment segment;
+            segment.pathBegin = pathBegin;
+            segment.pathEnd = worker.pathCells.size();
+            segment.stopCell = cell;
+            worker.segments.push_back(segment);
+        }
+        return;
+    }
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void CyclePoppingGenerator::resolveSegments()
+{
+    MAZE_TRACE_ZONE("CyclePoppingGenerator::resolveSegments");
+    /* Сегмент ведет туда же, куда клетка, в которую он уперся: в корень, в другой сегмент или в
+     * освобожденную после выталкивания цикла клетку (тогда до корня он в этом раунде не дошел).
+     * Если цепочка сегментов замкнулась, стрелки их клеток образуют цикл через stopCell
+     * последнего сегмента цепочки */
+    std::vector<SegmentId> chain;
+    for (unsigned int workerIndex = 0; workerIndex < threadCount_; ++workerIndex)
+    {
+        for (std::size_t segmentIndex = 0; segmentIndex < workers_[workerIndex].segments.size(); ++segmentIndex)
+        {
+            SegmentId segmentId = makeSegmentId(workerIndex, segmentIndex);
+            bool isRooted {false};
+            chain.clear();
+
+            for (;;)
+            {
+                Segment &segment = segmentById(segmentId);
+                if (segment.resolveState == ResolveState::Resolved)
+                {
+                    isRooted = segment.isRooted;
+                    break;
+                }
+                if (segment.resolveState == ResolveState::Resolving)
+                {
+                    popCycle(segmentById(chain.back()).stopCell);
+                    break;
+                }
+
+                segment.resolveState = ResolveState::Resolving;
+                chain.push_back(segmentId);
+
+                const SegmentId nextSegmentId = cellClaims_[segment.stopCell].load(std::memory_order_relaxed);
+                if (nextSegmentId == ROOTED || nextSegmentId == UNCLAIMED)
+                {
+                    isRooted = nextSegmentId == ROOTED;
+                    break;
+                }
+                segmentId = nextSegmentId;
+            }
+
+            for (SegmentId chainSegmentId : chain)
+            {
+                Segment &segment = segmentById(chainSegmentId);
+                segment.isRooted = isRooted;
+                segment.resolveState = ResolveState::Resolved;
+            }
+        }
+    }
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void CyclePoppingGenerator::applyRound(unsigned int workerIndex)
+{
+    MAZE_TRACE_ZONE("CyclePoppingGenerator::applyRound");
+    Worker &worker = workers_[workerIndex];
+    for (const Segment &segment : worker.segments)
+    {
+        const SegmentId claim = segment.isRooted ? ROOTED : UNCLAIMED;
+        for (std::size_t i = segment.pathBegin; i < segment.pathEnd; ++i)
+            cellClaims_[worker.pathCells[i]].store(claim, std::memory_order_release);
+    }
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void CyclePoppingGenerator::popCycle(CellIndex cycleCell)
+{
+    // Сначала собираем цикл целиком: после выталкивания стрелки клеток уже смотрят в другую сторону
+    std::vector<CellIndex> cycleCells;
+    CellIndex cell = cycleCell;
+    do
+    {
+        cycleCells.push_back(cell);
+        cell = arrowTarget(cell);
+    }
+    while (cell != cycleCell);
+
+    for (CellIndex cycleCellToPop : cycleCells)
+        ++stackDepths_[cycleCellToPop];
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void CyclePoppingGenerator::carvePassages(unsigned int workerIndex, PackedMazeGrid &grid) const
+{
+    MAZE_TRACE_ZONE("CyclePoppingGenerator::carvePassages");
+    /* Каждый поток пишет только в свои строки: проход вправо/вниз открыт, если туда смотрит
+     * стрелка клетки или обратная стрелка соседа */
+    const std::size_t firstRow = height_ * workerIndex / threadCount_;
+    const std::size_t lastRow = height_ * (workerIndex + 1) / threadCount_;
+
+    for (std::size_t y = firstRow; y < lastRow; ++y)
+    {
+        for (std::size_t x = 0; x < width_; ++x)
+        {
+            const CellIndex cell = static_cast<CellIndex>(y * width_ + x);
+            const int direction = arrowDirection(cell);
+
+            if (x + 1 < width_ && (direction == PackedMazeGrid::Direction::Right ||
+                                   arrowDirection(cell + 1) == PackedMazeGrid::Direction::Left))
+                grid.setPassage(x, y, PackedMazeGrid::Direction::Right, true);
+
+            if (y + 1 < height_ && (direction == PackedMazeGrid::Direction::Bot ||
+                                    arrowDirection(static_cast<CellIndex>(cell + width_)) == PackedMazeGrid::Direction::Top))
+                grid.setPassage(x, y, PackedMazeGrid::Direction::Bot, true);
+        }
+    }
+}
+
+/*------------------------------------------------------------------------------------------------*/
+int CyclePoppingGenerator::arrowDirection(CellIndex cell) const
+{
+    if (cell == rootCell_)
+        return -1;
+
+    const CellIndex width = static_cast<CellIndex>(width_);
+    const bool canGoTop = cell >= width;
+    const bool canGoBot = cell < lastRowStart_;
+    const CellIndex x = cell % width;
+    const std::uint64_t stackEntry = (static_cast<std::uint64_t>(cell) << 32) | stackDepths_[cell];
+
+    // Два бита на попытку, недопустимые у края направления перевыбираются
+    std::uint64_t bits = mixBits(stackEntry ^ seedKey_);
+    for (std::uint64_t attempt = 1; ; ++attempt)
+    {
+        for (unsigned int chunk = 0; chunk < 32; ++chunk, bits >>= 2)
+        {
+            const int direction = bits & 0x03;
+            if ((direction == PackedMazeGrid::Direction::Top && canGoTop) ||
+                    (direction == PackedMazeGrid::Direction::Right && x + 1 < width) ||
+                    (direction == PackedMazeGrid::Direction::Bot && canGoBot) ||
+                    (direction == PackedMazeGrid::Direction::Left && x > 0))
+                return direction;
+        }
+        bits = mixBits((stackEntry ^ seedKey_) + attempt);
+    }
+}
+
+/*------------------------------------------------------------------------------------------------*/
+CyclePoppingGenerator::CellIndex CyclePoppingGenerator::arrowTarget(CellIndex cell) const
+{
+    switch (arrowDirection(cell))
+    {
+    case PackedMazeGrid::Direction::Top :
+        return static_cast<CellIndex>(cell - width_);
+    case PackedMazeGrid::Direction::Right :
+        return cell + 1;
+    case PackedMazeGrid::Direction::Bot :
+        return static_cast<CellIndex>(cell + width_);
+    case PackedMazeGrid::Direction::Left :
+        return cell - 1;
+    }
+    return cell;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+CyclePoppingGenerator::SegmentId CyclePoppingGenerator::makeSegmentId(unsigned int workerIndex,
+                                                                      std::size_t segmentIndex) const
+{
+    return static_cast<SegmentId>(segmentIndex * threadCount_ + workerIndex + 1);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+CyclePoppingGenerator::Segment& CyclePoppingGenerator::segmentById(SegmentId segmentId)
+{
+    return workers_[(segmentId - 1) % threadCount_].segments[(segmentId - 1) / threadCount_];
+}
+
+/*------------------------------------------------------------------------------------------------*/
+template <typename Function>
+void CyclePoppingGenerator::runOnWorkers(Function function)
+{
+    std::vector<std::thread> threads;
+    for (unsigned int workerIndex = 1; workerIndex < threadCount_; ++workerIndex)
+        threads.emplace_back(function, workerIndex);
+    function(0);
+
+    for (auto &thread : threads)
+        thread.join();
+}
@@ -0,0 +1,106 @@
+#include "frametelemetry.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace
+{
+double getPercentileMs(std::vector<std::uint64_t> &valuesNs, double share)
+{
+    if (valuesNs.empty())
+        return 0.0;
+    const std::size_t index = std::min(valuesNs.size() - 1, static_cast<std::size_t>(share * valuesNs.size()));
+    std::nth_element(valuesNs.begin(), valuesNs.begin() + index, valuesNs.end());
+    return valuesNs[index] / 1e6;
+}
+}
+
+FrameTelemetry::FrameTelemetry(std::size_t capacity)
+    : frames_(std::max<std::size_t>(capacity, 2))
+{
+}
+
+/*------------------------------------------------------------------------------------------------*/
+const FrameTelemetry::Frame& FrameTelemetry::getFrame(std::size_t index) const
+{
+    const std::size_t oldestFrame = (nextFrame_ + frames_.size() - frameCount_) % frames_.size();
+    return frames_[(oldestFrame + index) % frames_.size()];
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void FrameTelemetry::addFrame(const Frame &frame)
+{
+    frames_[nextFrame_] = frame;
+    nextFrame_ = (nextFrame_ + 1) % frames_.size();
+    frameCount_ = std::min(frameCount_ + 1, frames_.size());
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void FrameTelemetry::clear()
+{
+    nextFrame_ = 0;
+    frameCount_ = 0;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::size_t FrameTelemetry::getFrameCount() const
+{
+    return frameCount_;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+FrameTelemetry::Summary FrameTelemetry::getSummary(std::uint64_t windowNs) const
+{
+    Summary summary {0, 0.0, 0.0, 0.0, 0.0, 0.0};
+    if (frameCount_ == 0)
+        return summary;
+
+    const std::uint64_t lastTimestampNs = getFrame(frameCount_ - 1).timestampNs;
+    std::size_t firstFrame = frameCount_ - 1;
+    while (firstFrame > 0 && lastTimestampNs - getFrame(firstFrame - 1).timestampNs <= windowNs)
+        --firstFrame;
+
+    std::vector<std::uint64_t> frameTimesNs;
+    std::vector<std::uint64_t> paintTimesNs;
+    std::uint64_t appliedSteps {0};
+    for (std::size_t frame = firstFrame; frame < frameCount_; ++frame)
+    {
+        paintTimesNs.push_back(getFrame(frame).paintNs);
+        // Шаги первого кадра окна сделаны до его начала
+        if (frame == firstFrame)
+            continue;
+        frameTimesNs.push_back(getFrame(frame).timestampNs - getFrame(frame - 1).timestampNs);
+        appliedSteps += getFrame(frame).appliedSteps;
+    }
+
+    summary.frameCount = frameCount_ - firstFrame;
+    const std::uint64_t spanNs = lastTimestampNs - getFrame(firstFrame).timestampNs;
+    if (spanNs > 0)
+    {
+        summary.framesPerSecond = frameTimesNs.size() * 1e9 / spanNs;
+        summary.stepsPerSecond = appliedSteps * 1e9 / spanNs;
+    }
+    summary.p50FrameMs = getPercentileMs(frameTimesNs, 0.5);
+    summary.p99FrameMs = getPercentileMs(frameTimesNs, 0.99);
+    summary.p99PaintMs = getPercentileMs(paintTimesNs, 0.99);
+    return summary;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool FrameTelemetry::writeCsv(const std::string &filePath) const
+{
+    std::FILE *file = std::fopen(filePath.c_str(), "w");
+    if (!file)
+        return false;
+
+    std::fputs("frame,timestamp_ms,frame_time_ms,paint_ms,scene_update_ms,steps\n", file);
+    for (std::size_t frame = 0; frame < frameCount_; ++frame)
+    {
+        const Frame &current = getFrame(frame);
+        const std::uint64_t frameTimeNs = frame > 0 ? current.timestampNs - getFrame(frame - 1).timestampNs : 0;
+        std::fprintf(file, "%llu,%.3f,%.3f,%.3f,%.3f,%llu\n", static_cast<unsigned long long>(frame),
+                     current.timestampNs / 1e6, frameTimeNs / 1e6, current.paintNs / 1e6,
+                     current.sceneUpdateNs / 1e6, static_cast<unsigned long long>(current.appliedSteps));
+    }
+    return std::fclose(file) == 0;
+}
@@ -0,0 +1,275 @@
+#include "generationcheckpoint.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define CHECKPOINT_FSYNC_SUPPORTED
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+const char CHECKPOINT_MAGIC[4] {'A', 'M', 'Z', 'C'};
+const std::uint32_t CHECKPOINT_VERSION {2};
+// Поля заголовка после magic; последнее - контрольная сумма всех предыдущих
+const std::size_t FIELD_COUNT {20};
+
+void writeUint(std::ostream &stream, std::uint64_t value)
+{
+    unsigned char bytes[8];
+    for (std::size_t byte = 0; byte < sizeof(bytes); ++byte)
+        bytes[byte] = static_cast<unsigned char>(value >> (byte * 8));
+    stream.write(reinterpret_cast<const char*>(bytes), sizeof(bytes));
+}
+
+bool readUint(std::istream &stream, std::uint64_t &value)
+{
+    unsigned char bytes[8];
+    if (!stream.read(reinterpret_cast<char*>(bytes), sizeof(bytes)))
+        return false;
+    value = 0;
+    for (std::size_t byte = 0; byte < sizeof(bytes); ++byte)
+        value |= std::uint64_t(bytes[byte]) << (byte * 8);
+    return true;
+}
+
+std::uint64_t computeCellStatesChecksum(const std::vector<std::uint8_t> &cellStates)
+{
+    std::uint64_t checksum {0xCBF29CE484222325};
+    for (std::uint8_t state : cellStates)
+        checksum = (checksum ^ state) * 0x100000001B3;
+    return checksum;
+}
+
+std::uint64_t computeFieldsChecksum(const std::uint64_t *fields, std::size_t fieldCount)
+{
+    std::uint64_t checksum {0xCBF29CE484222325};
+    for (std::size_t field = 0; field < fieldCount; ++field)
+        checksum = (checksum ^ fields[field]) * 0x100000001B3;
+    return checksum;
+}
+
+// Сбрасывает на диск файл или папку; у fstream нет дескриптора, и fsync через любой дескриптор подходит
+bool syncPath(const std::string &path)
+{
+#ifdef CHECKPOINT_FSYNC_SUPPORTED
+    const int descriptor = ::open(path.c_str(), O_RDONLY);
+    if (descriptor < 0)
+        return false;
+    const bool isSynced = fsync(descriptor) == 0;
+    ::close(descriptor);
+    return isSynced;
+#else
+    (void)path;
+    return true;
+#endif
+}
+
+std::string getDirectoryPath(const std::string &filePath)
+{
+    const std::size_t separator = filePath.find_last_of('/');
+    if (separator == std::string::npos)
+        return ".";
+    return separator == 0 ? "/" : filePath.substr(0, separator);
+}
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool GenerationCheckpoint::writeToFile(const std::string &filePath) const
+{
+    const std::string temporaryPath = filePath + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        file.write(CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+        std::uint64_t fields[FIELD_COUNT] {CHECKPOINT_VERSION, static_cast<std::uint64_t>(algorithm), seed,
+                                           randomState[0], randomState[1], randomState[2], randomState[3],
+                                           directionBits, directionBitsLeft,
+                                           static_cast<std::uint64_t>(phase), x, y, visitedCells, cellsToVisit,
+                                           wilsonStartCell, grid.getWidth(), grid.getHeight(),
+                                           computeCellStatesChecksum(cellStates), grid.computeChecksum()};
+        fields[FIELD_COUNT - 1] = computeFieldsChecksum(fields, FIELD_COUNT - 1);
+        for (std::uint64_t field : fields)
+            writeUint(file, field);
+
+        const std::streamsize planeBytes = grid.getSizeBytes() / 2;
+        file.write(reinterpret_cast<const char*>(cellStates.data()), cellStates.size());
+        if (planeBytes != 0)
+        {
+            file.write(reinterpret_cast<const char*>(grid.getRightRow(0)), planeBytes);
+            file.write(reinterpret_cast<const char*>(grid.getBotRow(0)), planeBytes);
+        }
+        if (!file.flush())
+            return false;
+    }
+    // Данные должны дойти до диска раньше переименования, иначе после сбоя питания файл может оказаться пустым
+    if (!syncPath(temporaryPath))
+        return false;
+#ifdef CHECKPOINT_FSYNC_SUPPORTED
+    // rename атомарно заменяет старую точку: в любой момент на диске одна из двух целых точек
+    if (std::rename(temporaryPath.c_str(), filePath.c_str()) != 0)
+        return false;
+    // Новая запись в папке тоже должна пережить сбой
+    return syncPath(getDirectoryPath(filePath));
+#else
+    // На Windows rename не заменяет существующий файл
+    std::remove(filePath.c_str());
+    return std::rename(temporaryPath.c_str(), filePath.c_str()) == 0;
+#endif
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool GenerationCheckpoint::readFromFile(const std::string &filePath)
+{
+    std::ifstream file(filePath, std::ios::binary);
+    char magic[sizeof(CHECKPOINT_MAGIC)] {};
+    if (!file.read(magic, sizeof(magic)) || std::memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic)) != 0)
+        return false;
+
+    std::uint64_t fields[FIELD_COUNT] {};
+    for (std::uint64_t &field : fields)
+    {
+        if (!readUint(file, field))
+            return false;
+    }
+    const std::uint64_t width = fields[15];
+    const std::uint64_t height = fields[16];
+    if (fields[0] != CHECKPOINT_VERSION || fields[FIELD_COUNT - 1] != computeFieldsChecksum(fields, FIELD_COUNT - 1) ||
+            width > (std::uint64_t(1) << 32) || height > (std::uint64_t(1) << 32))
+        return false;
+
+    /* Размер сетки сверяется с остатком файла до выделения памяти: байт состояния на клетку и две
+     * плоскости стен по целым словам на строку */
+    const std::streamoff dataStart = file.tellg();
+    file.seekg(0, std::ios::end);
+    const std::streamoff fileEnd = file.tellg();
+    file.seekg(dataStart);
+    if (!file || fileEnd < dataStart)
+        return false;
+    const std::uint64_t dataSize = static_cast<std::uint64_t>(fileEnd - dataStart);
+    if (width != 0 && height > dataSize / width)
+        return false;
+    const std::uint64_t cellCount = width * height;
+    const std::uint64_t planeSize = height * ((width + PackedMazeGrid::BITS_PER_WORD - 1) / PackedMazeGrid::BITS_PER_WORD) *
+            sizeof(std::uint64_t);
+    if (dataSize != cellCount + 2 * planeSize)
+        return false;
+
+    // Позиция блуждания и счетчики должны лежать внутри сетки, иначе генератор выйдет за массивы
+    const bool hasCells = cellCount != 0;
+    if (fields[8] > 32 || (hasCells && (fields[10] >= width || fields[11] >= height)) ||
+            fields[12] > cellCount || fields[13] > cellCount || fields[14] > cellCount)
+        return false;
+
+    algorithm = static_cast<int>(fields[1]);
+    seed = fields[2];
+    randomState = MazeRandom::State {{fields[3], fields[4], fields[5], fields[6]}};
+    directionBits = fields[7];
+    directionBitsLeft = static_cast<std::uint32_t>(fields[8]);
+    phase = static_cast<int>(fields[9]);
+    x = fields[10];
+    y = fields[11];
+    visitedCells = fields[12];
+    cellsToVisit = fields[13];
+    wilsonStartCell = fields[14];
+
+    cellStates.resize(static_cast<std::size_t>(width * height));
+    grid.resize(static_cast<std::size_t>(width), static_cast<std::size_t>(height));
+    const std::streamsize planeBytes = grid.getSizeBytes() / 2;
+    if (!file.read(reinterpret_cast<char*>(cellStates.data()), cellStates.size()))
+        return false;
+    if (planeBytes != 0 &&
+            (!file.read(reinterpret_cast<char*>(grid.getRightRow(0)), planeBytes) ||
+             !file.read(reinterpret_cast<char*>(grid.getBotRow(0)), planeBytes)))
+        return false;
+
+    return computeCellStatesChecksum(cellStates) == fields[17] && grid.computeChecksum() == fields[18];
+}
+
+/*------------------------------------------------------------------------------------------------*/
+CheckpointWriter::CheckpointWriter(const std::string &filePath)
+    : filePath_(filePath),
+      writerThread_(&CheckpointWriter::runWriter, this)
+{
+}
+
+/*------------------------------------------------------------------------------------------------*/
+CheckpointWriter::~CheckpointWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        isStopping_ = true;
+    }
+    condition_.notify_all();
+    writerThread_.join();
+}
+
+/*------------------------------------------------------------------------------------------------*/
+GenerationCheckpoint& CheckpointWriter::acquireBuffer()
+{
+    // Ожидающий, но еще не начатый буфер можно перезаписать: в нем более старое состояние
+    std::lock_guard<std::mutex> lock(mutex_);
+    fillingBuffer_ = writingBuffer_ == 0 ? 1 : 0;
+    if (pendingBuffer_ == fillingBuffer_)
+        pendingBuffer_ = -1;
+    return buffers_[fillingBuffer_];
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void CheckpointWriter::submit()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pendingBuffer_ = fillingBuffer_;
+        fillingBuffer_ = -1;
+    }
+    condition_.notify_all();
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void CheckpointWriter::flush()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    condition_.wait(lock, [this] { return pendingBuffer_ < 0 && writingBuffer_ < 0; });
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::uint64_t CheckpointWriter::getWrittenCount()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return writtenCount_;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool CheckpointWriter::hasWriteFailed()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return hasWriteFailed_;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void CheckpointWriter::runWriter()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;)
+    {
+        condition_.wait(lock, [this] { return pendingBuffer_ >= 0 || isStopping_; });
+        if (pendingBuffer_ < 0)
+            return;
+
+        writingBuffer_ = pendingBuffer_;
+        pendingBuffer_ = -1;
+        lock.unlock();
+        const bool isWritten = buffers_[writingBuffer_].writeToFile(filePath_);
+        lock.lock();
+
+        writingBuffer_ = -1;
+        if (isWritten)
+            ++writtenCount_;
+        else
+            hasWriteFailed_ = true;
+        condition_.notify_all();
+    }
+}
@@ -6,6 +6,9 @@ AlgorithmGeneratorMenu::AlgorithmGeneratorMenu(QWidget *parent) noexcept
     algorithmAldousBroderRadio_ = new QRadioButton("Aldous Broder");
     algorithmRecursiveBacktrackerRadio_ = new QRadioButton("Recursive Backtracker");
     algorithmWilsonRadio_ = new QRadioButton("Wilson");
+    algorithmBinaryTreeRadio_ = new QRadioButton("Binary Tree");
+    algorithmSidewinderRadio_ = new QRadioButton("Sidewinder");
+    algorithmCyclePoppingRadio_ = new QRadioButton("Cycle Popping");
     startGenerationButton_ = new StartStopPushButton();
     test_ = new QPushButton("test");
 
@@ -18,6 +21,12 @@ AlgorithmGeneratorMenu::AlgorithmGeneratorMenu(QWidget *parent) noexcept
             this, &AlgorithmGeneratorMenu::slotRecursiveBacktrackerRadio);
     connect(algorithmWilsonRadio_, &QRadioButton::toggled,
             this, &AlgorithmGeneratorMenu::slotWilsonRadio);
+    connect(algorithmBinaryTreeRadio_, &QRadioButton::toggled,
+            this, &AlgorithmGeneratorMenu::slotBinaryTreeRadio);
+    connect(algorithmSidewinderRadio_, &QRadioButton::toggled,
+            this, &AlgorithmGeneratorMenu::slotSidewinderRadio);
+    connect(algorithmCyclePoppingRadio_, &QRadioButton::toggled,
+            this, &AlgorithmGeneratorMenu::slotCyclePoppingRadio);
     connect(startGenerationButton_, &QPushButton::clicked,
             this, &AlgorithmGeneratorMenu::slotStartGenerationButton);
     connect(test_, &QPushButton::clicked, this ,&AlgorithmGeneratorMenu::loadMaze);
@@ -31,6 +40,9 @@ void AlgorithmGeneratorMenu::initializeMenu()
     //addRadioButton(algorithmAldousBroderRadio_);
     addRadioButton(algorithmRecursiveBacktrackerRadio_);
     //addRadioButton(algorithmWilsonRadio_);
+    addRadioButton(algorithmBinaryTreeRadio_);
+    addRadioButton(algorithmSidewinderRadio_);
+    addRadioButton(algorithmCyclePoppingRadio_);
 
     addPushButton(startGenerationButton_);
     addPushButton(test_);
@@ -58,6 +70,27 @@ void AlgorithmGeneratorMenu::slotWilsonRadio()
     emit algorithmReadyToGenerate();
 }
 
+/*------------------------------------------------------------------------------------------------*/
+void AlgorithmGeneratorMenu::slotBinaryTreeRadio()
+{
+    whichAlgorithmWasChosen_ = AlgorithmGeneratorMenu::Algorithm::BinaryTree;
+    emit algorithmReadyToGenerate();
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void AlgorithmGeneratorMenu::slotSidewinderRadio()
+{
+    whichAlgorithmWasChosen_ = AlgorithmGeneratorMenu::Algorithm::Sidewinder;
+    emit algorithmReadyToGenerate();
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void AlgorithmGeneratorMenu::slotCyclePoppingRadio()
+{
+    whichAlgorithmWasChosen_ = AlgorithmGeneratorMenu::Algorithm::CyclePopping;
+    emit algorithmReadyToGenerate();
+}
+
 /*------------------------------------------------------------------------------------------------*/
 void AlgorithmGeneratorMenu::activateGenerateButton()
 {
@@ -98,6 +131,9 @@ void AlgorithmGeneratorMenu::setDisabledButtons(bool makeButtonsDisabled)
     algorithmAldousBroderRadio_->setDisabled(makeButtonsDisabled);
     algorithmRecursiveBacktrackerRadio_->setDisabled(makeButtonsDisabled);
     algorithmWilsonRadio_->setDisabled(makeButtonsDisabled);
+    algorithmBinaryTreeRadio_->setDisabled(makeButtonsDisabled);
+    algorithmSidewinderRadio_->setDisabled(makeButtonsDisabled);
+    algorithmCyclePoppingRadio_->setDisabled(makeButtonsDisabled);
 
     if (makeButtonsDisabled == false)
         startGenerationButton_->makeStateStart();
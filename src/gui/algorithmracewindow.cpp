@@ -0,0 +1,176 @@
+#include "gui/algorithmracewindow.h"
+#include "mazegenerator.h"
+#include "tracezones.h"
+
+#include <QPixmap>
+
+#include <climits>
+#include <cstdint>
+
+AlgorithmRaceWindow::AlgorithmRaceWindow(QWidget *parent) noexcept
+    : QWidget(parent, Qt::Window)
+{
+    for (int algorithm = 0; algorithm < MazeGenerator::Algorithm::Count; ++algorithm)
+    {
+        if (MazeGenerator::isSupported(algorithm))
+            algorithms_.push_back(algorithm);
+    }
+    initializeWindow();
+
+    connect(startStopButton_, &QPushButton::clicked, this, &AlgorithmRaceWindow::startOrStopRace);
+    connect(refreshTimer_, &QTimer::timeout, this, &AlgorithmRaceWindow::refreshLanes);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void AlgorithmRaceWindow::initializeWindow()
+{
+    setWindowTitle("Гонка алгоритмов");
+
+    mazeSizeSpinBox_ = new QSpinBox;
+    mazeSizeSpinBox_->setRange(MIN_MAZE_SIZE, MAX_MAZE_SIZE);
+    mazeSizeSpinBox_->setValue(DEFAULT_MAZE_SIZE);
+    mazeSizeSpinBox_->setPrefix("Размер: ");
+    seedSpinBox_ = new QSpinBox;
+    seedSpinBox_->setRange(0, INT_MAX);
+    seedSpinBox_->setPrefix("Seed: ");
+    startStopButton_ = new QPushButton("Старт");
+
+    controlsLayout_ = new QHBoxLayout;
+    controlsLayout_->addWidget(mazeSizeSpinBox_);
+    controlsLayout_->addWidget(seedSpinBox_);
+    controlsLayout_->addWidget(startStopButton_);
+
+    lanesLayout_ = new QHBoxLayout;
+    for (int algorithm : algorithms_)
+    {
+        LaneWidgets lane {new QLabel(getAlgorithmName(algorithm)), new QLabel, new QLabel};
+        lane.imageLabel->setFixedSize(LANE_IMAGE_SIZE, LANE_IMAGE_SIZE);
+        lane.statisticsLabel->setMinimumWidth(LANE_IMAGE_SIZE);
+
+        QVBoxLayout *laneLayout = new QVBoxLayout;
+        laneLayout->addWidget(lane.titleLabel);
+        laneLayout->addWidget(lane.imageLabel);
+        laneLayout->addWidget(lane.statisticsLabel);
+        lanesLayout_->addLayout(laneLayout);
+        laneWidgets_.push_back(lane);
+    }
+
+    windowLayout_ = new QVBoxLayout(this);
+    windowLayout_->addLayout(controlsLayout_);
+    windowLayout_->addLayout(lanesLayout_);
+    setLayout(windowLayout_);
+
+    refreshTimer_ = new QTimer(this);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void AlgorithmRaceWindow::startOrStopRace()
+{
+    if (refreshTimer_->isActive())
+    {
+        stopRace();
+        return;
+    }
+
+    const std::size_t mazeSize = static_cast<std::size_t>(mazeSizeSpinBox_->value());
+    race_.reset(new AlgorithmRace(algorithms_, mazeSize, mazeSize, static_cast<std::uint64_t>(seedSpinBox_->value())));
+    drawnSteps_.assign(algorithms_.size(), UINT64_MAX);
+    race_->start();
+    refreshTimer_->start(REFRESH_MS);
+    startStopButton_->setText("Стоп");
+    refreshLanes();
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void AlgorithmRaceWindow::stopRace()
+{
+    if (!race_)
+        return;
+    race_->stop();
+    refreshLanes();
+    refreshTimer_->stop();
+    startStopButton_->setText("Старт");
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void AlgorithmRaceWindow::refreshLanes()
+{
+    MAZE_TRACE_ZONE("AlgorithmRaceWindow::refreshLanes");
+    PackedMazeGrid grid;
+    for (std::size_t lane = 0; lane < race_->getLaneCount(); ++lane)
+    {
+        const AlgorithmRace::LaneStatus status = race_->getLaneStatus(lane);
+        const double elapsedMs = status.elapsedNs / 1e6;
+        const double stepsPerSecond = status.elapsedNs > 0 ? status.steps * 1e9 / status.elapsedNs : 0.0;
+        laneWidgets_[lane].statisticsLabel->setText(
+                    QString("%1%2 мс\n%3 шагов/с").arg(status.isFinished ? "Готово: " : "")
+                    .arg(elapsedMs, 0, 'f', 1).arg(stepsPerSecond, 0, 'f', 0));
+
+        // Перерисовка сетки дорогая, поэтому только если с прошлого раза были шаги
+        if (status.steps == drawnSteps_[lane])
+            continue;
+        drawnSteps_[lane] = status.steps;
+        race_->copyLaneGrid(lane, grid);
+        laneWidgets_[lane].imageLabel->setPixmap(QPixmap::fromImage(makeMazeImage(grid).scaled(
+                                                     LANE_IMAGE_SIZE, LANE_IMAGE_SIZE, Qt::IgnoreAspectRatio,
+                                                     Qt::FastTransformation)));
+    }
+
+    if (race_->isFinished())
+    {
+        refreshTimer_->stop();
+        startStopButton_->setText("Старт");
+    }
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void AlgorithmRaceWindow::closeEvent(QCloseEvent *event)
+{
+    stopRace();
+    QWidget::closeEvent(event);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+QString AlgorithmRaceWindow::getAlgorithmName(int algorithm)
+{
+    switch (algorithm)
+    {
+    case MazeGenerator::Algorithm::AldousBroder :
+        return "Aldous Broder";
+    case MazeGenerator::Algorithm::RecursiveBacktracker :
+        return "Recursive Backtracker";
+    case MazeGenerator::Algorithm::Wilson :
+        return "Wilson";
+    case MazeGenerator::Algorithm::BinaryTree :
+        return "Binary Tree";
+    case MazeGenerator::Algorithm::Sidewinder :
+        return "Sidewinder";
+    case MazeGenerator::Algorithm::CyclePopping :
+        return "Cycle Popping";
+    }
+    return QString();
+}
+
+/*------------------------------------------------------------------------------------------------*/
+QImage AlgorithmRaceWindow::makeMazeImage(const PackedMazeGrid &grid)
+{
+    // Клетка и каждая стена - по пикселю: клетка (x, y) лежит в (2x + 1, 2y + 1)
+    const int width = static_cast<int>(grid.getWidth());
+    const int height = static_cast<int>(grid.getHeight());
+    QImage image(2 * width + 1, 2 * height + 1, QImage::Format_Grayscale8);
+    image.fill(0);
+    for (int y = 0; y < height; ++y)
+    {
+        uchar *cellLine = image.scanLine(2 * y + 1);
+        uchar *botLine = image.scanLine(2 * y + 2);
+        for (int x = 0; x < width; ++x)
+        {
+            cellLine[2 * x + 1] = 0xFF;
+            if (grid.hasPassage(x, y, PackedMazeGrid::Direction::Right))
+                cellLine[2 * x + 2] = 0xFF;
+            if (grid.hasPassage(x, y, PackedMazeGrid::Direction::Bot))
+                botLine[2 * x + 1] = 0xFF;
+        }
+    }
+    return image;
+}
@@ -0,0 +1,147 @@
+#include "gui/infinitemazeview.h"
+#include "tracezones.h"
+
+#include <algorithm>
+
+namespace
+{
+// Деление с округлением вниз: окно может стоять и в отрицательных координатах
+std::int64_t divideDown(std::int64_t value, std::int64_t divisor)
+{
+    return value >= 0 ? value / divisor : -((-value - 1) / divisor) - 1;
+}
+}
+
+const int InfiniteMazeView::CELL_SIZE_PX;
+const int InfiniteMazeView::KEY_SCROLL_CELLS;
+const std::size_t InfiniteMazeView::CHUNK_SIZE;
+const std::size_t InfiniteMazeView::CACHE_MARGIN_CHUNKS;
+
+InfiniteMazeView::InfiniteMazeView(std::uint64_t seed, int algorithm, QWidget *parent)
+    : QWidget(parent),
+      cache_(InfiniteMaze(seed, algorithm, CHUNK_SIZE), computeCacheCapacity(size()))
+{
+    setFocusPolicy(Qt::StrongFocus);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::size_t InfiniteMazeView::computeCacheCapacity(const QSize &viewSize)
+{
+    // Край окна редко совпадает с краем блока, поэтому видно на блок больше, чем помещается целиком
+    const std::size_t chunkSizePx = CHUNK_SIZE * CELL_SIZE_PX;
+    const std::size_t columns = (static_cast<std::size_t>(std::max(viewSize.width(), 1)) + chunkSizePx - 1) /
+            chunkSizePx + 1;
+    const std::size_t rows = (static_cast<std::size_t>(std::max(viewSize.height(), 1)) + chunkSizePx - 1) /
+            chunkSizePx + 1;
+    return (columns + 2 * CACHE_MARGIN_CHUNKS) * (rows + 2 * CACHE_MARGIN_CHUNKS);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+const InfiniteMazeCache& InfiniteMazeView::getCache() const
+{
+    return cache_;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void InfiniteMazeView::scrollBy(std::int64_t dx, std::int64_t dy)
+{
+    originX_ += dx;
+    originY_ += dy;
+    update();
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void InfiniteMazeView::paintEvent(QPaintEvent *)
+{
+    MAZE_TRACE_ZONE("InfiniteMazeView::paintEvent");
+    const std::int64_t firstCellX = divideDown(originX_, CELL_SIZE_PX);
+    const std::int64_t firstCellY = divideDown(originY_, CELL_SIZE_PX);
+    const std::int64_t lastCellX = divideDown(originX_ + width() - 1, CELL_SIZE_PX);
+    const std::int64_t lastCellY = divideDown(originY_ + height() - 1, CELL_SIZE_PX);
+
+    // Недостающие видимые блоки строятся разом и параллельно, дальше все берется из кэша
+    const InfiniteMaze &maze = cache_.getMaze();
+    cache_.prefetch(maze.getChunkCoordinate(firstCellX), maze.getChunkCoordinate(firstCellY),
+                    maze.getChunkCoordinate(lastCellX), maze.getChunkCoordinate(lastCellY));
+
+    // Каждая клетка рисует свои верхнюю и левую стены, правые и нижние - у соседей
+    QPainter painter(this);
+    painter.fillRect(rect(), BACKGROUND_COLOR);
+    painter.setPen(QPen(WALL_COLOR));
+    for (std::int64_t y = firstCellY; y <= lastCellY; ++y)
+    {
+        const int top = static_cast<int>(y * CELL_SIZE_PX - originY_);
+        for (std::int64_t x = firstCellX; x <= lastCellX; ++x)
+        {
+            const int left = static_cast<int>(x * CELL_SIZE_PX - originX_);
+            if (!cache_.hasPassage(x, y, PackedMazeGrid::Direction::Top))
+                painter.drawLine(left, top, left + CELL_SIZE_PX, top);
+            if (!cache_.hasPassage(x, y, PackedMazeGrid::Direction::Left))
+                painter.drawLine(left, top, left, top + CELL_SIZE_PX);
+        }
+    }
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void InfiniteMazeView::resizeEvent(QResizeEvent *event)
+{
+    // 1920 x 1080 видит до 13 x 8 = 104 блоков; с запасом кэш держит 17 x 12
+    cache_.setCapacity(computeCacheCapacity(event->size()));
+    QWidget::resizeEvent(event);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void InfiniteMazeView::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() != Qt::LeftButton)
+    {
+        QWidget::mousePressEvent(event);
+        return;
+    }
+    isDragging_ = true;
+    dragPosition_ = event->pos();
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void InfiniteMazeView::mouseMoveEvent(QMouseEvent *event)
+{
+    if (!isDragging_)
+    {
+        QWidget::mouseMoveEvent(event);
+        return;
+    }
+    // Лабиринт едет за курсором, то есть окно сдвигается в обратную сторону
+    scrollBy(dragPosition_.x() - event->pos().x(), dragPosition_.y() - event->pos().y());
+    dragPosition_ = event->pos();
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void InfiniteMazeView::mouseReleaseEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton)
+        isDragging_ = false;
+    QWidget::mouseReleaseEvent(event);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void InfiniteMazeView::keyPressEvent(QKeyEvent *event)
+{
+    const std::int64_t step = KEY_SCROLL_CELLS * CELL_SIZE_PX;
+    switch (event->key())
+    {
+    case Qt::Key_Left :
+        scrollBy(-step, 0);
+        break;
+    case Qt::Key_Right :
+        scrollBy(step, 0);
+        break;
+    case Qt::Key_Up :
+        scrollBy(0, -step);
+        break;
+    case Qt::Key_Down :
+        scrollBy(0, step);
+        break;
+    default :
+        QWidget::keyPressEvent(event);
+    }
+}
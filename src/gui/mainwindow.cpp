@@ -23,6 +23,7 @@ MainWindow::MainWindow(QWidget *parent) noexcept
 
     connect(algorithmGeneratorWidget_, &AlgorithmGeneratorMenu::interruptGeneration,
             mazeGrid_, &MazeArea::interruptGenerationHandling);
+    connect(algorithmRaceButton_, &QPushButton::clicked, this, &MainWindow::showAlgorithmRace);
   /*  connect(saveButton, &QPushButton::clicked, this, [this]() {
         maze.saveToFile("path/to/save/file");
     });
@@ -45,6 +46,7 @@ void MainWindow::initializeMazeSettingsMenu()
 {
     fieldSizeWidget_ = new FieldSizeMenu(this);
     algorithmGeneratorWidget_ = new AlgorithmGeneratorMenu(this);
+    algorithmRaceButton_ = new QPushButton("Algorithm Race", this);
 
     sidebarLayout_ = new QVBoxLayout;
     sidebarLayout_->setSpacing(5);
@@ -52,6 +54,7 @@ void MainWindow::initializeMazeSettingsMenu()
 
     sidebarLayout_->addWidget(fieldSizeWidget_);
     sidebarLayout_->addWidget(algorithmGeneratorWidget_);
+    sidebarLayout_->addWidget(algorithmRaceButton_);
 }
 
 
@@ -93,3 +96,19 @@ void MainWindow::setDisabledAllButtons()
         fieldSizeWidget_->setDisabledButtons(true);
     }
 }
+
+/*------------------------------------------------------------------------------------------------*/
+void MainWindow::showAlgorithmRace()
+{
+    // Гонка идет в своих потоках и не мешает генерации в основном окне
+    if (!algorithmRaceWindow_)
+        algorithmRaceWindow_ = new AlgorithmRaceWindow(this);
+    algorithmRaceWindow_->show();
+    algorithmRaceWindow_->raise();
+}
+
+/*------------------------------------------------------------------------------------------------*/
+MazeArea* MainWindow::getMazeArea() const
+{
+    return mazeGrid_;
+}
@@ -1,4 +1,14 @@
 #include "gui/mazearea.h"
+#include "compactmazeformat.h"
+#include "mazevectorexporter.h"
+#include "tracezones.h"
+
+#include <QDebug>
+#include <QFileDialog>
+#include <QPainterPath>
+
+#include <algorithm>
+#include <fstream>
 
 MazeArea::MazeArea(QWidget *parent) noexcept
     : QWidget(parent)
@@ -6,15 +16,33 @@ MazeArea::MazeArea(QWidget *parent) noexcept
     initializeMenu();
 
     maze_ = new Maze(MAZE_AREA_SIZE);
+    maze_->enableMazePool(MAZE_POOL_SIZE_PER_KEY, MAZE_POOL_MAX_SIZE_BYTES);
     connect(maze_, &Maze::requestToDrawMazeGrid, this, &MazeArea::drawMazeGrid);
     connect(maze_, &Maze::mazeWasGenerated, this, &MazeArea::requestToEnableAllButtons);
+    connect(maze_, &Maze::mazeWasGenerated, this, [this]() {
+        regenerateRegionButton_->setEnabled(true);
+        exportVectorButton_->setEnabled(true);
+        isMazeReady_ = true;
+        showConnectivity(QString());
+        refreshSolution();
+    });
+
+    frameClock_.start();
+    mazeView_->setFrameHandler([this](qint64 paintNs) { recordFrame(paintNs); });
+    mazeView_->setWallEditHandler([this](QPointF scenePosition) { toggleWallAt(scenePosition); });
+}
+
+/*------------------------------------------------------------------------------------------------*/
+Maze* MazeArea::getMaze() const
+{
+    return maze_;
 }
 
 /*------------------------------------------------------------------------------------------------*/
 void MazeArea::initializeMenu()
 {
     mazeScene_ = new QGraphicsScene;
-    mazeView_ = new QGraphicsView;
+    mazeView_ = new MazeGraphicsView;
     mazeView_->setFixedSize(GRAPHIC_VIEW_SIZE, GRAPHIC_VIEW_SIZE);
     mazeView_->setScene(mazeScene_);
 
@@ -22,6 +50,61 @@ void MazeArea::initializeMenu()
     mazeAreaLayout_->setAlignment(Qt::AlignCenter);
     mazeAreaLayout_->addWidget(mazeView_);
 
+    connectivityLabel_ = new QLabel("Ctrl+щелчок по стене ломает или ставит её");
+    mazeAreaLayout_->addWidget(connectivityLabel_);
+
+    telemetryOverlayCheckBox_ = new QCheckBox("Телеметрия");
+    exportTelemetryButton_ = new QPushButton("Экспорт CSV");
+    telemetryLayout_ = new QHBoxLayout;
+    telemetryLayout_->addWidget(telemetryOverlayCheckBox_);
+    telemetryLayout_->addWidget(exportTelemetryButton_);
+    mazeAreaLayout_->addLayout(telemetryLayout_);
+
+    telemetryOverlayTimer_ = new QTimer(this);
+    connect(telemetryOverlayTimer_, &QTimer::timeout, this, &MazeArea::refreshTelemetryOverlay);
+    connect(telemetryOverlayCheckBox_, &QCheckBox::toggled, this, &MazeArea::setTelemetryOverlayVisible);
+    connect(exportTelemetryButton_, &QPushButton::clicked, this, &MazeArea::exportTelemetry);
+
+    heatmapCheckBox_ = new QCheckBox("Тепловая карта");
+    exportHeatmapButton_ = new QPushButton("Экспорт карты");
+    heatmapLayout_ = new QHBoxLayout;
+    heatmapLayout_->addWidget(heatmapCheckBox_);
+    heatmapLayout_->addWidget(exportHeatmapButton_);
+    mazeAreaLayout_->addLayout(heatmapLayout_);
+
+    heatmapRefreshTimer_ = new QTimer(this);
+    connect(heatmapRefreshTimer_, &QTimer::timeout, this, &MazeArea::refreshHeatmap);
+    connect(heatmapCheckBox_, &QCheckBox::toggled, this, &MazeArea::setHeatmapVisible);
+    connect(exportHeatmapButton_, &QPushButton::clicked, this, &MazeArea::exportHeatmap);
+
+    solutionCheckBox_ = new QCheckBox("Путь от входа до выхода");
+    mazeAreaLayout_->addWidget(solutionCheckBox_);
+    connect(solutionCheckBox_, &QCheckBox::toggled, this, &MazeArea::setSolutionVisible);
+
+    // Перестраивать можно только готовый лабиринт, поэтому кнопка включается по окончании генерации
+    regenerateRegionButton_ = new QPushButton("Перестроить область");
+    regenerateRegionButton_->setCheckable(true);
+    regenerateRegionButton_->setEnabled(false);
+    mazeAreaLayout_->addWidget(regenerateRegionButton_);
+
+    connect(regenerateRegionButton_, &QPushButton::toggled, this, &MazeArea::setRegionSelectionEnabled);
+    connect(mazeView_, &QGraphicsView::rubberBandChanged, this, &MazeArea::trackRegionSelection);
+
+    exportVectorButton_ = new QPushButton("Экспорт SVG/PDF");
+    exportVectorButton_->setEnabled(false);
+    mazeAreaLayout_->addWidget(exportVectorButton_);
+    connect(exportVectorButton_, &QPushButton::clicked, this, &MazeArea::exportVectorImage);
+
+    infiniteMazeButton_ = new QPushButton("Бесконечный лабиринт");
+    infiniteMazeButton_->setCheckable(true);
+    mazeAreaLayout_->addWidget(infiniteMazeButton_);
+    connect(infiniteMazeButton_, &QPushButton::toggled, this, &MazeArea::setInfiniteMazeVisible);
+
+    tileViewButton_ = new QPushButton("Большой лабиринт");
+    tileViewButton_->setCheckable(true);
+    mazeAreaLayout_->addWidget(tileViewButton_);
+    connect(tileViewButton_, &QPushButton::toggled, this, &MazeArea::setTileViewVisible);
+
     mazeAreaGroupBox_ = new QGroupBox(this);
     mazeAreaGroupBox_->setStyleSheet(MAZE_AREA_STYLE_SHEET);
     mazeAreaGroupBox_->setLayout(mazeAreaLayout_);
@@ -32,7 +115,18 @@ void MazeArea::initializeMenu()
 /*------------------------------------------------------------------------------------------------*/
 void MazeArea::drawMazeGrid(QVector<QVector<Cell>>& cellGrid)
 {
+    MAZE_TRACE_ZONE("MazeArea::drawMazeGrid");
+    // clear() удаляет все элементы сцены, в том числе слой тепловой карты
     mazeScene_->clear();
+    heatmapItem_ = new QGraphicsPixmapItem;
+    heatmapItem_->setZValue(HEATMAP_Z_VALUE);
+    heatmapItem_->setVisible(heatmapCheckBox_->isChecked());
+    mazeScene_->addItem(heatmapItem_);
+    solutionItem_ = new QGraphicsPathItem;
+    solutionItem_->setZValue(SOLUTION_Z_VALUE);
+    solutionItem_->setPen(QPen(SOLUTION_COLOR));
+    solutionItem_->setVisible(false);
+    mazeScene_->addItem(solutionItem_);
     for (auto row = cellGrid.begin(); row != cellGrid.end(); row++)
     {
         for (auto col = row->begin(); col != row->end(); col++)
@@ -58,6 +152,11 @@ void MazeArea::addCellOnScene(Cell& cell)
 /*------------------------------------------------------------------------------------------------*/
 void MazeArea::startGenerateMazeGrid(unsigned int mazeSize)
 {
+    regenerateRegionButton_->setChecked(false);
+    regenerateRegionButton_->setEnabled(false);
+    exportVectorButton_->setEnabled(false);
+    isMazeReady_ = false;
+    refreshSolution();
     maze_->generateMazeGrid(mazeSize);
 }
 
@@ -70,6 +169,11 @@ void MazeArea::startGenerationMaze(int whichAlgorithmWasChosen)
      * причине вызывал неотлавливаемый баг и сам метод был костыльным и некрасивым. Текущее
      * решение лучше и оно работает на 100%. */
 
+    regenerateRegionButton_->setChecked(false);
+    regenerateRegionButton_->setEnabled(false);
+    exportVectorButton_->setEnabled(false);
+    isMazeReady_ = false;
+    refreshSolution();
     maze_->resetGrid();
     maze_->generateMaze(whichAlgorithmWasChosen);
 }
@@ -79,3 +183,316 @@ void MazeArea::interruptGenerationHandling()
 {
     maze_->interruptReceived();
 }
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeArea::recordFrame(qint64 paintNs)
+{
+    quint64 appliedSteps {};
+    qint64 sceneUpdateNs {};
+    maze_->takeFrameWork(appliedSteps, sceneUpdateNs);
+    frameTelemetry_.addFrame(FrameTelemetry::Frame {static_cast<std::uint64_t>(frameClock_.nsecsElapsed()),
+                                                    static_cast<std::uint64_t>(paintNs),
+                                                    static_cast<std::uint64_t>(sceneUpdateNs), appliedSteps});
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeArea::setTelemetryOverlayVisible(bool isVisible)
+{
+    /* Панель обновляется по таймеру, а не после каждого кадра: иначе каждая перерисовка панели
+     * вызывала бы следующую. Сами обновления панели - тоже кадры, поэтому без генерации FPS
+     * показывает частоту обновления панели */
+    if (isVisible)
+    {
+        refreshTelemetryOverlay();
+        telemetryOverlayTimer_->start(TELEMETRY_OVERLAY_REFRESH_MS);
+    }
+    else
+    {
+        telemetryOverlayTimer_->stop();
+        mazeView_->setOverlayText(QString());
+    }
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeArea::refreshTelemetryOverlay()
+{
+    const FrameTelemetry::Summary summary = frameTelemetry_.getSummary(TELEMETRY_WINDOW_NS);
+    QString overlayText = QString("FPS: %1\n"
+                                  "Кадр p50/p99: %2 / %3 мс\n"
+                                  "Отрисовка p99: %4 мс\n"
+                                  "Шагов в секунду: %5")
+            .arg(summary.framesPerSecond, 0, 'f', 1)
+            .arg(summary.p50FrameMs, 0, 'f', 1)
+            .arg(summary.p99FrameMs, 0, 'f', 1)
+            .arg(summary.p99PaintMs, 0, 'f', 2)
+            .arg(summary.stepsPerSecond, 0, 'f', 0);
+
+    // Кэш и пул показываются, только когда к ним уже обращались
+    const MazeCache::Statistics cacheStatistics = maze_->getCacheStatistics();
+    if (cacheStatistics.hits + cacheStatistics.misses != 0)
+        overlayText += QString("\nКэш: попаданий %1, промахов %2, вытеснено %3, %4 МБ")
+                .arg(static_cast<qulonglong>(cacheStatistics.hits))
+                .arg(static_cast<qulonglong>(cacheStatistics.misses))
+                .arg(static_cast<qulonglong>(cacheStatistics.evictions))
+                .arg(cacheStatistics.sizeBytes / 1048576.0, 0, 'f', 1);
+    const MazePool::Statistics poolStatistics = maze_->getMazePoolStatistics();
+    if (poolStatistics.hits + poolStatistics.misses != 0)
+        overlayText += QString("\nПул: попаданий %1, промахов %2, готово %3")
+                .arg(static_cast<qulonglong>(poolStatistics.hits))
+                .arg(static_cast<qulonglong>(poolStatistics.misses))
+                .arg(static_cast<qulonglong>(poolStatistics.readyMazes));
+    mazeView_->setOverlayText(overlayText);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeArea::exportTelemetry()
+{
+    const QString filePath = QFileDialog::getSaveFileName(this, "Экспорт телеметрии", "frames.csv", "CSV (*.csv)");
+    if (!filePath.isEmpty() && !frameTelemetry_.writeCsv(filePath.toStdString()))
+        qWarning() << "Unable to write telemetry to" << filePath;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+QImage MazeArea::makeHeatmapImage() const
+{
+    const VisitHeatmap &visitHeatmap = maze_->getVisitHeatmap();
+    const int width = static_cast<int>(visitHeatmap.getWidth());
+    const int height = static_cast<int>(visitHeatmap.getHeight());
+    if (width == 0 || height == 0)
+        return QImage();
+
+    // Пиксель на клетку, дальше растягивается без сглаживания до размера клеток на сцене
+    QImage heatmapImage(width, height, QImage::Format_ARGB32);
+    const std::uint16_t maxVisitCount = visitHeatmap.getMaxVisitCount();
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+            heatmapImage.setPixel(x, y, VisitHeatmap::getHeatColor(visitHeatmap.getVisitCount(x, y), maxVisitCount));
+    }
+    const int cellSize = MAZE_AREA_SIZE / width;
+    return heatmapImage.scaled(width * cellSize, height * cellSize, Qt::IgnoreAspectRatio, Qt::FastTransformation);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeArea::setHeatmapVisible(bool isVisible)
+{
+    /* Счетчики ведутся только при включенной карте, а слой перерисовывается по таймеру, а не
+     * на каждом шаге, чтобы карта не замедляла анимацию */
+    maze_->setVisitHeatmapEnabled(isVisible);
+    if (heatmapItem_)
+        heatmapItem_->setVisible(isVisible);
+    if (isVisible)
+    {
+        refreshHeatmap();
+        heatmapRefreshTimer_->start(HEATMAP_REFRESH_MS);
+    }
+    else
+    {
+        heatmapRefreshTimer_->stop();
+    }
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeArea::refreshHeatmap()
+{
+    if (heatmapItem_)
+        heatmapItem_->setPixmap(QPixmap::fromImage(makeHeatmapImage()));
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeArea::exportHeatmap()
+{
+    const QString filePath = QFileDialog::getSaveFileName(this, "Экспорт тепловой карты", "heatmap.png",
+                                                          "PNG (*.png);;CSV (*.csv)");
+    if (filePath.isEmpty())
+        return;
+
+    // В CSV - сами счетчики для анализа, в PNG - то же изображение, что на сцене
+    const bool isWritten = filePath.endsWith(".csv", Qt::CaseInsensitive) ?
+                maze_->getVisitHeatmap().writeCsv(filePath.toStdString()) : makeHeatmapImage().save(filePath);
+    if (!isWritten)
+        qWarning() << "Unable to write heatmap to" << filePath;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeArea::setRegionSelectionEnabled(bool isEnabled)
+{
+    selectedRegion_ = QRectF();
+    mazeView_->setDragMode(isEnabled ? QGraphicsView::RubberBandDrag : QGraphicsView::NoDrag);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeArea::trackRegionSelection(QRect viewportRect, QPointF fromScenePoint, QPointF toScenePoint)
+{
+    if (!regenerateRegionButton_->isChecked())
+        return;
+    // Пока кнопка мыши нажата, рамка меняется; пустая рамка приходит, когда её отпустили
+    if (!viewportRect.isNull())
+    {
+        selectedRegion_ = QRectF(fromScenePoint, toScenePoint).normalized();
+        return;
+    }
+    if (selectedRegion_.isNull())
+        return;
+
+    // Клетка (x, y) занимает на сцене квадрат от x * cellSize, как в Cell
+    const int mazeSize = static_cast<int>(maze_->getPackedGrid().getWidth());
+    const int cellSize = mazeSize > 0 ? static_cast<int>(MAZE_AREA_SIZE) / mazeSize : 0;
+    if (cellSize > 0)
+    {
+        const int left = qBound(0, static_cast<int>(selectedRegion_.left()) / cellSize, mazeSize - 1);
+        const int top = qBound(0, static_cast<int>(selectedRegion_.top()) / cellSize, mazeSize - 1);
+        const int right = qBound(0, static_cast<int>(selectedRegion_.right()) / cellSize, mazeSize - 1);
+        const int bottom = qBound(0, static_cast<int>(selectedRegion_.bottom()) / cellSize, mazeSize - 1);
+        if (maze_->regenerateRegion(Coordinate(left, top), right - left + 1, bottom - top + 1))
+        {
+            showConnectivity(QString());
+            refreshSolution();
+        }
+    }
+    regenerateRegionButton_->setChecked(false);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeArea::toggleWallAt(QPointF scenePosition)
+{
+    const int mazeSize = static_cast<int>(maze_->getPackedGrid().getWidth());
+    const int cellSize = mazeSize > 0 ? static_cast<int>(MAZE_AREA_SIZE) / mazeSize : 0;
+    if (!isMazeReady_ || cellSize == 0)
+        return;
+    const qreal mazeX = scenePosition.x() / cellSize;
+    const qreal mazeY = scenePosition.y() / cellSize;
+    if (mazeX < 0 || mazeY < 0 || mazeX >= mazeSize || mazeY >= mazeSize)
+        return;
+
+    // Ближайшая к точке стена клетки, как в MazeTileView; стены на краю toggleWall не трогает
+    const int x = static_cast<int>(mazeX);
+    const int y = static_cast<int>(mazeY);
+    const qreal offsetX = mazeX - x;
+    const qreal offsetY = mazeY - y;
+    const qreal distances[PackedMazeGrid::Direction::Count] {offsetY, 1 - offsetX, 1 - offsetY, offsetX};
+    const int direction = static_cast<int>(std::min_element(distances, distances + PackedMazeGrid::Direction::Count) -
+                                           distances);
+    const MazeConnectivity::EditResult result = maze_->toggleWall(Coordinate(x, y), direction);
+    if (!result.isChanged)
+        return;
+    showConnectivity(result.isLoopCreated ? "проход создал цикл" :
+                     result.isDisconnected ? "стена отрезала часть лабиринта" : QString());
+    refreshSolution();
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeArea::showConnectivity(const QString &editText)
+{
+    MazeConnectivity &connectivity = maze_->getConnectivity();
+    QString text = QString("Частей: %1, циклов: %2").arg(connectivity.getComponentCount()).arg(connectivity.getLoopCount());
+    if (!editText.isEmpty())
+        text += ", " + editText;
+    connectivityLabel_->setText(text);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeArea::setSolutionVisible(bool isVisible)
+{
+    if (isVisible)
+        refreshSolution();
+    else if (solutionItem_)
+        solutionItem_->setVisible(false);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeArea::refreshSolution()
+{
+    if (!solutionItem_)
+        return;
+    const int mazeSize = static_cast<int>(maze_->getPackedGrid().getWidth());
+    const int cellSize = mazeSize > 0 ? static_cast<int>(MAZE_AREA_SIZE) / mazeSize : 0;
+    if (!isMazeReady_ || !solutionCheckBox_->isChecked() || cellSize == 0)
+    {
+        solutionItem_->setVisible(false);
+        return;
+    }
+
+    /* Граф развилок Maze перестраивает только после изменения сетки, поэтому повторный поиск
+     * обходит узлы, а не клетки. После правки, отрезавшей выход, пути нет и линия пустая */
+    const PackedMazeGrid &grid = maze_->getPackedGrid();
+    const std::vector<std::uint32_t> path = maze_->getJunctionGraph().findPath(0, grid.getCellCount() - 1);
+    QPainterPath solutionPath;
+    for (std::size_t index = 0; index < path.size(); ++index)
+    {
+        const QPointF center((path[index] % mazeSize + 0.5) * cellSize, (path[index] / mazeSize + 0.5) * cellSize);
+        if (index == 0)
+            solutionPath.moveTo(center);
+        else
+            solutionPath.lineTo(center);
+    }
+    solutionItem_->setPath(solutionPath);
+    solutionItem_->setVisible(true);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeArea::setInfiniteMazeVisible(bool isVisible)
+{
+    // Обычный лабиринт остается на сцене нетронутым и снова виден после выключения
+    if (isVisible)
+    {
+        tileViewButton_->setChecked(false);
+        infiniteMazeView_ = new InfiniteMazeView(QRandomGenerator::global()->generate64(),
+                                                 MazeGenerator::Algorithm::RecursiveBacktracker);
+        infiniteMazeView_->setFixedSize(GRAPHIC_VIEW_SIZE, GRAPHIC_VIEW_SIZE);
+        mazeAreaLayout_->insertWidget(0, infiniteMazeView_);
+        mazeView_->hide();
+        infiniteMazeView_->setFocus();
+    }
+    else if (infiniteMazeView_)
+    {
+        infiniteMazeView_->deleteLater();
+        infiniteMazeView_ = nullptr;
+        mazeView_->show();
+    }
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeArea::setTileViewVisible(bool isVisible)
+{
+    if (!isVisible)
+    {
+        if (tileView_)
+        {
+            tileView_->deleteLater();
+            tileView_ = nullptr;
+            mazeView_->show();
+        }
+        return;
+    }
+
+    // Лабиринт 50 000 x 50 000 на сцену из Cell не помещается, поэтому читается сразу в PackedMazeGrid
+    const QString filePath = QFileDialog::getOpenFileName(this, "Открыть лабиринт");
+    std::ifstream file(filePath.toStdString(), std::ios::binary);
+    GenerationParameters parameters;
+    PackedMazeGrid grid;
+    if (filePath.isEmpty() || !file || !CompactMazeFormat::read(file, parameters, grid))
+    {
+        if (!filePath.isEmpty())
+            qWarning() << "Unable to read maze from" << filePath;
+        tileViewButton_->setChecked(false);
+        return;
+    }
+
+    infiniteMazeButton_->setChecked(false);
+    tileView_ = new MazeTileView(std::move(grid));
+    tileView_->setFixedSize(GRAPHIC_VIEW_SIZE, GRAPHIC_VIEW_SIZE);
+    tileView_->fitMaze();
+    mazeAreaLayout_->insertWidget(0, tileView_);
+    mazeView_->hide();
+    tileView_->setFocus();
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeArea::exportVectorImage()
+{
+    const QString filePath = QFileDialog::getSaveFileName(this, "Экспорт лабиринта", "maze.svg",
+                                                          "SVG (*.svg);;PDF (*.pdf)");
+    if (!filePath.isEmpty() && !MazeVectorExporter::writeToFile(filePath.toStdString(), maze_->getPackedGrid()))
+        qWarning() << "Unable to write maze image to" << filePath;
+}
@@ -0,0 +1,66 @@
+#include "gui/mazegraphicsview.h"
+#include "tracezones.h"
+
+#include <QElapsedTimer>
+
+MazeGraphicsView::MazeGraphicsView(QWidget *parent) noexcept
+    : QGraphicsView(parent)
+{
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeGraphicsView::setFrameHandler(const FrameHandler &frameHandler)
+{
+    frameHandler_ = frameHandler;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeGraphicsView::setWallEditHandler(const WallEditHandler &wallEditHandler)
+{
+    wallEditHandler_ = wallEditHandler;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeGraphicsView::setOverlayText(const QString &overlayText)
+{
+    overlayText_ = overlayText;
+    viewport()->update(OVERLAY_RECT);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeGraphicsView::paintEvent(QPaintEvent *event)
+{
+    MAZE_TRACE_ZONE("MazeGraphicsView::paintEvent");
+    QElapsedTimer paintTimer;
+    paintTimer.start();
+    QGraphicsView::paintEvent(event);
+    if (frameHandler_)
+        frameHandler_(paintTimer.nsecsElapsed());
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeGraphicsView::mousePressEvent(QMouseEvent *event)
+{
+    if (wallEditHandler_ && event->button() == Qt::LeftButton && (event->modifiers() & Qt::ControlModifier))
+    {
+        wallEditHandler_(mapToScene(event->pos()));
+        return;
+    }
+    QGraphicsView::mousePressEvent(event);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeGraphicsView::drawForeground(QPainter *painter, const QRectF &rect)
+{
+    QGraphicsView::drawForeground(painter, rect);
+    if (overlayText_.isEmpty())
+        return;
+
+    // Панель рисуется в координатах окна, чтобы не зависеть от масштаба сцены
+    painter->save();
+    painter->resetTransform();
+    painter->fillRect(OVERLAY_RECT, OVERLAY_BACKGROUND_COLOR);
+    painter->setPen(QPen(Qt::white));
+    painter->drawText(OVERLAY_RECT.adjusted(5, 3, -5, -3), Qt::AlignLeft | Qt::AlignTop, overlayText_);
+    painter->restore();
+}
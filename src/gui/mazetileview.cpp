@@ -0,0 +1,240 @@
+#include "gui/mazetileview.h"
+#include "tracezones.h"
+
+#include <QImage>
+#include <QMetaObject>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+struct VisibleTile
+{
+    std::shared_ptr<const MazeTilePyramid::Tile> tile;
+    QRectF target;
+};
+}
+
+MazeTileView::MazeTileView(PackedMazeGrid &&grid, QWidget *parent)
+    : QWidget(parent),
+      pyramid_(std::move(grid), CACHE_CAPACITY_TILES)
+{
+    setFocusPolicy(Qt::StrongFocus);
+    // Обработчик зовется из рабочего потока пирамиды, перерисовка - уже в потоке окна
+    pyramid_.setReadyHandler([this]() { QMetaObject::invokeMethod(this, "update", Qt::QueuedConnection); });
+}
+
+/*------------------------------------------------------------------------------------------------*/
+const MazeTilePyramid& MazeTileView::getPyramid() const
+{
+    return pyramid_;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeTileView::fitMaze()
+{
+    const double mazeWidth = static_cast<double>(pyramid_.getGrid().getWidth() * MazeTilePyramid::FINEST_CELL_PIXELS);
+    const double mazeHeight = static_cast<double>(pyramid_.getGrid().getHeight() * MazeTilePyramid::FINEST_CELL_PIXELS);
+    scale_ = std::max(getMinScale(), std::min({MAX_SCALE, width() / mazeWidth, height() / mazeHeight}));
+    originX_ = (mazeWidth - width() / scale_) / 2;
+    originY_ = (mazeHeight - height() / scale_) / 2;
+    update();
+}
+
+/*------------------------------------------------------------------------------------------------*/
+double MazeTileView::getMinScale() const
+{
+    // Верхняя плитка занимает на экране не меньше половины своего размера
+    return 0.5 / static_cast<double>(std::uint64_t {1} << (pyramid_.getLevelCount() - 1));
+}
+
+/*------------------------------------------------------------------------------------------------*/
+unsigned int MazeTileView::getVisibleLevel() const
+{
+    // Пиксель уровня level - это 2^level пикселей уровня 0
+    unsigned int level = 0;
+    while (level + 1 < pyramid_.getLevelCount() && static_cast<double>(std::uint64_t {1} << level) * scale_ < 1.0)
+        ++level;
+    return level;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeTileView::scrollBy(double dx, double dy)
+{
+    originX_ += dx / scale_;
+    originY_ += dy / scale_;
+    update();
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeTileView::zoomAt(QPointF position, double factor)
+{
+    // Точка лабиринта под position остается на месте
+    const double newScale = std::max(getMinScale(), std::min(MAX_SCALE, scale_ * factor));
+    originX_ += position.x() / scale_ - position.x() / newScale;
+    originY_ += position.y() / scale_ - position.y() / newScale;
+    scale_ = newScale;
+    update();
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeTileView::toggleWallAt(QPointF position)
+{
+    const double cellPixels = MazeTilePyramid::FINEST_CELL_PIXELS;
+    if (cellPixels * scale_ < MIN_EDIT_CELL_PX)
+        return;
+    const double mazeX = (originX_ + position.x() / scale_) / cellPixels;
+    const double mazeY = (originY_ + position.y() / scale_) / cellPixels;
+    const PackedMazeGrid &grid = pyramid_.getGrid();
+    if (mazeX < 0 || mazeY < 0 || mazeX >= grid.getWidth() || mazeY >= grid.getHeight())
+        return;
+
+    // Ближайшая к точке стена клетки; внешнюю границу лабиринта не трогаем
+    const std::size_t x = static_cast<std::size_t>(mazeX);
+    const std::size_t y = static_cast<std::size_t>(mazeY);
+    const double offsetX = mazeX - x;
+    const double offsetY = mazeY - y;
+    const double distances[PackedMazeGrid::Direction::Count] {offsetY, 1 - offsetX, 1 - offsetY, offsetX};
+    const int direction = static_cast<int>(std::min_element(distances, distances + PackedMazeGrid::Direction::Count) -
+                                           distances);
+    const bool isBorder = (direction == PackedMazeGrid::Direction::Top && y == 0) ||
+                          (direction == PackedMazeGrid::Direction::Right && x + 1 == grid.getWidth()) ||
+                          (direction == PackedMazeGrid::Direction::Bot && y + 1 == grid.getHeight()) ||
+                          (direction == PackedMazeGrid::Direction::Left && x == 0);
+    if (isBorder)
+        return;
+    pyramid_.setPassage(x, y, direction, !grid.hasPassage(x, y, direction));
+    update();
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeTileView::paintEvent(QPaintEvent *)
+{
+    MAZE_TRACE_ZONE("MazeTileView::paintEvent");
+    // Плитки прошлого положения окна, которые еще не начали рисоваться, уже не нужны
+    pyramid_.cancelPending();
+
+    /* Видимые плитки запрашиваются от верхнего уровня к нужному, так они и рисуются. Уровень
+     * полный, если все его видимые плитки в кэше: более грубые под ним рисовать незачем */
+    const unsigned int visibleLevel = getVisibleLevel();
+    std::vector<VisibleTile> visibleTiles;
+    std::size_t firstPaintedTile = 0;
+    for (unsigned int level = pyramid_.getLevelCount(); level-- > visibleLevel;)
+    {
+        const double tileSize = static_cast<double>(std::uint64_t {MazeTilePyramid::TILE_SIZE} << level);
+        const double firstX = std::max(0.0, std::floor(originX_ / tileSize));
+        const double firstY = std::max(0.0, std::floor(originY_ / tileSize));
+        const double lastX = std::min<double>(pyramid_.getTileColumns(level) - 1,
+                                              std::floor((originX_ + width() / scale_) / tileSize));
+        const double lastY = std::min<double>(pyramid_.getTileRows(level) - 1,
+                                              std::floor((originY_ + height() / scale_) / tileSize));
+
+        const std::size_t levelBegin = visibleTiles.size();
+        bool isLevelComplete = true;
+        for (double tileY = firstY; tileY <= lastY; ++tileY)
+        {
+            for (double tileX = firstX; tileX <= lastX; ++tileX)
+            {
+                auto tile = pyramid_.requestTile(level, static_cast<std::uint32_t>(tileX),
+                                                 static_cast<std::uint32_t>(tileY));
+                if (!tile)
+                {
+                    isLevelComplete = false;
+                    continue;
+                }
+                const QRectF target((tileX * tileSize - originX_) * scale_, (tileY * tileSize - originY_) * scale_,
+                                    tileSize * scale_, tileSize * scale_);
+                visibleTiles.push_back(VisibleTile {std::move(tile), target});
+            }
+        }
+        if (isLevelComplete)
+            firstPaintedTile = levelBegin;
+    }
+
+    QPainter painter(this);
+    painter.fillRect(rect(), BACKGROUND_COLOR);
+    for (std::size_t i = firstPaintedTile; i < visibleTiles.size(); ++i)
+    {
+        // Изображение без копирования смотрит в пиксели плитки, которые держит visibleTiles
+        const std::vector<std::uint8_t> &pixels = visibleTiles[i].tile->pixels;
+        const QImage tileImage(pixels.data(), MazeTilePyramid::TILE_SIZE, MazeTilePyramid::TILE_SIZE,
+                               MazeTilePyramid::TILE_SIZE, QImage::Format_Grayscale8);
+        painter.drawImage(visibleTiles[i].target, tileImage);
+    }
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeTileView::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() != Qt::LeftButton)
+    {
+        QWidget::mousePressEvent(event);
+        return;
+    }
+    if (event->modifiers() & Qt::ControlModifier)
+    {
+        toggleWallAt(event->pos());
+        return;
+    }
+    isDragging_ = true;
+    dragPosition_ = event->pos();
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeTileView::mouseMoveEvent(QMouseEvent *event)
+{
+    if (!isDragging_)
+    {
+        QWidget::mouseMoveEvent(event);
+        return;
+    }
+    scrollBy(dragPosition_.x() - event->pos().x(), dragPosition_.y() - event->pos().y());
+    dragPosition_ = event->pos();
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeTileView::mouseReleaseEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton)
+        isDragging_ = false;
+    QWidget::mouseReleaseEvent(event);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeTileView::wheelEvent(QWheelEvent *event)
+{
+    // Один щелчок колеса - 120 единиц angleDelta
+    zoomAt(event->position(), std::pow(ZOOM_STEP, event->angleDelta().y() / 120.0));
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeTileView::keyPressEvent(QKeyEvent *event)
+{
+    const QPointF center(width() / 2.0, height() / 2.0);
+    switch (event->key())
+    {
+    case Qt::Key_Left :
+        scrollBy(-KEY_SCROLL_PX, 0);
+        break;
+    case Qt::Key_Right :
+        scrollBy(KEY_SCROLL_PX, 0);
+        break;
+    case Qt::Key_Up :
+        scrollBy(0, -KEY_SCROLL_PX);
+        break;
+    case Qt::Key_Down :
+        scrollBy(0, KEY_SCROLL_PX);
+        break;
+    case Qt::Key_Plus :
+    case Qt::Key_Equal :
+        zoomAt(center, ZOOM_STEP);
+        break;
+    case Qt::Key_Minus :
+        zoomAt(center, 1 / ZOOM_STEP);
+        break;
+    default :
+        QWidget::keyPressEvent(event);
+    }
+}
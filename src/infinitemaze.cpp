@@ -0,0 +1,247 @@
+#include "infinitemaze.h"
+#include "tracezones.h"
+
+#include <algorithm>
+#include <thread>
+
+InfiniteMaze::InfiniteMaze(std::uint64_t seed, int algorithm, std::size_t chunkSize) noexcept
+    : seed_(seed),
+      algorithm_(MazeGenerator::isSupported(algorithm) ? algorithm : MazeGenerator::Algorithm::RecursiveBacktracker),
+      chunkSize_(std::max<std::size_t>(1, chunkSize))
+{
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::uint64_t InfiniteMaze::hashChunk(std::int64_t chunkX, std::int64_t chunkY, std::uint64_t salt) const
+{
+    // То же перемешивание, что у ключей MazeCache: соседние координаты дают несвязанные значения
+    const std::uint64_t fields[] {seed_, static_cast<std::uint64_t>(chunkX), static_cast<std::uint64_t>(chunkY), salt};
+    std::uint64_t hash {0xCBF29CE484222325};
+    for (std::uint64_t field : fields)
+    {
+        hash = (hash ^ field) * 0xBF58476D1CE4E5B9;
+        hash ^= hash >> 31;
+    }
+    return hash;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool InfiniteMaze::isParentAbove(std::int64_t chunkX, std::int64_t chunkY) const
+{
+    return hashChunk(chunkX, chunkY, 1) >> 63;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::uint32_t InfiniteMaze::getParentOpening(std::int64_t chunkX, std::int64_t chunkY) const
+{
+    return static_cast<std::uint32_t>(hashChunk(chunkX, chunkY, 2) % chunkSize_);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::uint64_t InfiniteMaze::getSeed() const
+{
+    return seed_;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+int InfiniteMaze::getAlgorithm() const
+{
+    return algorithm_;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::size_t InfiniteMaze::getChunkSize() const
+{
+    return chunkSize_;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::int64_t InfiniteMaze::getChunkCoordinate(std::int64_t cellCoordinate) const
+{
+    const std::int64_t chunkSize = static_cast<std::int64_t>(chunkSize_);
+    return cellCoordinate >= 0 ? cellCoordinate / chunkSize : -((-cellCoordinate - 1) / chunkSize) - 1;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void InfiniteMaze::generateChunk(std::int64_t chunkX, std::int64_t chunkY, Chunk &chunk) const
+{
+    MAZE_TRACE_ZONE("InfiniteMaze::generateChunk");
+    chunk.chunkX = chunkX;
+    chunk.chunkY = chunkY;
+    MazeGenerator::generate(GenerationParameters(algorithm_, chunkSize_, chunkSize_, hashChunk(chunkX, chunkY, 0)),
+                            chunk.grid);
+
+    // Свой проход ведет к родителю, а через правую и нижнюю стороны - проходы соседей, выбравших этот блок
+    const bool isAbove = isParentAbove(chunkX, chunkY);
+    const std::uint32_t parentOpening = getParentOpening(chunkX, chunkY);
+    chunk.openings[PackedMazeGrid::Direction::Top] = isAbove ? parentOpening : NO_OPENING;
+    chunk.openings[PackedMazeGrid::Direction::Left] = isAbove ? NO_OPENING : parentOpening;
+    chunk.openings[PackedMazeGrid::Direction::Right] = isParentAbove(chunkX + 1, chunkY) ?
+                NO_OPENING : getParentOpening(chunkX + 1, chunkY);
+    chunk.openings[PackedMazeGrid::Direction::Bot] = isParentAbove(chunkX, chunkY + 1) ?
+                getParentOpening(chunkX, chunkY + 1) : NO_OPENING;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void InfiniteMaze::generateChunks(const std::vector<ChunkKey> &keys, std::vector<Chunk> &chunks,
+                                  unsigned int threadCount) const
+{
+    MAZE_TRACE_ZONE("InfiniteMaze::generateChunks");
+    chunks.resize(keys.size());
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    const std::size_t workerCount = std::max<std::size_t>(1, std::min<std::size_t>(threadCount, keys.size()));
+
+    // Блоки раздаются через один по номеру потока, поток 0 - вызывающий
+    const auto work = [this, &keys, &chunks, workerCount](std::size_t worker) {
+        for (std::size_t index = worker; index < keys.size(); index += workerCount)
+            generateChunk(keys[index].first, keys[index].second, chunks[index]);
+    };
+    std::vector<std::thread> threads;
+    for (std::size_t worker = 1; worker < workerCount; ++worker)
+        threads.emplace_back(work, worker);
+    work(0);
+    for (std::thread &thread : threads)
+        thread.join();
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::size_t InfiniteMazeCache::ChunkKeyHash::operator()(const InfiniteMaze::ChunkKey &key) const
+{
+    const std::uint64_t hash = (static_cast<std::uint64_t>(key.first) * 0x9E3779B97F4A7C15) ^
+            static_cast<std::uint64_t>(key.second);
+    return static_cast<std::size_t>(hash ^ (hash >> 29));
+}
+
+/*------------------------------------------------------------------------------------------------*/
+InfiniteMazeCache::InfiniteMazeCache(const InfiniteMaze &maze, std::size_t capacity)
+    : maze_(maze),
+      capacity_(std::max<std::size_t>(1, capacity))
+{
+}
+
+/*------------------------------------------------------------------------------------------------*/
+const InfiniteMaze& InfiniteMazeCache::getMaze() const
+{
+    return maze_;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::size_t InfiniteMazeCache::getChunkCount() const
+{
+    return entries_.size();
+}
+
+/*------------------------------------------------------------------------------------------------*/
+InfiniteMazeCache::Statistics InfiniteMazeCache::getStatistics() const
+{
+    return statistics_;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void InfiniteMazeCache::setCapacity(std::size_t capacity)
+{
+    capacity_ = std::max<std::size_t>(1, capacity);
+    evictToFit(capacity_);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::size_t InfiniteMazeCache::getCapacity() const
+{
+    return capacity_;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void InfiniteMazeCache::evictToFit(std::size_t chunkCount)
+{
+    while (entries_.size() > chunkCount)
+    {
+        entries_.erase(lruKeys_.back());
+        lruKeys_.pop_back();
+        ++statistics_.evictions;
+    }
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void InfiniteMazeCache::insert(InfiniteMaze::Chunk &&chunk)
+{
+    const InfiniteMaze::ChunkKey key(chunk.chunkX, chunk.chunkY);
+    evictToFit(capacity_ - 1);
+    lruKeys_.push_front(key);
+    entries_[key] = Entry {std::make_shared<const InfiniteMaze::Chunk>(std::move(chunk)), lruKeys_.begin()};
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::shared_ptr<const InfiniteMaze::Chunk> InfiniteMazeCache::getChunk(std::int64_t chunkX, std::int64_t chunkY)
+{
+    const auto entry = entries_.find(InfiniteMaze::ChunkKey(chunkX, chunkY));
+    if (entry != entries_.end())
+    {
+        ++statistics_.hits;
+        lruKeys_.splice(lruKeys_.begin(), lruKeys_, entry->second.lruPosition);
+        return entry->second.chunk;
+    }
+
+    ++statistics_.misses;
+    InfiniteMaze::Chunk chunk;
+    maze_.generateChunk(chunkX, chunkY, chunk);
+    insert(std::move(chunk));
+    return entries_[lruKeys_.front()].chunk;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void InfiniteMazeCache::prefetch(std::int64_t firstChunkX, std::int64_t firstChunkY,
+                                 std::int64_t lastChunkX, std::int64_t lastChunkY)
+{
+    MAZE_TRACE_ZONE("InfiniteMazeCache::prefetch");
+    std::vector<InfiniteMaze::ChunkKey> missingKeys;
+    for (std::int64_t chunkY = firstChunkY; chunkY <= lastChunkY; ++chunkY)
+    {
+        for (std::int64_t chunkX = firstChunkX; chunkX <= lastChunkX; ++chunkX)
+        {
+            const auto entry = entries_.find(InfiniteMaze::ChunkKey(chunkX, chunkY));
+            if (entry == entries_.end())
+                missingKeys.push_back(InfiniteMaze::ChunkKey(chunkX, chunkY));
+            else
+                lruKeys_.splice(lruKeys_.begin(), lruKeys_, entry->second.lruPosition);
+        }
+    }
+    if (missingKeys.empty())
+        return;
+
+    statistics_.misses += missingKeys.size();
+    std::vector<InfiniteMaze::Chunk> chunks;
+    maze_.generateChunks(missingKeys, chunks);
+    for (InfiniteMaze::Chunk &chunk : chunks)
+        insert(std::move(chunk));
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool InfiniteMazeCache::hasPassage(std::int64_t x, std::int64_t y, int direction)
+{
+    const std::int64_t chunkSize = static_cast<std::int64_t>(maze_.getChunkSize());
+    const std::int64_t chunkX = maze_.getChunkCoordinate(x);
+    const std::int64_t chunkY = maze_.getChunkCoordinate(y);
+    const std::size_t localX = static_cast<std::size_t>(x - chunkX * chunkSize);
+    const std::size_t localY = static_cast<std::size_t>(y - chunkY * chunkSize);
+    const std::shared_ptr<const InfiniteMaze::Chunk> chunk = getChunk(chunkX, chunkY);
+
+    // Внутри блока отвечает его сетка, на стороне - проход блока через эту сторону
+    const std::size_t lastCell = maze_.getChunkSize() - 1;
+    switch (direction)
+    {
+    case PackedMazeGrid::Direction::Top :
+        return localY > 0 ? chunk->grid.hasPassage(localX, localY, direction) :
+                            chunk->openings[direction] == localX;
+    case PackedMazeGrid::Direction::Right :
+        return localX < lastCell ? chunk->grid.hasPassage(localX, localY, direction) :
+                                   chunk->openings[direction] == localY;
+    case PackedMazeGrid::Direction::Bot :
+        return localY < lastCell ? chunk->grid.hasPassage(localX, localY, direction) :
+                                   chunk->openings[direction] == localX;
+    case PackedMazeGrid::Direction::Left :
+        return localX > 0 ? chunk->grid.hasPassage(localX, localY, direction) :
+                            chunk->openings[direction] == localY;
+    }
+    return false;
+}
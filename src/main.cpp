@@ -1,15 +1,46 @@
-
 #include "gui/mainwindow.h"
+#include "tracezones.h"
 
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QDebug>
 
 int main(int argc, char *argv[]) {
     QApplication app(argc, argv);
+    MAZE_TRACE_THREAD_NAME("GUI");
+
+    // Те же имена, что у mazegen и mazedaemon: с общей папкой кэша лабиринт строится один раз
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    const QCommandLineOption seedOption("seed", "Generate every maze with seed S instead of a random one.", "S");
+    const QCommandLineOption cacheDirectoryOption("cache-dir", "Take mazes with a fixed seed from the cache in DIR.",
+                                                  "DIR");
+    const QCommandLineOption cacheSizeOption("cache-size", "Cache size limit in bytes.", "BYTES", "1073741824");
+    const QCommandLineOption sharedMemoryOption("shared-memory",
+                                                "Publish the maze in POSIX shared memory NAME (e.g. /a-maze-n-gen).",
+                                                "NAME");
+    parser.addOption(seedOption);
+    parser.addOption(cacheDirectoryOption);
+    parser.addOption(cacheSizeOption);
+    parser.addOption(sharedMemoryOption);
+    parser.process(app);
+
     MainWindow window;
+    Maze *maze = window.getMazeArea()->getMaze();
+    if (parser.isSet(seedOption))
+        maze->setGenerationSeed(parser.value(seedOption).toULongLong());
+    if (parser.isSet(cacheDirectoryOption))
+        maze->enableCache(parser.value(cacheDirectoryOption), parser.value(cacheSizeOption).toULongLong());
+    if (parser.isSet(sharedMemoryOption) && !maze->enableSharedMemoryPublication(parser.value(sharedMemoryOption)))
+        qWarning() << "Unable to publish the maze in shared memory" << parser.value(sharedMemoryOption);
 
     QFont globalFont("Centaur", 14);
     window.setFont(globalFont);
 
     window.show();
-    return app.exec();
+    const int exitCode = app.exec();
+
+    // В сборке с CONFIG+=tracing трасса открывается в ui.perfetto.dev или chrome://tracing
+    MAZE_TRACE_WRITE("amaze-trace.json");
+    return exitCode;
 }
@@ -0,0 +1,276 @@
+#include "maskedmazegenerator.h"
+#include "mazegenerator.h"
+#include "tracezones.h"
+
+namespace
+{
+// Клетка вместе с плотным номером, чтобы не пересчитывать его через select
+struct ActiveCell
+{
+    std::size_t x;
+    std::size_t y;
+    std::size_t index;
+};
+}
+
+MaskedMazeGenerator::MaskedMazeGenerator(const MazeMask &mask, std::uint64_t seed) noexcept
+    : mask_(mask),
+      random_(seed)
+{
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool MaskedMazeGenerator::isSupported(int algorithm)
+{
+    return algorithm == MazeGenerator::Algorithm::RecursiveBacktracker || algorithm == MazeGenerator::Algorithm::Wilson;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MaskedMazeGenerator::generate(int algorithm, PackedMazeGrid &grid)
+{
+    MAZE_TRACE_ZONE_ARG("MaskedMazeGenerator::generate", "algorithm", algorithm);
+    grid.resize(mask_.getWidth(), mask_.getHeight());
+    cellStates_.assign(mask_.getActiveCount(), 0);
+    directionBitsLeft_ = 0;
+    if (cellStates_.empty())
+        return;
+
+    if (algorithm == MazeGenerator::Algorithm::Wilson)
+        generateWilson(grid);
+    else
+        generateRecursiveBacktracker(grid);
+    // Состояние нужно только на время генерации
+    std::vector<std::uint8_t>().swap(cellStates_);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+unsigned int MaskedMazeGenerator::findNeighbors(std::size_t x, std::size_t y,
+                                                int directions[PackedMazeGrid::Direction::Count]) const
+{
+    unsigned int directionCount {0};
+    if (y > 0 && mask_.isActive(x, y - 1))
+        directions[directionCount++] = PackedMazeGrid::Direction::Top;
+    if (x + 1 < mask_.getWidth() && mask_.isActive(x + 1, y))
+        directions[directionCount++] = PackedMazeGrid::Direction::Right;
+    if (y + 1 < mask_.getHeight() && mask_.isActive(x, y + 1))
+        directions[directionCount++] = PackedMazeGrid::Direction::Bot;
+    if (x > 0 && mask_.isActive(x - 1, y))
+        directions[directionCount++] = PackedMazeGrid::Direction::Left;
+    return directionCount;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MaskedMazeGenerator::moveToNeighbor(std::size_t &x, std::size_t &y, std::size_t &index, int direction) const
+{
+    // Номера идут по строкам, поэтому соседи в строке отличаются на единицу
+    switch (direction)
+    {
+    case PackedMazeGrid::Direction::Top :
+        index = mask_.rank(x, --y);
+        break;
+    case PackedMazeGrid::Direction::Right :
+        ++x;
+        ++index;
+        break;
+    case PackedMazeGrid::Direction::Bot :
+        index = mask_.rank(x, ++y);
+        break;
+    case PackedMazeGrid::Direction::Left :
+        --x;
+        --index;
+        break;
+    }
+}
+
+/*------------------------------------------------------------------------------------------------*/
+int MaskedMazeGenerator::chooseRandomDirection(std::size_t x, std::size_t y)
+{
+    // Как в UniformTreeGenerator: два бита на попытку, направления вне маски перевыбираются
+    for (;;)
+    {
+        if (directionBitsLeft_ == 0)
+        {
+            directionBits_ = random_.generate64();
+            directionBitsLeft_ = 32;
+        }
+        const int direction = directionBits_ & 0x03;
+        directionBits_ >>= 2;
+        --directionBitsLeft_;
+
+        switch (direction)
+        {
+        case PackedMazeGrid::Direction::Top :
+            if (y > 0 && mask_.isActive(x, y - 1))
+                return direction;
+            break;
+        case PackedMazeGrid::Direction::Right :
+            if (x + 1 < mask_.getWidth() && mask_.isActive(x + 1, y))
+                return direction;
+            break;
+        case PackedMazeGrid::Direction::Bot :
+            if (y + 1 < mask_.getHeight() && mask_.isActive(x, y + 1))
+                return direction;
+            break;
+        case PackedMazeGrid::Direction::Left :
+            if (x > 0 && mask_.isActive(x - 1, y))
+                return direction;
+            break;
+        }
+    }
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::size_t MaskedMazeGenerator::chooseRandomActiveCell()
+{
+    return static_cast<std::size_t>(random_.generate64() % cellStates_.size());
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MaskedMazeGenerator::generateRecursiveBacktracker(PackedMazeGrid &grid)
+{
+    MAZE_TRACE_ZONE("MaskedMazeGenerator::generateRecursiveBacktracker");
+    // В стеке позиции y * width + x, как в MazeGenerator; плотный номер клетки пересчитывается через rank
+    const std::size_t width = mask_.getWidth();
+    std::vector<std::size_t> backtrackingStack;
+    std::size_t startIndex = chooseRandomActiveCell();
+    std::size_t nextUnvisited {0};
+    for (;;)
+    {
+        std::size_t startX {};
+        std::size_t startY {};
+        mask_.select(startIndex, startX, startY);
+        cellStates_[startIndex] |= CellState::InTree;
+        backtrackingStack.push_back(startY * width + startX);
+
+        while (!backtrackingStack.empty())
+        {
+            const std::size_t position = backtrackingStack.back();
+            const std::size_t x = position % width;
+            const std::size_t y = position / width;
+            const std::size_t index = mask_.rank(x, y);
+
+            // Непосещенные соседи внутри маски; соседи в строке - соседние номера
+            int directions[PackedMazeGrid::Direction::Count] {};
+            std::size_t nextPositions[PackedMazeGrid::Direction::Count] {};
+            std::uint32_t directionCount {0};
+            if (y > 0 && mask_.isActive(x, y - 1) && !(cellStates_[mask_.rank(x, y - 1)] & CellState::InTree))
+            {
+                directions[directionCount] = PackedMazeGrid::Direction::Top;
+                nextPositions[directionCount++] = position - width;
+            }
+            if (x + 1 < width && mask_.isActive(x + 1, y) && !(cellStates_[index + 1] & CellState::InTree))
+            {
+                directions[directionCount] = PackedMazeGrid::Direction::Right;
+                nextPositions[directionCount++] = position + 1;
+            }
+            if (y + 1 < mask_.getHeight() && mask_.isActive(x, y + 1) &&
+                    !(cellStates_[mask_.rank(x, y + 1)] & CellState::InTree))
+            {
+                directions[directionCount] = PackedMazeGrid::Direction::Bot;
+                nextPositions[directionCount++] = position + width;
+            }
+            if (x > 0 && mask_.isActive(x - 1, y) && !(cellStates_[index - 1] & CellState::InTree))
+            {
+                directions[directionCount] = PackedMazeGrid::Direction::Left;
+                nextPositions[directionCount++] = position - 1;
+            }
+            if (directionCount == 0)
+            {
+                backtrackingStack.pop_back();
+                continue;
+            }
+
+            const std::uint32_t choice = random_.bounded(directionCount);
+            grid.setPassage(x, y, directions[choice], true);
+            const std::size_t nextPosition = nextPositions[choice];
+            cellStates_[mask_.rank(nextPosition % width, nextPosition / width)] |= CellState::InTree;
+            backtrackingStack.push_back(nextPosition);
+        }
+
+        // Связная часть пройдена; следующая начинается с первой по номеру непосещенной клетки
+        while (nextUnvisited < cellStates_.size() && (cellStates_[nextUnvisited] & CellState::InTree))
+            ++nextUnvisited;
+        if (nextUnvisited == cellStates_.size())
+            return;
+        startIndex = nextUnvisited;
+    }
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MaskedMazeGenerator::markComponentRoots()
+{
+    /* На равномерность корень не влияет, а на время влияет сильно: до клетки на краю фигуры
+     * блуждать в среднем намного дольше. Поэтому первый корень - случайная клетка, как в
+     * UniformTreeGenerator, а у остальных частей - первая по номеру клетка */
+    std::vector<ActiveCell> pendingCells;
+    for (std::size_t candidate = 0; candidate <= cellStates_.size(); ++candidate)
+    {
+        const std::size_t root = candidate == 0 ? chooseRandomActiveCell() : candidate - 1;
+        if (cellStates_[root] & CellState::Reached)
+            continue;
+        ActiveCell rootCell {0, 0, root};
+        mask_.select(root, rootCell.x, rootCell.y);
+        cellStates_[root] |= CellState::InTree | CellState::Reached;
+        pendingCells.push_back(rootCell);
+
+        while (!pendingCells.empty())
+        {
+            const ActiveCell cell = pendingCells.back();
+            pendingCells.pop_back();
+            int neighbors[PackedMazeGrid::Direction::Count] {};
+            const unsigned int neighborCount = findNeighbors(cell.x, cell.y, neighbors);
+            for (unsigned int neighbor = 0; neighbor < neighborCount; ++neighbor)
+            {
+                ActiveCell next = cell;
+                moveToNeighbor(next.x, next.y, next.index, neighbors[neighbor]);
+                if (cellStates_[next.index] & CellState::Reached)
+                    continue;
+                cellStates_[next.index] |= CellState::Reached;
+                pendingCells.push_back(next);
+            }
+        }
+    }
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MaskedMazeGenerator::generateWilson(PackedMazeGrid &grid)
+{
+    MAZE_TRACE_ZONE("MaskedMazeGenerator::generateWilson");
+    /* Блуждание идет по соседям внутри маски, поэтому дерево каждой связной части равномерно
+     * среди остовных деревьев этой части. Без корня в каждой части блуждание из части, где
+     * дерева еще нет, никогда бы не кончилось */
+    markComponentRoots();
+
+    for (std::size_t start = 0; start < cellStates_.size(); ++start)
+    {
+        if (cellStates_[start] & CellState::InTree)
+            continue;
+        std::size_t x {};
+        std::size_t y {};
+        mask_.select(start, x, y);
+
+        // Блуждание до дерева, в клетке запоминается направление последнего выхода из нее
+        std::size_t walkX = x;
+        std::size_t walkY = y;
+        std::size_t walkIndex = start;
+        while (!(cellStates_[walkIndex] & CellState::InTree))
+        {
+            const int direction = chooseRandomDirection(walkX, walkY);
+            cellStates_[walkIndex] = static_cast<std::uint8_t>((cellStates_[walkIndex] & ~CellState::DirectionMask) |
+                                                               direction);
+            moveToNeighbor(walkX, walkY, walkIndex, direction);
+        }
+
+        // Путь без петель: снова от начала по запомненным направлениям
+        walkX = x;
+        walkY = y;
+        walkIndex = start;
+        while (!(cellStates_[walkIndex] & CellState::InTree))
+        {
+            const int direction = cellStates_[walkIndex] & CellState::DirectionMask;
+            cellStates_[walkIndex] |= CellState::InTree;
+            grid.setPassage(walkX, walkY, direction, true);
+            moveToNeighbor(walkX, walkY, walkIndex, direction);
+        }
+    }
+}
@@ -1,8 +1,10 @@
 #include "maze.h"
 #include "cell.h"
+#include "tracezones.h"
 #include <fstream>
 #include <vector>
 #include <QDataStream>
+#include <QDir>
 #include <QFile>
 #include <iostream>
 #include <QDebug> // Assurez-vous que cette en-tête est incluse pour qDebug()
@@ -18,8 +20,109 @@ QVector<QVector<Cell>>& Maze::getCellGrid()
     return cellGrid_;
 }
 
+/*------------------------------------------------------------------------------------------------*/
+const PackedMazeGrid& Maze::getPackedGrid() const
+{
+    return packedGrid_;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void Maze::setGenerationSeed(quint64 seed)
+{
+    generationSeed_ = seed;
+    isGenerationSeedSet_ = true;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void Maze::enableCache(const QString &directoryPath, quint64 maxSizeBytes)
+{
+    QDir().mkpath(directoryPath);
+    mazeCache_.reset(new MazeCache(directoryPath.toStdString(), maxSizeBytes));
+}
+
+/*------------------------------------------------------------------------------------------------*/
+MazeCache::Statistics Maze::getCacheStatistics() const
+{
+    return mazeCache_ ? mazeCache_->getStatistics() : MazeCache::Statistics();
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void Maze::enableMazePool(std::size_t mazesPerKey, quint64 maxSizeBytes)
+{
+    mazePool_.reset(new MazePool(mazesPerKey, maxSizeBytes));
+}
+
+/*------------------------------------------------------------------------------------------------*/
+MazePool::Statistics Maze::getMazePoolStatistics() const
+{
+    return mazePool_ ? mazePool_->getStatistics() : MazePool::Statistics();
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool Maze::enableSharedMemoryPublication(const QString &segmentName)
+{
+    /* Упакованная сетка переезжает в разделяемую память, и все алгоритмы, включая анимированные,
+     * дальше пишут прямо в неё. Другие процессы читают её через SharedMazeReader */
+    sharedMazePublisher_.reset(new SharedMazePublisher(segmentName.toStdString()));
+    if (!sharedMazePublisher_->open() || !sharedMazePublisher_->attach(packedGrid_))
+    {
+        sharedMazePublisher_.reset();
+        return false;
+    }
+    return true;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void Maze::takeFrameWork(quint64 &appliedSteps, qint64 &sceneUpdateNs)
+{
+    if (sceneUpdateTimer_.isValid())
+    {
+        sceneUpdateNs_ += sceneUpdateTimer_.nsecsElapsed();
+        sceneUpdateTimer_.start();
+    }
+    appliedSteps = appliedSteps_;
+    sceneUpdateNs = sceneUpdateNs_;
+    appliedSteps_ = 0;
+    sceneUpdateNs_ = 0;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void Maze::setVisitHeatmapEnabled(bool isEnabled)
+{
+    isVisitHeatmapEnabled_ = isEnabled;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+const VisitHeatmap& Maze::getVisitHeatmap() const
+{
+    return visitHeatmap_;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+const MazeJunctionGraph& Maze::getJunctionGraph()
+{
+    if (isJunctionGraphStale_)
+    {
+        junctionGraph_.build(packedGrid_);
+        isJunctionGraphStale_ = false;
+    }
+    return junctionGraph_;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+MazeConnectivity& Maze::getConnectivity()
+{
+    if (isConnectivityStale_)
+    {
+        connectivity_.build(packedGrid_);
+        isConnectivityStale_ = false;
+    }
+    return connectivity_;
+}
+
 /*------------------------------------------------------------------------------------------------*/
 void Maze::generateMazeGrid(unsigned int mazeSize) {
+    MAZE_TRACE_ZONE("Maze::generateMazeGrid");
     cellGrid_.clear();
     mazeSize_ = 5; // Ou utilisez mazeSize pour une taille dynamique.
     unsigned int cellSize = mazeGridSizePx_ / mazeSize_;
@@ -38,6 +141,13 @@ void Maze::generateMazeGrid(unsigned int mazeSize) {
         }
         cellGrid_.push_back(curColCells);
     }
+    packedGrid_.resize(mazeSize_, mazeSize_);
+    visitHeatmap_.resize(mazeSize_, mazeSize_);
+    isJunctionGraphStale_ = true;
+    isConnectivityStale_ = true;
+    // Пустая сетка публикуется без алгоритма
+    if (sharedMazePublisher_)
+        sharedMazePublisher_->endWrite(-1, packedGrid_);
 
     emit requestToDrawMazeGrid(getCellGrid());
 }
@@ -45,6 +155,7 @@ void Maze::generateMazeGrid(unsigned int mazeSize) {
 /*------------------------------------------------------------------------------------------------*/
 void Maze::resetGrid()
 {
+    MAZE_TRACE_ZONE("Maze::resetGrid");
     for (auto row = cellGrid_.begin(); row != cellGrid_.end(); row++)
     {
         for (auto col = row->begin(); col != row->end(); col++)
@@ -52,6 +163,12 @@ void Maze::resetGrid()
             col->resetCell();
         }
     }
+    // Сброс - начало новой генерации, читатели не должны видеть очищенную сетку
+    if (sharedMazePublisher_)
+        sharedMazePublisher_->beginWrite();
+    packedGrid_.clear();
+    isJunctionGraphStale_ = true;
+    isConnectivityStale_ = true;
 }
 
 /*------------------------------------------------------------------------------------------------*/
@@ -60,366 +177,315 @@ void Maze::interruptReceived()
     interruptFlag_ = true;
 }
 
-/*------------------------------------------------------------------------------------------------*/
-bool Maze::generationLoopExitCondition(unsigned int &visitedCells)
-{
-    return (!interruptFlag_ && visitedCells < mazeSize_ * mazeSize_);
-}
-
 /*------------------------------------------------------------------------------------------------*/
 void Maze::generateMaze(int whichAlgorithmWasChosen)
 {
+    MAZE_TRACE_ZONE_ARG("Maze::generateMaze", "algorithm", whichAlgorithmWasChosen);
+    sceneUpdateTimer_.start();
     Coordinate currentCoordinates {0, 0};
-    unsigned int visitedCells {1};
+    visitHeatmap_.clear();
+    regionRegenerationCount_ = 0;
     cellGrid_[0][0].wasVisited();
     cellGrid_[0][0].getRectForShowCurrentCell()->setVisible(true);
     delay(DELAY_MS_IN_GENERATION_CYCLE);
 
+    if (sharedMazePublisher_)
+        sharedMazePublisher_->beginWrite();
+
     switch (whichAlgorithmWasChosen)
     {
     case AlgorithmGeneratorMenu::Algorithm::AldousBroder :
-        generateAldousBroder(visitedCells, currentCoordinates);
-        break;
     case AlgorithmGeneratorMenu::Algorithm::RecursiveBacktracker :
-        generateRecursiveBacktracker(visitedCells, currentCoordinates);
-        break;
     case AlgorithmGeneratorMenu::Algorithm::Wilson :
-        generateWilson(visitedCells, currentCoordinates);
+        generateStepByStep(whichAlgorithmWasChosen, currentCoordinates);
+        break;
+    case AlgorithmGeneratorMenu::Algorithm::BinaryTree :
+    case AlgorithmGeneratorMenu::Algorithm::Sidewinder :
+    case AlgorithmGeneratorMenu::Algorithm::CyclePopping :
+        generatePackedMaze(whichAlgorithmWasChosen);
         break;
     }
 
     cellGrid_[currentCoordinates.x][currentCoordinates.y].getRectForShowCurrentCell()->setVisible(false);
+    if (sharedMazePublisher_)
+        sharedMazePublisher_->endWrite(whichAlgorithmWasChosen, packedGrid_);
+    isJunctionGraphStale_ = true;
+    isConnectivityStale_ = true;
     interruptFlag_ = false;
+    sceneUpdateNs_ += sceneUpdateTimer_.nsecsElapsed();
+    sceneUpdateTimer_.invalidate();
     emit mazeWasGenerated();
 }
 
 /*------------------------------------------------------------------------------------------------*/
-void Maze::generateAldousBroder(unsigned int &visitedCells, Coordinate &currentCoordinates)
+void Maze::generateStepByStep(int whichAlgorithmWasChosen, Coordinate &currentCoordinates)
 {
-    while (generationLoopExitCondition(visitedCells))
-    {
-        int whichWayToGo = QRandomGenerator::global()->generate() % Direction::Count;
-        if (isLegitimateStep(currentCoordinates, whichWayToGo))
-            makeStep(currentCoordinates, whichWayToGo, visitedCells);
-    }
+    /* Шаги выдает MazeStepGenerator, здесь они только переносятся на ячейки сцены с задержкой.
+     * С заданным seed анимированный лабиринт повторяется и совпадает с лабиринтом из MazeGenerator
+     * и кэша */
+    MAZE_TRACE_ZONE_ARG("Maze::generateStepByStep", "algorithm", whichAlgorithmWasChosen);
+    MazeStepGenerator generator(whichAlgorithmWasChosen, mazeSize_, mazeSize_, isGenerationSeedSet_ ?
+                                    generationSeed_ : QRandomGenerator::global()->generate64());
+    MazeStepGenerator::Step step;
+    while (!interruptFlag_ && generator.next(step))
+        applyGenerationStep(step, currentCoordinates);
 }
 
 /*------------------------------------------------------------------------------------------------*/
-void Maze::generateRecursiveBacktracker(unsigned int &visitedCells, Coordinate &currentCoordinates)
+void Maze::applyGenerationStep(const MazeStepGenerator::Step &step, Coordinate &currentCoordinates)
 {
-    QStack<Coordinate> backtrackingStack {};
-    backtrackingStack.push(currentCoordinates);
-
-    std::vector<char> mazeBytes; // Vecteur pour stocker les bytes du labyrinthe.
+    const Coordinate stepCoordinates(step.x, step.y);
+    cellGrid_[currentCoordinates.x][currentCoordinates.y].getRectForShowCurrentCell()->setVisible(false);
 
-    while (generationLoopExitCondition(visitedCells))
+    switch (step.type)
     {
-        if (backtrackingStack.isEmpty()) {
-            qDebug() << "Erreur: backtrackingStack est vide!";
-            break; // Sortir de la boucle pour éviter un crash.
-        }
-
-        Coordinate currentCell = backtrackingStack.top();
-        int whichWayToGo = checkNeighborsAndDecideWhichWayToGo(currentCell);
-
-        if (whichWayToGo != Direction::Forbidden)
-        {
-            makeStep(currentCell, whichWayToGo, visitedCells);
-            currentCoordinates = currentCell; // Mise à jour après le déplacement.
-            backtrackingStack.push(currentCoordinates);
-
-            auto cellBytes = cellGrid_[currentCoordinates.x][currentCoordinates.y].toBytes();
-            qDebug() << "Taille de cellBytes pour la cellule (" << currentCoordinates.x << "," << currentCoordinates.y << ") :" << cellBytes.size();
-
-            if (!cellBytes.empty()) {
-                mazeBytes.insert(mazeBytes.end(), cellBytes.begin(), cellBytes.end());
-            } else {
-                qDebug() << "Erreur: cellBytes est vide pour la cellule (" << currentCoordinates.x << "," << currentCoordinates.y << ").";
-            }
-
-            qDebug() << "Taille actuelle de mazeBytes :" << mazeBytes.size();
-        }
-        else
-        {
-            cellGrid_[currentCell.x][currentCell.y].getRectForShowCurrentCell()->setVisible(false);
-            backtrackingStack.pop();
-        }
+    case MazeStepGenerator::StepType::Start :
+        currentCoordinates = stepCoordinates;
+        cellGrid_[currentCoordinates.x][currentCoordinates.y].wasVisited();
+        break;
+    case MazeStepGenerator::StepType::Carve :
+        setPassageInCells(stepCoordinates, step.direction, true);
+        currentCoordinates = getNeighborCoordinates(stepCoordinates, step.direction);
+        cellGrid_[currentCoordinates.x][currentCoordinates.y].wasVisited();
+        break;
+    case MazeStepGenerator::StepType::Move :
+        currentCoordinates = getNeighborCoordinates(stepCoordinates, step.direction);
+        break;
+    case MazeStepGenerator::StepType::Erase :
+        setPassageInCells(stepCoordinates, step.direction, false);
+        cellGrid_[stepCoordinates.x][stepCoordinates.y].setUnvisited();
+        currentCoordinates = getNeighborCoordinates(stepCoordinates, step.direction);
+        break;
+    case MazeStepGenerator::StepType::Retreat :
+        // Возврат из тупика не показывается и идет без задержки
+        currentCoordinates = getNeighborCoordinates(stepCoordinates, step.direction);
+        ++appliedSteps_;
+        return;
     }
 
-    if (!mazeBytes.empty()) {
-        std::ofstream outFile("mazeData2.bin", std::ios::binary);
-        if (outFile.is_open())
-        {
-            outFile.write(reinterpret_cast<const char*>(mazeBytes.data()), mazeBytes.size());
-            outFile.close();
-            qDebug() << "Le fichier mazeData2.bin a été écrit avec succès.";
-        }
-        else
-        {
-            qDebug() << "Erreur: Impossible d'ouvrir le fichier pour écrire!";
-        }
-    } else {
-        qDebug() << "Erreur: mazeBytes est vide, rien à écrire dans le fichier.";
-    }
+    cellGrid_[currentCoordinates.x][currentCoordinates.y].getRectForShowCurrentCell()->setVisible(true);
+    ++appliedSteps_;
+    // Стирание петли - возврат по своему пути, а не новый заход в клетку
+    if (isVisitHeatmapEnabled_ && step.type != MazeStepGenerator::StepType::Erase)
+        visitHeatmap_.recordVisit(currentCoordinates.x, currentCoordinates.y);
+    delay(DELAY_MS_IN_GENERATION_CYCLE);
 }
 
 /*------------------------------------------------------------------------------------------------*/
-void Maze::generateWilson(unsigned int &visitedCells, Coordinate &currentCoordinates)
+void Maze::setPassageInCells(Coordinate coordinates, int direction, bool isOpen)
 {
-    QStack<Coordinate> currentPathStack {};
-    QVector<Coordinate> cellsAlreadyInMaze {};
-    cellsAlreadyInMaze.push_back(currentCoordinates);
-    cellGrid_[0][0].getRectForShowCurrentCell()->setVisible(false);
-
-    while (generationLoopExitCondition(visitedCells))
+    const Coordinate neighborCoordinates = getNeighborCoordinates(coordinates, direction);
+    Cell &cell = cellGrid_[coordinates.x][coordinates.y];
+    Cell &neighbor = cellGrid_[neighborCoordinates.x][neighborCoordinates.y];
+    switch (direction)
     {
-        chooseRandomNonAddedCoordinates(currentCoordinates, cellsAlreadyInMaze);
-        currentPathStack.push(currentCoordinates);
-
-        /* Данный цикл строит ветку лабиринта из случайной клетки до включенных в лабиринт клеток.
-         * Цикл может длиться очень долго и необходимо иметь возможность его прервать,
-         * поэтому здесь также отслеживаем флаг прерывания */
-        while (!cellsAlreadyInMaze.contains(currentCoordinates) && !interruptFlag_)
-        {
-            int whichWayToGo = QRandomGenerator::global()->generate() % Direction::Count;
-            if (isLegitimateStep(currentCoordinates, whichWayToGo))
-            {
-                makeStep(currentCoordinates, whichWayToGo, visitedCells);
-                if (!currentPathStack.contains(currentCoordinates))
-                {
-                    currentPathStack.push(currentCoordinates);
-                }
-                else
-                {
-                    while (currentCoordinates != currentPathStack.top())
-                    {
-                        Coordinate savedCoordinates = currentPathStack.top();
-                        currentPathStack.pop();
-                        makeStepBack(savedCoordinates, currentPathStack.top(), true);
-                    }
-                }
-            }
-        }
-
-        /* Во избежание краша, вызванного нажатием стоп при пустом стеке (pop-аем пустой стек), что
-         * возможно, если в текущий путь не успела добавиться ни одна ячейка*/
-        if (currentPathStack.size() != 0)
-        {
-            cellGrid_[currentCoordinates.x][currentCoordinates.y].getRectForShowCurrentCell()->setVisible(false);
-            currentPathStack.pop();
-            // Для корректной отрисовки необходимо вызвать данную функцию
-            makeStepBack(currentCoordinates, currentPathStack.top(), false);
-
-            // Добавляем ячейки из пути в основной лабиринт
-            while (currentPathStack.size() != 0)
-            {
-                cellsAlreadyInMaze.push_back(currentPathStack.top());
-                currentPathStack.pop();
-            }
-            currentPathStack.clear();
-        }
-        visitedCells = cellsAlreadyInMaze.size();
+    case Direction::Top :
+        cell.getTopWall()->setVisible(!isOpen);
+        neighbor.getBotWall()->setVisible(!isOpen);
+        break;
+    case Direction::Right :
+        cell.getRightWall()->setVisible(!isOpen);
+        neighbor.getLeftWall()->setVisible(!isOpen);
+        break;
+    case Direction::Bot :
+        cell.getBotWall()->setVisible(!isOpen);
+        neighbor.getTopWall()->setVisible(!isOpen);
+        break;
+    case Direction::Left :
+        cell.getLeftWall()->setVisible(!isOpen);
+        neighbor.getRightWall()->setVisible(!isOpen);
+        break;
     }
+    packedGrid_.setPassage(coordinates.x, coordinates.y, direction, isOpen);
 }
 
 /*------------------------------------------------------------------------------------------------*/
-int Maze::checkNeighborsAndDecideWhichWayToGo(Coordinate currentCoordinates)
+MazeConnectivity::EditResult Maze::toggleWall(Coordinate coordinates, int direction)
 {
-    QBitArray cellNeighborsState(Direction::Count);
-
-    if (isLegitimateStep(currentCoordinates, Direction::Top) &&
-            !cellGrid_[currentCoordinates.x][currentCoordinates.y - 1].isVisited())
-        cellNeighborsState.setBit(Direction::Top, true);
-
-    if (isLegitimateStep(currentCoordinates, Direction::Right) &&
-            !cellGrid_[currentCoordinates.x + 1][currentCoordinates.y].isVisited())
-        cellNeighborsState.setBit(Direction::Right, true);
-
-    if (isLegitimateStep(currentCoordinates, Direction::Bot) &&
-            !cellGrid_[currentCoordinates.x][currentCoordinates.y + 1].isVisited())
-        cellNeighborsState.setBit(Direction::Bot, true);
-
-    if (isLegitimateStep(currentCoordinates, Direction::Left) &&
-            !cellGrid_[currentCoordinates.x - 1][currentCoordinates.y].isVisited())
-        cellNeighborsState.setBit(Direction::Left, true);
-
-
-    if (cellNeighborsState == QBitArray(Direction::Count, false))
-        return Direction::Forbidden;
-    else
-    {
-        int whichWayToGo = QRandomGenerator::global()->generate() % Direction::Count;
-        while (cellNeighborsState[whichWayToGo] != true)
-            whichWayToGo = QRandomGenerator::global()->generate() % Direction::Count;
-        return whichWayToGo;
-    }
+    MAZE_TRACE_ZONE("Maze::toggleWall");
+    const Coordinate neighbor = getNeighborCoordinates(coordinates, direction);
+    const int mazeSize = static_cast<int>(mazeSize_);
+    if (direction < Direction::Top || direction >= Direction::Count ||
+            coordinates.x < 0 || coordinates.y < 0 || coordinates.x >= mazeSize || coordinates.y >= mazeSize ||
+            neighbor.x < 0 || neighbor.y < 0 || neighbor.x >= mazeSize || neighbor.y >= mazeSize)
+        return MazeConnectivity::EditResult {false, false, false};
+
+    // Связность строится по сетке до правки, а дальше обновляется вместе с ней
+    MazeConnectivity &connectivity = getConnectivity();
+    const bool isOpen = !packedGrid_.hasPassage(coordinates.x, coordinates.y, direction);
+    if (sharedMazePublisher_)
+        sharedMazePublisher_->beginWrite();
+    setPassageInCells(coordinates, direction, isOpen);
+    // Правленый лабиринт уже не результат алгоритма
+    if (sharedMazePublisher_)
+        sharedMazePublisher_->endWrite(-1, packedGrid_);
+    isJunctionGraphStale_ = true;
+    return connectivity.setPassage(coordinates.x, coordinates.y, direction, isOpen);
 }
 
 /*------------------------------------------------------------------------------------------------*/
-void Maze::chooseRandomNonAddedCoordinates(Coordinate &currentCoordinates, QVector<Coordinate> &cellsAlreadyInMaze)
+bool Maze::regenerateRegion(Coordinate corner, int width, int height)
 {
-    currentCoordinates.x = 0;
-    currentCoordinates.y = 0;
-
-    while (cellsAlreadyInMaze.contains(currentCoordinates))
+    MAZE_TRACE_ZONE("Maze::regenerateRegion");
+    const int mazeSize = static_cast<int>(mazeSize_);
+    if (width <= 0 || height <= 0 || corner.x < 0 || corner.y < 0 ||
+            width > mazeSize - corner.x || height > mazeSize - corner.y)
+        return false;
+
+    // Внутренние проходы области до перегенерации: бит 0 - вправо, бит 1 - вниз
+    const MazeRegionRegenerator::Region region {static_cast<std::size_t>(corner.x), static_cast<std::size_t>(corner.y),
+                                                static_cast<std::size_t>(width), static_cast<std::size_t>(height)};
+    std::vector<std::uint8_t> oldPassages(region.width * region.height, 0);
+    for (std::size_t y = 0; y < region.height; ++y)
     {
-        currentCoordinates = Coordinate(QRandomGenerator::global()->generate() % mazeSize_,
-                                        QRandomGenerator::global()->generate() % mazeSize_);
+        for (std::size_t x = 0; x < region.width; ++x)
+        {
+            oldPassages[y * region.width + x] =
+                    static_cast<std::uint8_t>(packedGrid_.hasPassage(region.x + x, region.y + y, Direction::Right) |
+                                              packedGrid_.hasPassage(region.x + x, region.y + y, Direction::Bot) << 1);
+        }
     }
 
-    cellGrid_[currentCoordinates.x][currentCoordinates.y].
-            getRectForShowCurrentCell()->setVisible(true);
-    cellGrid_[currentCoordinates.x][currentCoordinates.y].wasVisited();
-}
-
-/*------------------------------------------------------------------------------------------------*/
-void Maze::makeStepBack(Coordinate currentCoordinates, Coordinate previousCoordinates, bool isWallsNeedToRebuild)
-{
-    cellGrid_[currentCoordinates.x][currentCoordinates.y].setUnvisited();
-
-    Coordinate difference = Coordinate(currentCoordinates.x - previousCoordinates.x,
-                                       currentCoordinates.y - previousCoordinates.y);
-    if (difference.x == 1)
+    if (sharedMazePublisher_)
+        sharedMazePublisher_->beginWrite();
+    /* С заданным seed повтор той же области должен давать новый вариант, но вся цепочка правок после
+     * генерации - повторяться, поэтому seed смешивается с номером перегенерации */
+    ++regionRegenerationCount_;
+    MazeRegionRegenerator::regenerate(packedGrid_, region, isGenerationSeedSet_ ?
+                                          generationSeed_ + regionRegenerationCount_ * 0x9E3779B97F4A7C15ULL :
+                                          QRandomGenerator::global()->generate64());
+
+    /* Стены трогаются только у изменившихся проходов области, поэтому сцена перерисовывает только
+     * её. Связность, если уже построена, получает те же правки: сначала закрытия, потом открытия,
+     * чтобы новые проходы не считались циклами */
+    std::vector<std::pair<Coordinate, int>> openedPassages;
+    for (std::size_t y = 0; y < region.height; ++y)
     {
-        cellGrid_[currentCoordinates.x][currentCoordinates.y].getLeftWall()->setVisible(isWallsNeedToRebuild);
-        cellGrid_[previousCoordinates.x][previousCoordinates.y].getRightWall()->setVisible(isWallsNeedToRebuild);
-    }
-    if (difference.x == -1)
-    {
-        cellGrid_[currentCoordinates.x][currentCoordinates.y].getRightWall()->setVisible(isWallsNeedToRebuild);
-        cellGrid_[previousCoordinates.x][previousCoordinates.y].getLeftWall()->setVisible(isWallsNeedToRebuild);
-    }
-    if (difference.y == 1)
-    {
-        cellGrid_[currentCoordinates.x][currentCoordinates.y].getTopWall()->setVisible(isWallsNeedToRebuild);
-        cellGrid_[previousCoordinates.x][previousCoordinates.y].getBotWall()->setVisible(isWallsNeedToRebuild);
+        for (std::size_t x = 0; x < region.width; ++x)
+        {
+            for (int direction : {Direction::Right, Direction::Bot})
+            {
+                const std::size_t cellX = region.x + x;
+                const std::size_t cellY = region.y + y;
+                if ((direction == Direction::Right && x + 1 == region.width) ||
+                        (direction == Direction::Bot && y + 1 == region.height))
+                    continue;
+                const bool isOpen = packedGrid_.hasPassage(cellX, cellY, direction);
+                if (isOpen == static_cast<bool>(oldPassages[y * region.width + x] & (direction == Direction::Right ? 1 : 2)))
+                    continue;
+
+                const Coordinate coordinates {static_cast<int>(cellX), static_cast<int>(cellY)};
+                setPassageInCells(coordinates, direction, isOpen);
+                if (isOpen)
+                    openedPassages.push_back(std::make_pair(coordinates, direction));
+                else if (!isConnectivityStale_)
+                    connectivity_.setPassage(cellX, cellY, direction, false);
+            }
+        }
     }
-    if (difference.y == -1)
+    if (!isConnectivityStale_)
     {
-        cellGrid_[currentCoordinates.x][currentCoordinates.y].getBotWall()->setVisible(isWallsNeedToRebuild);
-        cellGrid_[previousCoordinates.x][previousCoordinates.y].getTopWall()->setVisible(isWallsNeedToRebuild);
+        for (const std::pair<Coordinate, int> &passage : openedPassages)
+            connectivity_.setPassage(passage.first.x, passage.first.y, passage.second, true);
     }
-}
 
-/*------------------------------------------------------------------------------------------------*/
-bool Maze::isLegitimateStep(Coordinate coordinate, int stepDirection)
-{
-    bool isLegitimateStep {false};
-    switch (stepDirection)
-    {
-    case Direction::Top :
-        coordinate.y <= 0 ? isLegitimateStep = false : isLegitimateStep = true;
-        break;
-    case Direction::Right :
-        coordinate.x >= static_cast<int> (mazeSize_ - 1) ? isLegitimateStep = false : isLegitimateStep = true;
-        break;
-    case Direction::Bot :
-        coordinate.y >= static_cast<int> (mazeSize_ - 1) ? isLegitimateStep = false : isLegitimateStep = true;
-        break;
-    case Direction::Left :
-        coordinate.x <= 0 ? isLegitimateStep = false : isLegitimateStep = true;
-        break;
-    }
-    return isLegitimateStep;
+    if (sharedMazePublisher_)
+        sharedMazePublisher_->endWrite(-1, packedGrid_);
+    isJunctionGraphStale_ = true;
+    return true;
 }
 
 /*------------------------------------------------------------------------------------------------*/
-void Maze::makeStep(Coordinate &currentCoordinates, int stepDirection, unsigned int &visitedCellsCounter)
+Coordinate Maze::getNeighborCoordinates(Coordinate coordinates, int direction)
 {
-    bool cellWasVisitedOnThisStep {false};
-    Coordinate newCoordinates = currentCoordinates;
-
-    switch (stepDirection)
+    switch (direction)
     {
     case Direction::Top :
-        goTop(currentCoordinates, newCoordinates, cellWasVisitedOnThisStep);
+        --coordinates.y;
         break;
     case Direction::Right :
-        goRight(currentCoordinates, newCoordinates, cellWasVisitedOnThisStep);
+        ++coordinates.x;
         break;
     case Direction::Bot :
-        goBot(currentCoordinates, newCoordinates, cellWasVisitedOnThisStep);
+        ++coordinates.y;
         break;
     case Direction::Left :
-        goLeft(currentCoordinates, newCoordinates, cellWasVisitedOnThisStep);
+        --coordinates.x;
         break;
     }
-
-    markCellAfterStep(currentCoordinates, newCoordinates);
-    delay(DELAY_MS_IN_GENERATION_CYCLE);
-
-    currentCoordinates = newCoordinates;
-    if (cellWasVisitedOnThisStep)
-        visitedCellsCounter++;
+    return coordinates;
 }
 
 /*------------------------------------------------------------------------------------------------*/
-void Maze::markCellAfterStep(Coordinate currentCoordinates, Coordinate newCoordinates)
+void Maze::generatePackedMaze(int whichAlgorithmWasChosen)
 {
-    cellGrid_[currentCoordinates.x][currentCoordinates.y].getRectForShowCurrentCell()->setVisible(false);
-    cellGrid_[newCoordinates.x][newCoordinates.y].getRectForShowCurrentCell()->setVisible(true);
-}
-
-/*------------------------------------------------------------------------------------------------*/
-void Maze::goTop(Coordinate &currentCoordinates, Coordinate &newCoordinates, bool &cellWasVisitedOnThisStep)
-{
-    newCoordinates.y = newCoordinates.y - 1;
-    if (cellGrid_[newCoordinates.x][newCoordinates.y].isVisited() == false)
+    /* Эти алгоритмы строят лабиринт сразу в упакованной сетке (словами по 64 клетки или
+     * параллельно на всех ядрах), пошаговая анимация для них не имеет смысла, поэтому стены ячеек
+     * обновляются один раз в конце. Результат зависит только от параметров, поэтому при заданном
+     * seed лабиринт берется из кэша, если он включен */
+    static_assert(static_cast<int>(AlgorithmGeneratorMenu::Algorithm::CyclePopping) ==
+                  static_cast<int>(MazeGenerator::Algorithm::CyclePopping),
+                  "Номера алгоритмов меню и MazeGenerator должны совпадать");
+
+    const GenerationParameters parameters(whichAlgorithmWasChosen, mazeSize_, mazeSize_, isGenerationSeedSet_ ?
+                                              generationSeed_ : QRandomGenerator::global()->generate64());
+
+    // Без заданного seed подходит любой лабиринт, поэтому сначала пробуем готовый из пула
+    if (mazeCache_ && isGenerationSeedSet_)
     {
-        cellGrid_[currentCoordinates.x][currentCoordinates.y].destroyTopWall();
-        cellGrid_[newCoordinates.x][newCoordinates.y].destroyBotWall();
-        cellGrid_[newCoordinates.x][newCoordinates.y].wasVisited();
-        cellWasVisitedOnThisStep = true;
+        MAZE_TRACE_ZONE("MazeCache::generate");
+        mazeCache_->generate(parameters, packedGrid_);
     }
+    else if (!mazePool_ || isGenerationSeedSet_ ||
+             !mazePool_->take(whichAlgorithmWasChosen, mazeSize_, mazeSize_, packedGrid_))
+        MazeGenerator::generate(parameters, packedGrid_);
+    applyPackedGridToCells();
 }
 
 /*------------------------------------------------------------------------------------------------*/
-void Maze::goRight(Coordinate &currentCoordinates, Coordinate &newCoordinates, bool &cellWasVisitedOnThisStep)
+void Maze::applyPackedGridToCells()
 {
-    newCoordinates.x = newCoordinates.x + 1;
-    if (cellGrid_[newCoordinates.x][newCoordinates.y].isVisited() == false)
+    MAZE_TRACE_ZONE("Maze::applyPackedGridToCells");
+    for (unsigned int x = 0; x < mazeSize_; ++x)
     {
-        cellGrid_[currentCoordinates.x][currentCoordinates.y].destroyRightWall();
-        cellGrid_[newCoordinates.x][newCoordinates.y].destroyLeftWall();
-        cellGrid_[newCoordinates.x][newCoordinates.y].wasVisited();
-        cellWasVisitedOnThisStep = true;
-    }
-}
-
-/*------------------------------------------------------------------------------------------------*/
-void Maze::goBot(Coordinate &currentCoordinates, Coordinate &newCoordinates, bool &cellWasVisitedOnThisStep)
-{
-    newCoordinates.y = newCoordinates.y + 1;
-    if (cellGrid_[newCoordinates.x][newCoordinates.y].isVisited() == false)
-    {
-        cellGrid_[currentCoordinates.x][currentCoordinates.y].destroyBotWall();
-        cellGrid_[newCoordinates.x][newCoordinates.y].destroyTopWall();
-        cellGrid_[newCoordinates.x][newCoordinates.y].wasVisited();
-        cellWasVisitedOnThisStep = true;
+        for (unsigned int y = 0; y < mazeSize_; ++y)
+        {
+            if (packedGrid_.hasPassage(x, y, Direction::Right))
+            {
+                cellGrid_[x][y].destroyRightWall();
+                cellGrid_[x + 1][y].destroyLeftWall();
+            }
+            if (packedGrid_.hasPassage(x, y, Direction::Bot))
+            {
+                cellGrid_[x][y].destroyBotWall();
+                cellGrid_[x][y + 1].destroyTopWall();
+            }
+            cellGrid_[x][y].wasVisited();
+        }
     }
+    appliedSteps_ += mazeSize_ * mazeSize_;
 }
 
 /*------------------------------------------------------------------------------------------------*/
-void Maze::goLeft(Coordinate &currentCoordinates, Coordinate &newCoordinates, bool &cellWasVisitedOnThisStep)
+void Maze::delay(int millisecondsWait)
 {
-    newCoordinates.x = newCoordinates.x - 1;
-    if (cellGrid_[newCoordinates.x][newCoordinates.y].isVisited() == false)
+    MAZE_TRACE_ZONE("Maze::delay");
+    // Ожидание и кадры внутри него не считаются работой со сценой
+    const bool isSceneUpdateTimed = sceneUpdateTimer_.isValid();
+    if (isSceneUpdateTimed)
     {
-        cellGrid_[currentCoordinates.x][currentCoordinates.y].destroyLeftWall();
-        cellGrid_[newCoordinates.x][newCoordinates.y].destroyRightWall();
-        cellGrid_[newCoordinates.x][newCoordinates.y].wasVisited();
-        cellWasVisitedOnThisStep = true;
+        sceneUpdateNs_ += sceneUpdateTimer_.nsecsElapsed();
+        sceneUpdateTimer_.invalidate();
     }
-}
 
-/*------------------------------------------------------------------------------------------------*/
-void Maze::delay(int millisecondsWait)
-{
     QEventLoop loop;
     QTimer t;
     t.connect(&t, &QTimer::timeout, &loop, &QEventLoop::quit);
     t.start(millisecondsWait);
     loop.exec();
+
+    if (isSceneUpdateTimed)
+        sceneUpdateTimer_.start();
 }
 /*void Maze::saveToFile(const QString& filePath) {
     QFile file(filePath);
@@ -452,6 +518,7 @@ void Maze::loadFromFile(const QString& filePath) {
 }*/
 
 void Maze::loadMazeFromFile(const std::string& filePath) {
+    MAZE_TRACE_ZONE("Maze::loadMazeFromFile");
     std::ifstream file(filePath, std::ios::binary);
     if (!file.is_open()) {
         throw std::runtime_error("Unable to open file for reading.");
@@ -471,6 +538,12 @@ void Maze::loadMazeFromFile(const std::string& filePath) {
     unsigned int mazeSize = std::sqrt(mazeData.size() / 2); // Ajustez cette logique selon la structure de votre labyrinthe.
     mazeSize_ = mazeSize;
     unsigned int cellSize = mazeGridSizePx_ / mazeSize_;
+    packedGrid_.resize(mazeSize_, mazeSize_);
+    visitHeatmap_.resize(mazeSize_, mazeSize_);
+    isJunctionGraphStale_ = true;
+    isConnectivityStale_ = true;
+    if (sharedMazePublisher_)
+        sharedMazePublisher_->endWrite(-1, packedGrid_);
 
     for (size_t i = 0; i < mazeData.size(); i += 2) {
         unsigned int row = static_cast<unsigned int>(mazeData[i]);
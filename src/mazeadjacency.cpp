@@ -0,0 +1,354 @@
+#include "mazeadjacency.h"
+#include "tracezones.h"
+
+#include <algorithm>
+#include <bitset>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define MAZE_ADJACENCY_MMAP_SUPPORTED
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Массивы пишутся и отображаются как есть, поэтому порядок байт хоста должен совпадать с файлом
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define MAZE_ADJACENCY_BIG_ENDIAN_HOST
+#endif
+
+const char MazeAdjacency::MAGIC[4] {'A', 'M', 'Z', 'J'};
+
+namespace
+{
+void putUint(unsigned char *destination, std::uint64_t value, std::size_t byteCount)
+{
+    for (std::size_t byte = 0; byte < byteCount; ++byte)
+        destination[byte] = static_cast<unsigned char>(value >> (byte * 8));
+}
+
+std::uint64_t getUint(const unsigned char *source, std::size_t byteCount)
+{
+    std::uint64_t value {0};
+    for (std::size_t byte = 0; byte < byteCount; ++byte)
+        value |= std::uint64_t(source[byte]) << (byte * 8);
+    return value;
+}
+
+std::size_t popcount(std::uint64_t word)
+{
+    return std::bitset<64>(word).count();
+}
+}
+
+bool MazeAdjacency::build(const PackedMazeGrid &grid, unsigned int threadCount)
+{
+    MAZE_TRACE_ZONE("MazeAdjacency::build");
+    width_ = 0;
+    height_ = 0;
+    offsets_.clear();
+    neighbors_.clear();
+    if (grid.getCellCount() > std::numeric_limits<std::uint32_t>::max())
+        return false;
+
+    width_ = grid.getWidth();
+    height_ = grid.getHeight();
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    const std::size_t maxThreads = std::max<std::size_t>(1, grid.getCellCount() / MIN_CELLS_PER_THREAD);
+    const std::size_t chunkCount = std::min<std::size_t>({threadCount, maxThreads, std::max<std::size_t>(1, height_)});
+    const std::size_t rowsPerChunk = (height_ + chunkCount - 1) / std::max<std::size_t>(1, chunkCount);
+
+    // Поток 0 - вызывающий, остальные строки раздаются запущенным потокам
+    const auto forEachChunk = [&](const std::function<void(std::size_t, std::size_t)> &work) {
+        std::vector<std::thread> threads;
+        for (std::size_t chunk = 1; chunk < chunkCount; ++chunk)
+        {
+            const std::size_t firstRow = std::min(height_, chunk * rowsPerChunk);
+            threads.emplace_back(work, firstRow, std::min(height_, firstRow + rowsPerChunk));
+        }
+        work(0, std::min(height_, rowsPerChunk));
+        for (std::thread &thread : threads)
+            thread.join();
+    };
+
+    std::vector<std::uint64_t> rowEntries(height_ + 1, 0);
+    forEachChunk([this, &grid, &rowEntries](std::size_t firstRow, std::size_t endRow) {
+        countRowEntries(grid, firstRow, endRow, rowEntries);
+    });
+    // Префиксная сумма по строкам: rowEntries[y] - позиция первой записи строки y в neighbors
+    std::uint64_t entryCount {0};
+    for (std::size_t row = 0; row <= height_; ++row)
+    {
+        const std::uint64_t rowCount = rowEntries[row];
+        rowEntries[row] = entryCount;
+        entryCount += rowCount;
+    }
+
+    offsets_.resize(grid.getCellCount() + 1);
+    neighbors_.resize(static_cast<std::size_t>(entryCount));
+    forEachChunk([this, &grid, &rowEntries](std::size_t firstRow, std::size_t endRow) {
+        fillRows(grid, firstRow, endRow, rowEntries);
+    });
+    offsets_.back() = entryCount;
+    return true;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeAdjacency::countRowEntries(const PackedMazeGrid &grid, std::size_t firstRow, std::size_t endRow,
+                                    std::vector<std::uint64_t> &rowEntries) const
+{
+    MAZE_TRACE_ZONE("MazeAdjacency::countRowEntries");
+    // Проход вправо дает по записи обоим концам в строке, проход вниз - верхнему концу здесь и
+    // нижнему в следующей строке
+    for (std::size_t row = firstRow; row < endRow; ++row)
+    {
+        const std::uint64_t *right = grid.getRightRow(row);
+        const std::uint64_t *bot = row + 1 < height_ ? grid.getBotRow(row) : nullptr;
+        const std::uint64_t *botAbove = row > 0 ? grid.getBotRow(row - 1) : nullptr;
+        std::uint64_t entries {0};
+        for (std::size_t word = 0; word < grid.getWordsPerRow(); ++word)
+        {
+            entries += 2 * popcount(right[word] & grid.getRightRowMask(word));
+            if (bot)
+                entries += popcount(bot[word] & grid.getRowMask(word));
+            if (botAbove)
+                entries += popcount(botAbove[word] & grid.getRowMask(word));
+        }
+        rowEntries[row] = entries;
+    }
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeAdjacency::fillRows(const PackedMazeGrid &grid, std::size_t firstRow, std::size_t endRow,
+                             const std::vector<std::uint64_t> &rowEntries)
+{
+    MAZE_TRACE_ZONE("MazeAdjacency::fillRows");
+    const std::uint32_t width = static_cast<std::uint32_t>(width_);
+    for (std::size_t row = firstRow; row < endRow; ++row)
+    {
+        const std::uint64_t *right = grid.getRightRow(row);
+        const std::uint64_t *bot = row + 1 < height_ ? grid.getBotRow(row) : nullptr;
+        const std::uint64_t *botAbove = row > 0 ? grid.getBotRow(row - 1) : nullptr;
+        std::uint64_t entry = rowEntries[row];
+        std::uint32_t node = static_cast<std::uint32_t>(row * width_);
+        // Бит прохода влево из x - это бит прохода вправо из x - 1, переносится между словами
+        bool hasLeft {false};
+        for (std::size_t word = 0; word < grid.getWordsPerRow(); ++word)
+        {
+            const std::uint64_t rightWord = right[word] & grid.getRightRowMask(word);
+            const std::uint64_t botWord = bot ? bot[word] & grid.getRowMask(word) : 0;
+            const std::uint64_t topWord = botAbove ? botAbove[word] & grid.getRowMask(word) : 0;
+            const std::size_t bitCount = std::min<std::size_t>(PackedMazeGrid::BITS_PER_WORD,
+                                                               width_ - word * PackedMazeGrid::BITS_PER_WORD);
+            for (std::size_t bit = 0; bit < bitCount; ++bit, ++node)
+            {
+                offsets_[node] = entry;
+                if ((topWord >> bit) & 1)
+                    neighbors_[entry++] = node - width;
+                if (hasLeft)
+                    neighbors_[entry++] = node - 1;
+                hasLeft = (rightWord >> bit) & 1;
+                if (hasLeft)
+                    neighbors_[entry++] = node + 1;
+                if ((botWord >> bit) & 1)
+                    neighbors_[entry++] = node + width;
+            }
+        }
+    }
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::size_t MazeAdjacency::getWidth() const
+{
+    return width_;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::size_t MazeAdjacency::getHeight() const
+{
+    return height_;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::size_t MazeAdjacency::getNodeCount() const
+{
+    return width_ * height_;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::size_t MazeAdjacency::getEntryCount() const
+{
+    return neighbors_.size();
+}
+
+/*------------------------------------------------------------------------------------------------*/
+const std::uint64_t* MazeAdjacency::getOffsets() const
+{
+    return offsets_.data();
+}
+
+/*------------------------------------------------------------------------------------------------*/
+const std::uint32_t* MazeAdjacency::getNeighbors() const
+{
+    return neighbors_.data();
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool MazeAdjacency::writeToFile(const std::string &filePath) const
+{
+    MAZE_TRACE_ZONE("MazeAdjacency::writeToFile");
+#ifdef MAZE_ADJACENCY_BIG_ENDIAN_HOST
+    (void)filePath;
+    return false;
+#else
+    if (offsets_.empty())
+        return false;
+    std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+    if (!file)
+        return false;
+
+    unsigned char header[HEADER_SIZE] {};
+    std::memcpy(header, MAGIC, sizeof(MAGIC));
+    putUint(header + 4, VERSION, 4);
+    putUint(header + 8, width_, 4);
+    putUint(header + 12, height_, 4);
+    putUint(header + 16, getNodeCount(), 8);
+    putUint(header + 24, neighbors_.size(), 8);
+    file.write(reinterpret_cast<const char*>(header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(offsets_.data()), offsets_.size() * sizeof(std::uint64_t));
+    file.write(reinterpret_cast<const char*>(neighbors_.data()), neighbors_.size() * sizeof(std::uint32_t));
+    return static_cast<bool>(file.flush());
+#endif
+}
+
+/*------------------------------------------------------------------------------------------------*/
+MazeAdjacencyView::~MazeAdjacencyView()
+{
+    close();
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool MazeAdjacencyView::open(const std::string &filePath)
+{
+    close();
+#if defined(MAZE_ADJACENCY_BIG_ENDIAN_HOST)
+    (void)filePath;
+    return false;
+#elif defined(MAZE_ADJACENCY_MMAP_SUPPORTED)
+    const int descriptor = ::open(filePath.c_str(), O_RDONLY);
+    if (descriptor < 0)
+        return false;
+    struct stat fileStatus;
+    if (fstat(descriptor, &fileStatus) != 0 || fileStatus.st_size < off_t(MazeAdjacency::HEADER_SIZE))
+    {
+        ::close(descriptor);
+        return false;
+    }
+    size_ = static_cast<std::size_t>(fileStatus.st_size);
+    void *mapping = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    // Отображение живет и после закрытия дескриптора
+    ::close(descriptor);
+    if (mapping == MAP_FAILED)
+    {
+        size_ = 0;
+        return false;
+    }
+    mapping_ = mapping;
+    data_ = static_cast<const std::uint8_t*>(mapping);
+#else
+    std::ifstream file(filePath, std::ios::binary | std::ios::ate);
+    if (!file)
+        return false;
+    size_ = static_cast<std::size_t>(file.tellg());
+    // Буфер из 64-битных слов, чтобы offsets были выровнены так же, как в отображении
+    fileData_.resize((size_ + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t));
+    file.seekg(0);
+    if (size_ < MazeAdjacency::HEADER_SIZE || !file.read(reinterpret_cast<char*>(fileData_.data()), size_))
+    {
+        close();
+        return false;
+    }
+    data_ = reinterpret_cast<const std::uint8_t*>(fileData_.data());
+#endif
+
+    width_ = static_cast<std::size_t>(getUint(data_ + 8, 4));
+    height_ = static_cast<std::size_t>(getUint(data_ + 12, 4));
+    const std::uint64_t nodeCount = getUint(data_ + 16, 8);
+    const std::uint64_t entryCount = getUint(data_ + 24, 8);
+    // Сначала число вершин, чтобы размеры массивов ниже не переполнялись
+    const std::uint64_t maxNodes = std::numeric_limits<std::uint32_t>::max();
+    const bool isValid = std::memcmp(data_, MazeAdjacency::MAGIC, sizeof(MazeAdjacency::MAGIC)) == 0 &&
+            getUint(data_ + 4, 4) == MazeAdjacency::VERSION &&
+            nodeCount == std::uint64_t(width_) * height_ && nodeCount <= maxNodes &&
+            entryCount <= 4 * maxNodes &&
+            MazeAdjacency::HEADER_SIZE + (nodeCount + 1) * sizeof(std::uint64_t) +
+            entryCount * sizeof(std::uint32_t) <= size_;
+    if (!isValid)
+    {
+        close();
+        return false;
+    }
+    nodeCount_ = static_cast<std::size_t>(nodeCount);
+    entryCount_ = static_cast<std::size_t>(entryCount);
+    return true;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeAdjacencyView::close()
+{
+#ifdef MAZE_ADJACENCY_MMAP_SUPPORTED
+    if (mapping_)
+        munmap(mapping_, size_);
+#endif
+    mapping_ = nullptr;
+    fileData_.clear();
+    data_ = nullptr;
+    size_ = 0;
+    width_ = 0;
+    height_ = 0;
+    nodeCount_ = 0;
+    entryCount_ = 0;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::size_t MazeAdjacencyView::getWidth() const
+{
+    return width_;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::size_t MazeAdjacencyView::getHeight() const
+{
+    return height_;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::size_t MazeAdjacencyView::getNodeCount() const
+{
+    return nodeCount_;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::size_t MazeAdjacencyView::getEntryCount() const
+{
+    return entryCount_;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+const std::uint64_t* MazeAdjacencyView::getOffsets() const
+{
+    return data_ ? reinterpret_cast<const std::uint64_t*>(data_ + MazeAdjacency::HEADER_SIZE) : nullptr;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+const std::uint32_t* MazeAdjacencyView::getNeighbors() const
+{
+    return data_ ? reinterpret_cast<const std::uint32_t*>(data_ + MazeAdjacency::HEADER_SIZE +
+                                                          (nodeCount_ + 1) * sizeof(std::uint64_t)) : nullptr;
+}
@@ -0,0 +1,83 @@
+#include "mazeanalyzer.h"
+
+#include <bitset>
+
+/*------------------------------------------------------------------------------------------------*/
+std::vector<std::uint32_t> MazeAnalyzer::findPath(const PackedMazeGrid &grid, std::size_t fromCell, std::size_t toCell)
+{
+    const std::size_t width = grid.getWidth();
+    const std::size_t cellCount = grid.getCellCount();
+    std::vector<std::uint32_t> path;
+    if (fromCell >= cellCount || toCell >= cellCount)
+        return path;
+
+    // Обход в ширину от toCell, чтобы путь по ссылкам на родителя сразу шел от fromCell
+    const std::uint32_t NOT_REACHED {0xFFFFFFFF};
+    std::vector<std::uint32_t> parents(cellCount, NOT_REACHED);
+    std::vector<std::uint32_t> queue {static_cast<std::uint32_t>(toCell)};
+    parents[toCell] = static_cast<std::uint32_t>(toCell);
+
+    for (std::size_t head = 0; head < queue.size() && parents[fromCell] == NOT_REACHED; ++head)
+    {
+        const std::uint32_t cell = queue[head];
+        const std::size_t x = cell % width;
+        const std::size_t y = cell / width;
+        const std::uint32_t neighbors[PackedMazeGrid::Direction::Count]
+            {static_cast<std::uint32_t>(cell - width), cell + 1, static_cast<std::uint32_t>(cell + width), cell - 1};
+
+        for (int direction = 0; direction < PackedMazeGrid::Direction::Count; ++direction)
+        {
+            if (grid.hasPassage(x, y, direction) && parents[neighbors[direction]] == NOT_REACHED)
+            {
+                parents[neighbors[direction]] = cell;
+                queue.push_back(neighbors[direction]);
+            }
+        }
+    }
+
+    if (parents[fromCell] == NOT_REACHED)
+        return path;
+    for (std::uint32_t cell = static_cast<std::uint32_t>(fromCell); cell != toCell; cell = parents[cell])
+        path.push_back(cell);
+    path.push_back(static_cast<std::uint32_t>(toCell));
+    return path;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+MazeAnalyzer::Statistics MazeAnalyzer::computeStatistics(const PackedMazeGrid &grid)
+{
+    /* Число проходов считается сразу для 64 клеток: четыре слова (вправо, влево, вниз, вверх)
+     * складываются побитовыми сумматорами в разряды ones, twos и fours */
+    Statistics statistics;
+    const std::size_t wordsPerRow = grid.getWordsPerRow();
+    for (std::size_t row = 0; row < grid.getHeight(); ++row)
+    {
+        const std::uint64_t *rightRow = grid.getRightRow(row);
+        const std::uint64_t *botRow = grid.getBotRow(row);
+        const std::uint64_t *topRow = row > 0 ? grid.getBotRow(row - 1) : nullptr;
+
+        for (std::size_t word = 0; word < wordsPerRow; ++word)
+        {
+            const std::uint64_t right = rightRow[word];
+            const std::uint64_t left = (right << 1) | (word > 0 ? rightRow[word - 1] >> 63 : 0);
+            const std::uint64_t bot = botRow[word];
+            const std::uint64_t top = topRow ? topRow[word] : 0;
+
+            const std::uint64_t horizontalOnes = right ^ left;
+            const std::uint64_t horizontalTwos = right & left;
+            const std::uint64_t verticalOnes = bot ^ top;
+            const std::uint64_t verticalTwos = bot & top;
+            const std::uint64_t ones = horizontalOnes ^ verticalOnes;
+            const std::uint64_t onesCarry = horizontalOnes & verticalOnes;
+            const std::uint64_t twos = horizontalTwos ^ verticalTwos ^ onesCarry;
+            const std::uint64_t fours = (horizontalTwos & verticalTwos) | (horizontalTwos & onesCarry) |
+                    (verticalTwos & onesCarry);
+
+            const std::uint64_t rowMask = grid.getRowMask(word);
+            statistics.deadEnds += std::bitset<64>(ones & ~twos & ~fours & rowMask).count();
+            statistics.corridors += std::bitset<64>(~ones & twos & ~fours & rowMask).count();
+            statistics.junctions += std::bitset<64>(((ones & twos) | fours) & rowMask).count();
+        }
+    }
+    return statistics;
+}
@@ -0,0 +1,576 @@
+#include "mazeanimationexporter.h"
+#include "tracezones.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+
+namespace
+{
+const unsigned int GIF_MIN_CODE_SIZE {2};
+const unsigned int GIF_MAX_CODE {4095};
+const std::uint8_t PALETTE[4][3] {{0xFF, 0xFF, 0xFF}, {0x00, 0x00, 0x00}, {0x80, 0x80, 0x80}, {0xFF, 0xFF, 0xFF}};
+
+// Длины для кодов 257-285 deflate и число их дополнительных битов
+const unsigned int DEFLATE_LENGTH_BASES[29] {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                             35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+const unsigned int DEFLATE_LENGTH_EXTRA_BITS[29] {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                                  3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+const unsigned int DEFLATE_MIN_MATCH {3};
+const unsigned int DEFLATE_MAX_MATCH {258};
+
+void putUint16(std::string &bytes, std::uint32_t value)
+{
+    bytes += static_cast<char>(value & 0xFF);
+    bytes += static_cast<char>((value >> 8) & 0xFF);
+}
+
+void putUint32BigEndian(std::string &bytes, std::uint32_t value)
+{
+    for (int shift = 24; shift >= 0; shift -= 8)
+        bytes += static_cast<char>((value >> shift) & 0xFF);
+}
+
+// Биты младшими вперед, как их читают и LZW в GIF, и deflate
+class BitWriter
+{
+private:
+    std::string &bytes_;
+    std::uint32_t bitBuffer_ {};
+    unsigned int bitCount_ {};
+
+public:
+    explicit BitWriter(std::string &bytes)
+        : bytes_(bytes)
+    {
+    }
+
+    void write(std::uint32_t value, unsigned int bitCount)
+    {
+        bitBuffer_ |= value << bitCount_;
+        bitCount_ += bitCount;
+        while (bitCount_ >= 8)
+        {
+            bytes_ += static_cast<char>(bitBuffer_ & 0xFF);
+            bitBuffer_ >>= 8;
+            bitCount_ -= 8;
+        }
+    }
+
+    // Коды Хаффмана deflate пишутся старшим битом вперед
+    void writeReversed(std::uint32_t code, unsigned int bitCount)
+    {
+        std::uint32_t reversed {0};
+        for (unsigned int bit = 0; bit < bitCount; ++bit)
+            reversed |= ((code >> bit) & 1) << (bitCount - 1 - bit);
+        write(reversed, bitCount);
+    }
+
+    void flush()
+    {
+        if (bitCount_ > 0)
+            bytes_ += static_cast<char>(bitBuffer_ & 0xFF);
+        bitBuffer_ = 0;
+        bitCount_ = 0;
+    }
+};
+
+// Словарь LZW хранится деревом: у каждого кода по ребенку на каждый из четырех цветов
+std::string encodeGifLzw(const std::vector<std::uint8_t> &pixels)
+{
+    const std::uint32_t clearCode = 1u << GIF_MIN_CODE_SIZE;
+    std::string codes;
+    BitWriter writer(codes);
+    std::vector<std::uint16_t> children((GIF_MAX_CODE + 1) * 4, 0);
+    unsigned int codeSize = GIF_MIN_CODE_SIZE + 1;
+    std::uint32_t maxCode = clearCode + 1;
+
+    writer.write(clearCode, codeSize);
+    std::uint32_t prefix = pixels[0];
+    for (std::size_t pixel = 1; pixel < pixels.size(); ++pixel)
+    {
+        const std::uint8_t color = pixels[pixel];
+        const std::uint16_t child = children[prefix * 4 + color];
+        if (child != 0)
+        {
+            prefix = child;
+            continue;
+        }
+        writer.write(prefix, codeSize);
+        children[prefix * 4 + color] = static_cast<std::uint16_t>(++maxCode);
+        if (maxCode >= (1u << codeSize))
+            ++codeSize;
+        if (maxCode == GIF_MAX_CODE)
+        {
+            writer.write(clearCode, codeSize);
+            std::fill(children.begin(), children.end(), 0);
+            codeSize = GIF_MIN_CODE_SIZE + 1;
+            maxCode = clearCode + 1;
+        }
+        prefix = color;
+    }
+    writer.write(prefix, codeSize);
+    writer.write(clearCode + 1, codeSize);
+    writer.flush();
+    return codes;
+}
+
+std::vector<std::uint32_t> makeCrc32Table()
+{
+    std::vector<std::uint32_t> table(256);
+    for (std::uint32_t value = 0; value < 256; ++value)
+    {
+        std::uint32_t crc = value;
+        for (int bit = 0; bit < 8; ++bit)
+            crc = crc & 1 ? 0xEDB88320 ^ (crc >> 1) : crc >> 1;
+        table[value] = crc;
+    }
+    return table;
+}
+
+std::uint32_t computeCrc32(const std::string &bytes, std::size_t first)
+{
+    static const std::vector<std::uint32_t> table = makeCrc32Table();
+    std::uint32_t crc {0xFFFFFFFF};
+    for (std::size_t byte = first; byte < bytes.size(); ++byte)
+        crc = table[(crc ^ static_cast<std::uint8_t>(bytes[byte])) & 0xFF] ^ (crc >> 8);
+    return crc ^ 0xFFFFFFFF;
+}
+
+// Кусок PNG: длина, тип, данные и CRC типа с данными
+void appendPngChunk(std::string &png, const char *type, const std::string &data)
+{
+    putUint32BigEndian(png, static_cast<std::uint32_t>(data.size()));
+    const std::size_t typeStart = png.size();
+    png += type;
+    png += data;
+    putUint32BigEndian(png, computeCrc32(png, typeStart));
+}
+
+void writeDeflateLiteralOrLength(BitWriter &writer, unsigned int symbol)
+{
+    if (symbol < 144)
+        writer.writeReversed(0x30 + symbol, 8);
+    else if (symbol < 256)
+        writer.writeReversed(0x190 + symbol - 144, 9);
+    else if (symbol < 280)
+        writer.writeReversed(symbol - 256, 7);
+    else
+        writer.writeReversed(0xC0 + symbol - 280, 8);
+}
+
+void writeDeflateMatch(BitWriter &writer, unsigned int length)
+{
+    unsigned int code = 28;
+    while (DEFLATE_LENGTH_BASES[code] > length)
+        --code;
+    writeDeflateLiteralOrLength(writer, 257 + code);
+    writer.write(length - DEFLATE_LENGTH_BASES[code], DEFLATE_LENGTH_EXTRA_BITS[code]);
+    // Расстояние 1: код 0 из пяти битов без дополнительных
+    writer.writeReversed(0, 5);
+}
+
+/* zlib-поток из одного блока deflate с фиксированным Хаффманом: повтор предыдущего байта пишется
+ * ссылкой на расстояние 1. После фильтра Up неизменные части строк - длинные серии нулей */
+std::string deflateRuns(const std::vector<std::uint8_t> &data)
+{
+    std::string stream;
+    stream += static_cast<char>(0x78);
+    stream += static_cast<char>(0x01);
+    BitWriter writer(stream);
+    writer.write(1, 1);
+    writer.write(1, 2);
+    std::size_t position {0};
+    while (position < data.size())
+    {
+        writeDeflateLiteralOrLength(writer, data[position]);
+        std::size_t runEnd = position + 1;
+        while (runEnd < data.size() && data[runEnd] == data[position])
+            ++runEnd;
+        std::size_t repeats = runEnd - position - 1;
+        while (repeats >= DEFLATE_MIN_MATCH)
+        {
+            const unsigned int length = static_cast<unsigned int>(std::min<std::size_t>(repeats, DEFLATE_MAX_MATCH));
+            writeDeflateMatch(writer, length);
+            repeats -= length;
+        }
+        for (; repeats > 0; --repeats)
+            writeDeflateLiteralOrLength(writer, data[position]);
+        position = runEnd;
+    }
+    writeDeflateLiteralOrLength(writer, 256);
+    writer.flush();
+
+    std::uint32_t sum1 {1};
+    std::uint32_t sum2 {0};
+    for (std::uint8_t byte : data)
+    {
+        sum1 = (sum1 + byte) % 65521;
+        sum2 = (sum2 + sum1) % 65521;
+    }
+    putUint32BigEndian(stream, (sum2 << 16) | sum1);
+    return stream;
+}
+
+std::string encodePng(const std::vector<std::uint8_t> &pixels, std::size_t width, std::size_t height)
+{
+    std::string png("\x89PNG\r\n\x1A\n", 8);
+    std::string header;
+    putUint32BigEndian(header, static_cast<std::uint32_t>(width));
+    putUint32BigEndian(header, static_cast<std::uint32_t>(height));
+    // 8 бит на индекс палитры, тип цвета 3 - палитра
+    header += std::string("\x08\x03\x00\x00\x00", 5);
+    appendPngChunk(png, "IHDR", header);
+
+    std::string palette;
+    for (const std::uint8_t *color : PALETTE)
+        palette.append(reinterpret_cast<const char*>(color), 3);
+    appendPngChunk(png, "PLTE", palette);
+
+    // Фильтр Up: байт строки минус байт над ним, первая строка без фильтра
+    std::vector<std::uint8_t> filtered;
+    filtered.reserve((width + 1) * height);
+    for (std::size_t y = 0; y < height; ++y)
+    {
+        filtered.push_back(y == 0 ? 0 : 2);
+        for (std::size_t x = 0; x < width; ++x)
+        {
+            const std::uint8_t above = y == 0 ? 0 : pixels[(y - 1) * width + x];
+            filtered.push_back(static_cast<std::uint8_t>(pixels[y * width + x] - above));
+        }
+    }
+    appendPngChunk(png, "IDAT", deflateRuns(filtered));
+    appendPngChunk(png, "IEND", std::string());
+    return png;
+}
+
+void getNeighbor(std::size_t x, std::size_t y, int direction, std::size_t &neighborX, std::size_t &neighborY)
+{
+    neighborX = x;
+    neighborY = y;
+    switch (direction)
+    {
+    case PackedMazeGrid::Direction::Top :
+        --neighborY;
+        break;
+    case PackedMazeGrid::Direction::Right :
+        ++neighborX;
+        break;
+    case PackedMazeGrid::Direction::Bot :
+        ++neighborY;
+        break;
+    case PackedMazeGrid::Direction::Left :
+        --neighborX;
+        break;
+    }
+}
+}
+
+MazeAnimationExporter::MazeAnimationExporter(const Settings &settings) noexcept
+    : settings_(settings)
+{
+    settings_.stepsPerFrame = std::max<std::size_t>(1, settings_.stepsPerFrame);
+    settings_.cellPixels = std::max(2u, settings_.cellPixels);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool MazeAnimationExporter::isSupported(int algorithm)
+{
+    return MazeStepGenerator::isSupported(algorithm);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+MazeAnimationExporter::Statistics MazeAnimationExporter::getStatistics() const
+{
+    return statistics_;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeAnimationExporter::fillRect(std::size_t left, std::size_t top, std::size_t width, std::size_t height,
+                                     std::uint8_t color)
+{
+    for (std::size_t y = top; y < top + height; ++y)
+        std::fill_n(image_.begin() + y * imageWidth_ + left, width, color);
+
+    if (!isDirty_)
+    {
+        dirtyLeft_ = left;
+        dirtyTop_ = top;
+        dirtyRight_ = left + width;
+        dirtyBottom_ = top + height;
+        isDirty_ = true;
+        return;
+    }
+    dirtyLeft_ = std::min(dirtyLeft_, left);
+    dirtyTop_ = std::min(dirtyTop_, top);
+    dirtyRight_ = std::max(dirtyRight_, left + width);
+    dirtyBottom_ = std::max(dirtyBottom_, top + height);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeAnimationExporter::setPassage(std::size_t x, std::size_t y, int direction, bool isOpen)
+{
+    // Проход вверх и влево - это проход вниз и вправо из соседа; углы стен не трогаются
+    const std::size_t cellPixels = settings_.cellPixels;
+    if (direction == PackedMazeGrid::Direction::Top || direction == PackedMazeGrid::Direction::Left)
+    {
+        getNeighbor(x, y, direction, x, y);
+        direction = direction == PackedMazeGrid::Direction::Top ? PackedMazeGrid::Direction::Bot :
+                                                                  PackedMazeGrid::Direction::Right;
+    }
+    const std::uint8_t color = isOpen ? Color::Background : Color::Wall;
+    if (direction == PackedMazeGrid::Direction::Right)
+        fillRect((x + 1) * cellPixels, y * cellPixels + 1, 1, cellPixels - 1, color);
+    else
+        fillRect(x * cellPixels + 1, (y + 1) * cellPixels, cellPixels - 1, 1, color);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeAnimationExporter::setCurrentCell(std::size_t x, std::size_t y)
+{
+    clearCurrentCell();
+    const std::size_t cellPixels = settings_.cellPixels;
+    fillRect(x * cellPixels + 1, y * cellPixels + 1, cellPixels - 1, cellPixels - 1, Color::CurrentCell);
+    currentX_ = x;
+    currentY_ = y;
+    hasCurrentCell_ = true;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeAnimationExporter::clearCurrentCell()
+{
+    if (!hasCurrentCell_)
+        return;
+    const std::size_t cellPixels = settings_.cellPixels;
+    fillRect(currentX_ * cellPixels + 1, currentY_ * cellPixels + 1, cellPixels - 1, cellPixels - 1, Color::Background);
+    hasCurrentCell_ = false;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeAnimationExporter::applyStep(const MazeStepGenerator::Step &step)
+{
+    // Как Maze::applyGenerationStep: возврат Recursive Backtracker из тупика без подсветки
+    std::size_t neighborX {};
+    std::size_t neighborY {};
+    getNeighbor(step.x, step.y, step.direction, neighborX, neighborY);
+    switch (step.type)
+    {
+    case MazeStepGenerator::StepType::Start :
+        setCurrentCell(step.x, step.y);
+        break;
+    case MazeStepGenerator::StepType::Carve :
+        setPassage(step.x, step.y, step.direction, true);
+        setCurrentCell(neighborX, neighborY);
+        break;
+    case MazeStepGenerator::StepType::Move :
+        setCurrentCell(neighborX, neighborY);
+        break;
+    case MazeStepGenerator::StepType::Erase :
+        setPassage(step.x, step.y, step.direction, false);
+        setCurrentCell(neighborX, neighborY);
+        break;
+    case MazeStepGenerator::StepType::Retreat :
+        clearCurrentCell();
+        break;
+    }
+}
+
+/*------------------------------------------------------------------------------------------------*/
+MazeAnimationExporter::Frame MazeAnimationExporter::takeFrame(bool isFullFrame, bool isTransparent,
+                                                              unsigned int delayMs)
+{
+    Frame frame;
+    frame.delayMs = delayMs;
+    if (isFullFrame || !isDirty_)
+    {
+        // Без изменений кадр GIF - один прозрачный пиксель, который только держит задержку
+        frame.width = isFullFrame ? imageWidth_ : 1;
+        frame.height = isFullFrame ? imageHeight_ : 1;
+    }
+    else
+    {
+        frame.left = dirtyLeft_;
+        frame.top = dirtyTop_;
+        frame.width = dirtyRight_ - dirtyLeft_;
+        frame.height = dirtyBottom_ - dirtyTop_;
+    }
+
+    frame.pixels.resize(frame.width * frame.height);
+    for (std::size_t y = 0; y < frame.height; ++y)
+    {
+        const std::size_t rowStart = (frame.top + y) * imageWidth_ + frame.left;
+        for (std::size_t x = 0; x < frame.width; ++x)
+        {
+            const std::uint8_t color = image_[rowStart + x];
+            const bool isUnchanged = isTransparent && previousImage_[rowStart + x] == color;
+            frame.pixels[y * frame.width + x] = isUnchanged ? static_cast<std::uint8_t>(Color::Transparent) : color;
+        }
+        if (isTransparent)
+            std::copy_n(image_.begin() + rowStart, frame.width, previousImage_.begin() + rowStart);
+    }
+    isDirty_ = false;
+    return frame;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeAnimationExporter::pushFrame(Frame &&frame)
+{
+    std::unique_lock<std::mutex> lock(queueMutex_);
+    queueCondition_.wait(lock, [this]() { return frameQueue_.size() < MAX_QUEUED_FRAMES; });
+    frameQueue_.push_back(std::move(frame));
+    queueCondition_.notify_all();
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool MazeAnimationExporter::popFrame(Frame &frame)
+{
+    std::unique_lock<std::mutex> lock(queueMutex_);
+    queueCondition_.wait(lock, [this]() { return !frameQueue_.empty() || isProducerFinished_; });
+    if (frameQueue_.empty())
+        return false;
+    frame = std::move(frameQueue_.front());
+    frameQueue_.pop_front();
+    queueCondition_.notify_all();
+    return true;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool MazeAnimationExporter::run(bool isGif, const std::function<bool(const Frame&)> &encode)
+{
+    MAZE_TRACE_ZONE("MazeAnimationExporter::run");
+    statistics_ = Statistics();
+    if (!isSupported(settings_.algorithm) || settings_.width == 0 || settings_.height == 0)
+        return false;
+
+    // Сначала пустое поле: все стены на месте
+    const std::size_t cellPixels = settings_.cellPixels;
+    imageWidth_ = settings_.width * cellPixels + 1;
+    imageHeight_ = settings_.height * cellPixels + 1;
+    image_.assign(imageWidth_ * imageHeight_, Color::Background);
+    for (std::size_t y = 0; y <= settings_.height; ++y)
+        std::fill_n(image_.begin() + y * cellPixels * imageWidth_, imageWidth_, Color::Wall);
+    for (std::size_t y = 0; y < imageHeight_; ++y)
+    {
+        for (std::size_t x = 0; x <= settings_.width; ++x)
+            image_[y * imageWidth_ + x * cellPixels] = Color::Wall;
+    }
+    previousImage_ = isGif ? image_ : std::vector<std::uint8_t>();
+    isDirty_ = false;
+    hasCurrentCell_ = false;
+    frameQueue_.clear();
+    isProducerFinished_ = false;
+
+    // При ошибке записи кодировщик продолжает разбирать очередь, чтобы генерация не встала
+    std::atomic<bool> isEncodeFailed {false};
+    std::thread encoder([this, &encode, &isEncodeFailed]() {
+        Frame frame;
+        while (popFrame(frame))
+        {
+            if (!isEncodeFailed && !encode(frame))
+                isEncodeFailed = true;
+        }
+    });
+
+    pushFrame(takeFrame(true, false, settings_.frameDelayMs));
+    MazeStepGenerator generator(settings_.algorithm, settings_.width, settings_.height, settings_.seed);
+    while (!isEncodeFailed)
+    {
+        const std::size_t steps = generator.advance(settings_.stepsPerFrame,
+                                                    [this](const MazeStepGenerator::Step &step) { applyStep(step); });
+        statistics_.steps += steps;
+        if (steps == 0)
+            break;
+        if (isDirty_)
+            pushFrame(takeFrame(!isGif, isGif, settings_.frameDelayMs));
+    }
+    clearCurrentCell();
+    pushFrame(takeFrame(!isGif, isGif, settings_.finalFrameDelayMs));
+
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        isProducerFinished_ = true;
+    }
+    queueCondition_.notify_all();
+    encoder.join();
+    return !isEncodeFailed;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool MazeAnimationExporter::writeGif(const std::string &filePath)
+{
+    MAZE_TRACE_ZONE("MazeAnimationExporter::writeGif");
+    // Размеры экрана и кадров в GIF - 16-битные
+    if (settings_.width * settings_.cellPixels >= 0xFFFF || settings_.height * settings_.cellPixels >= 0xFFFF)
+        return false;
+    std::ofstream output(filePath, std::ios::binary | std::ios::trunc);
+    if (!output)
+        return false;
+
+    bool isHeaderWritten {false};
+    const auto encode = [this, &output, &isHeaderWritten](const Frame &frame) {
+        std::string bytes;
+        if (!isHeaderWritten)
+        {
+            // Логический экран, глобальная палитра на 4 цвета и расширение NETSCAPE2.0 для повтора
+            bytes += "GIF89a";
+            putUint16(bytes, static_cast<std::uint32_t>(imageWidth_));
+            putUint16(bytes, static_cast<std::uint32_t>(imageHeight_));
+            bytes += std::string("\xF1\x00\x00", 3);
+            for (const std::uint8_t *color : PALETTE)
+                bytes.append(reinterpret_cast<const char*>(color), 3);
+            bytes += std::string("\x21\xFF\x0BNETSCAPE2.0\x03\x01\x00\x00\x00", 19);
+            isHeaderWritten = true;
+        }
+
+        // Кадр остается под следующим (disposal 1), индекс Transparent прозрачен
+        bytes += std::string("\x21\xF9\x04\x05", 4);
+        putUint16(bytes, (frame.delayMs + 5) / 10);
+        bytes += static_cast<char>(Color::Transparent);
+        bytes += '\0';
+        bytes += '\x2C';
+        putUint16(bytes, static_cast<std::uint32_t>(frame.left));
+        putUint16(bytes, static_cast<std::uint32_t>(frame.top));
+        putUint16(bytes, static_cast<std::uint32_t>(frame.width));
+        putUint16(bytes, static_cast<std::uint32_t>(frame.height));
+        bytes += '\0';
+        bytes += static_cast<char>(GIF_MIN_CODE_SIZE);
+        const std::string codes = encodeGifLzw(frame.pixels);
+        for (std::size_t blockStart = 0; blockStart < codes.size(); blockStart += 255)
+        {
+            const std::size_t blockSize = std::min<std::size_t>(255, codes.size() - blockStart);
+            bytes += static_cast<char>(blockSize);
+            bytes.append(codes, blockStart, blockSize);
+        }
+        bytes += '\0';
+
+        output.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        statistics_.bytesWritten += bytes.size();
+        ++statistics_.frames;
+        return static_cast<bool>(output);
+    };
+
+    if (!run(true, encode))
+        return false;
+    output.put('\x3B');
+    ++statistics_.bytesWritten;
+    return static_cast<bool>(output.flush());
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool MazeAnimationExporter::writePngSequence(const std::string &pathPrefix)
+{
+    MAZE_TRACE_ZONE("MazeAnimationExporter::writePngSequence");
+    const auto encode = [this, &pathPrefix](const Frame &frame) {
+        char suffix[24] {};
+        std::snprintf(suffix, sizeof(suffix), "_%05llu.png", static_cast<unsigned long long>(statistics_.frames));
+        std::ofstream output(pathPrefix + suffix, std::ios::binary | std::ios::trunc);
+        const std::string png = encodePng(frame.pixels, frame.width, frame.height);
+        output.write(png.data(), static_cast<std::streamsize>(png.size()));
+        statistics_.bytesWritten += png.size();
+        ++statistics_.frames;
+        return static_cast<bool>(output.flush());
+    };
+    return run(false, encode);
+}
@@ -0,0 +1,307 @@
+#include "mazearchive.h"
+#include "mazeentropycoder.h"
+
+#include <cstring>
+#include <limits>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define MAZE_ARCHIVE_MMAP_SUPPORTED
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+const char MazeArchive::MAGIC[4] {'A', 'M', 'Z', 'A'};
+
+namespace
+{
+void putUint(unsigned char *destination, std::uint64_t value, std::size_t byteCount)
+{
+    for (std::size_t byte = 0; byte < byteCount; ++byte)
+        destination[byte] = static_cast<unsigned char>(value >> (byte * 8));
+}
+
+std::uint64_t getUint(const unsigned char *source, std::size_t byteCount)
+{
+    std::uint64_t value {0};
+    for (std::size_t byte = 0; byte < byteCount; ++byte)
+        value |= std::uint64_t(source[byte]) << (byte * 8);
+    return value;
+}
+}
+
+MazeArchiveWriter::~MazeArchiveWriter()
+{
+    close();
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool MazeArchiveWriter::writeHeader()
+{
+    unsigned char header[MazeArchive::HEADER_SIZE] {};
+    std::memcpy(header, MazeArchive::MAGIC, sizeof(MazeArchive::MAGIC));
+    putUint(header + 4, MazeArchive::VERSION, 4);
+    putUint(header + 8, entryCount_, 8);
+    putUint(header + 16, dataEnd_, 8);
+    file_.seekp(0);
+    file_.write(reinterpret_cast<const char*>(header), sizeof(header));
+    return file_.flush() && syncFile();
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool MazeArchiveWriter::syncFile()
+{
+#ifdef MAZE_ARCHIVE_MMAP_SUPPORTED
+    // У fstream нет дескриптора, а fsync через любой дескриптор файла сбрасывает все его данные
+    const int descriptor = ::open(filePath_.c_str(), O_RDONLY);
+    if (descriptor < 0)
+        return false;
+    const bool isSynced = fsync(descriptor) == 0;
+    ::close(descriptor);
+    return isSynced;
+#else
+    return true;
+#endif
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool MazeArchiveWriter::open(const std::string &filePath)
+{
+    close();
+    filePath_ = filePath;
+    entryCount_ = 0;
+    indexOffset_ = MazeArchive::HEADER_SIZE;
+    dataEnd_ = MazeArchive::HEADER_SIZE;
+    index_.clear();
+    hasWriteFailed_ = false;
+
+    file_.open(filePath_, std::ios::in | std::ios::out | std::ios::binary);
+    if (file_.is_open())
+    {
+        unsigned char header[MazeArchive::HEADER_SIZE] {};
+        file_.read(reinterpret_cast<char*>(header), sizeof(header));
+        file_.seekg(0, std::ios::end);
+        const std::uint64_t fileSize = static_cast<std::uint64_t>(file_.tellg());
+        entryCount_ = getUint(header + 8, 8);
+        indexOffset_ = getUint(header + 16, 8);
+        // Число записей сверяется с размером файла до выделения памяти под индекс
+        if (!file_ || std::memcmp(header, MazeArchive::MAGIC, sizeof(MazeArchive::MAGIC)) != 0 ||
+                getUint(header + 4, 4) != MazeArchive::VERSION ||
+                (getUint(header + 24, 8) & MazeArchive::FLAG_WRITE_IN_PROGRESS) != 0 ||
+                indexOffset_ < MazeArchive::HEADER_SIZE || indexOffset_ > fileSize ||
+                entryCount_ > (fileSize - indexOffset_) / MazeArchive::INDEX_ENTRY_SIZE)
+        {
+            file_.close();
+            return false;
+        }
+        index_.resize(static_cast<std::size_t>(entryCount_ * MazeArchive::INDEX_ENTRY_SIZE));
+        file_.seekg(indexOffset_);
+        if (!index_.empty() && !file_.read(reinterpret_cast<char*>(index_.data()), index_.size()))
+        {
+            file_.close();
+            return false;
+        }
+        // Новые тела идут за старым индексом; хвост после него остался от прерванного дописывания
+        dataEnd_ = indexOffset_ + index_.size();
+    }
+    else
+    {
+        file_.clear();
+        file_.open(filePath_, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+        // Новый архив сразу читается как пустой
+        if (!file_.is_open() || !writeHeader())
+        {
+            file_.close();
+            return false;
+        }
+    }
+
+    file_.seekp(dataEnd_);
+    isOpen_ = true;
+    return true;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool MazeArchiveWriter::append(const GenerationParameters &parameters, const PackedMazeGrid &grid)
+{
+    encodedBuffer_.clear();
+    MazeEntropyCoder::encode(grid, encodedBuffer_);
+    return appendEncoded(parameters, grid.computeChecksum(), encodedBuffer_);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool MazeArchiveWriter::appendEncoded(const GenerationParameters &parameters, std::uint64_t checksum,
+                                      const std::vector<std::uint8_t> &encoded)
+{
+    const std::uint64_t maxSide = std::numeric_limits<std::uint32_t>::max();
+    if (!isOpen_ || parameters.width > maxSide || parameters.height > maxSide)
+        return false;
+
+    file_.write(reinterpret_cast<const char*>(encoded.data()), encoded.size());
+    if (!file_)
+    {
+        hasWriteFailed_ = true;
+        return false;
+    }
+
+    unsigned char entry[MazeArchive::INDEX_ENTRY_SIZE] {};
+    putUint(entry, dataEnd_, 8);
+    putUint(entry + 8, encoded.size(), 8);
+    putUint(entry + 16, parameters.seed, 8);
+    putUint(entry + 24, checksum, 8);
+    putUint(entry + 32, parameters.width, 4);
+    putUint(entry + 36, parameters.height, 4);
+    putUint(entry + 40, static_cast<std::uint32_t>(parameters.algorithm), 4);
+    index_.insert(index_.end(), entry, entry + sizeof(entry));
+
+    dataEnd_ += encoded.size();
+    ++entryCount_;
+    return true;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool MazeArchiveWriter::close()
+{
+    if (!isOpen_)
+        return true;
+    isOpen_ = false;
+
+    // Ничего не дописано - старый индекс остается действующим
+    bool isWritten = !hasWriteFailed_;
+    if (isWritten && dataEnd_ != indexOffset_ + index_.size())
+    {
+        // Заголовок переключается на новый индекс, только когда тот целиком на диске
+        file_.seekp(dataEnd_);
+        file_.write(reinterpret_cast<const char*>(index_.data()), index_.size());
+        isWritten = file_.flush() && syncFile() && writeHeader();
+    }
+    file_.close();
+    index_.clear();
+    index_.shrink_to_fit();
+    return isWritten;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::uint64_t MazeArchiveWriter::getEntryCount() const
+{
+    return entryCount_;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+MazeArchiveReader::~MazeArchiveReader()
+{
+    close();
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool MazeArchiveReader::open(const std::string &filePath)
+{
+    close();
+#ifdef MAZE_ARCHIVE_MMAP_SUPPORTED
+    const int descriptor = ::open(filePath.c_str(), O_RDONLY);
+    if (descriptor < 0)
+        return false;
+    struct stat fileStatus;
+    if (fstat(descriptor, &fileStatus) != 0 || fileStatus.st_size < off_t(MazeArchive::HEADER_SIZE))
+    {
+        ::close(descriptor);
+        return false;
+    }
+    size_ = static_cast<std::size_t>(fileStatus.st_size);
+    void *mapping = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    // Отображение живет и после закрытия дескриптора
+    ::close(descriptor);
+    if (mapping == MAP_FAILED)
+    {
+        size_ = 0;
+        return false;
+    }
+    // Лабиринты читаются вразнобой, упреждающее чтение соседних страниц только мешает
+    posix_madvise(mapping, size_, POSIX_MADV_RANDOM);
+    mapping_ = mapping;
+    data_ = static_cast<const std::uint8_t*>(mapping);
+#else
+    std::ifstream file(filePath, std::ios::binary | std::ios::ate);
+    if (!file)
+        return false;
+    fileData_.resize(static_cast<std::size_t>(file.tellg()));
+    file.seekg(0);
+    if (fileData_.size() < MazeArchive::HEADER_SIZE ||
+            !file.read(reinterpret_cast<char*>(fileData_.data()), fileData_.size()))
+    {
+        fileData_.clear();
+        return false;
+    }
+    size_ = fileData_.size();
+    data_ = fileData_.data();
+#endif
+
+    entryCount_ = getUint(data_ + 8, 8);
+    indexOffset_ = getUint(data_ + 16, 8);
+    const bool isValid = std::memcmp(data_, MazeArchive::MAGIC, sizeof(MazeArchive::MAGIC)) == 0 &&
+            getUint(data_ + 4, 4) == MazeArchive::VERSION &&
+            (getUint(data_ + 24, 8) & MazeArchive::FLAG_WRITE_IN_PROGRESS) == 0 &&
+            indexOffset_ >= MazeArchive::HEADER_SIZE && indexOffset_ <= size_ &&
+            entryCount_ <= (size_ - indexOffset_) / MazeArchive::INDEX_ENTRY_SIZE;
+    if (!isValid)
+        close();
+    return isValid;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeArchiveReader::close()
+{
+#ifdef MAZE_ARCHIVE_MMAP_SUPPORTED
+    if (mapping_)
+        munmap(mapping_, size_);
+#endif
+    mapping_ = nullptr;
+    fileData_.clear();
+    data_ = nullptr;
+    size_ = 0;
+    entryCount_ = 0;
+    indexOffset_ = 0;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::uint64_t MazeArchiveReader::getEntryCount() const
+{
+    return entryCount_;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool MazeArchiveReader::getEntry(std::uint64_t entryIndex, MazeArchive::Entry &entry) const
+{
+    if (entryIndex >= entryCount_)
+        return false;
+
+    const std::uint8_t *record = data_ + indexOffset_ + entryIndex * MazeArchive::INDEX_ENTRY_SIZE;
+    entry.offset = getUint(record, 8);
+    entry.size = getUint(record + 8, 8);
+    entry.parameters.seed = getUint(record + 16, 8);
+    entry.checksum = getUint(record + 24, 8);
+    entry.parameters.width = static_cast<std::size_t>(getUint(record + 32, 4));
+    entry.parameters.height = static_cast<std::size_t>(getUint(record + 36, 4));
+    entry.parameters.algorithm = static_cast<int>(getUint(record + 40, 4));
+    return entry.offset >= MazeArchive::HEADER_SIZE && entry.offset <= indexOffset_ &&
+            entry.size <= indexOffset_ - entry.offset;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool MazeArchiveReader::read(std::uint64_t entryIndex, GenerationParameters &parameters, PackedMazeGrid &grid) const
+{
+    MazeArchive::Entry entry;
+    if (!getEntry(entryIndex, entry))
+        return false;
+
+    // Поврежденный размер сетки отбрасывается до выделения памяти: столько клеток в теле не уместить
+    const std::uint64_t cellCount = std::uint64_t(entry.parameters.width) * entry.parameters.height;
+    if (cellCount / MazeEntropyCoder::MAX_CELLS_PER_BYTE > entry.size)
+        return false;
+
+    parameters = entry.parameters;
+    grid.resize(parameters.width, parameters.height);
+    return MazeEntropyCoder::decode(data_ + entry.offset, static_cast<std::size_t>(entry.size), grid) &&
+            grid.computeChecksum() == entry.checksum;
+}
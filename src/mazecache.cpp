@@ -0,0 +1,270 @@
+#include "mazecache.h"
+#include "compactmazeformat.h"
+#include "tracezones.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define MAZE_CACHE_DIRECTORY_SCAN_SUPPORTED
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+#endif
+
+namespace
+{
+// Имя записи: 16 шестнадцатеричных цифр ключа и расширение
+const std::size_t KEY_DIGITS {16};
+const char ENTRY_EXTENSION[] {".amz"};
+
+#ifdef MAZE_CACHE_DIRECTORY_SCAN_SUPPORTED
+struct ScannedEntry
+{
+    std::uint64_t key;
+    std::uint64_t sizeBytes;
+    time_t modificationTime;
+};
+
+bool parseEntryName(const char *name, std::uint64_t &key)
+{
+    if (std::strlen(name) != KEY_DIGITS + sizeof(ENTRY_EXTENSION) - 1 ||
+            std::strcmp(name + KEY_DIGITS, ENTRY_EXTENSION) != 0)
+        return false;
+    char *end {nullptr};
+    key = std::strtoull(name, &end, 16);
+    return end == name + KEY_DIGITS;
+}
+#endif
+}
+
+MazeCache::MazeCache(const std::string &directoryPath, std::uint64_t maxSizeBytes)
+    : directoryPath_(directoryPath),
+      maxSizeBytes_(maxSizeBytes)
+{
+    scanDirectory();
+}
+
+/*------------------------------------------------------------------------------------------------*/
+MazeCache::Key MazeCache::makeKey(const GenerationParameters &parameters)
+{
+    // Версия формата входит в ключ, чтобы записи старого формата просто перестали находиться
+    const std::uint64_t fields[] {CompactMazeFormat::VERSION, static_cast<std::uint64_t>(parameters.algorithm),
+                                  parameters.width, parameters.height, parameters.seed};
+    Key key {0xCBF29CE484222325};
+    for (std::uint64_t field : fields)
+    {
+        key = (key ^ field) * 0xBF58476D1CE4E5B9;
+        key ^= key >> 31;
+    }
+    return key;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::string MazeCache::makeEntryPath(Key key) const
+{
+    char fileName[24] {};
+    std::snprintf(fileName, sizeof(fileName), "%016llx%s", static_cast<unsigned long long>(key), ENTRY_EXTENSION);
+    return directoryPath_ + "/" + fileName;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::string MazeCache::makeTemporaryPath(const std::string &entryPath)
+{
+    // Одну запись могут сохранять сразу несколько потоков и процессов, у каждого свой файл
+    char suffix[48] {};
+#ifdef MAZE_CACHE_DIRECTORY_SCAN_SUPPORTED
+    const unsigned long long processId = static_cast<unsigned long long>(getpid());
+#else
+    const unsigned long long processId = reinterpret_cast<std::uintptr_t>(this);
+#endif
+    std::snprintf(suffix, sizeof(suffix), ".%llx.%llx.tmp", processId,
+                  static_cast<unsigned long long>(temporaryFileCount_.fetch_add(1)));
+    return entryPath + suffix;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeCache::scanDirectory()
+{
+    lruKeys_.clear();
+    entries_.clear();
+    statistics_.sizeBytes = 0;
+#ifdef MAZE_CACHE_DIRECTORY_SCAN_SUPPORTED
+    DIR *directory = opendir(directoryPath_.c_str());
+    if (!directory)
+    {
+        statistics_.entryCount = 0;
+        return;
+    }
+    std::vector<ScannedEntry> scannedEntries;
+    while (const dirent *directoryEntry = readdir(directory))
+    {
+        ScannedEntry entry {};
+        struct stat fileStatus;
+        if (!parseEntryName(directoryEntry->d_name, entry.key) ||
+                stat((directoryPath_ + "/" + directoryEntry->d_name).c_str(), &fileStatus) != 0)
+            continue;
+        entry.sizeBytes = static_cast<std::uint64_t>(fileStatus.st_size);
+        entry.modificationTime = fileStatus.st_mtime;
+        scannedEntries.push_back(entry);
+    }
+    closedir(directory);
+
+    std::sort(scannedEntries.begin(), scannedEntries.end(), [](const ScannedEntry &first, const ScannedEntry &second) {
+        return first.modificationTime > second.modificationTime;
+    });
+    for (const ScannedEntry &entry : scannedEntries)
+    {
+        lruKeys_.push_back(entry.key);
+        entries_[entry.key] = Entry {entry.sizeBytes, std::prev(lruKeys_.end())};
+        statistics_.sizeBytes += entry.sizeBytes;
+    }
+#endif
+    statistics_.entryCount = entries_.size();
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeCache::removeEntry(Key key)
+{
+    std::remove(makeEntryPath(key).c_str());
+    forgetEntry(key);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeCache::forgetEntry(Key key)
+{
+    auto entry = entries_.find(key);
+    if (entry == entries_.end())
+        return;
+
+    statistics_.sizeBytes -= entry->second.sizeBytes;
+    lruKeys_.erase(entry->second.lruPosition);
+    entries_.erase(entry);
+    statistics_.entryCount = entries_.size();
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeCache::addEntry(Key key, std::uint64_t sizeBytes)
+{
+    lruKeys_.push_front(key);
+    entries_[key] = Entry {sizeBytes, lruKeys_.begin()};
+    statistics_.sizeBytes += sizeBytes;
+    statistics_.entryCount = entries_.size();
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeCache::evictToFit(std::uint64_t incomingBytes)
+{
+    if (statistics_.sizeBytes + incomingBytes <= maxSizeBytes_)
+        return;
+
+    // Другие процессы могли добавить или удалить записи: решение принимается по самой папке
+    scanDirectory();
+    const std::uint64_t targetSizeBytes = static_cast<std::uint64_t>(EVICTION_TARGET_SHARE * maxSizeBytes_);
+    while (!lruKeys_.empty() && statistics_.sizeBytes + incomingBytes > targetSizeBytes)
+    {
+        removeEntry(lruKeys_.back());
+        ++statistics_.evictions;
+    }
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool MazeCache::load(const GenerationParameters &parameters, PackedMazeGrid &grid)
+{
+    MAZE_TRACE_ZONE("MazeCache::load");
+    const Key key = makeKey(parameters);
+    const std::string entryPath = makeEntryPath(key);
+
+    /* Файл ищется в папке, а не в списке: запись мог сохранить другой процесс. Читается без
+     * блокировки, так как запись в него идет через переименование готового файла */
+    std::ifstream file(entryPath, std::ios::binary);
+    if (!file)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++statistics_.misses;
+        return false;
+    }
+    GenerationParameters storedParameters;
+    const bool isValid = CompactMazeFormat::read(file, storedParameters, grid);
+    file.close();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!isValid || storedParameters != parameters)
+    {
+        // Совпадение ключа при других параметрах - коллизия хеша, а не порча
+        if (!isValid)
+            ++statistics_.corruptedEntries;
+        removeEntry(key);
+        ++statistics_.misses;
+        return false;
+    }
+
+#ifdef MAZE_CACHE_DIRECTORY_SCAN_SUPPORTED
+    // Время изменения - общий для всех процессов порядок использования
+    utime(entryPath.c_str(), nullptr);
+#endif
+    // Запись другого процесса попадает в список при первом попадании
+    forgetEntry(key);
+    addEntry(key, CompactMazeFormat::getEncodedSize(grid));
+    ++statistics_.hits;
+    return true;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeCache::store(const GenerationParameters &parameters, const PackedMazeGrid &grid)
+{
+    MAZE_TRACE_ZONE("MazeCache::store");
+    const std::uint64_t sizeBytes = CompactMazeFormat::getEncodedSize(grid);
+    if (sizeBytes > maxSizeBytes_)
+        return;
+
+    const Key key = makeKey(parameters);
+    const std::string entryPath = makeEntryPath(key);
+    const std::string temporaryPath = makeTemporaryPath(entryPath);
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        CompactMazeFormat::write(file, parameters, grid);
+        if (!file.flush())
+        {
+            file.close();
+            std::remove(temporaryPath.c_str());
+            return;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    removeEntry(key);
+    evictToFit(sizeBytes);
+    if (std::rename(temporaryPath.c_str(), entryPath.c_str()) != 0)
+    {
+        std::remove(temporaryPath.c_str());
+        return;
+    }
+
+    // Просмотр папки в evictToFit мог найти запись, сохраненную другим процессом
+    forgetEntry(key);
+    addEntry(key, sizeBytes);
+    ++statistics_.stores;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeCache::generate(const GenerationParameters &parameters, PackedMazeGrid &grid)
+{
+    if (load(parameters, grid))
+        return;
+
+    MazeGenerator::generate(parameters, grid);
+    store(parameters, grid);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+MazeCache::Statistics MazeCache::getStatistics() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return statistics_;
+}
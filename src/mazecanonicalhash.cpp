@@ -0,0 +1,233 @@
+#include "mazecanonicalhash.h"
+
+#include <algorithm>
+
+namespace
+{
+const std::size_t REFLECTION_COUNT {4};
+// Блок строк реже этого транспонируется по установленным битам, а не целиком
+const std::size_t MIN_DENSE_BLOCK_ROWS {32};
+
+unsigned int countTrailingZeros(std::uint64_t word)
+{
+#if defined(__GNUC__)
+    return static_cast<unsigned int>(__builtin_ctzll(word));
+#else
+    unsigned int count {0};
+    for (; !(word & 1); word >>= 1)
+        ++count;
+    return count;
+#endif
+}
+
+void mixWord(std::uint64_t &hash, std::uint64_t word)
+{
+    hash ^= word;
+    hash *= 0xBF58476D1CE4E5B9;
+    hash ^= hash >> 31;
+}
+
+std::uint64_t reverseBits(std::uint64_t word)
+{
+    word = ((word >> 1) & 0x5555555555555555) | ((word & 0x5555555555555555) << 1);
+    word = ((word >> 2) & 0x3333333333333333) | ((word & 0x3333333333333333) << 2);
+    word = ((word >> 4) & 0x0F0F0F0F0F0F0F0F) | ((word & 0x0F0F0F0F0F0F0F0F) << 4);
+#if defined(__GNUC__)
+    return __builtin_bswap64(word);
+#else
+    word = ((word >> 8) & 0x00FF00FF00FF00FF) | ((word & 0x00FF00FF00FF00FF) << 8);
+    word = ((word >> 16) & 0x0000FFFF0000FFFF) | ((word & 0x0000FFFF0000FFFF) << 16);
+    return (word >> 32) | (word << 32);
+#endif
+}
+
+// Транспонирование блока 64 x 64 обменом все меньших подблоков: бит c слова r переходит в бит r слова c
+void transposeBlock(std::uint64_t block[PackedMazeGrid::BITS_PER_WORD])
+{
+    std::uint64_t mask {0x00000000FFFFFFFF};
+    for (unsigned int shift = 32; shift != 0; shift >>= 1, mask ^= mask << shift)
+    {
+        for (unsigned int row = 0; row < PackedMazeGrid::BITS_PER_WORD; ++row)
+        {
+            if (row & shift)
+                continue;
+            const std::uint64_t swapped = ((block[row] >> shift) ^ block[row | shift]) & mask;
+            block[row] ^= swapped << shift;
+            block[row | shift] ^= swapped;
+        }
+    }
+}
+}
+
+void MazeCanonicalHash::resizePlanes(Planes &planes, std::size_t width, std::size_t height)
+{
+    planes.width = width;
+    planes.height = height;
+    planes.wordsPerRow = (width + PackedMazeGrid::BITS_PER_WORD - 1) / PackedMazeGrid::BITS_PER_WORD;
+    const std::size_t planeWords = planes.wordsPerRow * height;
+    planes.right.assign(planeWords, 0);
+    planes.bot.assign(planeWords, 0);
+    planes.reversedRight.resize(planeWords);
+    planes.reversedBot.resize(planeWords);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeCanonicalHash::transposePlane(const std::vector<std::uint64_t> &source, std::size_t sourceWordsPerRow,
+                                       std::size_t sourceRows, std::vector<std::uint64_t> &target,
+                                       std::size_t targetWordsPerRow, std::size_t targetRows)
+{
+    // Целевая плоскость уже обнулена
+    const std::size_t bitsPerWord = PackedMazeGrid::BITS_PER_WORD;
+    std::uint64_t block[PackedMazeGrid::BITS_PER_WORD];
+    for (std::size_t rowBlock = 0; rowBlock < targetWordsPerRow; ++rowBlock)
+    {
+        const std::size_t blockRows = std::min(bitsPerWord, sourceRows - rowBlock * bitsPerWord);
+        for (std::size_t word = 0; word < sourceWordsPerRow; ++word)
+        {
+            // У маленьких лабиринтов блок почти пуст, и дешевле переставить по одному установленные биты
+            if (blockRows < MIN_DENSE_BLOCK_ROWS)
+            {
+                for (std::size_t row = 0; row < blockRows; ++row)
+                {
+                    std::uint64_t bits = source[(rowBlock * bitsPerWord + row) * sourceWordsPerRow + word];
+                    for (; bits != 0; bits &= bits - 1)
+                    {
+                        const std::size_t targetRow = word * bitsPerWord + countTrailingZeros(bits);
+                        target[targetRow * targetWordsPerRow + rowBlock] |= std::uint64_t(1) << row;
+                    }
+                }
+                continue;
+            }
+
+            for (std::size_t row = 0; row < bitsPerWord; ++row)
+                block[row] = row < blockRows ? source[(rowBlock * bitsPerWord + row) * sourceWordsPerRow + word] : 0;
+            transposeBlock(block);
+            for (std::size_t row = 0; row < bitsPerWord && word * bitsPerWord + row < targetRows; ++row)
+                target[(word * bitsPerWord + row) * targetWordsPerRow + rowBlock] = block[row];
+        }
+    }
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeCanonicalHash::reverseRow(const std::uint64_t *row, std::size_t wordsPerRow, std::size_t bitCount,
+                                   std::uint64_t *reversedRow)
+{
+    // Разворот всей строки слов и сдвиг к нулевому биту на число неиспользуемых старших битов
+    if (bitCount == 0)
+    {
+        std::fill_n(reversedRow, wordsPerRow, 0);
+        return;
+    }
+    if (wordsPerRow == 1)
+    {
+        reversedRow[0] = reverseBits(row[0]) >> (PackedMazeGrid::BITS_PER_WORD - bitCount);
+        return;
+    }
+    std::fill_n(reversedRow, wordsPerRow, 0);
+    const std::size_t unusedBits = wordsPerRow * PackedMazeGrid::BITS_PER_WORD - bitCount;
+    const std::size_t wordShift = unusedBits / PackedMazeGrid::BITS_PER_WORD;
+    const unsigned int bitShift = unusedBits % PackedMazeGrid::BITS_PER_WORD;
+    for (std::size_t word = 0; word + wordShift < wordsPerRow; ++word)
+    {
+        const std::size_t sourceWord = wordsPerRow - 1 - word - wordShift;
+        std::uint64_t reversed = reverseBits(row[sourceWord]) >> bitShift;
+        if (bitShift != 0 && sourceWord > 0)
+            reversed |= reverseBits(row[sourceWord - 1]) << (PackedMazeGrid::BITS_PER_WORD - bitShift);
+        reversedRow[word] = reversed;
+    }
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeCanonicalHash::reversePlanes(Planes &planes)
+{
+    // Проходов вправо в строке на один меньше, чем клеток
+    for (std::size_t y = 0; y < planes.height; ++y)
+    {
+        const std::size_t rowStart = y * planes.wordsPerRow;
+        reverseRow(planes.right.data() + rowStart, planes.wordsPerRow, planes.width - 1,
+                   planes.reversedRight.data() + rowStart);
+        reverseRow(planes.bot.data() + rowStart, planes.wordsPerRow, planes.width, planes.reversedBot.data() + rowStart);
+    }
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::uint64_t MazeCanonicalHash::hashReflections(const Planes &planes)
+{
+    /* Строка за строкой: проходы вправо, затем вниз; у последней строки проходов вниз нет.
+     * Отражение по x берет развернутые строки, по y - строки с конца, а проходы вниз при этом
+     * сдвигаются на строку. Четыре хеша считаются в одном цикле, чтобы умножения шли параллельно */
+    const std::size_t height = planes.height;
+    const std::size_t wordsPerRow = planes.wordsPerRow;
+    std::uint64_t hashes[REFLECTION_COUNT];
+    for (std::uint64_t &hash : hashes)
+    {
+        hash = 0xCBF29CE484222325;
+        mixWord(hash, planes.width);
+        mixWord(hash, height);
+    }
+    for (std::size_t y = 0; y < height; ++y)
+    {
+        const std::uint64_t *rightRows[REFLECTION_COUNT] {
+            planes.right.data() + y * wordsPerRow, planes.reversedRight.data() + y * wordsPerRow,
+            planes.right.data() + (height - 1 - y) * wordsPerRow,
+            planes.reversedRight.data() + (height - 1 - y) * wordsPerRow};
+        for (std::size_t word = 0; word < wordsPerRow; ++word)
+        {
+            for (std::size_t reflection = 0; reflection < REFLECTION_COUNT; ++reflection)
+                mixWord(hashes[reflection], rightRows[reflection][word]);
+        }
+        if (y + 1 == height)
+            break;
+
+        const std::uint64_t *botRows[REFLECTION_COUNT] {
+            planes.bot.data() + y * wordsPerRow, planes.reversedBot.data() + y * wordsPerRow,
+            planes.bot.data() + (height - 2 - y) * wordsPerRow,
+            planes.reversedBot.data() + (height - 2 - y) * wordsPerRow};
+        for (std::size_t word = 0; word < wordsPerRow; ++word)
+        {
+            for (std::size_t reflection = 0; reflection < REFLECTION_COUNT; ++reflection)
+                mixWord(hashes[reflection], botRows[reflection][word]);
+        }
+    }
+
+    std::uint64_t minHash = ~std::uint64_t(0);
+    for (std::uint64_t hash : hashes)
+    {
+        mixWord(hash, 0);
+        minHash = std::min(minHash, hash);
+    }
+    return minHash;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::uint64_t MazeCanonicalHash::compute(const PackedMazeGrid &grid)
+{
+    const std::size_t width = grid.getWidth();
+    const std::size_t height = grid.getHeight();
+    if (width == 0 || height == 0)
+        return 0;
+
+    // Копия с обнуленными битами за краем: генераторы их не трогают, но хеш от них зависеть не должен
+    resizePlanes(original_, width, height);
+    const std::size_t wordsPerRow = original_.wordsPerRow;
+    for (std::size_t word = 0; word < wordsPerRow; ++word)
+    {
+        const std::uint64_t rowMask = grid.getRowMask(word);
+        const std::uint64_t rightRowMask = grid.getRightRowMask(word);
+        for (std::size_t y = 0; y < height; ++y)
+        {
+            original_.right[y * wordsPerRow + word] = grid.getRightRow(y)[word] & rightRowMask;
+            if (y + 1 < height)
+                original_.bot[y * wordsPerRow + word] = grid.getBotRow(y)[word] & rowMask;
+        }
+    }
+
+    // Проход вниз из (x, y) - это проход вправо из (y, x) транспонированной сетки, и наоборот
+    resizePlanes(transposed_, height, width);
+    transposePlane(original_.bot, wordsPerRow, height, transposed_.right, transposed_.wordsPerRow, width);
+    transposePlane(original_.right, wordsPerRow, height, transposed_.bot, transposed_.wordsPerRow, width);
+
+    reversePlanes(original_);
+    reversePlanes(transposed_);
+    return std::min(hashReflections(original_), hashReflections(transposed_));
+}
@@ -0,0 +1,369 @@
+#include "mazeconnectivity.h"
+#include "tracezones.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace
+{
+// Ключ прохода в loopPassages_: меньшая клетка * 2, плюс 1 для прохода по вертикали
+std::uint64_t getPassageKey(std::uint32_t firstCell, int direction)
+{
+    return std::uint64_t(firstCell) * 2 +
+            (direction == PackedMazeGrid::Direction::Top || direction == PackedMazeGrid::Direction::Bot);
+}
+}
+
+bool MazeConnectivity::build(const PackedMazeGrid &grid)
+{
+    MAZE_TRACE_ZONE("MazeConnectivity::build");
+    grid_.clear();
+    nodes_.clear();
+    isReversed_.clear();
+    loopPassages_.clear();
+    componentCount_ = 0;
+    if (grid.getCellCount() >= NONE)
+        return false;
+
+    grid_ = grid;
+    const std::size_t width = grid_.getWidth();
+    const std::size_t cellCount = grid_.getCellCount();
+    nodes_.assign(cellCount, Node {NONE, {NONE, NONE}, 1});
+    isReversed_.assign(cellCount, 0);
+
+    /* Обход в ширину сразу дает готовое link-cut дерево: каждая вершина - отдельный путь из одной
+     * вершины, а ссылка на родителя в обходе - ссылка на родительский путь */
+    std::vector<std::uint8_t> isReached(cellCount, 0);
+    std::vector<std::uint32_t> queue;
+    queue.reserve(cellCount);
+    for (std::size_t root = 0; root < cellCount; ++root)
+    {
+        if (isReached[root])
+            continue;
+        ++componentCount_;
+        isReached[root] = 1;
+        queue.assign(1, static_cast<std::uint32_t>(root));
+        for (std::size_t head = 0; head < queue.size(); ++head)
+        {
+            const std::uint32_t cell = queue[head];
+            const std::size_t x = cell % width;
+            const std::size_t y = cell / width;
+            const std::uint32_t neighbors[PackedMazeGrid::Direction::Count]
+                {static_cast<std::uint32_t>(cell - width), cell + 1, static_cast<std::uint32_t>(cell + width), cell - 1};
+            for (int direction = 0; direction < PackedMazeGrid::Direction::Count; ++direction)
+            {
+                if (!grid_.hasPassage(x, y, direction))
+                    continue;
+                const std::uint32_t neighbor = neighbors[direction];
+                if (!isReached[neighbor])
+                {
+                    isReached[neighbor] = 1;
+                    nodes_[neighbor].parent = cell;
+                    queue.push_back(neighbor);
+                }
+                // Проход цикла встречается с обеих сторон, во множестве он остается один раз
+                else if (nodes_[cell].parent != neighbor)
+                    loopPassages_.insert(getPassageKey(std::min(cell, neighbor), direction));
+            }
+        }
+    }
+    return true;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool MazeConnectivity::getPassageCells(std::size_t x, std::size_t y, int direction,
+                                       std::uint32_t &first, std::uint32_t &second) const
+{
+    const std::size_t width = grid_.getWidth();
+    const std::size_t height = grid_.getHeight();
+    if (x >= width || y >= height)
+        return false;
+    std::size_t neighborX = x;
+    std::size_t neighborY = y;
+    switch (direction)
+    {
+    case PackedMazeGrid::Direction::Top :
+        if (y == 0)
+            return false;
+        --neighborY;
+        break;
+    case PackedMazeGrid::Direction::Right :
+        if (x + 1 >= width)
+            return false;
+        ++neighborX;
+        break;
+    case PackedMazeGrid::Direction::Bot :
+        if (y + 1 >= height)
+            return false;
+        ++neighborY;
+        break;
+    case PackedMazeGrid::Direction::Left :
+        if (x == 0)
+            return false;
+        --neighborX;
+        break;
+    default :
+        return false;
+    }
+    // first - меньшая из клеток, так проход записывается одинаково с обеих сторон
+    first = static_cast<std::uint32_t>(std::min(y * width + x, neighborY * width + neighborX));
+    second = static_cast<std::uint32_t>(std::max(y * width + x, neighborY * width + neighborX));
+    return true;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+MazeConnectivity::EditResult MazeConnectivity::setPassage(std::size_t x, std::size_t y, int direction, bool isOpen)
+{
+    MAZE_TRACE_ZONE("MazeConnectivity::setPassage");
+    EditResult result {false, false, false};
+    std::uint32_t first {};
+    std::uint32_t second {};
+    if (!getPassageCells(x, y, direction, first, second) || grid_.hasPassage(x, y, direction) == isOpen)
+        return result;
+    grid_.setPassage(x, y, direction, isOpen);
+    result.isChanged = true;
+    const std::uint64_t passageKey = getPassageKey(first, direction);
+
+    if (isOpen)
+    {
+        if (isConnected(first, second))
+        {
+            loopPassages_.insert(passageKey);
+            result.isLoopCreated = true;
+        }
+        else
+        {
+            link(first, second);
+            --componentCount_;
+        }
+        return result;
+    }
+
+    if (loopPassages_.erase(passageKey) != 0)
+        return result;
+    cut(first, second);
+    // Замена - любой проход цикла, концы которого оказались в разных частях
+    for (auto passage = loopPassages_.begin(); passage != loopPassages_.end(); ++passage)
+    {
+        const std::uint32_t loopFirst = static_cast<std::uint32_t>(*passage / 2);
+        const std::uint32_t loopSecond = static_cast<std::uint32_t>(*passage % 2 ? loopFirst + grid_.getWidth() : loopFirst + 1);
+        if (!isConnected(loopFirst, loopSecond))
+        {
+            link(loopFirst, loopSecond);
+            loopPassages_.erase(passage);
+            return result;
+        }
+    }
+    ++componentCount_;
+    result.isDisconnected = true;
+    return result;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+const PackedMazeGrid& MazeConnectivity::getGrid() const
+{
+    return grid_;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::size_t MazeConnectivity::getComponentCount() const
+{
+    return componentCount_;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::size_t MazeConnectivity::getLoopCount() const
+{
+    return loopPassages_.size();
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool MazeConnectivity::isPerfect() const
+{
+    return componentCount_ == 1 && loopPassages_.empty();
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool MazeConnectivity::isConnected(std::size_t firstCell, std::size_t secondCell)
+{
+    if (firstCell >= nodes_.size() || secondCell >= nodes_.size())
+        return false;
+    return firstCell == secondCell || findRoot(static_cast<std::uint32_t>(firstCell)) ==
+            findRoot(static_cast<std::uint32_t>(secondCell));
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::uint64_t MazeConnectivity::getPathLength(std::size_t fromCell, std::size_t toCell)
+{
+    if (!isConnected(fromCell, toCell))
+        return NO_PATH;
+    // После makeRoot и access splay-дерево toCell - ровно путь от fromCell
+    makeRoot(static_cast<std::uint32_t>(fromCell));
+    access(static_cast<std::uint32_t>(toCell));
+    return nodes_[toCell].size - 1;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::vector<std::uint32_t> MazeConnectivity::getPath(std::size_t fromCell, std::size_t toCell)
+{
+    std::vector<std::uint32_t> path;
+    if (!isConnected(fromCell, toCell))
+        return path;
+    makeRoot(static_cast<std::uint32_t>(fromCell));
+    access(static_cast<std::uint32_t>(toCell));
+    path.reserve(nodes_[toCell].size);
+    collectPath(static_cast<std::uint32_t>(toCell), path);
+    return path;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeConnectivity::collectPath(std::uint32_t node, std::vector<std::uint32_t> &path)
+{
+    // Симметричный обход splay-дерева без рекурсии: глубина дерева может быть линейной
+    std::vector<std::uint32_t> stack;
+    while (node != NONE || !stack.empty())
+    {
+        while (node != NONE)
+        {
+            pushReverse(node);
+            stack.push_back(node);
+            node = nodes_[node].children[0];
+        }
+        node = stack.back();
+        stack.pop_back();
+        path.push_back(node);
+        node = nodes_[node].children[1];
+    }
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool MazeConnectivity::isSplayRoot(std::uint32_t node) const
+{
+    const std::uint32_t parent = nodes_[node].parent;
+    return parent == NONE || (nodes_[parent].children[0] != node && nodes_[parent].children[1] != node);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeConnectivity::pushReverse(std::uint32_t node)
+{
+    if (!isReversed_[node])
+        return;
+    Node &current = nodes_[node];
+    std::swap(current.children[0], current.children[1]);
+    for (std::uint32_t child : current.children)
+    {
+        if (child != NONE)
+            isReversed_[child] ^= 1;
+    }
+    isReversed_[node] = 0;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeConnectivity::updateSize(std::uint32_t node)
+{
+    Node &current = nodes_[node];
+    current.size = 1;
+    for (std::uint32_t child : current.children)
+    {
+        if (child != NONE)
+            current.size += nodes_[child].size;
+    }
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeConnectivity::rotate(std::uint32_t node)
+{
+    const std::uint32_t parent = nodes_[node].parent;
+    const std::uint32_t grandparent = nodes_[parent].parent;
+    const int side = nodes_[parent].children[1] == node;
+    if (!isSplayRoot(parent))
+        nodes_[grandparent].children[nodes_[grandparent].children[1] == parent] = node;
+    nodes_[node].parent = grandparent;
+
+    const std::uint32_t movedChild = nodes_[node].children[1 - side];
+    nodes_[parent].children[side] = movedChild;
+    if (movedChild != NONE)
+        nodes_[movedChild].parent = parent;
+    nodes_[node].children[1 - side] = parent;
+    nodes_[parent].parent = node;
+    updateSize(parent);
+    updateSize(node);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeConnectivity::splay(std::uint32_t node)
+{
+    // Отложенные развороты сначала спускаются от корня splay-дерева до node
+    splayPath_.assign(1, node);
+    for (std::uint32_t current = node; !isSplayRoot(current); current = nodes_[current].parent)
+        splayPath_.push_back(nodes_[current].parent);
+    for (auto current = splayPath_.rbegin(); current != splayPath_.rend(); ++current)
+        pushReverse(*current);
+
+    while (!isSplayRoot(node))
+    {
+        const std::uint32_t parent = nodes_[node].parent;
+        if (!isSplayRoot(parent))
+        {
+            const std::uint32_t grandparent = nodes_[parent].parent;
+            const bool isZigZig = (nodes_[parent].children[0] == node) == (nodes_[grandparent].children[0] == parent);
+            rotate(isZigZig ? parent : node);
+        }
+        rotate(node);
+    }
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeConnectivity::access(std::uint32_t node)
+{
+    std::uint32_t previous {NONE};
+    for (std::uint32_t current = node; current != NONE; current = nodes_[current].parent)
+    {
+        splay(current);
+        nodes_[current].children[1] = previous;
+        updateSize(current);
+        previous = current;
+    }
+    splay(node);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeConnectivity::makeRoot(std::uint32_t node)
+{
+    access(node);
+    isReversed_[node] ^= 1;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::uint32_t MazeConnectivity::findRoot(std::uint32_t node)
+{
+    access(node);
+    std::uint32_t root = node;
+    pushReverse(root);
+    while (nodes_[root].children[0] != NONE)
+    {
+        root = nodes_[root].children[0];
+        pushReverse(root);
+    }
+    // Подъем найденного корня держит следующие запросы амортизированно логарифмическими
+    splay(root);
+    return root;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeConnectivity::link(std::uint32_t first, std::uint32_t second)
+{
+    makeRoot(first);
+    nodes_[first].parent = second;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeConnectivity::cut(std::uint32_t first, std::uint32_t second)
+{
+    // После makeRoot(first) и access(second) соседняя first стоит слева от second
+    makeRoot(first);
+    access(second);
+    nodes_[second].children[0] = NONE;
+    nodes_[first].parent = NONE;
+    updateSize(second);
+}
@@ -0,0 +1,297 @@
+#include "mazeentropycoder.h"
+
+#include <vector>
+
+const std::uint64_t MazeEntropyCoder::MAX_CELLS_PER_BYTE;
+
+namespace
+{
+const unsigned int PROBABILITY_BITS {11};
+const std::uint32_t PROBABILITY_ONE {1u << PROBABILITY_BITS};
+const unsigned int ADAPTATION_SHIFT {5};
+const std::uint32_t TOP_VALUE {1u << 24};
+
+class RangeEncoder
+{
+private:
+    std::vector<std::uint8_t> &output_;
+    std::uint64_t low_ {0};
+    std::uint32_t range_ {0xFFFFFFFF};
+    std::uint8_t cache_ {0};
+    std::uint64_t cacheSize_ {1};
+
+    // Перенос из low_ может изменить уже "выданные" байты, поэтому хвост из 0xFF придерживается в cache_
+    void shiftLow()
+    {
+        if (static_cast<std::uint32_t>(low_) < 0xFF000000 || (low_ >> 32) != 0)
+        {
+            std::uint8_t carry = static_cast<std::uint8_t>(low_ >> 32);
+            std::uint8_t byte = cache_;
+            do
+            {
+                output_.push_back(static_cast<std::uint8_t>(byte + carry));
+                byte = 0xFF;
+            }
+            while (--cacheSize_ != 0);
+            cache_ = static_cast<std::uint8_t>(low_ >> 24);
+        }
+        ++cacheSize_;
+        low_ = (low_ & 0x00FFFFFF) << 8;
+    }
+
+public:
+    explicit RangeEncoder(std::vector<std::uint8_t> &output) : output_(output) {}
+
+    bool codeBit(std::uint16_t &probability, bool bit)
+    {
+        const std::uint32_t bound = (range_ >> PROBABILITY_BITS) * probability;
+        if (!bit)
+        {
+            range_ = bound;
+            probability += (PROBABILITY_ONE - probability) >> ADAPTATION_SHIFT;
+        }
+        else
+        {
+            low_ += bound;
+            range_ -= bound;
+            probability -= probability >> ADAPTATION_SHIFT;
+        }
+        while (range_ < TOP_VALUE)
+        {
+            range_ <<= 8;
+            shiftLow();
+        }
+        return bit;
+    }
+
+    void flush()
+    {
+        for (int byte = 0; byte < 5; ++byte)
+            shiftLow();
+    }
+};
+
+class RangeDecoder
+{
+private:
+    const std::uint8_t *input_;
+    const std::uint8_t *inputEnd_;
+    std::uint32_t code_ {0};
+    std::uint32_t range_ {0xFFFFFFFF};
+    bool isOverrun_ {false};
+
+    std::uint8_t nextByte()
+    {
+        if (input_ == inputEnd_)
+        {
+            isOverrun_ = true;
+            return 0;
+        }
+        return *input_++;
+    }
+
+public:
+    RangeDecoder(const std::uint8_t *input, std::size_t inputSize)
+        : input_(input), inputEnd_(input + inputSize)
+    {
+        for (int byte = 0; byte < 5; ++byte)
+            code_ = (code_ << 8) | nextByte();
+    }
+
+    bool codeBit(std::uint16_t &probability, bool)
+    {
+        const std::uint32_t bound = (range_ >> PROBABILITY_BITS) * probability;
+        bool bit;
+        if (code_ < bound)
+        {
+            range_ = bound;
+            probability += (PROBABILITY_ONE - probability) >> ADAPTATION_SHIFT;
+            bit = false;
+        }
+        else
+        {
+            code_ -= bound;
+            range_ -= bound;
+            probability -= probability >> ADAPTATION_SHIFT;
+            bit = true;
+        }
+        while (range_ < TOP_VALUE)
+        {
+            range_ <<= 8;
+            code_ = (code_ << 8) | nextByte();
+        }
+        return bit;
+    }
+
+    bool isOverrun() const
+    {
+        return isOverrun_;
+    }
+};
+
+inline bool testBit(const std::uint64_t *row, std::size_t x)
+{
+    return (row[x / PackedMazeGrid::BITS_PER_WORD] >> (x % PackedMazeGrid::BITS_PER_WORD)) & 1;
+}
+
+inline void setBit(std::uint64_t *row, std::size_t x)
+{
+    row[x / PackedMazeGrid::BITS_PER_WORD] |= std::uint64_t(1) << (x % PackedMazeGrid::BITS_PER_WORD);
+}
+
+// Компоненты связности клеток текущей строки по уже пройденным проходам (как в алгоритме Эллера)
+class RowComponents
+{
+private:
+    std::vector<std::size_t> parents_;
+
+public:
+    explicit RowComponents(std::size_t labelCount) : parents_(labelCount) {}
+
+    void reset()
+    {
+        for (std::size_t label = 0; label < parents_.size(); ++label)
+            parents_[label] = label;
+    }
+
+    std::size_t find(std::size_t label)
+    {
+        while (parents_[label] != label)
+        {
+            parents_[label] = parents_[parents_[label]];
+            label = parents_[label];
+        }
+        return label;
+    }
+
+    void unite(std::size_t first, std::size_t second)
+    {
+        parents_[find(first)] = find(second);
+    }
+};
+
+/* Общий обход для сжатия и распаковки: контекст берется из уже пройденных битов grid.
+ * При распаковке output указывает на ту же сетку, и раскодированные биты сразу пишутся в неё.
+ *
+ * Строка кодируется в два прохода: сначала все проходы вправо, потом все проходы вниз. Так для
+ * каждой клетки известно, с какими клетками строки она уже связана. Проход вправо между уже
+ * связанными клетками дал бы цикл, а компонента, последняя клетка которой в строке так и не
+ * ушла вниз, навсегда отрезана от остального лабиринта - в идеальном лабиринте оба случая
+ * невозможны. Эти биты кодируются в отдельных контекстах и почти ничего не стоят, но лабиринт
+ * с циклами или изолированными областями все равно сохраняется без потерь */
+template <typename Coder>
+void codeCells(Coder &coder, const PackedMazeGrid &grid, PackedMazeGrid *output)
+{
+    const std::size_t RIGHT_CONTEXT_COUNT {8};
+    const std::size_t BOT_CONTEXT_COUNT {32};
+    // Последние контексты - для случаев, невозможных в идеальном лабиринте
+    std::uint16_t rightProbabilities[RIGHT_CONTEXT_COUNT + 1];
+    std::uint16_t botProbabilities[BOT_CONTEXT_COUNT + 1];
+    for (std::uint16_t &probability : rightProbabilities)
+        probability = PROBABILITY_ONE / 2;
+    for (std::uint16_t &probability : botProbabilities)
+        probability = PROBABILITY_ONE / 2;
+
+    const std::size_t width = grid.getWidth();
+    const std::size_t height = grid.getHeight();
+    /* Метки клеток: [0, width) - компоненты, пришедшие сверху (по номеру их первой клетки в
+     * прошлой строке), [width, 2 * width) - клетки, в которые сверху прохода нет */
+    RowComponents components(2 * width);
+    std::vector<std::size_t> upperLabels(width);
+    std::vector<std::size_t> labels(width);
+    std::vector<std::size_t> roots(width);
+    std::vector<std::size_t> lastCells(2 * width);
+    std::vector<std::size_t> downPassages(2 * width);
+    const std::size_t NO_LABEL {~std::size_t(0)};
+    std::vector<std::size_t> nextLabels(2 * width, NO_LABEL);
+
+    for (std::size_t y = 0; y < height; ++y)
+    {
+        const std::uint64_t *rightRow = grid.getRightRow(y);
+        const std::uint64_t *botRow = grid.getBotRow(y);
+        const std::uint64_t *upperBotRow = y > 0 ? grid.getBotRow(y - 1) : nullptr;
+
+        components.reset();
+        for (std::size_t x = 0; x < width; ++x)
+            labels[x] = upperBotRow && testBit(upperBotRow, x) ? upperLabels[x] : width + x;
+
+        for (std::size_t x = 0; x + 1 < width; ++x)
+        {
+            const std::size_t leftRoot = components.find(labels[x]);
+            const std::size_t rightRoot = components.find(labels[x + 1]);
+            std::size_t context {RIGHT_CONTEXT_COUNT};
+            if (leftRoot != rightRoot)
+            {
+                const unsigned int isLeftOpen = x > 0 && testBit(rightRow, x - 1);
+                const unsigned int isTopOpen = labels[x] < width;
+                const unsigned int isRightNeighborTopOpen = labels[x + 1] < width;
+                context = isLeftOpen | (isTopOpen << 1) | (isRightNeighborTopOpen << 2);
+            }
+            if (coder.codeBit(rightProbabilities[context], testBit(rightRow, x)))
+            {
+                if (output)
+                    setBit(output->getRightRow(y), x);
+                components.unite(leftRoot, rightRoot);
+            }
+        }
+
+        for (std::size_t x = 0; x < width; ++x)
+        {
+            roots[x] = components.find(labels[x]);
+            lastCells[roots[x]] = x;
+            downPassages[roots[x]] = 0;
+        }
+        if (y + 1 == height)
+            break;
+
+        for (std::size_t x = 0; x < width; ++x)
+        {
+            const std::size_t root = roots[x];
+            const unsigned int isLastCell = lastCells[root] == x;
+            const unsigned int hasDownPassage = downPassages[root] != 0;
+            std::size_t context {BOT_CONTEXT_COUNT};
+            if (!isLastCell || hasDownPassage)
+            {
+                const unsigned int isRightOpen = x + 1 < width && testBit(rightRow, x);
+                const unsigned int isLeftOpen = x > 0 && testBit(rightRow, x - 1);
+                const unsigned int isTopOpen = labels[x] < width;
+                context = isRightOpen | (isLeftOpen << 1) | (isTopOpen << 2) | (hasDownPassage << 3) |
+                        (isLastCell << 4);
+            }
+            if (coder.codeBit(botProbabilities[context], testBit(botRow, x)))
+            {
+                if (output)
+                    setBit(output->getBotRow(y), x);
+                ++downPassages[root];
+            }
+        }
+
+        // Компоненты нумеруются заново по первой клетке, чтобы метки следующей строки были < width
+        for (std::size_t x = 0; x < width; ++x)
+        {
+            if (nextLabels[roots[x]] == NO_LABEL)
+                nextLabels[roots[x]] = x;
+            upperLabels[x] = nextLabels[roots[x]];
+        }
+        for (std::size_t x = 0; x < width; ++x)
+            nextLabels[roots[x]] = NO_LABEL;
+    }
+}
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeEntropyCoder::encode(const PackedMazeGrid &grid, std::vector<std::uint8_t> &encoded)
+{
+    RangeEncoder encoder(encoded);
+    codeCells(encoder, grid, nullptr);
+    encoder.flush();
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool MazeEntropyCoder::decode(const std::uint8_t *encoded, std::size_t encodedSize, PackedMazeGrid &grid)
+{
+    grid.clear();
+    RangeDecoder decoder(encoded, encodedSize);
+    codeCells(decoder, grid, &grid);
+    return !decoder.isOverrun();
+}
@@ -0,0 +1,147 @@
+#include "mazegenerator.h"
+#include "cyclepoppinggenerator.h"
+#include "mazerandom.h"
+#include "rowwisegenerator.h"
+#include "tracezones.h"
+#include "uniformtreegenerator.h"
+
+#include <vector>
+
+GenerationParameters::GenerationParameters()
+    : algorithm(0),
+      width(0),
+      height(0),
+      seed(0)
+{
+}
+
+/*------------------------------------------------------------------------------------------------*/
+GenerationParameters::GenerationParameters(int algorithm, std::size_t width, std::size_t height, std::uint64_t seed)
+    : algorithm(algorithm),
+      width(width),
+      height(height),
+      seed(seed)
+{
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool GenerationParameters::operator==(const GenerationParameters &other) const
+{
+    return algorithm == other.algorithm && width == other.width &&
+            height == other.height && seed == other.seed;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool GenerationParameters::operator!=(const GenerationParameters &other) const
+{
+    return !(*this == other);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool MazeGenerator::isSupported(int algorithm)
+{
+    return algorithm >= 0 && algorithm < Algorithm::Count;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool MazeGenerator::isSupported(const GenerationParameters &parameters)
+{
+    if (!isSupported(parameters.algorithm))
+        return false;
+    // Остальные генераторы индексируют клетки std::size_t
+    if (parameters.algorithm == Algorithm::CyclePopping)
+        return CyclePoppingGenerator::isSupported(parameters.width, parameters.height);
+    return true;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeGenerator::generate(const GenerationParameters &parameters, PackedMazeGrid &grid)
+{
+    MAZE_TRACE_ZONE_ARG("MazeGenerator::generate", "algorithm", parameters.algorithm);
+    switch (parameters.algorithm)
+    {
+    case Algorithm::AldousBroder :
+        UniformTreeGenerator(parameters.width, parameters.height, parameters.seed).
+                generate(UniformTreeGenerator::Algorithm::AldousBroder, grid);
+        break;
+    case Algorithm::RecursiveBacktracker :
+        generateRecursiveBacktracker(parameters, grid);
+        break;
+    case Algorithm::Wilson :
+        UniformTreeGenerator(parameters.width, parameters.height, parameters.seed).
+                generate(UniformTreeGenerator::Algorithm::Wilson, grid);
+        break;
+    case Algorithm::BinaryTree :
+        RowWiseGenerator(parameters.width, parameters.height, parameters.seed).
+                generate(RowWiseGenerator::Algorithm::BinaryTree, grid);
+        break;
+    case Algorithm::Sidewinder :
+        RowWiseGenerator(parameters.width, parameters.height, parameters.seed).
+                generate(RowWiseGenerator::Algorithm::Sidewinder, grid);
+        break;
+    case Algorithm::CyclePopping :
+        CyclePoppingGenerator(parameters.width, parameters.height, parameters.seed).generate(grid);
+        break;
+    }
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeGenerator::generateRecursiveBacktracker(const GenerationParameters &parameters, PackedMazeGrid &grid)
+{
+    const std::size_t width = parameters.width;
+    const std::size_t height = parameters.height;
+    grid.resize(width, height);
+    if (width == 0 || height == 0)
+        return;
+
+    MazeRandom random(parameters.seed);
+    std::vector<std::uint8_t> visited(width * height, 0);
+    std::vector<std::size_t> backtrackingStack {0};
+    visited[0] = 1;
+
+    while (!backtrackingStack.empty())
+    {
+        const std::size_t cell = backtrackingStack.back();
+        const std::size_t x = cell % width;
+        const std::size_t y = cell / width;
+
+        int directions[PackedMazeGrid::Direction::Count] {};
+        std::uint32_t directionCount {0};
+        if (y > 0 && !visited[cell - width])
+            directions[directionCount++] = PackedMazeGrid::Direction::Top;
+        if (x + 1 < width && !visited[cell + 1])
+            directions[directionCount++] = PackedMazeGrid::Direction::Right;
+        if (y + 1 < height && !visited[cell + width])
+            directions[directionCount++] = PackedMazeGrid::Direction::Bot;
+        if (x > 0 && !visited[cell - 1])
+            directions[directionCount++] = PackedMazeGrid::Direction::Left;
+
+        if (directionCount == 0)
+        {
+            backtrackingStack.pop_back();
+            continue;
+        }
+
+        const int direction = directions[random.bounded(directionCount)];
+        grid.setPassage(x, y, direction, true);
+
+        std::size_t nextCell = cell;
+        switch (direction)
+        {
+        case PackedMazeGrid::Direction::Top :
+            nextCell -= width;
+            break;
+        case PackedMazeGrid::Direction::Right :
+            nextCell += 1;
+            break;
+        case PackedMazeGrid::Direction::Bot :
+            nextCell += width;
+            break;
+        case PackedMazeGrid::Direction::Left :
+            nextCell -= 1;
+            break;
+        }
+        visited[nextCell] = 1;
+        backtrackingStack.push_back(nextCell);
+    }
+}
@@ -0,0 +1,134 @@
+#include "mazehashset.h"
+
+#include <limits>
+
+MazeHashSet::MazeHashSet(std::size_t capacity)
+{
+    reserve(capacity);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeHashSet::reserve(std::size_t capacity)
+{
+    if (keys_ && capacity <= capacity_)
+        return;
+
+    std::size_t slotCount {2};
+    while (slotCount < capacity * 2)
+        slotCount *= 2;
+    // Новые таблицы строятся рядом со старыми: если памяти не хватит, множество останется прежним
+    std::unique_ptr<std::atomic<std::uint64_t>[]> keys(new std::atomic<std::uint64_t>[slotCount]);
+    std::unique_ptr<std::atomic<std::uint64_t>[]> firstOrdinals(new std::atomic<std::uint64_t>[slotCount]);
+    for (std::size_t slot = 0; slot < slotCount; ++slot)
+    {
+        keys[slot].store(EMPTY_KEY, std::memory_order_relaxed);
+        firstOrdinals[slot].store(std::numeric_limits<std::uint64_t>::max(), std::memory_order_relaxed);
+    }
+
+    const std::size_t slotMask = slotCount - 1;
+    for (std::size_t oldSlot = 0; keys_ && oldSlot <= slotMask_; ++oldSlot)
+    {
+        const std::uint64_t key = keys_[oldSlot].load(std::memory_order_relaxed);
+        if (key == EMPTY_KEY)
+            continue;
+        std::size_t slot = static_cast<std::size_t>(key) & slotMask;
+        while (keys[slot].load(std::memory_order_relaxed) != EMPTY_KEY)
+            slot = (slot + 1) & slotMask;
+        keys[slot].store(key, std::memory_order_relaxed);
+        firstOrdinals[slot].store(firstOrdinals_[oldSlot].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
+    keys_.swap(keys);
+    firstOrdinals_.swap(firstOrdinals);
+    slotMask_ = slotMask;
+    capacity_ = capacity;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::uint64_t MazeHashSet::toKey(std::uint64_t hash)
+{
+    return hash == EMPTY_KEY ? 1 : hash;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::size_t MazeHashSet::getFirstSlot(std::uint64_t key) const
+{
+    // Хеши лабиринтов уже перемешаны, младших битов достаточно
+    return static_cast<std::size_t>(key) & slotMask_;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+MazeHashSet::InsertResult MazeHashSet::insert(std::uint64_t hash, std::uint64_t ordinal)
+{
+    const std::uint64_t key = toKey(hash);
+    for (std::size_t slot = getFirstSlot(key), probe = 0; probe <= slotMask_; slot = (slot + 1) & slotMask_, ++probe)
+    {
+        std::uint64_t current = keys_[slot].load(std::memory_order_acquire);
+        bool isInserted {false};
+        if (current == EMPTY_KEY)
+        {
+            // Место резервируется до захвата ячейки, чтобы ни при каких гонках не превысить capacity
+            if (size_.fetch_add(1, std::memory_order_relaxed) >= capacity_)
+            {
+                size_.fetch_sub(1, std::memory_order_relaxed);
+                return Full;
+            }
+            isInserted = keys_[slot].compare_exchange_strong(current, key, std::memory_order_acq_rel);
+            if (!isInserted)
+                size_.fetch_sub(1, std::memory_order_relaxed);
+        }
+        if (!isInserted && current != key)
+            continue;
+
+        // Номер уменьшается и тем, кто вставил хеш, и тем, кто пришел с повтором, - в любом порядке
+        std::uint64_t firstOrdinal = firstOrdinals_[slot].load(std::memory_order_relaxed);
+        while (ordinal < firstOrdinal &&
+               !firstOrdinals_[slot].compare_exchange_weak(firstOrdinal, ordinal, std::memory_order_relaxed))
+        {
+        }
+        return isInserted ? Inserted : Duplicate;
+    }
+    return Full;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool MazeHashSet::contains(std::uint64_t hash) const
+{
+    const std::uint64_t key = toKey(hash);
+    for (std::size_t slot = getFirstSlot(key), probe = 0; probe <= slotMask_; slot = (slot + 1) & slotMask_, ++probe)
+    {
+        const std::uint64_t current = keys_[slot].load(std::memory_order_acquire);
+        if (current == key)
+            return true;
+        if (current == EMPTY_KEY)
+            return false;
+    }
+    return false;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool MazeHashSet::isFirst(std::uint64_t hash, std::uint64_t ordinal) const
+{
+    const std::uint64_t key = toKey(hash);
+    for (std::size_t slot = getFirstSlot(key), probe = 0; probe <= slotMask_; slot = (slot + 1) & slotMask_, ++probe)
+    {
+        const std::uint64_t current = keys_[slot].load(std::memory_order_acquire);
+        if (current == key)
+            return firstOrdinals_[slot].load(std::memory_order_relaxed) == ordinal;
+        if (current == EMPTY_KEY)
+            return false;
+    }
+    return false;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::size_t MazeHashSet::getSize() const
+{
+    return size_.load(std::memory_order_relaxed);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::size_t MazeHashSet::getCapacity() const
+{
+    return capacity_;
+}
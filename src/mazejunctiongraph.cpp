@@ -0,0 +1,578 @@
+#include "mazejunctiongraph.h"
+#include "tracezones.h"
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <thread>
+
+namespace
+{
+// Биты проходов клетки в openings_, по одному на PackedMazeGrid::Direction
+const std::uint8_t DEGREES[16] {0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4};
+const std::uint8_t FIRST_DIRECTIONS[16] {0, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0};
+// Ссылки на родителя при поиске пути
+const std::uint32_t NOT_REACHED {0xFFFFFFFF};
+const std::uint32_t SOURCE {0xFFFFFFFE};
+
+int getReverseDirection(int direction)
+{
+    return (direction + 2) % PackedMazeGrid::Direction::Count;
+}
+
+// Номер ребра среди ребер узла: ребра идут по порядку направлений
+std::size_t getDirectionRank(std::uint8_t openings, int direction)
+{
+    return DEGREES[openings & ((1u << direction) - 1)];
+}
+}
+
+bool MazeJunctionGraph::build(const PackedMazeGrid &grid, unsigned int threadCount)
+{
+    MAZE_TRACE_ZONE("MazeJunctionGraph::build");
+    width_ = 0;
+    height_ = 0;
+    nodeCells_.clear();
+    nodeEdgeOffsets_.assign(1, 0);
+    nodeEdges_.clear();
+    edges_.clear();
+    corridorCells_.clear();
+    cellLocations_.clear();
+    maxEdgeLength_ = 0;
+    hasCycles_ = false;
+    if (grid.getCellCount() >= CORRIDOR_FLAG)
+        return false;
+
+    width_ = grid.getWidth();
+    height_ = grid.getHeight();
+    openings_.assign(grid.getCellCount(), 0);
+    cellLocations_.assign(grid.getCellCount(), std::uint32_t(NO_NODE));
+
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    const std::size_t maxThreads = std::max<std::size_t>(1, grid.getCellCount() / MIN_CELLS_PER_THREAD);
+    const std::size_t bandCount = std::min<std::size_t>({threadCount, maxThreads, std::max<std::size_t>(1, height_)});
+    const std::size_t rowsPerBand = (height_ + bandCount - 1) / bandCount;
+    std::vector<Band> bands(bandCount);
+    for (std::size_t band = 0; band < bandCount; ++band)
+    {
+        bands[band].firstRow = std::min(height_, band * rowsPerBand);
+        bands[band].endRow = std::min(height_, bands[band].firstRow + rowsPerBand);
+    }
+
+    // Полоса 0 обрабатывается в вызывающем потоке
+    const auto forEachBand = [&bands](const std::function<void(Band&)> &work) {
+        std::vector<std::thread> threads;
+        for (std::size_t band = 1; band < bands.size(); ++band)
+            threads.emplace_back(work, std::ref(bands[band]));
+        work(bands[0]);
+        for (std::thread &thread : threads)
+            thread.join();
+    };
+
+    forEachBand([this, &grid](Band &band) { findOpenings(grid, band); });
+    std::uint32_t nodeCount {0};
+    std::uint64_t slotCount {0};
+    for (Band &band : bands)
+    {
+        band.firstNode = nodeCount;
+        band.firstSlot = slotCount;
+        nodeCount += band.nodeCount;
+        slotCount += band.slotCount;
+    }
+    nodeCells_.resize(nodeCount);
+    nodeEdgeOffsets_.resize(nodeCount + std::size_t(1));
+    nodeEdgeOffsets_.back() = slotCount;
+    nodeEdges_.resize(static_cast<std::size_t>(slotCount));
+
+    // Коридоры проходятся только после нумерации всех узлов: конец коридора может быть в чужой полосе
+    forEachBand([this](Band &band) { numberNodes(band); });
+    forEachBand([this](Band &band) { traceCorridors(band); });
+    std::uint32_t edgeCount {0};
+    std::uint64_t corridorCellCount {0};
+    for (Band &band : bands)
+    {
+        band.firstEdge = edgeCount;
+        band.firstCorridorCell = corridorCellCount;
+        edgeCount += static_cast<std::uint32_t>(band.edges.size());
+        corridorCellCount += band.corridorCells.size();
+    }
+    edges_.resize(edgeCount);
+    corridorCells_.resize(static_cast<std::size_t>(corridorCellCount));
+    forEachBand([this](Band &band) { publishEdges(band); });
+
+    // Каждая клетка - узел или клетка коридора, если в сетке нет циклов без развилок и тупиков
+    if (nodeCount + corridorCellCount < grid.getCellCount())
+        addCycleNodes();
+    hasCycles_ = findCycles();
+    for (const Edge &edge : edges_)
+        maxEdgeLength_ = std::max(maxEdgeLength_, edge.length);
+    std::vector<std::uint8_t>().swap(openings_);
+    return true;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeJunctionGraph::findOpenings(const PackedMazeGrid &grid, Band &band)
+{
+    MAZE_TRACE_ZONE("MazeJunctionGraph::findOpenings");
+    for (std::size_t row = band.firstRow; row < band.endRow; ++row)
+    {
+        const std::uint64_t *right = grid.getRightRow(row);
+        const std::uint64_t *bot = row + 1 < height_ ? grid.getBotRow(row) : nullptr;
+        const std::uint64_t *top = row > 0 ? grid.getBotRow(row - 1) : nullptr;
+        std::uint8_t *openings = &openings_[row * width_];
+        std::uint8_t hasLeft {0};
+        for (std::size_t x = 0; x < width_; ++x)
+        {
+            const std::size_t word = x / PackedMazeGrid::BITS_PER_WORD;
+            const std::size_t bit = x % PackedMazeGrid::BITS_PER_WORD;
+            const std::uint8_t hasRight = x + 1 < width_ ? (right[word] >> bit) & 1 : 0;
+            const std::uint8_t cellOpenings = static_cast<std::uint8_t>(
+                        (top ? (top[word] >> bit) & 1 : 0) << PackedMazeGrid::Direction::Top |
+                        hasRight << PackedMazeGrid::Direction::Right |
+                        (bot ? (bot[word] >> bit) & 1 : 0) << PackedMazeGrid::Direction::Bot |
+                        hasLeft << PackedMazeGrid::Direction::Left);
+            hasLeft = hasRight;
+
+            openings[x] = cellOpenings;
+            if (DEGREES[cellOpenings] != 2)
+            {
+                ++band.nodeCount;
+                band.slotCount += DEGREES[cellOpenings];
+            }
+        }
+    }
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeJunctionGraph::numberNodes(Band &band)
+{
+    std::uint32_t node = band.firstNode;
+    std::uint64_t slot = band.firstSlot;
+    for (std::size_t cell = band.firstRow * width_; cell < band.endRow * width_; ++cell)
+    {
+        const std::uint8_t degree = DEGREES[openings_[cell]];
+        if (degree == 2)
+            continue;
+        nodeCells_[node] = static_cast<std::uint32_t>(cell);
+        nodeEdgeOffsets_[node] = slot;
+        cellLocations_[cell] = node;
+        slot += degree;
+        ++node;
+    }
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeJunctionGraph::traceCorridors(Band &band) const
+{
+    MAZE_TRACE_ZONE("MazeJunctionGraph::traceCorridors");
+    const std::size_t steps[PackedMazeGrid::Direction::Count] {std::size_t(0) - width_, 1, width_, std::size_t(0) - 1};
+    // Оценка сверху для дерева: ребер вдвое меньше выходов из узлов, коридоров не больше не-узлов полосы
+    band.edges.reserve(static_cast<std::size_t>(band.slotCount / 2 + 1));
+    band.corridorCells.reserve((band.endRow - band.firstRow) * width_ - band.nodeCount);
+    for (std::uint32_t node = band.firstNode; node < band.firstNode + band.nodeCount; ++node)
+    {
+        const std::uint8_t nodeOpenings = openings_[nodeCells_[node]];
+        for (int startDirection = 0; startDirection < PackedMazeGrid::Direction::Count; ++startDirection)
+        {
+            if (!(nodeOpenings & (1u << startDirection)))
+                continue;
+
+            const std::size_t firstCell = band.corridorCells.size();
+            std::size_t cell = nodeCells_[node];
+            int direction = startDirection;
+            std::uint32_t length {0};
+            for (;;)
+            {
+                cell += steps[direction];
+                ++length;
+                // Узел узнается по проходам, чтобы коридор читал один байтовый массив
+                if (DEGREES[openings_[cell]] != 2)
+                    break;
+                band.corridorCells.push_back(static_cast<std::uint32_t>(cell));
+                direction = FIRST_DIRECTIONS[openings_[cell] & ~(1u << getReverseDirection(direction))];
+            }
+
+            // Каждый коридор проходится с обоих концов, ребро остается у узла с меньшим номером
+            const std::uint32_t endNode = cellLocations_[cell];
+            const int endDirection = getReverseDirection(direction);
+            if (node < endNode || (node == endNode && startDirection < endDirection))
+                band.edges.push_back(Edge {node, endNode, length, static_cast<std::uint8_t>(startDirection),
+                                           static_cast<std::uint8_t>(endDirection), firstCell});
+            else
+                band.corridorCells.resize(firstCell);
+        }
+    }
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeJunctionGraph::publishEdges(Band &band)
+{
+    std::copy(band.corridorCells.begin(), band.corridorCells.end(),
+              corridorCells_.begin() + static_cast<std::ptrdiff_t>(band.firstCorridorCell));
+    for (std::size_t index = 0; index < band.edges.size(); ++index)
+    {
+        Edge edge = band.edges[index];
+        const std::uint32_t edgeIndex = band.firstEdge + static_cast<std::uint32_t>(index);
+        edge.firstCell += band.firstCorridorCell;
+        edges_[edgeIndex] = edge;
+
+        for (std::uint64_t cell = edge.firstCell; cell < edge.firstCell + edge.length - 1; ++cell)
+            cellLocations_[corridorCells_[cell]] = CORRIDOR_FLAG | edgeIndex;
+        nodeEdges_[nodeEdgeOffsets_[edge.fromNode] +
+                getDirectionRank(openings_[nodeCells_[edge.fromNode]], edge.fromDirection)] = edgeIndex;
+        nodeEdges_[nodeEdgeOffsets_[edge.toNode] +
+                getDirectionRank(openings_[nodeCells_[edge.toNode]], edge.toDirection)] = edgeIndex;
+    }
+    std::vector<Edge>().swap(band.edges);
+    std::vector<std::uint32_t>().swap(band.corridorCells);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeJunctionGraph::addCycleNodes()
+{
+    MAZE_TRACE_ZONE("MazeJunctionGraph::addCycleNodes");
+    const std::size_t steps[PackedMazeGrid::Direction::Count] {std::size_t(0) - width_, 1, width_, std::size_t(0) - 1};
+    for (std::size_t nodeCell = 0; nodeCell < cellLocations_.size(); ++nodeCell)
+    {
+        if (cellLocations_[nodeCell] != NO_NODE)
+            continue;
+
+        // Клетка цикла становится узлом степени 2, а весь цикл - ребром-петлей из неё
+        const std::uint32_t node = static_cast<std::uint32_t>(nodeCells_.size());
+        const std::uint32_t edgeIndex = static_cast<std::uint32_t>(edges_.size());
+        const std::uint8_t nodeOpenings = openings_[nodeCell];
+        nodeCells_.push_back(static_cast<std::uint32_t>(nodeCell));
+        nodeEdgeOffsets_.push_back(nodeEdgeOffsets_.back() + 2);
+        nodeEdges_.resize(nodeEdges_.size() + 2, edgeIndex);
+        cellLocations_[nodeCell] = node;
+
+        const int startDirection = FIRST_DIRECTIONS[nodeOpenings];
+        const std::uint64_t firstCell = corridorCells_.size();
+        std::size_t cell = nodeCell;
+        int direction = startDirection;
+        std::uint32_t length {0};
+        for (;;)
+        {
+            cell += steps[direction];
+            ++length;
+            if (cell == nodeCell)
+                break;
+            corridorCells_.push_back(static_cast<std::uint32_t>(cell));
+            cellLocations_[cell] = CORRIDOR_FLAG | edgeIndex;
+            direction = FIRST_DIRECTIONS[openings_[cell] & ~(1u << getReverseDirection(direction))];
+        }
+        edges_.push_back(Edge {node, node, length, static_cast<std::uint8_t>(startDirection),
+                               static_cast<std::uint8_t>(getReverseDirection(direction)), firstCell});
+    }
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool MazeJunctionGraph::findCycles() const
+{
+    // Ребро между узлами, уже связанными другими ребрами, замыкает цикл; петля - тоже цикл
+    std::vector<std::uint32_t> parents(nodeCells_.size());
+    for (std::uint32_t node = 0; node < parents.size(); ++node)
+        parents[node] = node;
+    const auto findRoot = [&parents](std::uint32_t node) {
+        while (parents[node] != node)
+            node = parents[node] = parents[parents[node]];
+        return node;
+    };
+    for (const Edge &edge : edges_)
+    {
+        const std::uint32_t fromRoot = findRoot(edge.fromNode);
+        const std::uint32_t toRoot = findRoot(edge.toNode);
+        if (fromRoot == toRoot)
+            return true;
+        parents[fromRoot] = toRoot;
+    }
+    return false;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::size_t MazeJunctionGraph::getWidth() const
+{
+    return width_;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::size_t MazeJunctionGraph::getHeight() const
+{
+    return height_;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::size_t MazeJunctionGraph::getNodeCount() const
+{
+    return nodeCells_.size();
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool MazeJunctionGraph::hasCycles() const
+{
+    return hasCycles_;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::size_t MazeJunctionGraph::getEdgeCount() const
+{
+    return edges_.size();
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::uint32_t MazeJunctionGraph::getNodeCell(std::uint32_t node) const
+{
+    return nodeCells_[node];
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::size_t MazeJunctionGraph::getNodeDegree(std::uint32_t node) const
+{
+    return static_cast<std::size_t>(nodeEdgeOffsets_[node + 1] - nodeEdgeOffsets_[node]);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::uint32_t MazeJunctionGraph::getNodeEdge(std::uint32_t node, std::size_t index) const
+{
+    return nodeEdges_[nodeEdgeOffsets_[node] + index];
+}
+
+/*------------------------------------------------------------------------------------------------*/
+const MazeJunctionGraph::Edge& MazeJunctionGraph::getEdge(std::uint32_t edge) const
+{
+    return edges_[edge];
+}
+
+/*------------------------------------------------------------------------------------------------*/
+const std::uint32_t* MazeJunctionGraph::getCorridorCells(std::uint32_t edge) const
+{
+    return corridorCells_.data() + edges_[edge].firstCell;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::uint32_t MazeJunctionGraph::getCellNode(std::size_t cell) const
+{
+    return cellLocations_[cell] & CORRIDOR_FLAG ? NO_NODE : cellLocations_[cell];
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::uint32_t MazeJunctionGraph::getCellEdge(std::size_t cell) const
+{
+    return cellLocations_[cell] & CORRIDOR_FLAG ? cellLocations_[cell] & ~CORRIDOR_FLAG : NO_NODE;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::size_t MazeJunctionGraph::getCorridorPosition(std::uint32_t edge, std::uint32_t cell) const
+{
+    const std::uint32_t *cells = getCorridorCells(edge);
+    return static_cast<std::size_t>(std::find(cells, cells + edges_[edge].length - 1, cell) - cells);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeJunctionGraph::appendCorridor(std::uint32_t edge, std::size_t first, std::size_t last,
+                                       std::vector<std::uint32_t> &path) const
+{
+    // Границы включительно, first > last - обратный порядок, от toNode к fromNode
+    const std::uint32_t *cells = getCorridorCells(edge);
+    if (first <= last)
+        path.insert(path.end(), cells + first, cells + last + 1);
+    else
+        path.insert(path.end(), std::reverse_iterator<const std::uint32_t*>(cells + first + 1),
+                    std::reverse_iterator<const std::uint32_t*>(cells + last));
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::uint64_t MazeJunctionGraph::getExitLength(std::uint32_t edge, std::size_t position, std::uint32_t node) const
+{
+    const Edge &corridor = edges_[edge];
+    const std::uint64_t toStart = position + 1;
+    const std::uint64_t toEnd = corridor.length - 1 - position;
+    if (corridor.fromNode == corridor.toNode)
+        return std::min(toStart, toEnd);
+    return node == corridor.fromNode ? toStart : toEnd;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool MazeJunctionGraph::isExitAtEnd(std::uint32_t edge, std::size_t position, std::uint32_t node) const
+{
+    const Edge &corridor = edges_[edge];
+    if (corridor.fromNode == corridor.toNode)
+        return corridor.length - 1 - position < position + 1;
+    return node == corridor.toNode;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::uint32_t MazeJunctionGraph::searchTree(std::size_t fromCell, std::size_t toCell,
+                                            std::vector<std::uint32_t> &parentEdges) const
+{
+    // Обход в ширину по узлам от toCell (от обоих концов его коридора)
+    const std::uint32_t fromEdge = getCellEdge(fromCell);
+    const std::uint32_t toEdge = getCellEdge(toCell);
+    std::vector<std::uint32_t> queue;
+    const auto addSource = [&parentEdges, &queue](std::uint32_t node) {
+        parentEdges[node] = SOURCE;
+        queue.push_back(node);
+    };
+    if (toEdge == NO_NODE)
+        addSource(cellLocations_[toCell]);
+    else
+    {
+        addSource(edges_[toEdge].fromNode);
+        if (edges_[toEdge].toNode != edges_[toEdge].fromNode)
+            addSource(edges_[toEdge].toNode);
+    }
+
+    // Из клетки коридора путь выходит через тот его конец, до которого обход дошел первым
+    const std::uint32_t firstExit = fromEdge == NO_NODE ? cellLocations_[fromCell] : edges_[fromEdge].fromNode;
+    const std::uint32_t secondExit = fromEdge == NO_NODE ? cellLocations_[fromCell] : edges_[fromEdge].toNode;
+    for (std::size_t head = 0; head < queue.size() && parentEdges[firstExit] == NOT_REACHED &&
+         parentEdges[secondExit] == NOT_REACHED; ++head)
+    {
+        const std::uint32_t node = queue[head];
+        for (std::uint64_t slot = nodeEdgeOffsets_[node]; slot < nodeEdgeOffsets_[node + 1]; ++slot)
+        {
+            const Edge &edge = edges_[nodeEdges_[slot]];
+            const std::uint32_t neighbor = edge.fromNode == node ? edge.toNode : edge.fromNode;
+            if (parentEdges[neighbor] == NOT_REACHED)
+            {
+                parentEdges[neighbor] = nodeEdges_[slot];
+                queue.push_back(neighbor);
+            }
+        }
+    }
+
+    if (parentEdges[firstExit] != NOT_REACHED)
+        return firstExit;
+    return parentEdges[secondExit] != NOT_REACHED ? secondExit : NO_NODE;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::uint32_t MazeJunctionGraph::searchShortest(std::size_t fromCell, std::size_t toCell, std::uint64_t maxLength,
+                                                std::vector<std::uint32_t> &parentEdges) const
+{
+    const std::uint32_t fromEdge = getCellEdge(fromCell);
+    const std::uint32_t toEdge = getCellEdge(toCell);
+    const std::size_t fromPosition = fromEdge == NO_NODE ? 0 :
+                                                           getCorridorPosition(fromEdge, static_cast<std::uint32_t>(fromCell));
+    /* Длины ребер - небольшие целые, поэтому вместо кучи очередь Дейкстры - кольцо корзин по длине
+     * пути (алгоритм Дайала): узел с длиной length лежит в корзине length % bucketCount, а все длины
+     * в очереди отличаются от текущей меньше, чем на самое длинное ребро */
+    const std::uint64_t NO_LENGTH {~std::uint64_t(0)};
+    const std::size_t bucketCount = static_cast<std::size_t>(maxEdgeLength_) + 1;
+    std::vector<std::uint64_t> lengths(nodeCells_.size(), NO_LENGTH);
+    std::vector<std::vector<std::uint32_t>> buckets(bucketCount);
+    std::size_t queuedCount {0};
+    const auto enqueue = [&](std::uint32_t node, std::uint64_t length, std::uint32_t parentEdge) {
+        if (length >= lengths[node])
+            return;
+        lengths[node] = length;
+        parentEdges[node] = parentEdge;
+        buckets[static_cast<std::size_t>(length % bucketCount)].push_back(node);
+        ++queuedCount;
+    };
+    std::uint64_t length {0};
+    if (toEdge == NO_NODE)
+        enqueue(cellLocations_[toCell], 0, SOURCE);
+    else
+    {
+        const std::size_t toPosition = getCorridorPosition(toEdge, static_cast<std::uint32_t>(toCell));
+        const std::uint64_t fromNodeLength = getExitLength(toEdge, toPosition, edges_[toEdge].fromNode);
+        const std::uint64_t toNodeLength = getExitLength(toEdge, toPosition, edges_[toEdge].toNode);
+        enqueue(edges_[toEdge].fromNode, fromNodeLength, SOURCE);
+        enqueue(edges_[toEdge].toNode, toNodeLength, SOURCE);
+        length = std::min(fromNodeLength, toNodeLength);
+    }
+
+    // Длина пути через узел известна, когда узел снят с очереди; дальше ищется только путь короче
+    std::uint64_t bestLength = maxLength;
+    std::uint32_t bestExit = NO_NODE;
+    for (; queuedCount > 0 && length < bestLength; ++length)
+    {
+        std::vector<std::uint32_t> &bucket = buckets[static_cast<std::size_t>(length % bucketCount)];
+        // Ребра не короче 1, поэтому в текущую корзину во время её разбора ничего не добавляется
+        for (const std::uint32_t node : bucket)
+        {
+            --queuedCount;
+            if (lengths[node] != length)
+                continue;
+
+            const bool isExit = fromEdge == NO_NODE ? node == cellLocations_[fromCell] :
+                                                      node == edges_[fromEdge].fromNode || node == edges_[fromEdge].toNode;
+            if (isExit)
+            {
+                const std::uint64_t exitLength = length + (fromEdge == NO_NODE ? 0 :
+                                                                                 getExitLength(fromEdge, fromPosition, node));
+                if (exitLength < bestLength)
+                {
+                    bestLength = exitLength;
+                    bestExit = node;
+                }
+            }
+
+            for (std::uint64_t slot = nodeEdgeOffsets_[node]; slot < nodeEdgeOffsets_[node + 1]; ++slot)
+            {
+                const Edge &edge = edges_[nodeEdges_[slot]];
+                enqueue(edge.fromNode == node ? edge.toNode : edge.fromNode, length + edge.length, nodeEdges_[slot]);
+            }
+        }
+        bucket.clear();
+    }
+    return bestExit;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::vector<std::uint32_t> MazeJunctionGraph::findPath(std::size_t fromCell, std::size_t toCell) const
+{
+    MAZE_TRACE_ZONE("MazeJunctionGraph::findPath");
+    std::vector<std::uint32_t> path;
+    if (fromCell >= cellLocations_.size() || toCell >= cellLocations_.size())
+        return path;
+    if (fromCell == toCell)
+        return std::vector<std::uint32_t> {static_cast<std::uint32_t>(fromCell)};
+
+    const std::uint32_t fromEdge = getCellEdge(fromCell);
+    const std::uint32_t toEdge = getCellEdge(toCell);
+    const std::size_t fromPosition = fromEdge == NO_NODE ? 0 :
+                                                           getCorridorPosition(fromEdge, static_cast<std::uint32_t>(fromCell));
+    const std::size_t toPosition = toEdge == NO_NODE ? 0 :
+                                                       getCorridorPosition(toEdge, static_cast<std::uint32_t>(toCell));
+    // В дереве путь между клетками одного коридора идет по нему; с циклами обход может быть короче
+    const bool isSameCorridor = fromEdge != NO_NODE && fromEdge == toEdge;
+    const std::uint64_t corridorLength = fromPosition > toPosition ? fromPosition - toPosition : toPosition - fromPosition;
+    std::vector<std::uint32_t> parentEdges;
+    std::uint32_t node = NO_NODE;
+    if (!isSameCorridor || hasCycles_)
+    {
+        parentEdges.assign(nodeCells_.size(), NOT_REACHED);
+        node = hasCycles_ ? searchShortest(fromCell, toCell, isSameCorridor ? corridorLength : ~std::uint64_t(0),
+                                           parentEdges) :
+                            searchTree(fromCell, toCell, parentEdges);
+    }
+    if (node == NO_NODE)
+    {
+        if (isSameCorridor)
+            appendCorridor(fromEdge, fromPosition, toPosition, path);
+        return path;
+    }
+
+    if (fromEdge != NO_NODE)
+        appendCorridor(fromEdge, fromPosition, isExitAtEnd(fromEdge, fromPosition, node) ? edges_[fromEdge].length - 2 : 0,
+                       path);
+    path.push_back(nodeCells_[node]);
+
+    while (parentEdges[node] != SOURCE)
+    {
+        const std::uint32_t edgeIndex = parentEdges[node];
+        const Edge &edge = edges_[edgeIndex];
+        const bool isForward = edge.fromNode == node;
+        if (edge.length > 1)
+            appendCorridor(edgeIndex, isForward ? 0 : edge.length - 2, isForward ? edge.length - 2 : 0, path);
+        node = isForward ? edge.toNode : edge.fromNode;
+        path.push_back(nodeCells_[node]);
+    }
+
+    if (toEdge != NO_NODE)
+        appendCorridor(toEdge, isExitAtEnd(toEdge, toPosition, node) ? edges_[toEdge].length - 2 : 0, toPosition, path);
+    return path;
+}
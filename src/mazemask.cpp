@@ -0,0 +1,226 @@
+#include "mazemask.h"
+
+#include <algorithm>
+#include <cctype>
+#include <limits>
+
+namespace
+{
+unsigned int countSetBits(std::uint64_t word)
+{
+#if defined(__GNUC__)
+    return static_cast<unsigned int>(__builtin_popcountll(word));
+#else
+    unsigned int count {0};
+    for (; word != 0; word &= word - 1)
+        ++count;
+    return count;
+#endif
+}
+
+unsigned int countTrailingZeros(std::uint64_t word)
+{
+#if defined(__GNUC__)
+    return static_cast<unsigned int>(__builtin_ctzll(word));
+#else
+    unsigned int count {0};
+    for (; !(word & 1); word >>= 1)
+        ++count;
+    return count;
+#endif
+}
+
+// Позиция установленного бита с номером index (с нуля) среди установленных битов слова
+unsigned int selectBit(std::uint64_t word, unsigned int index)
+{
+    // Сначала половинами по 32, 16 и 8 бит, оставшийся байт - сбросом младших битов
+    unsigned int offset {0};
+    for (unsigned int half = 32; half >= 8; half /= 2)
+    {
+        const unsigned int lowCount = countSetBits(word & ((std::uint64_t(1) << half) - 1));
+        if (index >= lowCount)
+        {
+            index -= lowCount;
+            word >>= half;
+            offset += half;
+        }
+    }
+    for (; index > 0; --index)
+        word &= word - 1;
+    return offset + countTrailingZeros(word);
+}
+
+// Предел стороны маски: произведение сторон и байты данных помещаются в 64 бита
+const std::uint64_t MAX_PBM_SIDE {std::uint64_t(1) << 31};
+// Для потока без известного размера: 2^30 клеток - около 256 МБ на биты и индекс
+const std::uint64_t MAX_UNSIZED_PBM_CELLS {std::uint64_t(1) << 30};
+
+// Следующее число заголовка PBM; комментарии от '#' до конца строки пропускаются
+bool readPbmNumber(std::istream &stream, std::size_t &number)
+{
+    int symbol = stream.get();
+    for (; stream && (std::isspace(symbol) || symbol == '#'); symbol = stream.get())
+    {
+        if (symbol == '#')
+            stream.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    }
+    if (!stream || !std::isdigit(symbol))
+        return false;
+    number = 0;
+    for (; stream && std::isdigit(symbol); symbol = stream.get())
+    {
+        const std::size_t digit = static_cast<std::size_t>(symbol - '0');
+        if (number > (std::numeric_limits<std::size_t>::max() - digit) / 10)
+            return false;
+        number = number * 10 + digit;
+    }
+    // Один пробельный символ после числа - часть заголовка, за ним у P4 сразу идут данные
+    return true;
+}
+
+/* Данных после заголовка должно хватать на dataBytes байтов. Размер остатка известен только у
+ * потока с позиционированием (файла); у остальных потоков ограничивается сама маска */
+bool hasPbmData(std::istream &stream, std::uint64_t dataBytes, std::uint64_t cellCount)
+{
+    if (dataBytes == 0)
+        return true;
+    if (!stream)
+        return false;
+    const std::streampos dataStart = stream.tellg();
+    if (dataStart == std::streampos(-1))
+        return cellCount <= MAX_UNSIZED_PBM_CELLS;
+    stream.seekg(0, std::ios::end);
+    const std::streampos streamEnd = stream.tellg();
+    stream.seekg(dataStart);
+    return stream && streamEnd >= dataStart && static_cast<std::uint64_t>(streamEnd - dataStart) >= dataBytes;
+}
+}
+
+MazeMask::MazeMask(std::size_t width, std::size_t height)
+{
+    resize(width, height);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeMask::resize(std::size_t width, std::size_t height)
+{
+    width_ = width;
+    height_ = height;
+    wordsPerRow_ = (width + BITS_PER_WORD - 1) / BITS_PER_WORD;
+    words_.assign(wordsPerRow_ * height, 0);
+    wordRanks_.assign(words_.size() + 1, 0);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeMask::fill(bool isActive)
+{
+    std::fill(words_.begin(), words_.end(), 0);
+    if (!isActive || width_ == 0)
+        return;
+    // Биты за правым краем остаются нулевыми, иначе rank и select их посчитали бы
+    const std::size_t tailBits = width_ % BITS_PER_WORD;
+    const std::uint64_t lastWordMask = tailBits == 0 ? ~std::uint64_t(0) : (std::uint64_t(1) << tailBits) - 1;
+    for (std::size_t y = 0; y < height_; ++y)
+    {
+        std::fill(words_.begin() + y * wordsPerRow_, words_.begin() + (y + 1) * wordsPerRow_, ~std::uint64_t(0));
+        words_[(y + 1) * wordsPerRow_ - 1] = lastWordMask;
+    }
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::size_t MazeMask::getWidth() const
+{
+    return width_;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::size_t MazeMask::getHeight() const
+{
+    return height_;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeMask::setActive(std::size_t x, std::size_t y, bool isActive)
+{
+    const std::uint64_t bit = std::uint64_t(1) << (x % BITS_PER_WORD);
+    std::uint64_t &word = words_[y * wordsPerRow_ + x / BITS_PER_WORD];
+    word = isActive ? word | bit : word & ~bit;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeMask::buildIndex()
+{
+    std::uint64_t activeCount {0};
+    for (std::size_t word = 0; word < words_.size(); ++word)
+    {
+        wordRanks_[word] = activeCount;
+        activeCount += countSetBits(words_[word]);
+    }
+    wordRanks_[words_.size()] = activeCount;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::size_t MazeMask::getActiveCount() const
+{
+    return wordRanks_.empty() ? 0 : static_cast<std::size_t>(wordRanks_.back());
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeMask::select(std::size_t index, std::size_t &x, std::size_t &y) const
+{
+    // Последнее слово, до которого активных клеток не больше index, - в нем и лежит искомая
+    const std::size_t word = static_cast<std::size_t>(
+                std::upper_bound(wordRanks_.begin(), wordRanks_.end() - 1, std::uint64_t(index)) - wordRanks_.begin()) - 1;
+    const unsigned int bit = selectBit(words_[word], static_cast<unsigned int>(index - wordRanks_[word]));
+    y = word / wordsPerRow_;
+    x = (word % wordsPerRow_) * BITS_PER_WORD + bit;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool MazeMask::readPbm(std::istream &stream, MazeMask &mask)
+{
+    char magic[2] {};
+    std::size_t width {};
+    std::size_t height {};
+    if (!stream.read(magic, sizeof(magic)) || magic[0] != 'P' || (magic[1] != '1' && magic[1] != '4') ||
+            !readPbmNumber(stream, width) || !readPbmNumber(stream, height))
+        return false;
+
+    // Размер проверяется до выделения памяти: испорченный заголовок не должен стоить гигабайтов
+    const bool isBinary = magic[1] == '4';
+    if (width > MAX_PBM_SIDE || height > MAX_PBM_SIDE)
+        return false;
+    // В P4 на строку целое число байтов, в P1 на пиксель хотя бы один символ
+    const std::uint64_t cellCount = static_cast<std::uint64_t>(width) * height;
+    const std::uint64_t dataBytes = isBinary ? static_cast<std::uint64_t>((width + 7) / 8) * height : cellCount;
+    if (!hasPbmData(stream, dataBytes, cellCount))
+        return false;
+
+    mask.resize(width, height);
+    // В P4 строка - целое число байтов, старший бит байта - левый пиксель
+    std::vector<unsigned char> rowBytes(isBinary ? (width + 7) / 8 : 0);
+    for (std::size_t y = 0; y < height; ++y)
+    {
+        if (isBinary)
+        {
+            if (!stream.read(reinterpret_cast<char*>(rowBytes.data()), static_cast<std::streamsize>(rowBytes.size())))
+                return false;
+            for (std::size_t x = 0; x < width; ++x)
+            {
+                if ((rowBytes[x / 8] >> (7 - x % 8)) & 1)
+                    mask.setActive(x, y, true);
+            }
+            continue;
+        }
+        for (std::size_t x = 0; x < width; ++x)
+        {
+            char pixel {};
+            if (!(stream >> pixel) || (pixel != '0' && pixel != '1'))
+                return false;
+            if (pixel == '1')
+                mask.setActive(x, y, true);
+        }
+    }
+    mask.buildIndex();
+    return true;
+}
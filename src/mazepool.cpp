@@ -0,0 +1,188 @@
+#include "mazepool.h"
+#include "tracezones.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <random>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+MazePool::MazePool(std::size_t mazesPerKey, std::uint64_t maxSizeBytes, unsigned int threadCount)
+    : mazesPerKey_(mazesPerKey),
+      maxSizeBytes_(maxSizeBytes),
+      seedSource_((std::uint64_t(std::random_device()()) << 32) ^
+                  static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count()))
+{
+    for (unsigned int worker = 0; worker < threadCount; ++worker)
+        workers_.emplace_back(&MazePool::runWorker, this);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+MazePool::~MazePool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        isStopping_ = true;
+    }
+    refillCondition_.notify_all();
+    for (std::thread &worker : workers_)
+        worker.join();
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool MazePool::take(int algorithm, std::size_t width, std::size_t height, PackedMazeGrid &grid)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    Slot &slot = slots_[Key(algorithm, width, height)];
+    slot.lastUsedTick = ++tick_;
+
+    if (slot.readyMazes.empty())
+    {
+        ++statistics_.misses;
+        refillCondition_.notify_one();
+        return false;
+    }
+
+    grid.swap(slot.readyMazes.front());
+    slot.readyMazes.pop_front();
+    sizeBytes_ -= grid.getSizeBytes();
+    ++statistics_.hits;
+    refillCondition_.notify_one();
+    return true;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+MazePool::Statistics MazePool::getStatistics() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    Statistics statistics = statistics_;
+    for (const auto &slot : slots_)
+        statistics.readyMazes += slot.second.readyMazes.size();
+    statistics.sizeBytes = sizeBytes_;
+    return statistics;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::uint64_t MazePool::estimateSizeBytes(const Key &key)
+{
+    const std::uint64_t wordsPerRow = (std::get<1>(key) + PackedMazeGrid::BITS_PER_WORD - 1) /
+            PackedMazeGrid::BITS_PER_WORD;
+    return 2 * wordsPerRow * std::get<2>(key) * sizeof(std::uint64_t);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool MazePool::isCpuUnderPressure(unsigned int busyWorkers)
+{
+    // Средняя загрузка доступна только на unix-системах, на остальных пополнение не ограничивается
+#if defined(__unix__) || defined(__APPLE__)
+    double loadAverage {};
+    if (getloadavg(&loadAverage, 1) != 1)
+        return false;
+    const unsigned int coreCount = std::max(1u, std::thread::hardware_concurrency());
+    return loadAverage - busyWorkers > coreCount;
+#else
+    (void)busyWorkers;
+    return false;
+#endif
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazePool::lowerCurrentThreadPriority()
+{
+#if defined(_WIN32)
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_IDLE);
+#elif defined(__linux__)
+    // В Linux nice задается для отдельного потока
+    setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 19);
+#endif
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool MazePool::findSlotToRefill(Key &key)
+{
+    // Пополняется в первую очередь последний запрошенный размер
+    auto bestSlot = slots_.end();
+    for (auto slot = slots_.begin(); slot != slots_.end(); ++slot)
+    {
+        if (slot->second.readyMazes.size() + slot->second.pendingMazes < mazesPerKey_ &&
+                (bestSlot == slots_.end() || slot->second.lastUsedTick > bestSlot->second.lastUsedTick))
+            bestSlot = slot;
+    }
+    if (bestSlot == slots_.end() || !freeMemoryFor(bestSlot->first, estimateSizeBytes(bestSlot->first)))
+        return false;
+
+    key = bestSlot->first;
+    return true;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool MazePool::freeMemoryFor(const Key &key, std::uint64_t sizeBytes)
+{
+    const std::uint64_t keyTick = slots_[key].lastUsedTick;
+    while (sizeBytes_ + sizeBytes > maxSizeBytes_)
+    {
+        // Жертвуем только размерами, которые запрашивались раньше пополняемого
+        auto oldestSlot = slots_.end();
+        for (auto slot = slots_.begin(); slot != slots_.end(); ++slot)
+        {
+            if (!slot->second.readyMazes.empty() && slot->second.lastUsedTick < keyTick &&
+                    (oldestSlot == slots_.end() || slot->second.lastUsedTick < oldestSlot->second.lastUsedTick))
+                oldestSlot = slot;
+        }
+        if (oldestSlot == slots_.end())
+            return false;
+
+        sizeBytes_ -= oldestSlot->second.readyMazes.back().getSizeBytes();
+        oldestSlot->second.readyMazes.pop_back();
+    }
+    return true;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazePool::runWorker()
+{
+    MAZE_TRACE_THREAD_NAME("MazePool worker");
+    lowerCurrentThreadPriority();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!isStopping_)
+    {
+        Key key;
+        if (!findSlotToRefill(key))
+        {
+            refillCondition_.wait(lock);
+            continue;
+        }
+        if (isCpuUnderPressure(busyWorkers_))
+        {
+            refillCondition_.wait_for(lock, std::chrono::seconds(1));
+            continue;
+        }
+
+        const std::uint64_t sizeBytes = estimateSizeBytes(key);
+        const GenerationParameters parameters(std::get<0>(key), std::get<1>(key), std::get<2>(key),
+                                              seedSource_.generate64());
+        ++slots_[key].pendingMazes;
+        sizeBytes_ += sizeBytes;
+        ++busyWorkers_;
+
+        lock.unlock();
+        PackedMazeGrid grid;
+        MazeGenerator::generate(parameters, grid);
+        lock.lock();
+
+        --busyWorkers_;
+        Slot &slot = slots_[key];
+        --slot.pendingMazes;
+        slot.readyMazes.emplace_back();
+        slot.readyMazes.back().swap(grid);
+    }
+}
@@ -0,0 +1,33 @@
+#include "mazerandom.h"
+
+MazeRandom::MazeRandom(std::uint64_t seed) noexcept
+{
+    MazeRandom::seed(seed);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeRandom::seed(std::uint64_t seed)
+{
+    // Состояние заполняется через splitmix64, чтобы близкие seed давали независимые потоки
+    for (auto &word : state_)
+    {
+        seed += 0x9E3779B97F4A7C15ULL;
+        std::uint64_t z = seed;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        word = z ^ (z >> 31);
+    }
+}
+
+/*------------------------------------------------------------------------------------------------*/
+MazeRandom::State MazeRandom::getState() const
+{
+    return State {{state_[0], state_[1], state_[2], state_[3]}};
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeRandom::setState(const State &state)
+{
+    for (std::size_t word = 0; word < state.size(); ++word)
+        state_[word] = state[word];
+}
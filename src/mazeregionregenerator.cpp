@@ -0,0 +1,153 @@
+#include "mazeregionregenerator.h"
+#include "mazerandom.h"
+#include "tracezones.h"
+
+// Определение нужно при ODR-использовании: конструктор vector берет значение по ссылке
+const std::uint32_t MazeRegionRegenerator::NO_COMPONENT;
+
+bool MazeRegionRegenerator::regenerate(PackedMazeGrid &grid, const Region &region, std::uint64_t seed)
+{
+    if (region.width == 0 || region.height == 0 || region.x >= grid.getWidth() || region.y >= grid.getHeight() ||
+            region.width > grid.getWidth() - region.x || region.height > grid.getHeight() - region.y)
+        return false;
+    MAZE_TRACE_ZONE("MazeRegionRegenerator::regenerate");
+
+    // Клетки области нумеруются локально: y * region.width + x относительно её угла
+    std::vector<std::uint32_t> components(region.width * region.height, NO_COMPONENT);
+    const std::uint32_t componentCount = labelComponents(grid, region, components);
+    clearInteriorPassages(grid, region);
+    runWilson(grid, region, components, componentCount, seed);
+    return true;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool MazeRegionRegenerator::getNeighbor(const Region &region, std::size_t cell, int direction, std::size_t &neighbor)
+{
+    const std::size_t x = cell % region.width;
+    const std::size_t y = cell / region.width;
+    switch (direction)
+    {
+    case PackedMazeGrid::Direction::Top :
+        neighbor = cell - region.width;
+        return y > 0;
+    case PackedMazeGrid::Direction::Right :
+        neighbor = cell + 1;
+        return x + 1 < region.width;
+    case PackedMazeGrid::Direction::Bot :
+        neighbor = cell + region.width;
+        return y + 1 < region.height;
+    case PackedMazeGrid::Direction::Left :
+        neighbor = cell - 1;
+        return x > 0;
+    }
+    return false;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::uint32_t MazeRegionRegenerator::labelComponents(const PackedMazeGrid &grid, const Region &region,
+                                                     std::vector<std::uint32_t> &components)
+{
+    std::uint32_t componentCount {0};
+    std::vector<std::size_t> queue;
+    for (std::size_t start = 0; start < components.size(); ++start)
+    {
+        if (components[start] != NO_COMPONENT)
+            continue;
+        components[start] = componentCount;
+        queue.assign(1, start);
+        for (std::size_t head = 0; head < queue.size(); ++head)
+        {
+            const std::size_t cell = queue[head];
+            for (int direction = 0; direction < PackedMazeGrid::Direction::Count; ++direction)
+            {
+                std::size_t neighbor {};
+                if (getNeighbor(region, cell, direction, neighbor) && components[neighbor] == NO_COMPONENT &&
+                        grid.hasPassage(region.x + cell % region.width, region.y + cell / region.width, direction))
+                {
+                    components[neighbor] = componentCount;
+                    queue.push_back(neighbor);
+                }
+            }
+        }
+        ++componentCount;
+    }
+    return componentCount;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeRegionRegenerator::clearInteriorPassages(PackedMazeGrid &grid, const Region &region)
+{
+    // Проходы правого столбца вправо и нижней строки вниз ведут наружу и остаются
+    for (std::size_t y = region.y; y < region.y + region.height; ++y)
+    {
+        for (std::size_t x = region.x; x < region.x + region.width; ++x)
+        {
+            if (x + 1 < region.x + region.width)
+                grid.setPassage(x, y, PackedMazeGrid::Direction::Right, false);
+            if (y + 1 < region.y + region.height)
+                grid.setPassage(x, y, PackedMazeGrid::Direction::Bot, false);
+        }
+    }
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeRegionRegenerator::runWilson(PackedMazeGrid &grid, const Region &region,
+                                      const std::vector<std::uint32_t> &components, std::uint32_t componentCount,
+                                      std::uint64_t seed)
+{
+    /* Уилсон с отдельным корнем в каждом компоненте: блуждание не выходит из своего компонента, а
+     * петли стираются перезаписью направления клетки, как в UniformTreeGenerator::runWilson.
+     * Корень связной области - случайная клетка (от угла блуждания заметно длиннее), у остальных
+     * компонентов - первая по порядку; на равномерность выбор корня не влияет */
+    MazeRandom random(seed);
+    std::vector<std::uint8_t> hasRoot(componentCount, 0);
+    std::vector<std::uint8_t> cellStates(components.size(), 0);
+    const std::size_t rootCell = random.bounded(static_cast<std::uint32_t>(components.size()));
+    hasRoot[components[rootCell]] = 1;
+    cellStates[rootCell] = CellState::InTree;
+
+    std::uint64_t directionBits {};
+    unsigned int directionBitsLeft {};
+    for (std::size_t start = 0; start < components.size(); ++start)
+    {
+        if (cellStates[start] & CellState::InTree)
+            continue;
+        const std::uint32_t component = components[start];
+        if (!hasRoot[component])
+        {
+            hasRoot[component] = 1;
+            cellStates[start] = CellState::InTree;
+            continue;
+        }
+
+        std::size_t cell = start;
+        while (!(cellStates[cell] & CellState::InTree))
+        {
+            // Два бита на попытку; направления за край области и в чужой компонент перевыбираются
+            std::size_t neighbor {};
+            int direction {};
+            do
+            {
+                if (directionBitsLeft == 0)
+                {
+                    directionBits = random.generate64();
+                    directionBitsLeft = 32;
+                }
+                direction = directionBits & 0x03;
+                directionBits >>= 2;
+                --directionBitsLeft;
+            }
+            while (!getNeighbor(region, cell, direction, neighbor) || components[neighbor] != component);
+            cellStates[cell] = static_cast<std::uint8_t>(direction);
+            cell = neighbor;
+        }
+
+        for (cell = start; !(cellStates[cell] & CellState::InTree); )
+        {
+            const int direction = cellStates[cell] & CellState::DirectionMask;
+            cellStates[cell] |= CellState::InTree;
+            grid.setPassage(region.x + cell % region.width, region.y + cell / region.width, direction, true);
+            getNeighbor(region, cell, direction, cell);
+        }
+    }
+}
@@ -0,0 +1,338 @@
+#include "mazestepgenerator.h"
+#include "mazegenerator.h"
+#include "tracezones.h"
+
+MazeStepGenerator::MazeStepGenerator(int algorithm, std::size_t width, std::size_t height, std::uint64_t seed) noexcept
+    : width_(width),
+      height_(height),
+      seed_(seed),
+      random_(seed),
+      algorithm_(algorithm)
+{
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool MazeStepGenerator::isSupported(int algorithm)
+{
+    return algorithm == MazeGenerator::Algorithm::AldousBroder ||
+           algorithm == MazeGenerator::Algorithm::RecursiveBacktracker ||
+           algorithm == MazeGenerator::Algorithm::Wilson;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeStepGenerator::applyStep(const Step &step, PackedMazeGrid &grid)
+{
+    if (step.type == StepType::Carve)
+        grid.setPassage(step.x, step.y, step.direction, true);
+    else if (step.type == StepType::Erase)
+        grid.setPassage(step.x, step.y, step.direction, false);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool MazeStepGenerator::next(Step &step)
+{
+    if (!isStarted_)
+    {
+        isStarted_ = true;
+        const std::size_t cellCount = width_ * height_;
+        if (cellCount == 0 || !isSupported(algorithm_))
+            return false;
+
+        /* Начало и расход случайных чисел те же, что у MazeGenerator: Recursive Backtracker идет
+         * из (0, 0), блуждания - из случайной клетки, как в UniformTreeGenerator */
+        const std::size_t startCell = algorithm_ == MazeGenerator::Algorithm::RecursiveBacktracker ?
+                    0 : static_cast<std::size_t>(random_.generate64() % cellCount);
+        cellStates_.assign(cellCount, 0);
+        cellStates_[startCell] = CellState::InMaze;
+        cellsInMaze_ = 1;
+        x_ = startCell % width_;
+        y_ = startCell / width_;
+        cell_ = startCell;
+        firstFreeCell_ = 0;
+        path_.clear();
+        switch (algorithm_)
+        {
+        case MazeGenerator::Algorithm::AldousBroder :
+            phase_ = Phase::AldousBroderWalk;
+            break;
+        case MazeGenerator::Algorithm::RecursiveBacktracker :
+            phase_ = Phase::BacktrackerWalk;
+            path_.push_back(0);
+            break;
+        case MazeGenerator::Algorithm::Wilson :
+            phase_ = Phase::WilsonSeek;
+            break;
+        }
+        if (cellCount == 1)
+            phase_ = Phase::Finished;
+        setStep(step, StepType::Start, -1);
+        return true;
+    }
+
+    switch (phase_)
+    {
+    case Phase::AldousBroderWalk :
+        makeAldousBroderStep(step);
+        return true;
+    case Phase::BacktrackerWalk :
+        makeBacktrackerStep(step);
+        return true;
+    case Phase::WilsonSeek :
+        makeWilsonSeekStep(step);
+        return true;
+    case Phase::WilsonWalk :
+        makeWilsonWalkStep(step);
+        return true;
+    case Phase::WilsonErase :
+        makeWilsonEraseStep(step);
+        return true;
+    }
+    return false;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool MazeStepGenerator::isFinished() const
+{
+    return isStarted_ && phase_ == Phase::Finished;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeStepGenerator::run(PackedMazeGrid &grid)
+{
+    MAZE_TRACE_ZONE_ARG("MazeStepGenerator::run", "algorithm", algorithm_);
+    if (!isStarted_)
+    {
+        // Шаги никто не смотрит: тот же лабиринт быстрее строят циклы MazeGenerator без выдачи шагов
+        isStarted_ = true;
+        phase_ = Phase::Finished;
+        if (isSupported(algorithm_))
+            MazeGenerator::generate(GenerationParameters(algorithm_, width_, height_, seed_), grid);
+        else
+            grid.resize(width_, height_);
+        return;
+    }
+
+    Step step;
+    while (next(step))
+        applyStep(step, grid);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeStepGenerator::makeAldousBroderStep(Step &step)
+{
+    const int direction = chooseRandomDirection(x_, y_);
+    std::uint8_t &state = cellStates_[getNeighbor(cell_, direction)];
+    if (state & CellState::InMaze)
+    {
+        setStep(step, StepType::Move, direction);
+    }
+    else
+    {
+        setStep(step, StepType::Carve, direction);
+        state |= CellState::InMaze;
+        ++cellsInMaze_;
+    }
+    moveToNeighbor(direction);
+
+    if (cellsInMaze_ == cellStates_.size())
+        phase_ = Phase::Finished;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeStepGenerator::makeBacktrackerStep(Step &step)
+{
+    // Порядок направлений и выбор из них те же, что в MazeGenerator: при одном seed лабиринт совпадает
+    const std::size_t cell = cell_;
+    const std::size_t x = x_;
+    const std::size_t y = y_;
+
+    int directions[PackedMazeGrid::Direction::Count] {};
+    std::uint32_t directionCount {0};
+    if (y > 0 && !cellStates_[cell - width_])
+        directions[directionCount++] = PackedMazeGrid::Direction::Top;
+    if (x + 1 < width_ && !cellStates_[cell + 1])
+        directions[directionCount++] = PackedMazeGrid::Direction::Right;
+    if (y + 1 < height_ && !cellStates_[cell + width_])
+        directions[directionCount++] = PackedMazeGrid::Direction::Bot;
+    if (x > 0 && !cellStates_[cell - 1])
+        directions[directionCount++] = PackedMazeGrid::Direction::Left;
+
+    if (directionCount == 0)
+    {
+        // Стек не опустеет раньше, чем лабиринт будет готов: генерация заканчивается на последней клетке
+        path_.pop_back();
+        const int direction = getDirectionBetween(cell, path_.back(), width_);
+        setStep(step, StepType::Retreat, direction);
+        moveToNeighbor(direction);
+        return;
+    }
+
+    const int direction = directions[random_.bounded(directionCount)];
+    setStep(step, StepType::Carve, direction);
+    moveToNeighbor(direction);
+    cellStates_[cell_] = CellState::InMaze;
+    ++cellsInMaze_;
+    path_.push_back(cell_);
+
+    if (cellsInMaze_ == cellStates_.size())
+        phase_ = Phase::Finished;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeStepGenerator::makeWilsonSeekStep(Step &step)
+{
+    /* Ветка начинается с первой по порядку клетки вне лабиринта, как в UniformTreeGenerator:
+     * клетки перед ней уже в лабиринте, поэтому весь поиск за генерацию линейный. На равномерность
+     * порядок стартовых клеток не влияет */
+    while (cellStates_[firstFreeCell_] & CellState::InMaze)
+        ++firstFreeCell_;
+    const std::size_t startCell = firstFreeCell_;
+
+    cellStates_[startCell] |= CellState::OnPath;
+    path_.assign(1, startCell);
+    cell_ = startCell;
+    x_ = startCell % width_;
+    y_ = startCell / width_;
+    setStep(step, StepType::Start, -1);
+    phase_ = Phase::WilsonWalk;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeStepGenerator::makeWilsonWalkStep(Step &step)
+{
+    const int direction = chooseRandomDirection(x_, y_);
+    const std::size_t nextCell = getNeighbor(cell_, direction);
+    const std::uint8_t nextState = cellStates_[nextCell];
+
+    if (nextState & CellState::OnPath)
+    {
+        // Зашли в свой же путь: петля стирается по одной клетке за шаг
+        eraseTargetCell_ = nextCell;
+        phase_ = Phase::WilsonErase;
+        makeWilsonEraseStep(step);
+        return;
+    }
+
+    setStep(step, StepType::Carve, direction);
+    moveToNeighbor(direction);
+    if (!(nextState & CellState::InMaze))
+    {
+        cellStates_[nextCell] |= CellState::OnPath;
+        path_.push_back(nextCell);
+        return;
+    }
+
+    // Путь дошел до лабиринта и целиком становится его частью
+    for (std::size_t pathCell : path_)
+        cellStates_[pathCell] = CellState::InMaze;
+    cellsInMaze_ += path_.size();
+    path_.clear();
+    phase_ = cellsInMaze_ == cellStates_.size() ? Phase::Finished : Phase::WilsonSeek;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeStepGenerator::makeWilsonEraseStep(Step &step)
+{
+    path_.pop_back();
+    cellStates_[cell_] &= static_cast<std::uint8_t>(~CellState::OnPath);
+
+    const int direction = getDirectionBetween(cell_, path_.back(), width_);
+    setStep(step, StepType::Erase, direction);
+    moveToNeighbor(direction);
+    if (cell_ == eraseTargetCell_)
+        phase_ = Phase::WilsonWalk;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeStepGenerator::setStep(Step &step, int type, int direction) const
+{
+    step.type = type;
+    step.x = static_cast<std::uint32_t>(x_);
+    step.y = static_cast<std::uint32_t>(y_);
+    step.direction = direction;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+int MazeStepGenerator::chooseRandomDirection(std::size_t x, std::size_t y)
+{
+    // Два бита на попытку, недопустимые у края направления просто перевыбираются
+    for (;;)
+    {
+        if (directionBitsLeft_ == 0)
+        {
+            directionBits_ = random_.generate64();
+            directionBitsLeft_ = 32;
+        }
+        const int direction = directionBits_ & 0x03;
+        directionBits_ >>= 2;
+        --directionBitsLeft_;
+
+        switch (direction)
+        {
+        case PackedMazeGrid::Direction::Top :
+            if (y > 0)
+                return direction;
+            break;
+        case PackedMazeGrid::Direction::Right :
+            if (x + 1 < width_)
+                return direction;
+            break;
+        case PackedMazeGrid::Direction::Bot :
+            if (y + 1 < height_)
+                return direction;
+            break;
+        case PackedMazeGrid::Direction::Left :
+            if (x > 0)
+                return direction;
+            break;
+        }
+    }
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::size_t MazeStepGenerator::getNeighbor(std::size_t cell, int direction) const
+{
+    switch (direction)
+    {
+    case PackedMazeGrid::Direction::Top :
+        return cell - width_;
+    case PackedMazeGrid::Direction::Right :
+        return cell + 1;
+    case PackedMazeGrid::Direction::Bot :
+        return cell + width_;
+    default :
+        return cell - 1;
+    }
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeStepGenerator::moveToNeighbor(int direction)
+{
+    cell_ = getNeighbor(cell_, direction);
+    switch (direction)
+    {
+    case PackedMazeGrid::Direction::Top :
+        --y_;
+        break;
+    case PackedMazeGrid::Direction::Right :
+        ++x_;
+        break;
+    case PackedMazeGrid::Direction::Bot :
+        ++y_;
+        break;
+    case PackedMazeGrid::Direction::Left :
+        --x_;
+        break;
+    }
+}
+
+/*------------------------------------------------------------------------------------------------*/
+int MazeStepGenerator::getDirectionBetween(std::size_t fromCell, std::size_t toCell, std::size_t width)
+{
+    // Вертикаль проверяется первой: при ширине 1 соседи по горизонтали не существуют
+    if (toCell + width == fromCell)
+        return PackedMazeGrid::Direction::Top;
+    if (fromCell + width == toCell)
+        return PackedMazeGrid::Direction::Bot;
+    return toCell > fromCell ? PackedMazeGrid::Direction::Right : PackedMazeGrid::Direction::Left;
+}
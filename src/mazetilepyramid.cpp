@@ -0,0 +1,386 @@
+#include "mazetilepyramid.h"
+#include "tracezones.h"
+
+#include <algorithm>
+
+namespace
+{
+const std::uint8_t WALL_COLOR {0};
+const std::uint8_t BACKGROUND_COLOR {255};
+// Часть плитки за краем лабиринта
+const std::uint8_t OUTSIDE_COLOR {200};
+// Клеток на сторону плитки уровня 0
+const std::size_t FINEST_TILE_CELLS {MazeTilePyramid::TILE_SIZE / MazeTilePyramid::FINEST_CELL_PIXELS};
+// С этого уровня клетка меньше пикселя
+const unsigned int FIRST_DENSITY_LEVEL {3};
+
+unsigned int countSetBits(std::uint64_t word)
+{
+#if defined(__GNUC__)
+    return static_cast<unsigned int>(__builtin_popcountll(word));
+#else
+    unsigned int count {0};
+    for (; word != 0; word &= word - 1)
+        ++count;
+    return count;
+#endif
+}
+
+bool hasBit(const std::uint64_t *row, std::size_t bit)
+{
+    return (row[bit / PackedMazeGrid::BITS_PER_WORD] >> (bit % PackedMazeGrid::BITS_PER_WORD)) & 1;
+}
+}
+
+MazeTilePyramid::MazeTilePyramid(PackedMazeGrid &&grid, std::size_t capacity, unsigned int threadCount)
+    : capacity_(std::max<std::size_t>(1, capacity))
+{
+    grid_.swap(grid);
+    const std::size_t side = std::max(grid_.getWidth(), grid_.getHeight());
+    levelCount_ = 1;
+    while (getTileCells(levelCount_ - 1) <= side)
+        ++levelCount_;
+
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency() - 1);
+    for (unsigned int worker = 0; worker < threadCount; ++worker)
+        workers_.emplace_back(&MazeTilePyramid::runWorker, this);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+MazeTilePyramid::~MazeTilePyramid()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        isStopping_ = true;
+    }
+    workCondition_.notify_all();
+    for (std::thread &worker : workers_)
+        worker.join();
+}
+
+/*------------------------------------------------------------------------------------------------*/
+const PackedMazeGrid& MazeTilePyramid::getGrid() const
+{
+    return grid_;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+unsigned int MazeTilePyramid::getLevelCount() const
+{
+    return levelCount_;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::size_t MazeTilePyramid::getTileCells(unsigned int level) const
+{
+    return FINEST_TILE_CELLS << level;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::uint32_t MazeTilePyramid::getTileColumns(unsigned int level) const
+{
+    // Правая граница лабиринта - столбец пикселей уже за последней клеткой
+    return static_cast<std::uint32_t>(grid_.getWidth() / getTileCells(level) + 1);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::uint32_t MazeTilePyramid::getTileRows(unsigned int level) const
+{
+    return static_cast<std::uint32_t>(grid_.getHeight() / getTileCells(level) + 1);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+MazeTilePyramid::Statistics MazeTilePyramid::getStatistics() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return statistics_;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeTilePyramid::setReadyHandler(const ReadyHandler &readyHandler)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    readyHandler_ = readyHandler;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+MazeTilePyramid::Key MazeTilePyramid::makeKey(unsigned int level, std::uint32_t tileX, std::uint32_t tileY)
+{
+    return (Key(level) << 56) | (Key(tileX) << 28) | tileY;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeTilePyramid::enqueue(Key key)
+{
+    if (!queuedKeys_.insert(key).second)
+        return;
+    pendingKeys_.push_back(key);
+    workCondition_.notify_one();
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::shared_ptr<const MazeTilePyramid::Tile> MazeTilePyramid::requestTile(unsigned int level, std::uint32_t tileX,
+                                                                         std::uint32_t tileY)
+{
+    const Key key = makeKey(level, tileX, tileY);
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto entry = entries_.find(key);
+    if (entry == entries_.end())
+    {
+        ++statistics_.misses;
+        enqueue(key);
+        return nullptr;
+    }
+    ++statistics_.hits;
+    lruKeys_.splice(lruKeys_.begin(), lruKeys_, entry->second.lruPosition);
+    if (entry->second.isStale)
+        enqueue(key);
+    return entry->second.tile;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::shared_ptr<const MazeTilePyramid::Tile> MazeTilePyramid::findTile(unsigned int level, std::uint32_t tileX,
+                                                                      std::uint32_t tileY) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto entry = entries_.find(makeKey(level, tileX, tileY));
+    return entry == entries_.end() ? nullptr : entry->second.tile;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeTilePyramid::cancelPending()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (Key key : pendingKeys_)
+        queuedKeys_.erase(key);
+    pendingKeys_.clear();
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeTilePyramid::insertTile(Key key, std::shared_ptr<const Tile> &&tile)
+{
+    const auto entry = entries_.find(key);
+    if (entry != entries_.end())
+    {
+        entry->second.tile = std::move(tile);
+        entry->second.isStale = false;
+        lruKeys_.splice(lruKeys_.begin(), lruKeys_, entry->second.lruPosition);
+        return;
+    }
+
+    lruKeys_.push_front(key);
+    Entry &newEntry = entries_[key];
+    newEntry.tile = std::move(tile);
+    newEntry.lruPosition = lruKeys_.begin();
+    while (entries_.size() > capacity_)
+    {
+        entries_.erase(lruKeys_.back());
+        lruKeys_.pop_back();
+        ++statistics_.evictions;
+    }
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeTilePyramid::invalidateTile(unsigned int level, std::size_t tileX, std::size_t tileY)
+{
+    // Плитки, которой нет в кэше, и так будут нарисованы по новым стенам
+    const Key key = makeKey(level, static_cast<std::uint32_t>(tileX), static_cast<std::uint32_t>(tileY));
+    const auto entry = entries_.find(key);
+    if (entry == entries_.end())
+        return;
+    entry->second.isStale = true;
+    ++statistics_.invalidations;
+    enqueue(key);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeTilePyramid::setPassage(std::size_t x, std::size_t y, int direction, bool isOpen)
+{
+    MAZE_TRACE_ZONE("MazeTilePyramid::setPassage");
+    // Стена между клетками - это проход вправо или вниз из левой или верхней из них
+    if (direction == PackedMazeGrid::Direction::Top)
+    {
+        --y;
+        direction = PackedMazeGrid::Direction::Bot;
+    }
+    else if (direction == PackedMazeGrid::Direction::Left)
+    {
+        --x;
+        direction = PackedMazeGrid::Direction::Right;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    isGridWriteWaiting_ = true;
+    gridCondition_.wait(lock, [this]() { return activeRenders_ == 0; });
+    grid_.setPassage(x, y, direction, isOpen);
+    isGridWriteWaiting_ = false;
+
+    /* На уровнях со стенами стена - отрезок пикселей на левой или верхней стороне соседней клетки,
+     * и он целиком в плитке этой клетки; на остальных проход учитывается в пикселе самой клетки */
+    const bool isRight = direction == PackedMazeGrid::Direction::Right;
+    for (unsigned int level = 0; level < levelCount_; ++level)
+    {
+        const std::size_t tileCells = getTileCells(level);
+        if (level < FIRST_DENSITY_LEVEL)
+            invalidateTile(level, (isRight ? x + 1 : x) / tileCells, (isRight ? y : y + 1) / tileCells);
+        else
+            invalidateTile(level, x / tileCells, y / tileCells);
+    }
+    workCondition_.notify_all();
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeTilePyramid::runWorker()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;)
+    {
+        workCondition_.wait(lock, [this]() { return isStopping_ || (!pendingKeys_.empty() && !isGridWriteWaiting_); });
+        if (isStopping_)
+            return;
+        const Key key = pendingKeys_.front();
+        pendingKeys_.pop_front();
+        ++activeRenders_;
+        lock.unlock();
+
+        std::shared_ptr<Tile> tile = std::make_shared<Tile>();
+        tile->level = static_cast<unsigned int>(key >> 56);
+        tile->tileX = static_cast<std::uint32_t>((key >> 28) & 0x0FFFFFFF);
+        tile->tileY = static_cast<std::uint32_t>(key & 0x0FFFFFFF);
+        renderTile(*tile);
+
+        lock.lock();
+        if (--activeRenders_ == 0)
+            gridCondition_.notify_all();
+        queuedKeys_.erase(key);
+        insertTile(key, std::move(tile));
+        ++statistics_.rendered;
+        const ReadyHandler readyHandler = readyHandler_;
+        lock.unlock();
+        if (readyHandler)
+            readyHandler();
+        lock.lock();
+    }
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeTilePyramid::renderTile(Tile &tile) const
+{
+    MAZE_TRACE_ZONE_ARG("MazeTilePyramid::renderTile", "level", static_cast<int>(tile.level));
+    tile.pixels.assign(std::size_t(TILE_SIZE) * TILE_SIZE, OUTSIDE_COLOR);
+    if (tile.level < FIRST_DENSITY_LEVEL)
+        renderWalls(tile, FINEST_CELL_PIXELS >> tile.level);
+    else
+        renderDensity(tile, std::size_t(1) << (tile.level - FIRST_DENSITY_LEVEL));
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeTilePyramid::renderWalls(Tile &tile, unsigned int cellPixels) const
+{
+    /* Клетка - квадрат cellPixels x cellPixels: угол, верхняя стена, левая стена и внутренность.
+     * Правая и нижняя граница лабиринта - верхняя и левая стены несуществующих клеток за краем */
+    const std::size_t width = grid_.getWidth();
+    const std::size_t height = grid_.getHeight();
+    const std::size_t tileCells = getTileCells(tile.level);
+    const std::size_t firstX = tile.tileX * tileCells;
+    const std::size_t firstY = tile.tileY * tileCells;
+    for (std::size_t cellY = 0; cellY < tileCells && firstY + cellY <= height; ++cellY)
+    {
+        const std::size_t y = firstY + cellY;
+        const std::uint64_t *rightRow = y < height ? grid_.getRightRow(y) : nullptr;
+        const std::uint64_t *botRowAbove = y > 0 && y < height ? grid_.getBotRow(y - 1) : nullptr;
+        for (std::size_t cellX = 0; cellX < tileCells && firstX + cellX <= width; ++cellX)
+        {
+            const std::size_t x = firstX + cellX;
+            std::uint8_t *block = tile.pixels.data() + cellY * cellPixels * TILE_SIZE + cellX * cellPixels;
+            block[0] = WALL_COLOR;
+            if (y == height)
+            {
+                if (x < width)
+                    std::fill_n(block + 1, cellPixels - 1, WALL_COLOR);
+                continue;
+            }
+            if (x == width)
+            {
+                for (unsigned int row = 1; row < cellPixels; ++row)
+                    block[row * TILE_SIZE] = WALL_COLOR;
+                continue;
+            }
+
+            const bool isTopWall = !botRowAbove || !hasBit(botRowAbove, x);
+            const bool isLeftWall = x == 0 || !hasBit(rightRow, x - 1);
+            std::fill_n(block + 1, cellPixels - 1, isTopWall ? WALL_COLOR : BACKGROUND_COLOR);
+            for (unsigned int row = 1; row < cellPixels; ++row)
+            {
+                block[row * TILE_SIZE] = isLeftWall ? WALL_COLOR : BACKGROUND_COLOR;
+                std::fill_n(block + row * TILE_SIZE + 1, cellPixels - 1, BACKGROUND_COLOR);
+            }
+        }
+    }
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void MazeTilePyramid::renderDensity(Tile &tile, std::size_t cellsPerPixel) const
+{
+    /* Яркость пикселя - доля открытых проходов вправо и вниз среди возможных в его квадрате клеток.
+     * Проходы считаются popcount по словам строк: слово целиком в одном пикселе или делится на
+     * несколько пикселей; плитка начинается с границы слова */
+    const std::size_t width = grid_.getWidth();
+    const std::size_t height = grid_.getHeight();
+    const std::size_t tileCells = getTileCells(tile.level);
+    const std::size_t firstX = tile.tileX * tileCells;
+    const std::size_t firstY = tile.tileY * tileCells;
+    if (firstX >= width || firstY >= height)
+        return;
+    const std::size_t bitsPerWord = PackedMazeGrid::BITS_PER_WORD;
+    const std::size_t firstWord = firstX / bitsPerWord;
+    const std::size_t lastWord = std::min(grid_.getWordsPerRow(), (firstX + tileCells) / bitsPerWord);
+    const std::size_t pixelsPerWord = std::max<std::size_t>(1, bitsPerWord / cellsPerPixel);
+    const std::uint64_t pixelMask = cellsPerPixel < bitsPerWord ? (std::uint64_t(1) << cellsPerPixel) - 1 :
+                                                                  ~std::uint64_t(0);
+    const std::size_t pixelCount = std::min<std::size_t>(TILE_SIZE, (width - firstX + cellsPerPixel - 1) / cellsPerPixel);
+    // Биты за краем сетки есть только в последнем слове строки
+    const std::size_t lastRowWord = grid_.getWordsPerRow() - 1;
+    const std::uint64_t lastRightMask = grid_.getRightRowMask(lastRowWord);
+    const std::uint64_t lastRowMask = grid_.getRowMask(lastRowWord);
+
+    std::vector<std::uint64_t> passages(TILE_SIZE);
+    for (std::size_t pixelY = 0; pixelY < TILE_SIZE && firstY + pixelY * cellsPerPixel < height; ++pixelY)
+    {
+        std::fill(passages.begin(), passages.end(), 0);
+        const std::size_t fromY = firstY + pixelY * cellsPerPixel;
+        const std::size_t toY = std::min(fromY + cellsPerPixel, height);
+        for (std::size_t y = fromY; y < toY; ++y)
+        {
+            const std::uint64_t *rightRow = grid_.getRightRow(y);
+            const std::uint64_t *botRow = y + 1 < height ? grid_.getBotRow(y) : nullptr;
+            for (std::size_t word = firstWord; word < lastWord; ++word)
+            {
+                const bool isLastWord = word == lastRowWord;
+                const std::uint64_t right = isLastWord ? rightRow[word] & lastRightMask : rightRow[word];
+                const std::uint64_t bot = !botRow ? 0 : isLastWord ? botRow[word] & lastRowMask : botRow[word];
+                const std::size_t firstPixel = (word * bitsPerWord - firstX) / cellsPerPixel;
+                for (std::size_t pixel = 0; pixel < pixelsPerWord; ++pixel)
+                {
+                    const unsigned int shift = static_cast<unsigned int>(pixel * cellsPerPixel % bitsPerWord);
+                    passages[firstPixel + pixel] += countSetBits((right >> shift) & pixelMask) +
+                                                    countSetBits((bot >> shift) & pixelMask);
+                }
+            }
+        }
+
+        // Возможных проходов вправо в квадрате на столбец меньше у правого края, вниз - на строку у нижнего
+        const std::size_t rows = toY - fromY;
+        const std::size_t botRows = std::min(toY, height - 1) > fromY ? std::min(toY, height - 1) - fromY : 0;
+        std::uint8_t *row = tile.pixels.data() + pixelY * TILE_SIZE;
+        for (std::size_t pixelX = 0; pixelX < pixelCount; ++pixelX)
+        {
+            const std::size_t fromX = firstX + pixelX * cellsPerPixel;
+            const std::size_t toX = std::min(fromX + cellsPerPixel, width);
+            const std::size_t rightColumns = std::min(toX, width - 1) > fromX ? std::min(toX, width - 1) - fromX : 0;
+            const std::uint64_t slots = rightColumns * rows + (toX - fromX) * botRows;
+            row[pixelX] = slots == 0 ? BACKGROUND_COLOR : static_cast<std::uint8_t>(passages[pixelX] * 255 / slots);
+        }
+    }
+}
@@ -0,0 +1,261 @@
+#include "mazevectorexporter.h"
+#include "tracezones.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+namespace
+{
+unsigned int countTrailingZeros(std::uint64_t word)
+{
+#if defined(__GNUC__)
+    return static_cast<unsigned int>(__builtin_ctzll(word));
+#else
+    unsigned int count {0};
+    for (; !(word & 1); word >>= 1)
+        ++count;
+    return count;
+#endif
+}
+
+// Отрезков миллионы, и snprintf на каждый заметно медленнее записи цифр вручную
+void appendNumber(std::string &text, unsigned long long value)
+{
+    char digits[20] {};
+    std::size_t digitCount {0};
+    do
+    {
+        digits[digitCount++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+    while (value != 0);
+    while (digitCount > 0)
+        text += digits[--digitCount];
+}
+
+// PDF ссылается на объекты по смещению в байтах, поэтому запись ведет счет байтов сама
+class PdfStream
+{
+private:
+    std::ostream &output_;
+    std::uint64_t offset_ {};
+    std::vector<std::uint64_t> objectOffsets_;
+
+public:
+    explicit PdfStream(std::ostream &output, std::size_t objectCount)
+        : output_(output),
+          objectOffsets_(objectCount + 1, 0)
+    {
+    }
+
+    std::uint64_t getOffset() const
+    {
+        return offset_;
+    }
+
+    void write(const std::string &text)
+    {
+        output_.write(text.data(), static_cast<std::streamsize>(text.size()));
+        offset_ += text.size();
+    }
+
+    void beginObject(std::size_t object)
+    {
+        objectOffsets_[object] = offset_;
+        write(std::to_string(object) + " 0 obj\n");
+    }
+
+    void writeTrailer()
+    {
+        const std::uint64_t xrefOffset = offset_;
+        write("xref\n0 " + std::to_string(objectOffsets_.size()) + "\n0000000000 65535 f \n");
+        char entry[24] {};
+        for (std::size_t object = 1; object < objectOffsets_.size(); ++object)
+        {
+            std::snprintf(entry, sizeof(entry), "%010llu 00000 n \n",
+                          static_cast<unsigned long long>(objectOffsets_[object]));
+            write(entry);
+        }
+        write("trailer\n<< /Size " + std::to_string(objectOffsets_.size()) + " /Root 1 0 R >>\nstartxref\n" +
+              std::to_string(xrefOffset) + "\n%%EOF\n");
+    }
+};
+}
+
+void MazeVectorExporter::forEachWallRun(const PackedMazeGrid &grid, const RunHandler &runHandler,
+                                        const RowEndHandler &rowEndHandler)
+{
+    const std::size_t width = grid.getWidth();
+    const std::size_t height = grid.getHeight();
+    const std::size_t wordsPerRow = grid.getWordsPerRow();
+    if (width == 0 || height == 0)
+        return;
+
+    // Бит c в словах - вертикальная линия между столбцами c и c + 1; отрезок на ней начат в строке runStarts[c]
+    std::vector<std::uint64_t> previousWalls(wordsPerRow, 0);
+    std::vector<std::size_t> runStarts(width, 0);
+    for (std::size_t y = 0; y <= height; ++y)
+    {
+        // Горизонтальная линия над строкой y: стена там, где у клетки выше нет прохода вниз
+        if (y == 0 || y == height)
+        {
+            runHandler(0, y, width, false);
+        }
+        else
+        {
+            const std::uint64_t *botRow = grid.getBotRow(y - 1);
+            bool isRunOpen {false};
+            std::size_t runStart {};
+            for (std::size_t word = 0; word < wordsPerRow; ++word)
+            {
+                const std::uint64_t walls = ~botRow[word] & grid.getRowMask(word);
+                const std::size_t firstBit = word * PackedMazeGrid::BITS_PER_WORD;
+                unsigned int bit {0};
+                while (bit < PackedMazeGrid::BITS_PER_WORD)
+                {
+                    // Ищется конец текущего отрезка или начало следующего
+                    const std::uint64_t rest = (isRunOpen ? ~walls : walls) >> bit;
+                    if (rest == 0)
+                        break;
+                    bit += countTrailingZeros(rest);
+                    if (isRunOpen)
+                        runHandler(runStart, y, firstBit + bit - runStart, false);
+                    else
+                        runStart = firstBit + bit;
+                    isRunOpen = !isRunOpen;
+                }
+            }
+            if (isRunOpen)
+                runHandler(runStart, y, width - runStart, false);
+        }
+
+        // Вертикальные отрезки начинаются и кончаются там, где стена меняется по сравнению со строкой выше
+        const std::uint64_t *rightRow = y < height ? grid.getRightRow(y) : nullptr;
+        for (std::size_t word = 0; word < wordsPerRow; ++word)
+        {
+            const std::uint64_t walls = rightRow ? ~rightRow[word] & grid.getRightRowMask(word) : 0;
+            for (std::uint64_t changed = walls ^ previousWalls[word]; changed != 0; changed &= changed - 1)
+            {
+                const unsigned int bit = countTrailingZeros(changed);
+                const std::size_t line = word * PackedMazeGrid::BITS_PER_WORD + bit;
+                if ((walls >> bit) & 1)
+                    runStarts[line] = y;
+                else
+                    runHandler(line + 1, runStarts[line], y - runStarts[line], true);
+            }
+            previousWalls[word] = walls;
+        }
+        if (y == height)
+        {
+            runHandler(0, 0, height, true);
+            runHandler(width, 0, height, true);
+        }
+        rowEndHandler();
+    }
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool MazeVectorExporter::writeSvg(std::ostream &output, const PackedMazeGrid &grid, unsigned int cellSize)
+{
+    MAZE_TRACE_ZONE("MazeVectorExporter::writeSvg");
+    // Отступ, чтобы внешние стены не обрезались по краю
+    const unsigned long long margin = cellSize / 2 + WALL_WIDTH;
+    const unsigned long long imageWidth = grid.getWidth() * cellSize + 2 * margin;
+    const unsigned long long imageHeight = grid.getHeight() * cellSize + 2 * margin;
+    output << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+           << "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"" << imageWidth << "\" height=\"" << imageHeight
+           << "\" viewBox=\"0 0 " << imageWidth << ' ' << imageHeight << "\">\n"
+           << "<rect width=\"100%\" height=\"100%\" fill=\"white\"/>\n"
+           << "<g fill=\"none\" stroke=\"black\" stroke-width=\"" << WALL_WIDTH << "\" stroke-linecap=\"square\">\n";
+
+    // Путь на каждую строку, чтобы ни один атрибут не рос с размером лабиринта
+    std::string path;
+    forEachWallRun(grid, [&path, margin, cellSize](std::size_t x, std::size_t y, std::size_t length, bool isVertical) {
+        path += 'M';
+        appendNumber(path, margin + x * cellSize);
+        path += ' ';
+        appendNumber(path, margin + y * cellSize);
+        path += isVertical ? 'v' : 'h';
+        appendNumber(path, length * cellSize);
+    }, [&path, &output]() {
+        if (path.empty())
+            return;
+        output << "<path d=\"" << path << "\"/>\n";
+        path.clear();
+    });
+
+    output << "</g>\n</svg>\n";
+    return static_cast<bool>(output);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool MazeVectorExporter::writePdf(std::ostream &output, const PackedMazeGrid &grid, unsigned int cellSize)
+{
+    MAZE_TRACE_ZONE("MazeVectorExporter::writePdf");
+    const unsigned long long margin = cellSize / 2 + WALL_WIDTH;
+    const double contentWidth = static_cast<double>(grid.getWidth() * cellSize + 2 * margin);
+    const double contentHeight = static_cast<double>(grid.getHeight() * cellSize + 2 * margin);
+    const double scale = std::min(1.0, MAX_PDF_PAGE_SIZE / std::max(contentWidth, contentHeight));
+    char text[160] {};
+
+    // 1 - каталог, 2 - дерево страниц, 3 - страница, 4 - содержимое, 5 - его длина, известная только в конце
+    PdfStream pdf(output, 5);
+    pdf.write("%PDF-1.4\n");
+    pdf.beginObject(1);
+    pdf.write("<< /Type /Catalog /Pages 2 0 R >>\nendobj\n");
+    pdf.beginObject(2);
+    pdf.write("<< /Type /Pages /Kids [3 0 R] /Count 1 >>\nendobj\n");
+    pdf.beginObject(3);
+    std::snprintf(text, sizeof(text), "<< /Type /Page /Parent 2 0 R /MediaBox [0 0 %.2f %.2f] /Resources << >> "
+                  "/Contents 4 0 R >>\nendobj\n", contentWidth * scale, contentHeight * scale);
+    pdf.write(text);
+    pdf.beginObject(4);
+    pdf.write("<< /Length 5 0 R >>\nstream\n");
+
+    // Ось y страницы направлена вверх, поэтому координаты клеток переворачиваются матрицей
+    const std::uint64_t streamStart = pdf.getOffset();
+    std::snprintf(text, sizeof(text), "q %.6f 0 0 %.6f 0 %.2f cm %u w 2 J\n",
+                  scale, -scale, contentHeight * scale, WALL_WIDTH);
+    pdf.write(text);
+    std::string path;
+    forEachWallRun(grid, [&path, margin, cellSize](std::size_t x, std::size_t y, std::size_t length, bool isVertical) {
+        const unsigned long long fromX = margin + x * cellSize;
+        const unsigned long long fromY = margin + y * cellSize;
+        appendNumber(path, fromX);
+        path += ' ';
+        appendNumber(path, fromY);
+        path += " m ";
+        appendNumber(path, isVertical ? fromX : fromX + length * cellSize);
+        path += ' ';
+        appendNumber(path, isVertical ? fromY + length * cellSize : fromY);
+        path += " l\n";
+    }, [&path, &pdf]() {
+        if (path.empty())
+            return;
+        pdf.write(path + "S\n");
+        path.clear();
+    });
+    pdf.write("Q\n");
+    const std::uint64_t streamLength = pdf.getOffset() - streamStart;
+
+    pdf.write("endstream\nendobj\n");
+    pdf.beginObject(5);
+    pdf.write(std::to_string(streamLength) + "\nendobj\n");
+    pdf.writeTrailer();
+    return static_cast<bool>(output);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool MazeVectorExporter::writeToFile(const std::string &filePath, const PackedMazeGrid &grid, unsigned int cellSize)
+{
+    std::ofstream output(filePath, std::ios::binary | std::ios::trunc);
+    if (!output)
+        return false;
+
+    const std::string extension = filePath.size() >= 4 ? filePath.substr(filePath.size() - 4) : std::string();
+    const bool isPdf = extension == ".pdf" || extension == ".PDF";
+    const bool isWritten = isPdf ? writePdf(output, grid, cellSize) : writeSvg(output, grid, cellSize);
+    return isWritten && output.flush();
+}
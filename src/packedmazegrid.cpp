@@ -0,0 +1,231 @@
+#include "packedmazegrid.h"
+
+#include <algorithm>
+#include <utility>
+
+// Определение нужно при ODR-использовании, например std::min берет константу по ссылке
+const std::size_t PackedMazeGrid::BITS_PER_WORD;
+
+PackedMazeGrid::PackedMazeGrid(std::size_t width, std::size_t height)
+{
+    resize(width, height);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+PackedMazeGrid::PackedMazeGrid(const PackedMazeGrid &other)
+    : width_(other.width_),
+      height_(other.height_),
+      wordsPerRow_(other.wordsPerRow_),
+      rightPassages_(other.rightPlane_, other.rightPlane_ + other.getPlaneWords()),
+      botPassages_(other.botPlane_, other.botPlane_ + other.getPlaneWords()),
+      rightPlane_(rightPassages_.data()),
+      botPlane_(botPassages_.data())
+{
+}
+
+/*------------------------------------------------------------------------------------------------*/
+PackedMazeGrid& PackedMazeGrid::operator=(const PackedMazeGrid &other)
+{
+    PackedMazeGrid copy(other);
+    swap(copy);
+    return *this;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void PackedMazeGrid::resize(std::size_t width, std::size_t height)
+{
+    width_ = width;
+    height_ = height;
+    wordsPerRow_ = (width + BITS_PER_WORD - 1) / BITS_PER_WORD;
+
+    const std::size_t planeWords = getPlaneWords();
+    if (isExternalStorage_ && planeWords <= externalCapacityWords_)
+    {
+        clear();
+        return;
+    }
+
+    isExternalStorage_ = false;
+    rightPassages_.assign(planeWords, 0);
+    botPassages_.assign(planeWords, 0);
+    rightPlane_ = rightPassages_.data();
+    botPlane_ = botPassages_.data();
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void PackedMazeGrid::clear()
+{
+    std::fill(rightPlane_, rightPlane_ + getPlaneWords(), 0);
+    std::fill(botPlane_, botPlane_ + getPlaneWords(), 0);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void PackedMazeGrid::swap(PackedMazeGrid &other) noexcept
+{
+    std::swap(width_, other.width_);
+    std::swap(height_, other.height_);
+    std::swap(wordsPerRow_, other.wordsPerRow_);
+    rightPassages_.swap(other.rightPassages_);
+    botPassages_.swap(other.botPassages_);
+    std::swap(rightPlane_, other.rightPlane_);
+    std::swap(botPlane_, other.botPlane_);
+    std::swap(externalCapacityWords_, other.externalCapacityWords_);
+    std::swap(isExternalStorage_, other.isExternalStorage_);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void PackedMazeGrid::moveToExternalStorage(std::uint64_t *rightPlane, std::uint64_t *botPlane,
+                                           std::size_t planeCapacityWords)
+{
+    if (rightPlane_ != rightPlane)
+    {
+        std::copy(rightPlane_, rightPlane_ + getPlaneWords(), rightPlane);
+        std::copy(botPlane_, botPlane_ + getPlaneWords(), botPlane);
+    }
+
+    rightPassages_ = std::vector<std::uint64_t>();
+    botPassages_ = std::vector<std::uint64_t>();
+    rightPlane_ = rightPlane;
+    botPlane_ = botPlane;
+    externalCapacityWords_ = planeCapacityWords;
+    isExternalStorage_ = true;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool PackedMazeGrid::usesStorage(const std::uint64_t *rightPlane) const
+{
+    return isExternalStorage_ && rightPlane_ == rightPlane;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::size_t PackedMazeGrid::getPlaneWords() const
+{
+    return wordsPerRow_ * height_;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::size_t PackedMazeGrid::getWidth() const
+{
+    return width_;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::size_t PackedMazeGrid::getHeight() const
+{
+    return height_;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::size_t PackedMazeGrid::getCellCount() const
+{
+    return width_ * height_;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::size_t PackedMazeGrid::getWordsPerRow() const
+{
+    return wordsPerRow_;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::size_t PackedMazeGrid::getSizeBytes() const
+{
+    return 2 * getPlaneWords() * sizeof(std::uint64_t);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::uint64_t PackedMazeGrid::getRowMask(std::size_t wordIndex) const
+{
+    const std::size_t tailBits = width_ % BITS_PER_WORD;
+    if (wordIndex + 1 < wordsPerRow_ || tailBits == 0)
+        return ~std::uint64_t(0);
+    return (std::uint64_t(1) << tailBits) - 1;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::uint64_t PackedMazeGrid::getRightRowMask(std::size_t wordIndex) const
+{
+    // Из последнего столбца идти вправо некуда
+    std::uint64_t mask = getRowMask(wordIndex);
+    if (wordIndex + 1 == wordsPerRow_)
+        mask &= ~(std::uint64_t(1) << ((width_ - 1) % BITS_PER_WORD));
+    return mask;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::uint64_t* PackedMazeGrid::getRightRow(std::size_t row)
+{
+    return rightPlane_ + row * wordsPerRow_;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::uint64_t* PackedMazeGrid::getBotRow(std::size_t row)
+{
+    return botPlane_ + row * wordsPerRow_;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+const std::uint64_t* PackedMazeGrid::getRightRow(std::size_t row) const
+{
+    return rightPlane_ + row * wordsPerRow_;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+const std::uint64_t* PackedMazeGrid::getBotRow(std::size_t row) const
+{
+    return botPlane_ + row * wordsPerRow_;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool PackedMazeGrid::hasPassage(std::size_t x, std::size_t y, int direction) const
+{
+    switch (direction)
+    {
+    case Direction::Top :
+        return y > 0 && hasPassage(x, y - 1, Direction::Bot);
+    case Direction::Right :
+        return (getRightRow(y)[x / BITS_PER_WORD] >> (x % BITS_PER_WORD)) & 1;
+    case Direction::Bot :
+        return (getBotRow(y)[x / BITS_PER_WORD] >> (x % BITS_PER_WORD)) & 1;
+    case Direction::Left :
+        return x > 0 && hasPassage(x - 1, y, Direction::Right);
+    }
+    return false;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void PackedMazeGrid::setPassage(std::size_t x, std::size_t y, int direction, bool isOpen)
+{
+    // Проход сверху и слева хранится в соседней клетке
+    if (direction == Direction::Top)
+    {
+        --y;
+        direction = Direction::Bot;
+    }
+    else if (direction == Direction::Left)
+    {
+        --x;
+        direction = Direction::Right;
+    }
+
+    std::uint64_t &word = (direction == Direction::Right ? getRightRow(y) : getBotRow(y))[x / BITS_PER_WORD];
+    const std::uint64_t bit = std::uint64_t(1) << (x % BITS_PER_WORD);
+    if (isOpen)
+        word |= bit;
+    else
+        word &= ~bit;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::uint64_t PackedMazeGrid::computeChecksum() const
+{
+    // Каждое слово перемешивается вместе со своей позицией, поэтому перестановка слов тоже заметна
+    std::uint64_t checksum = 0x9E3779B97F4A7C15 ^ width_ ^ (std::uint64_t(height_) << 32);
+    const std::size_t wordCount = getPlaneWords();
+    for (std::size_t word = 0; word < wordCount; ++word)
+    {
+        checksum = (checksum ^ rightPlane_[word]) * 0xFF51AFD7ED558CCD;
+        checksum = (checksum ^ botPlane_[word] ^ (checksum >> 29)) * 0xC4CEB9FE1A85EC53;
+    }
+    return checksum ^ (checksum >> 32);
+}
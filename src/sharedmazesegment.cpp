@@ -0,0 +1,310 @@
+#include "sharedmazesegment.h"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SHARED_MAZE_SEGMENT_SUPPORTED
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+const std::uint32_t SEGMENT_MAGIC {0x535A4D41}; // "AMZS"
+const std::uint32_t SEGMENT_VERSION {1};
+const std::size_t HEADER_SIZE {64};
+
+static_assert(sizeof(SharedMazeHeader) <= HEADER_SIZE, "SharedMazeHeader must fit into the reserved header");
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "Seqlock counter must be lock-free to work across processes");
+
+std::size_t getSegmentSize(std::size_t planeCapacityWords)
+{
+    return HEADER_SIZE + 2 * planeCapacityWords * sizeof(std::uint64_t);
+}
+}
+
+SharedMazePublisher::SharedMazePublisher(const std::string &name) noexcept
+    : name_(name)
+{
+}
+
+/*------------------------------------------------------------------------------------------------*/
+SharedMazePublisher::~SharedMazePublisher()
+{
+#ifdef SHARED_MAZE_SEGMENT_SUPPORTED
+    if (mapping_)
+        munmap(mapping_, mappingSize_);
+    if (segmentDescriptor_ >= 0)
+    {
+        // Имя могло перейти к сегменту издателя, запущенного позже, - его не трогаем
+        if (!isKeptAfterExit_ && isNameOwner())
+            shm_unlink(name_.c_str());
+        close(segmentDescriptor_);
+    }
+#endif
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool SharedMazePublisher::isNameOwner() const
+{
+#ifdef SHARED_MAZE_SEGMENT_SUPPORTED
+    const int namedDescriptor = shm_open(name_.c_str(), O_RDONLY, 0);
+    if (namedDescriptor < 0)
+        return false;
+    struct stat namedState {};
+    struct stat ownState {};
+    const bool isOwner = fstat(namedDescriptor, &namedState) == 0 && fstat(segmentDescriptor_, &ownState) == 0 &&
+            namedState.st_dev == ownState.st_dev && namedState.st_ino == ownState.st_ino;
+    close(namedDescriptor);
+    return isOwner;
+#else
+    return false;
+#endif
+}
+
+/*------------------------------------------------------------------------------------------------*/
+SharedMazeHeader* SharedMazePublisher::getHeader() const
+{
+    return static_cast<SharedMazeHeader*>(mapping_);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::uint64_t* SharedMazePublisher::getRightPlane() const
+{
+    return reinterpret_cast<std::uint64_t*>(static_cast<char*>(mapping_) + HEADER_SIZE);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::uint64_t* SharedMazePublisher::getBotPlane() const
+{
+    return getRightPlane() + getHeader()->planeCapacityWords;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool SharedMazePublisher::open()
+{
+#ifdef SHARED_MAZE_SEGMENT_SUPPORTED
+    /* Сегмент с этим именем от прошлого запуска могут еще держать отображенным читатели:
+     * усечение убило бы их SIGBUS. Имя отвязывается, а издатель создает новый сегмент; старые
+     * читатели дочитывают свой, новые открывают уже этот */
+    shm_unlink(name_.c_str());
+    segmentDescriptor_ = shm_open(name_.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (segmentDescriptor_ < 0 || ftruncate(segmentDescriptor_, getSegmentSize(0)) != 0)
+        return false;
+
+    mappingSize_ = getSegmentSize(0);
+    mapping_ = mmap(nullptr, mappingSize_, PROT_READ | PROT_WRITE, MAP_SHARED, segmentDescriptor_, 0);
+    if (mapping_ == MAP_FAILED)
+    {
+        mapping_ = nullptr;
+        return false;
+    }
+
+    SharedMazeHeader *header = new (mapping_) SharedMazeHeader;
+    header->magic = SEGMENT_MAGIC;
+    header->version = SEGMENT_VERSION;
+    header->sequence.store(0, std::memory_order_relaxed);
+    header->width = 0;
+    header->height = 0;
+    header->wordsPerRow = 0;
+    header->planeCapacityWords = 0;
+    header->algorithm = -1;
+    header->reserved = 0;
+    return true;
+#else
+    return false;
+#endif
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void SharedMazePublisher::keepAfterExit()
+{
+    isKeptAfterExit_ = true;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool SharedMazePublisher::ensureCapacity(std::size_t planeWords)
+{
+#ifdef SHARED_MAZE_SEGMENT_SUPPORTED
+    if (!mapping_)
+        return false;
+    if (planeWords <= getHeader()->planeCapacityWords)
+        return true;
+
+    /* Сегмент только растет. Читатели замечают новый planeCapacityWords и переотображают его,
+     * а запись идет при нечетном sequence, поэтому промежуточное состояние им не видно */
+    const bool isWriting = getHeader()->sequence.load(std::memory_order_relaxed) & 1;
+    if (!isWriting)
+        beginWrite();
+
+    const std::size_t newSize = getSegmentSize(planeWords);
+    void *newMapping = MAP_FAILED;
+    if (ftruncate(segmentDescriptor_, newSize) == 0)
+        newMapping = mmap(nullptr, newSize, PROT_READ | PROT_WRITE, MAP_SHARED, segmentDescriptor_, 0);
+    if (newMapping == MAP_FAILED)
+    {
+        if (!isWriting)
+            getHeader()->sequence.fetch_add(1, std::memory_order_release);
+        return false;
+    }
+
+    munmap(mapping_, mappingSize_);
+    mapping_ = newMapping;
+    mappingSize_ = newSize;
+    getHeader()->planeCapacityWords = planeWords;
+
+    if (!isWriting)
+        getHeader()->sequence.fetch_add(1, std::memory_order_release);
+    return true;
+#else
+    (void)planeWords;
+    return false;
+#endif
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool SharedMazePublisher::attach(PackedMazeGrid &grid)
+{
+    // Сетка, уже лежащая в сегменте, в него помещается, и переотображать ничего не нужно
+    if (mapping_ && grid.usesStorage(getRightPlane()))
+        return true;
+
+    const std::size_t planeWords = grid.getWordsPerRow() * grid.getHeight();
+    if (!ensureCapacity(std::max<std::size_t>(planeWords, 1)))
+        return false;
+
+    grid.moveToExternalStorage(getRightPlane(), getBotPlane(), getHeader()->planeCapacityWords);
+    return true;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void SharedMazePublisher::beginWrite()
+{
+    if (!mapping_)
+        return;
+
+    std::atomic<std::uint64_t> &sequence = getHeader()->sequence;
+    const std::uint64_t current = sequence.load(std::memory_order_relaxed);
+    if (current & 1)
+        return;
+    sequence.store(current + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void SharedMazePublisher::endWrite(int algorithm, PackedMazeGrid &grid)
+{
+    if (!mapping_)
+        return;
+
+    beginWrite();
+    // Сетка могла переехать в свою память (resize сверх сегмента или обмен с пулом)
+    attach(grid);
+
+    SharedMazeHeader *header = getHeader();
+    header->width = grid.getWidth();
+    header->height = grid.getHeight();
+    header->wordsPerRow = grid.getWordsPerRow();
+    header->algorithm = algorithm;
+    header->sequence.fetch_add(1, std::memory_order_release);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+SharedMazeReader::~SharedMazeReader()
+{
+#ifdef SHARED_MAZE_SEGMENT_SUPPORTED
+    if (mapping_)
+        munmap(const_cast<void*>(mapping_), mappingSize_);
+    if (segmentDescriptor_ >= 0)
+        close(segmentDescriptor_);
+#endif
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool SharedMazeReader::open(const std::string &name)
+{
+#ifdef SHARED_MAZE_SEGMENT_SUPPORTED
+    segmentDescriptor_ = shm_open(name.c_str(), O_RDONLY, 0);
+    if (segmentDescriptor_ < 0 || !remap())
+        return false;
+
+    const SharedMazeHeader *header = static_cast<const SharedMazeHeader*>(mapping_);
+    return header->magic == SEGMENT_MAGIC && header->version == SEGMENT_VERSION;
+#else
+    (void)name;
+    return false;
+#endif
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool SharedMazeReader::remap()
+{
+#ifdef SHARED_MAZE_SEGMENT_SUPPORTED
+    struct stat segmentState {};
+    if (fstat(segmentDescriptor_, &segmentState) != 0 || segmentState.st_size < static_cast<off_t>(HEADER_SIZE))
+        return false;
+
+    if (mapping_)
+        munmap(const_cast<void*>(mapping_), mappingSize_);
+    mappingSize_ = static_cast<std::size_t>(segmentState.st_size);
+    mapping_ = mmap(nullptr, mappingSize_, PROT_READ, MAP_SHARED, segmentDescriptor_, 0);
+    if (mapping_ == MAP_FAILED)
+    {
+        mapping_ = nullptr;
+        return false;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool SharedMazeReader::readSnapshot(const std::function<void(const Snapshot&)> &consumer, unsigned int maxAttempts)
+{
+    for (unsigned int attempt = 0; attempt < maxAttempts && mapping_; ++attempt)
+    {
+        const SharedMazeHeader *header = static_cast<const SharedMazeHeader*>(mapping_);
+        const std::uint64_t sequence = header->sequence.load(std::memory_order_acquire);
+        if (sequence & 1)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        const std::size_t planeCapacityWords = header->planeCapacityWords;
+        Snapshot snapshot;
+        snapshot.sequence = sequence;
+        snapshot.width = header->width;
+        snapshot.height = header->height;
+        snapshot.wordsPerRow = header->wordsPerRow;
+        snapshot.algorithm = header->algorithm;
+
+        // Сегмент вырос после нашего отображения - переотображаем и пробуем снова
+        if (getSegmentSize(planeCapacityWords) > mappingSize_)
+        {
+            if (!remap())
+                return false;
+            continue;
+        }
+        // Несогласованный заголовок не должен выводить consumer за пределы отображения
+        if (snapshot.wordsPerRow * snapshot.height > planeCapacityWords)
+            continue;
+
+        const std::uint64_t *rightPlane = reinterpret_cast<const std::uint64_t*>(
+                    static_cast<const char*>(mapping_) + HEADER_SIZE);
+        snapshot.rightPlane = rightPlane;
+        snapshot.botPlane = rightPlane + planeCapacityWords;
+        consumer(snapshot);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (header->sequence.load(std::memory_order_relaxed) == sequence)
+            return true;
+    }
+    return false;
+}
@@ -0,0 +1,151 @@
+#include "tracezones.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+const std::size_t EVENTS_PER_CHUNK {4096};
+// Не больше ~4 млн событий на поток; остальные только подсчитываются
+const std::size_t MAX_CHUNKS {1024};
+
+/* Буфер событий одного потока. Пишет в него только поток-владелец: событие заполняется, и лишь
+ * потом eventCount публикует его с release, поэтому экспорт из другого потока читает готовые
+ * события без блокировок. Куски памяти не перемещаются и живут до конца процесса */
+struct ThreadBuffer
+{
+    std::uint32_t threadId {};
+    std::string threadName;
+    std::atomic<TraceEvent*> chunks[MAX_CHUNKS];
+    std::atomic<std::size_t> eventCount {0};
+    std::atomic<std::uint64_t> droppedCount {0};
+
+    ThreadBuffer()
+    {
+        for (std::atomic<TraceEvent*> &chunk : chunks)
+            chunk.store(nullptr, std::memory_order_relaxed);
+    }
+};
+
+const std::chrono::steady_clock::time_point processStart {std::chrono::steady_clock::now()};
+
+// Список буферов меняется только при появлении нового потока, запись событий его не трогает
+std::mutex registryMutex;
+std::vector<std::unique_ptr<ThreadBuffer>> threadBuffers;
+thread_local ThreadBuffer *currentThreadBuffer {nullptr};
+
+ThreadBuffer* getThreadBuffer()
+{
+    if (!currentThreadBuffer)
+    {
+        std::unique_ptr<ThreadBuffer> buffer(new ThreadBuffer);
+        std::lock_guard<std::mutex> lock(registryMutex);
+        buffer->threadId = static_cast<std::uint32_t>(threadBuffers.size() + 1);
+        currentThreadBuffer = buffer.get();
+        threadBuffers.push_back(std::move(buffer));
+    }
+    return currentThreadBuffer;
+}
+
+void writeEscaped(std::FILE *file, const char *text)
+{
+    for (; *text; ++text)
+    {
+        if (*text == '"' || *text == '\\')
+            std::fputc('\\', file);
+        if (static_cast<unsigned char>(*text) >= 0x20)
+            std::fputc(*text, file);
+    }
+}
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::uint64_t TraceRecorder::now()
+{
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                          std::chrono::steady_clock::now() - processStart).count());
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void TraceRecorder::record(const TraceEvent &event)
+{
+    ThreadBuffer *buffer = getThreadBuffer();
+    const std::size_t eventIndex = buffer->eventCount.load(std::memory_order_relaxed);
+    const std::size_t chunkIndex = eventIndex / EVENTS_PER_CHUNK;
+    if (chunkIndex >= MAX_CHUNKS)
+    {
+        buffer->droppedCount.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    TraceEvent *chunk = buffer->chunks[chunkIndex].load(std::memory_order_relaxed);
+    if (!chunk)
+    {
+        chunk = new TraceEvent[EVENTS_PER_CHUNK];
+        buffer->chunks[chunkIndex].store(chunk, std::memory_order_release);
+    }
+    chunk[eventIndex % EVENTS_PER_CHUNK] = event;
+    buffer->eventCount.store(eventIndex + 1, std::memory_order_release);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void TraceRecorder::setThreadName(const char *threadName)
+{
+    ThreadBuffer *buffer = getThreadBuffer();
+    std::lock_guard<std::mutex> lock(registryMutex);
+    buffer->threadName = threadName;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool TraceRecorder::writeChromeTrace(const std::string &filePath)
+{
+    std::FILE *file = std::fopen(filePath.c_str(), "w");
+    if (!file)
+        return false;
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", file);
+    bool isFirstEvent {true};
+    for (const std::unique_ptr<ThreadBuffer> &buffer : threadBuffers)
+    {
+        if (!buffer->threadName.empty())
+        {
+            std::fprintf(file, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"",
+                         isFirstEvent ? "" : ",\n", buffer->threadId);
+            writeEscaped(file, buffer->threadName.c_str());
+            std::fputs("\"}}", file);
+            isFirstEvent = false;
+        }
+
+        const std::size_t eventCount = buffer->eventCount.load(std::memory_order_acquire);
+        for (std::size_t eventIndex = 0; eventIndex < eventCount; ++eventIndex)
+        {
+            const TraceEvent *chunk = buffer->chunks[eventIndex / EVENTS_PER_CHUNK].load(std::memory_order_acquire);
+            const TraceEvent &event = chunk[eventIndex % EVENTS_PER_CHUNK];
+            // Время в Chrome trace - в микросекундах
+            std::fprintf(file, "%s{\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"name\":\"",
+                         isFirstEvent ? "" : ",\n", buffer->threadId, event.startNs / 1000.0, event.durationNs / 1000.0);
+            writeEscaped(file, event.name);
+            std::fputc('"', file);
+            if (event.argumentName)
+            {
+                std::fputs(",\"args\":{\"", file);
+                writeEscaped(file, event.argumentName);
+                std::fprintf(file, "\":%lld}", static_cast<long long>(event.argument));
+            }
+            std::fputc('}', file);
+            isFirstEvent = false;
+        }
+
+        const std::uint64_t droppedCount = buffer->droppedCount.load(std::memory_order_relaxed);
+        if (droppedCount != 0)
+            std::fprintf(stderr, "Trace buffer of thread %u overflowed, %llu events dropped\n", buffer->threadId,
+                         static_cast<unsigned long long>(droppedCount));
+    }
+    std::fputs("\n]}\n", file);
+    return std::fclose(file) == 0;
+}
@@ -0,0 +1,289 @@
+#include "uniformtreegenerator.h"
+#include "tracezones.h"
+
+UniformTreeGenerator::UniformTreeGenerator(std::size_t width, std::size_t height, std::uint64_t seed) noexcept
+    : width_(width),
+      height_(height),
+      seed_(seed),
+      random_(seed)
+{
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void UniformTreeGenerator::setProgressHandler(const ProgressHandler &progressHandler)
+{
+    progressHandler_ = progressHandler;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void UniformTreeGenerator::setVisitHeatmap(VisitHeatmap *visitHeatmap)
+{
+    visitHeatmap_ = visitHeatmap;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool UniformTreeGenerator::generate(int algorithm, PackedMazeGrid &grid)
+{
+    const std::size_t cellCount = width_ * height_;
+    grid.resize(width_, height_);
+    cellStates_.assign(cellCount, 0);
+    if (cellCount == 0)
+        return true;
+
+    const std::size_t startCell = random_.generate64() % cellCount;
+    cellStates_[startCell] = CellState::InTree;
+    algorithm_ = algorithm;
+    x_ = startCell % width_;
+    y_ = startCell / width_;
+    visitedCells_ = 1;
+    wilsonStartCell_ = 0;
+    if (visitHeatmap_)
+    {
+        visitHeatmap_->resize(width_, height_);
+        visitHeatmap_->recordVisit(x_, y_);
+    }
+
+    switch (algorithm)
+    {
+    case Algorithm::AldousBroder :
+        phase_ = Phase::AldousBroderWalk;
+        cellsToVisit_ = cellCount;
+        break;
+    case Algorithm::Wilson :
+        phase_ = Phase::WilsonSeek;
+        break;
+    }
+    return run(grid);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool UniformTreeGenerator::resume(PackedMazeGrid &grid)
+{
+    return run(grid);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void UniformTreeGenerator::saveCheckpoint(const PackedMazeGrid &grid, GenerationCheckpoint &checkpoint) const
+{
+    checkpoint.algorithm = algorithm_;
+    checkpoint.seed = seed_;
+    checkpoint.randomState = random_.getState();
+    checkpoint.directionBits = directionBits_;
+    checkpoint.directionBitsLeft = directionBitsLeft_;
+    checkpoint.phase = phase_;
+    checkpoint.x = x_;
+    checkpoint.y = y_;
+    checkpoint.visitedCells = visitedCells_;
+    checkpoint.cellsToVisit = cellsToVisit_;
+    checkpoint.wilsonStartCell = wilsonStartCell_;
+    checkpoint.cellStates = cellStates_;
+    checkpoint.grid = grid;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool UniformTreeGenerator::restoreCheckpoint(const GenerationCheckpoint &checkpoint, PackedMazeGrid &grid)
+{
+    // Размер, позицию и счетчики уже сверил readFromFile; здесь то, что знает только генератор
+    if (checkpoint.algorithm < Algorithm::AldousBroder || checkpoint.algorithm > Algorithm::Wilson ||
+            checkpoint.phase < Phase::AldousBroderWalk || checkpoint.phase > Phase::Finished ||
+            checkpoint.grid.getWidth() != width_ || checkpoint.grid.getHeight() != height_ ||
+            checkpoint.cellStates.size() != width_ * height_)
+        return false;
+    // У Aldous-Broder одна фаза блуждания, у Уилсона - свои три
+    const bool isAldousBroderPhase = checkpoint.phase == Phase::AldousBroderWalk;
+    if (checkpoint.phase != Phase::Finished && isAldousBroderPhase != (checkpoint.algorithm == Algorithm::AldousBroder))
+        return false;
+    for (std::uint8_t state : checkpoint.cellStates)
+    {
+        if (state & ~(CellState::DirectionMask | CellState::InTree))
+            return false;
+    }
+
+    algorithm_ = checkpoint.algorithm;
+    seed_ = checkpoint.seed;
+    random_.setState(checkpoint.randomState);
+    directionBits_ = checkpoint.directionBits;
+    directionBitsLeft_ = checkpoint.directionBitsLeft;
+    phase_ = checkpoint.phase;
+    x_ = checkpoint.x;
+    y_ = checkpoint.y;
+    visitedCells_ = checkpoint.visitedCells;
+    cellsToVisit_ = checkpoint.cellsToVisit;
+    wilsonStartCell_ = checkpoint.wilsonStartCell;
+    cellStates_ = checkpoint.cellStates;
+    grid = checkpoint.grid;
+    // Посещения до контрольной точки в ней не хранятся, карта начинается заново
+    if (visitHeatmap_)
+        visitHeatmap_->resize(width_, height_);
+    return true;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool UniformTreeGenerator::reportProgress(const PackedMazeGrid &grid)
+{
+    // Обработчик вызывается в начале шага, когда состояние целиком описывается членами класса
+    if (--stepsUntilProgress_ != 0)
+        return true;
+    stepsUntilProgress_ = PROGRESS_INTERVAL_STEPS;
+    return !progressHandler_ || progressHandler_(*this, grid);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool UniformTreeGenerator::run(PackedMazeGrid &grid)
+{
+    while (phase_ != Phase::Finished)
+    {
+        const bool isRunning = phase_ == Phase::AldousBroderWalk ? runAldousBroder(grid) : runWilson(grid);
+        if (!isRunning)
+            return false;
+    }
+    return true;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool UniformTreeGenerator::runAldousBroder(PackedMazeGrid &grid)
+{
+    MAZE_TRACE_ZONE("UniformTreeGenerator::runAldousBroder");
+    while (visitedCells_ < cellsToVisit_)
+    {
+        if (!reportProgress(grid))
+            return false;
+
+        const int direction = chooseRandomDirection(x_, y_);
+        const std::size_t fromX = x_;
+        const std::size_t fromY = y_;
+        moveToNeighbor(x_, y_, direction);
+        if (visitHeatmap_)
+            visitHeatmap_->recordVisit(x_, y_);
+
+        std::uint8_t &state = cellStates_[y_ * width_ + x_];
+        if (!(state & CellState::InTree))
+        {
+            grid.setPassage(fromX, fromY, direction, true);
+            state |= CellState::InTree;
+            ++visitedCells_;
+        }
+    }
+
+    phase_ = Phase::Finished;
+    return true;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool UniformTreeGenerator::runWilson(PackedMazeGrid &grid)
+{
+    MAZE_TRACE_ZONE("UniformTreeGenerator::runWilson");
+    /* Блуждание запоминает в каждой клетке направление последнего выхода из неё. Перезапись
+     * направления при повторном заходе и есть стирание петель, поэтому сам путь хранить не нужно:
+     * после попадания в дерево достаточно пройти от начала по запомненным направлениям.
+     * Порядок выбора стартовых клеток на равномерность не влияет, корнем служат все клетки,
+     * уже вошедшие в дерево */
+    const std::size_t cellCount = width_ * height_;
+    while (wilsonStartCell_ < cellCount)
+    {
+        if (phase_ == Phase::WilsonSeek)
+        {
+            if (cellStates_[wilsonStartCell_] & CellState::InTree)
+            {
+                ++wilsonStartCell_;
+                continue;
+            }
+            x_ = wilsonStartCell_ % width_;
+            y_ = wilsonStartCell_ / width_;
+            phase_ = Phase::WilsonWalk;
+            if (visitHeatmap_)
+                visitHeatmap_->recordVisit(x_, y_);
+        }
+
+        if (phase_ == Phase::WilsonWalk)
+        {
+            while (!(cellStates_[y_ * width_ + x_] & CellState::InTree))
+            {
+                if (!reportProgress(grid))
+                    return false;
+
+                const int direction = chooseRandomDirection(x_, y_);
+                std::uint8_t &state = cellStates_[y_ * width_ + x_];
+                state = static_cast<std::uint8_t>((state & ~CellState::DirectionMask) | direction);
+                moveToNeighbor(x_, y_, direction);
+                if (visitHeatmap_)
+                    visitHeatmap_->recordVisit(x_, y_);
+            }
+            x_ = wilsonStartCell_ % width_;
+            y_ = wilsonStartCell_ / width_;
+            phase_ = Phase::WilsonCarve;
+        }
+
+        // Прокладка пути случайных чисел не тратит, поэтому идет без остановок
+        while (!(cellStates_[y_ * width_ + x_] & CellState::InTree))
+        {
+            std::uint8_t &state = cellStates_[y_ * width_ + x_];
+            const int direction = state & CellState::DirectionMask;
+            state |= CellState::InTree;
+            grid.setPassage(x_, y_, direction, true);
+            moveToNeighbor(x_, y_, direction);
+        }
+        phase_ = Phase::WilsonSeek;
+        ++wilsonStartCell_;
+    }
+
+    phase_ = Phase::Finished;
+    return true;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+int UniformTreeGenerator::chooseRandomDirection(std::size_t x, std::size_t y)
+{
+    // Два бита на попытку, недопустимые у края направления просто перевыбираются
+    for (;;)
+    {
+        if (directionBitsLeft_ == 0)
+        {
+            directionBits_ = random_.generate64();
+            directionBitsLeft_ = 32;
+        }
+        const int direction = directionBits_ & 0x03;
+        directionBits_ >>= 2;
+        --directionBitsLeft_;
+
+        switch (direction)
+        {
+        case PackedMazeGrid::Direction::Top :
+            if (y > 0)
+                return direction;
+            break;
+        case PackedMazeGrid::Direction::Right :
+            if (x + 1 < width_)
+                return direction;
+            break;
+        case PackedMazeGrid::Direction::Bot :
+            if (y + 1 < height_)
+                return direction;
+            break;
+        case PackedMazeGrid::Direction::Left :
+            if (x > 0)
+                return direction;
+            break;
+        }
+    }
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void UniformTreeGenerator::moveToNeighbor(std::size_t &x, std::size_t &y, int direction) const
+{
+    switch (direction)
+    {
+    case PackedMazeGrid::Direction::Top :
+        --y;
+        break;
+    case PackedMazeGrid::Direction::Right :
+        ++x;
+        break;
+    case PackedMazeGrid::Direction::Bot :
+        ++y;
+        break;
+    case PackedMazeGrid::Direction::Left :
+        --x;
+        break;
+    }
+}
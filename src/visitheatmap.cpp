@@ -0,0 +1,72 @@
+#include "visitheatmap.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+/*------------------------------------------------------------------------------------------------*/
+void VisitHeatmap::resize(std::size_t width, std::size_t height)
+{
+    width_ = width;
+    height_ = height;
+    visitCounts_.assign(width * height, 0);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+void VisitHeatmap::clear()
+{
+    std::fill(visitCounts_.begin(), visitCounts_.end(), 0);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::size_t VisitHeatmap::getWidth() const
+{
+    return width_;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::size_t VisitHeatmap::getHeight() const
+{
+    return height_;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::uint16_t VisitHeatmap::getVisitCount(std::size_t x, std::size_t y) const
+{
+    return visitCounts_[y * width_ + x];
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::uint16_t VisitHeatmap::getMaxVisitCount() const
+{
+    return visitCounts_.empty() ? 0 : *std::max_element(visitCounts_.begin(), visitCounts_.end());
+}
+
+/*------------------------------------------------------------------------------------------------*/
+std::uint32_t VisitHeatmap::getHeatColor(std::uint16_t visitCount, std::uint16_t maxVisitCount)
+{
+    if (visitCount == 0 || maxVisitCount == 0)
+        return 0;
+
+    // Заходы распределены очень неравномерно, в линейной шкале почти все клетки были бы одного цвета
+    const double heat = maxVisitCount > 1 ? std::log(double(visitCount)) / std::log(double(maxVisitCount)) : 1.0;
+    const std::uint32_t red = static_cast<std::uint32_t>(255 * heat);
+    const std::uint32_t blue = 255 - red;
+    const std::uint32_t alpha = 96 + static_cast<std::uint32_t>(127 * heat);
+    return (alpha << 24) | (red << 16) | (std::uint32_t(64) << 8) | blue;
+}
+
+/*------------------------------------------------------------------------------------------------*/
+bool VisitHeatmap::writeCsv(const std::string &filePath) const
+{
+    std::FILE *file = std::fopen(filePath.c_str(), "w");
+    if (!file)
+        return false;
+
+    for (std::size_t y = 0; y < height_; ++y)
+    {
+        for (std::size_t x = 0; x < width_; ++x)
+            std::fprintf(file, x + 1 < width_ ? "%u," : "%u\n", unsigned(visitCounts_[y * width_ + x]));
+    }
+    return std::fclose(file) == 0;
+}